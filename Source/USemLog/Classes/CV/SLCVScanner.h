@@ -5,6 +5,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Info.h"
+#include "Utils/SLImageWriter.h"
 #include "SLCVScanner.generated.h"
 
 // Forward declarations
@@ -183,8 +184,11 @@ private:
 	// Print progress to terminal
 	void PrintProgress() const;
 
-	// Save image to file
-	void SaveToFile(const TArray<uint8>& CompressedBitmap) const;
+	// Get the file paths of the current image
+	TArray<FString> GetImagePaths() const;
+
+	// Get the encoding of the current image
+	ESLImageFormat GetCurrImageFormat() const;
 
 protected:
 	// Skip auto init and start
@@ -271,6 +275,10 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "Semantic Logger|Image", meta = (editcondition = "!bUseIndividualMaskValue"))
 	FColor MaskColor = FColor::White;
 
+	// Store the mask images with the fast lossless run-length encoding (.slrle) instead of png
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger|Image")
+	uint8 bEncodeMasksAsRLE : 1;
+
 	// Disable post process volumes in the world
 	UPROPERTY(EditAnywhere, Category = "Semantic Logger|Image")
 	uint8 bDisablePostProcessVolumes : 1;
@@ -351,6 +359,9 @@ protected:
 	AStaticMeshActor* BackgroundSMA;
 
 private:
+	// Compresses and saves the images in the background
+	FSLImageWriter ImageWriter;
+
 	// Camera poses on the unit sphere (this will be multiplied with each scenes bounds spehre radius)
 	TArray<FTransform> CameraScanUnitPoses;
 
@@ -2,8 +2,6 @@
 // Author: Andrei Haidu (http://haidu.eu)
 
 #pragma once
-#include <tuple> // for tuple
-#include <string>
 //#include "../../UVRHands/Source/UVRHands/Public/SLCutter.h"
 #include "Actors/SLCutterAgentClass.h"
 #include "Engine/StaticMeshActor.h"
@@ -18,7 +16,33 @@ class FSLSupportedByEvent;
 struct FSLContactResult;
 class FSLPouringEvent;
 class FSLCuttingEvent;
- 
+
+/**
+ * Running pouring state of a container (one per container class and role), the particle contacts
+ * are aggregated into the event, the container poses are kept as a bounded evenly spaced sample
+ */
+struct FSLPouringContainerState
+{
+	// Latest pouring event of the container in this role
+	TSharedPtr<FSLPouringEvent> Event;
+
+	// Time of the last particle contact (end time of the event)
+	float LastTime = 0.f;
+
+	// Only every n-th pose is added to the event sample (doubled every time the sample is full)
+	int32 PoseStride = 1;
+
+	// Number of poses offered to the current event
+	int32 NumPoses = 0;
+
+	// Poses with the min and max roll of the current event (kept out of the sample) and their pose numbers
+	FTransform MinRollPose;
+	FTransform MaxRollPose;
+	float MinRoll = 0.f;
+	float MaxRoll = 0.f;
+	int32 MinRollIdx = 0;
+	int32 MaxRollIdx = 0;
+};
 
 /**
  * Listens to contact events input, and outputs finished semantic contact events
@@ -40,7 +64,7 @@ private:
 	void AddNewContactEvent(const FSLContactResult& InResult);
 
 	// Finish then publish the event
-	bool FinishContactEvent(USLBaseIndividual* InOther, float EndTime);
+	bool FinishContactEvent(uint64 InPairId, float EndTime);
 
 	// Start new Pouring event
 	void AddNewPouringEvent(const FSLContactResult& InResult);
@@ -80,37 +104,37 @@ private:
 	// Parent semantic overlap area
 	class ISLContactMonitorInterface* Parent = nullptr;
 
-	// Array of started contact events
-	TArray<TSharedPtr<FSLContactEvent>> StartedContactEvents;
+	// Started contact events indexed by the pair id
+	TMap<uint64, TSharedPtr<FSLContactEvent>> StartedContactEvents;
 
-	// Array of started supported by events
-	TArray<TSharedPtr<FSLSupportedByEvent>> StartedSupportedByEvents;
+	// Started supported by events indexed by the pair id
+	TMap<uint64, TSharedPtr<FSLSupportedByEvent>> StartedSupportedByEvents;
 
 	// Array of started Pouring events
 	TArray<TSharedPtr<FSLPouringEvent>> StartedPouringEvents;
 
-	bool IsPouringEventCurrentlyRunning(TArray<std::tuple<FString, float>> Containers, const FSLContactResult& InResult);
+	// Check if the container has a pouring event running in the given role
+	bool IsPouringEventCurrentlyRunning(const TMap<FString, FSLPouringContainerState>& Containers, const FString& ContainerName, float Time) const;
+
+	// Add the particle contact to the running pouring event of the container
+	void UpdatePouringContainer(FSLPouringContainerState& State, TArray<FTransform>& OutPoses, const FTransform& Pose, float Time);
+
+	// Insert the poses with the min and max roll into the sample of the event (in chronological order)
+	void FinishPouringContainer(FSLPouringContainerState& State, TArray<FTransform>& OutPoses);
 	
 	/* Constant values */
 	constexpr static float ContactEventMin = 0.01f;
 	constexpr static float SupportedByEventMin = 0.4f;
 	constexpr static float PouringEventMin = 0.03f;
 	constexpr static float CuttingEventMin = 0.03f;
-	int particlesOverlapEnded = 0;
-	TArray<FTransform> PouringPoseForSourceContainer;
-	TArray<FTransform> PouringPoseForDestinationContainer;
-	TArray <FString> SourceContainers;
-	TArray <FString> DestinationContainers;
-	FString SourceContainerName;
-	FString DestinationContainerName;
-	
-	TArray<std::tuple<FString, float>> SourceContainersList;
-	
-	TArray<std::tuple<FSLContactResult, FSLContactResult>> ListOfContainersCombinations;
+	constexpr static int32 MaxPouringPoses = 64;
 
-	TArray<std::tuple<FString, float>> DestinationContainersList;
-	float MaxPouringEventTime = 5;
-	TSharedPtr<FSLPouringEvent> CurrentPouringEvent;
+	// Pouring state of the containers indexed by their class, used as source
+	TMap<FString, FSLPouringContainerState> SourceContainers;
 
-	
+	// Pouring state of the containers indexed by their class, used as destination
+	TMap<FString, FSLPouringContainerState> DestinationContainers;
+
+	// A new pouring event is started if the container had no particle contact for this long
+	float MaxPouringEventTime = 5;
 };
@@ -0,0 +1,257 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Events/ISLEvent.h"
+#include "Events/SLGoogleCharts.h"
+#include "Owl/SLOwlExperiment.h"
+#include "Async/AsyncWork.h"
+
+/**
+* Finished event data needed for the owl and timeline exports (no references to the individuals)
+*/
+struct FSLEventJournalRecord
+{
+	// Event id
+	FString Id;
+
+	// Event type name
+	FString TypeName;
+
+	// Timeline context
+	FString Context;
+
+	// Timeline tooltip
+	FString Tooltip;
+
+	// Event times
+	float StartTime = 0.f;
+	float EndTime = 0.f;
+
+	// Owl representation of the event
+	FSLOwlNode OwlNode;
+
+	// Ids and classes of the objects registered by the event
+	TMap<FString, FString> Objects;
+
+	// Default ctor
+	FSLEventJournalRecord() {};
+
+	// Create the record from the event (game thread, the event can reference individuals)
+	FSLEventJournalRecord(ISLEvent& Event);
+
+	// Serialize the record
+	friend FArchive& operator<<(FArchive& Ar, FSLEventJournalRecord& Record);
+};
+
+/**
+* Event restored from the journal, used for writing the owl and timeline exports
+*/
+class FSLJournalEvent : public ISLEvent
+{
+public:
+	// Init ctor
+	FSLJournalEvent(FSLEventJournalRecord&& InRecord) :
+		ISLEvent(InRecord.Id, InRecord.StartTime, InRecord.EndTime), Record(MoveTemp(InRecord)) {};
+
+	/* Begin ISLEvent interface */
+	// Create an owl representation of the event
+	virtual FSLOwlNode ToOwlNode() const override { return Record.OwlNode; };
+
+	// Register the timepoints and add the owl node to the document
+	virtual void AddToOwlDoc(FSLOwlDoc* OutDoc) override
+	{
+		// We know that the document is of type FSLOwlExperiment (no RTTI)
+		FSLOwlExperiment* EventsDoc = static_cast<FSLOwlExperiment*>(OutDoc);
+		EventsDoc->RegisterTimepoint(StartTime);
+		EventsDoc->RegisterTimepoint(EndTime);
+		for (const auto& IdClassPair : Record.Objects)
+		{
+			EventsDoc->RegisterObject(IdClassPair.Key, IdClassPair.Value);
+		}
+		OutDoc->AddIndividual(Record.OwlNode);
+	};
+
+	// Send through ROSBridge
+	virtual FString ToROSQuery() const override { return FString(); };
+
+	// Get event context data as string
+	virtual FString Context() const override { return Record.Context; };
+
+	// Get the tooltip data
+	virtual FString Tooltip() const override { return Record.Tooltip; };
+
+	// Get the data as string
+	virtual FString ToString() const override { return FString::Printf(TEXT("%s [%.3f-%.3f]"), *Id, StartTime, EndTime); };
+
+	// Get the event type name
+	virtual FString TypeName() const override { return Record.TypeName; };
+
+	// The REST calls are made when the events are journaled
+	virtual FString RESTCallToKnowRob(FSLKRRestClient* InFSLKRRestClient) const override { return FString(); };
+	/* End ISLEvent interface */
+
+private:
+	// Journaled data
+	FSLEventJournalRecord Record;
+};
+
+/**
+* Parameters of writing the owl and timeline files from the journal
+*/
+struct FSLEventJournalExportParams
+{
+	// Experiment document template
+	TSharedPtr<FSLOwlExperiment> ExperimentDoc;
+
+	// Output directory
+	FString DirPath;
+
+	// Experiment metadata
+	FString SemanticMapId;
+	FString TaskId;
+
+	// Overwrite the existing owl file
+	bool bOverwrite = false;
+
+	// Write the timelines html as well
+	bool bWriteTimelines = false;
+
+	// Timelines parameters
+	FSLGoogleChartsParameters TimelinesParams;
+};
+
+/**
+* Async task appending the records to the journal file
+*/
+class FSLEventJournalWriteTask : public FNonAbandonableTask
+{
+public:
+	// Ctor
+	FSLEventJournalWriteTask(FArchive* InAr, TArray<FSLEventJournalRecord>&& InRecords) :
+		Ar(InAr), Records(MoveTemp(InRecords)) {};
+
+	// Append the records and flush the file
+	void DoWork();
+
+	// Needed internally
+	FORCEINLINE TStatId GetStatId() const { RETURN_QUICK_DECLARE_CYCLE_STAT(FSLEventJournalWriteTask, STATGROUP_ThreadPoolAsyncTasks); }
+
+private:
+	// Journal file (only used by one task at a time)
+	FArchive* Ar;
+
+	// Records to append
+	TArray<FSLEventJournalRecord> Records;
+};
+
+/**
+* Async task writing the owl and timeline files from the journal
+*/
+class FSLEventJournalExportTask : public FNonAbandonableTask
+{
+public:
+	// Ctor
+	FSLEventJournalExportTask(const FString& InPath, FSLEventJournalExportParams&& InParams) :
+		Path(InPath), Params(MoveTemp(InParams)) {};
+
+	// Export the journal
+	void DoWork();
+
+	// Needed internally
+	FORCEINLINE TStatId GetStatId() const { RETURN_QUICK_DECLARE_CYCLE_STAT(FSLEventJournalExportTask, STATGROUP_ThreadPoolAsyncTasks); }
+
+private:
+	// Journal file
+	FString Path;
+
+	// Export parameters
+	FSLEventJournalExportParams Params;
+};
+
+/**
+* Append-only file of the finished events, written in the background while logging,
+* every record is length and checksum prefixed, so a journal of a crashed session can still be exported
+*/
+class USEMLOG_API FSLEventJournal
+{
+public:
+	// Ctor
+	FSLEventJournal(int32 InMaxPendingRecords = 32, float InMaxPendingSeconds = 1.f);
+
+	// Dtor, closes the journal and waits for the export
+	~FSLEventJournal();
+
+	// Create the journal file (overwrites any previous journal, waits for its export first)
+	bool Open(const FString& InPath);
+
+	// True if the journal file is open
+	bool IsOpen() const { return Ar != nullptr; };
+
+	// Get the journal file path
+	const FString& GetPath() const { return Path; };
+
+	// Add the finished event, the records are appended in batches in the background
+	void AddEvent(const TSharedPtr<ISLEvent>& Event);
+
+	// Write the pending records if the oldest one waits for longer than the max pending time (call periodically)
+	void FlushIfDue();
+
+	// Get the max time a record waits before it is written
+	float GetMaxPendingSeconds() const { return MaxPendingSeconds; };
+
+	// Write the pending records and close the file
+	void Close();
+
+	// Number of journaled events
+	int32 Num() const { return NumRecords; };
+
+	// Read the valid records of the journal (a truncated last record is skipped)
+	static bool ReadRecords(const FString& InPath, TArray<FSLEventJournalRecord>& OutRecords);
+
+	// Write the owl and timeline files from the journal (can be re-run on the journal of an interrupted session)
+	static bool Export(const FString& InPath, const FSLEventJournalExportParams& Params);
+
+	// Export the closed journal on a worker thread, waits for the previous export first (the params are moved, the document should not be shared with the caller)
+	void ExportAsync(FSLEventJournalExportParams&& Params);
+
+	// True if the export is still running
+	bool IsExporting() const { return ExportTask != nullptr && !ExportTask->IsDone(); };
+
+	// Wait for the running export (if any)
+	void WaitForExport();
+
+private:
+	// Start writing the pending records if the previous write is done
+	void TryWritePending(bool bWait);
+
+private:
+	// Journal file
+	FArchive* Ar;
+
+	// Journal file path
+	FString Path;
+
+	// Records waiting for the next write
+	TArray<FSLEventJournalRecord> PendingRecords;
+
+	// Current write task
+	FAsyncTask<FSLEventJournalWriteTask>* WriteTask;
+
+	// Last export task
+	FAsyncTask<FSLEventJournalExportTask>* ExportTask;
+
+	// Write when this many records are pending
+	int32 MaxPendingRecords;
+
+	// Write if the oldest pending record is older than this
+	float MaxPendingSeconds;
+
+	// Time of the first pending record
+	double FirstPendingTime;
+
+	// Number of journaled events
+	int32 NumRecords;
+};
@@ -6,6 +6,7 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Info.h"
 #include "HAL/ThreadSafeBool.h"
+#include "Individuals/SLIndividualPoseSnapshot.h"
 #include "SLIndividualManager.generated.h"
 
 // Forward declaration
@@ -78,6 +79,14 @@ public:
 	// Spawn or get manager from the world
 	static ASLIndividualManager* GetExistingOrSpawnNew(UWorld* World);
 
+	// Get the pose index layout of the individuals (rebuilt if the cache changed)
+	TSharedPtr<const FSLIndividualPoseLayout, ESPMode::ThreadSafe> GetPoseLayout();
+
+	// Update the cached poses of all individuals and write them to the snapshot (game thread only, returns the number of moved individuals)
+	// bKeepMovedFlags merges the new moved flags with the ones already in the snapshot
+	// Bones are compared against their last reported pose using separate location and rotation tolerances
+	int32 CachePosesToSnapshot(const FSLIndividualPoseTolerance& Tolerance, float Timestamp, FSLIndividualPoseSnapshot& OutSnapshot, bool bKeepMovedFlags = false);
+
 protected:
 	// Clear all cached references
 	void InitReset();
@@ -119,6 +128,9 @@ private:
 	// Remove from cache
 	bool RemoveFromCache(USLIndividualComponent* IC);
 
+	// Build the pose index layout from the current cache
+	void BuildPoseLayout();
+
 	// Triggered by external destruction of individual component
 	UFUNCTION()
 	void OnIndividualComponentDestroyed(USLIndividualComponent* DestroyedComponent);
@@ -177,6 +189,16 @@ private:
 	UPROPERTY(VisibleAnywhere, Transient, Category = "Semantic Logger")
 	TMap<FString, USLIndividualComponent*> IdToIndividualComponents;
 
+	/* World state logger pose snapshot */
+	// Pose index layout, indices follow the Individuals array (reset every time the cache changes)
+	TSharedPtr<FSLIndividualPoseLayout, ESPMode::ThreadSafe> PoseLayout;
+
+	// Version of the last built pose layout
+	int32 PoseLayoutVersion = 0;
+
+	// Last reported bone poses in pose index order (only the bone entries are used)
+	TArray<FVector> BoneRefLocations;
+	TArray<FQuat> BoneRefRotations;
 
 
 
@@ -0,0 +1,104 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Index layout of the individuals poses, built on the game thread by the individual manager,
+ * immutable afterwards and therefore safe to be read from other threads
+ */
+struct FSLIndividualPoseLayout
+{
+	// Version of the layout, incremented every time the layout is rebuilt
+	int32 Version = 0;
+
+	// Id of every individual in pose index order
+	TArray<FString> Ids;
+
+	// Pose index of every skeletal individual
+	TArray<int32> SkeletalPoseIndices;
+
+	// Offset of every skeletal individual into the bone arrays (Num = SkeletalPoseIndices.Num() + 1)
+	TArray<int32> SkeletalBoneOffsets;
+
+	// Pose index of every (virtual) bone, grouped by the skeletal individual
+	TArray<int32> BonePoseIndices;
+
+	// Skeletal bone index of every (virtual) bone, grouped by the skeletal individual
+	TArray<int32> BoneIndices;
+
+	// True if the pose index belongs to a (virtual) bone
+	TBitArray<> BoneFlags;
+
+	// Number of poses in the layout
+	int32 Num() const { return Ids.Num(); };
+
+	// Number of skeletal individuals in the layout
+	int32 NumSkeletal() const { return SkeletalPoseIndices.Num(); };
+
+	// Get the [first, last) range of the bones of the given skeletal individual
+	void GetBoneRange(int32 SkelIdx, int32& OutFirst, int32& OutLast) const
+	{
+		OutFirst = SkeletalBoneOffsets[SkelIdx];
+		OutLast = SkeletalBoneOffsets[SkelIdx + 1];
+	}
+};
+
+/**
+ * Change detection tolerances used when caching the poses into the snapshot (0 marks every pose as moved)
+ */
+struct FSLIndividualPoseTolerance
+{
+	// Transform tolerance of the individuals (FTransform::Equals)
+	float Pose = 0.f;
+
+	// Location tolerance (cm) of the (virtual) bones
+	float BoneLocation = 0.f;
+
+	// Rotation tolerance (degrees) of the (virtual) bones
+	float BoneRotation = 0.f;
+};
+
+/**
+ * Structure-of-arrays snapshot of the individual poses at a given timestamp,
+ * written on the game thread in one pass and consumed by the world state writer
+ */
+struct FSLIndividualPoseSnapshot
+{
+	// Layout describing the pose indices
+	TSharedPtr<const FSLIndividualPoseLayout, ESPMode::ThreadSafe> Layout;
+
+	// Simulation time of the snapshot
+	float Timestamp = 0.f;
+
+	// Locations in pose index order
+	TArray<FVector> Locations;
+
+	// Rotations in pose index order
+	TArray<FQuat> Rotations;
+
+	// True if the pose changed more than the tolerance since the previous snapshot
+	TBitArray<> Moved;
+
+	// Number of set moved flags
+	int32 NumMoved = 0;
+
+	// Resize the containers to the layout, allocations are kept between snapshots
+	void Prepare(const TSharedPtr<const FSLIndividualPoseLayout, ESPMode::ThreadSafe>& InLayout)
+	{
+		Layout = InLayout;
+		const int32 NumPoses = Layout.IsValid() ? Layout->Num() : 0;
+		Locations.SetNumUninitialized(NumPoses, false);
+		Rotations.SetNumUninitialized(NumPoses, false);
+		Moved.Init(false, NumPoses);
+		NumMoved = 0;
+	}
+
+	// Get the pose at the given index as a transform
+	FTransform GetPose(int32 Idx) const { return FTransform(Rotations[Idx], Locations[Idx]); };
+
+	// Check if the snapshot has valid data
+	bool IsValid() const { return Layout.IsValid() && Locations.Num() == Layout->Num(); };
+};
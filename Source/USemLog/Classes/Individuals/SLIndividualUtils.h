@@ -10,6 +10,7 @@
 class USLIndividualComponent;
 class USLBaseIndividual;
 class USLSkeletalDataAsset;
+class FSLMaskColorAllocator;
 //class ASLIndividualManager;
 
 //// Individual types flags
@@ -163,12 +164,11 @@ private:
 	static bool ClearClass(AActor* Actor);
 
 	/* Visual Mask */
-	static bool WriteUniqueVisualMask(AActor* Actor, TArray<FColor>& ConsumedColors, bool bOverwrite);
+	static bool WriteUniqueVisualMask(AActor* Actor, FSLMaskColorAllocator& ColorAllocator, bool bOverwrite);
 	static bool ClearVisualMask(AActor* Actor);
 	
 	/* Visual Mask  Helpers */
 	static TArray<FColor> GetAllConsumedVisualMaskColorsInWorld(UWorld* World);
-	static FColor GenerateRandomUniqueColor(TArray<FColor>& ConsumedColors, int32 NumTrials, int32 MinManhattanDist);
 
 	/* Color helpers */
 	// Get the manhattan distance between the colors
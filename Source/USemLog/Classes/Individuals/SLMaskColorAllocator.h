@@ -0,0 +1,81 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+
+/**
+ * Allocates unique visual mask colors with a guaranteed minimum manhattan distance between them,
+ * the candidates are the points of a face centered cubic lattice in RGB space (taken in a shuffled order),
+ * the consumed colors are indexed in a grid so a check only visits the neighbouring cells
+ */
+class USEMLOG_API FSLMaskColorAllocator
+{
+public:
+	// Ctor, colors closer or equal to the min distance are considered equal
+	FSLMaskColorAllocator(int32 InMinManhattanDist = 17, int32 InMinDistToBlackWhite = 23, int32 Seed = 0);
+
+	// Mark the color as used (e.g. existing masks in the world)
+	void AddConsumedColor(const FColor& Color);
+
+	// Mark the colors as used
+	void AddConsumedColors(const TArray<FColor>& Colors);
+
+	// Check if the color is far enough from the consumed and the reserved (black, white) colors
+	bool IsColorAvailable(const FColor& Color) const;
+
+	// Get a new unique color, random trials are used if the lattice is exhausted (return black if failed)
+	FColor Allocate(int32 NumRandomTrials = 255);
+
+	// Number of consumed colors
+	int32 Num() const { return NumConsumed; };
+
+	// Number of lattice candidates not yet visited
+	int32 NumRemainingCandidates() const { return Candidates.Num() - CandidateIdx; };
+
+private:
+	// Create the shuffled lattice candidates
+	void InitCandidates();
+
+	// Get the grid cell coordinate of the color channel
+	FORCEINLINE int32 GetCellCoord(uint8 Channel) const { return Channel / CellSize; };
+
+	// Get the grid cell index from the cell coordinates
+	FORCEINLINE int32 GetCellIdx(int32 X, int32 Y, int32 Z) const { return (X * NumCellsPerAxis + Y) * NumCellsPerAxis + Z; };
+
+	// Get the manhattan distance between the colors
+	FORCEINLINE static int32 GetManhattanDistance(const FColor& C1, const FColor& C2)
+	{
+		return FMath::Abs(C1.R - C2.R) + FMath::Abs(C1.G - C2.G) + FMath::Abs(C1.B - C2.B);
+	};
+
+private:
+	// Colors closer or equal to this are considered equal
+	int32 MinManhattanDist;
+
+	// Avoid colors close to black or white
+	int32 MinDistToBlackWhite;
+
+	// Size of the grid cells, larger than the min distance, so only the neighbouring cells need to be checked
+	int32 CellSize;
+
+	// Number of grid cells on every axis
+	int32 NumCellsPerAxis;
+
+	// Consumed colors in every grid cell
+	TArray<TArray<FColor>> Cells;
+
+	// Shuffled lattice colors
+	TArray<FColor> Candidates;
+
+	// Next candidate to check (the colors are never freed, so the skipped candidates stay invalid)
+	int32 CandidateIdx;
+
+	// Number of consumed colors
+	int32 NumConsumed;
+
+	// Deterministic shuffling and random trials
+	FRandomStream RandStream;
+};
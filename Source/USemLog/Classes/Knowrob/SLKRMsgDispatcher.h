@@ -9,6 +9,10 @@
 #include "Runtime/SLLoggerStructs.h"
 #include "Knowrob/SLKRWSClient.h"
 #include "SLKRResponseStruct.h"
+#include "Utils/SLLatencyHistogram.h"
+#include "Containers/Queue.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "Async/AsyncWork.h"
 #include "CoreMinimal.h"
 
 // Forward declarations
@@ -21,6 +25,41 @@ class ASLWorldStateLogger;
 
 enum class ESLVizPrimitiveMarkerType : uint8;
 enum class ESLVizMaterialType : uint8;
+class SLKRMsgDispatcher;
+
+/**
+ * Knowrob command decoded on a worker thread, waiting to be dispatched on the game thread
+ */
+struct FSLKRCommand
+{
+#if SL_WITH_PROTO
+	// Decoded message
+	sl_pb::KRAmevaEvent Event;
+#endif // SL_WITH_PROTO
+
+	// Time when the message was received
+	double ReceiveTime = 0.0;
+};
+
+/**
+ * Async task decoding the received messages until the raw queue is empty
+ */
+class FSLKRDecodeTask : public FNonAbandonableTask
+{
+public:
+	// Ctor
+	FSLKRDecodeTask(SLKRMsgDispatcher* InDispatcher) : Dispatcher(InDispatcher) {};
+
+	// Decode the pending messages
+	void DoWork();
+
+	// Needed internally
+	FORCEINLINE TStatId GetStatId() const { RETURN_QUICK_DECLARE_CYCLE_STAT(FSLKRDecodeTask, STATGROUP_ThreadPoolAsyncTasks); }
+
+private:
+	// Owner of the queues
+	SLKRMsgDispatcher* Dispatcher;
+};
 
 /**
  * 
@@ -48,54 +87,73 @@ public:
 
 public:
 	// Parse the proto sequence and trigger function
-	void ProcessProtobuf(std::string ProtoStr);
+	void ProcessProtobuf(const std::string& ProtoStr);
+
+	// Add the received message to be decoded in the background (can be called from any thread)
+	void EnqueueProtobuf(std::string&& ProtoStr);
+
+	// Trigger the functions of the decoded messages (game thread), MaxCommands <= 0 dispatches all, returns the number of dispatched commands
+	int32 DispatchCommands(int32 MaxCommands = 0);
+
+	// Log the per-command latencies
+	void LogStats() const;
 
 private:
+	// Decode the pending messages until the raw queue is empty (worker thread)
+	void DecodePending();
+	friend class FSLKRDecodeTask;
+
+	// Call the function of the decoded command
+	void DispatchCommand(const FSLKRCommand& Command);
+
 #if SL_WITH_PROTO
+	// Fill in the function table
+	void InitCommandHandlers();
+
 	// Load the level 
-	void LoadLevel(sl_pb::LoadLevelParams params);
+	void LoadLevel(const sl_pb::LoadLevelParams& params);
 
 	// Set the task of MongoManager
-	void SetTask(sl_pb::SetTaskParams params);
+	void SetTask(const sl_pb::SetTaskParams& params);
 
 	// Set the episode of MongoManager
-	void SetEpisode(sl_pb::SetEpisodeParams params);
+	void SetEpisode(const sl_pb::SetEpisodeParams& params);
 	
 	// Draw the individual marker
-	void DrawMarker(sl_pb::DrawMarkerAtParams);
+	void DrawMarker(const sl_pb::DrawMarkerAtParams& params);
 
 	// Draw the individual trajectory
-	void DrawMarkerTraj(sl_pb::DrawMarkerTrajParams params);
+	void DrawMarkerTraj(const sl_pb::DrawMarkerTrajParams& params);
 
 	// Hightlight the individual
-	void HighlightIndividual(sl_pb::HighlightParams params);
+	void HighlightIndividual(const sl_pb::HighlightParams& params);
 
 	// Remove the individual hightlight
-	void RemoveIndividualHighlight(sl_pb::RemoveHighlightParams params);
+	void RemoveIndividualHighlight(const sl_pb::RemoveHighlightParams& params);
 
 	// Hightlight the individual
 	void RemoveAllIndividualHighlight();
 
 	// Start Symbolic and World State Logger
-	void StartLogging(sl_pb::StartLoggingParams params);
+	void StartLogging(const sl_pb::StartLoggingParams& params);
 
 	// Stop Symbolic and World Logger
 	void StopLogging();
 
 	// Send the Episode data
-	void SendEpisodeData(sl_pb::GetEpisodeDataParams params);
+	void SendEpisodeData(const sl_pb::GetEpisodeDataParams& params);
 
 	// Start Simulation
-	void StartSimulation(sl_pb::StartSimulationParams params);
+	void StartSimulation(const sl_pb::StartSimulationParams& params);
 
 	// Stop Simulation
-	void StopSimulation(sl_pb::StopSimulationParams params);
+	void StopSimulation(const sl_pb::StopSimulationParams& params);
 
 	// Set the pose of the idividual
-	void SetIndividualPose(sl_pb::SetIndividualPoseParams params);
+	void SetIndividualPose(const sl_pb::SetIndividualPoseParams& params);
 	
 	// Apply force to individual
-	void ApplyForceTo(sl_pb::ApplyForceToParams params);
+	void ApplyForceTo(const sl_pb::ApplyForceToParams& params);
 
 private:
 	// -----  helper function  ------//
@@ -146,4 +204,30 @@ private:
 	// True if the manager is initialized
 	bool bIsInit;
 
+	// Received messages waiting to be decoded (with their receive time)
+	TQueue<TPair<double, std::string>, EQueueMode::Mpsc> RawQueue;
+
+	// Number of messages not yet decoded, the decode task runs while it is non zero
+	FThreadSafeCounter NumPendingRaw;
+
+	// Decoded commands waiting to be dispatched on the game thread
+	TQueue<TSharedPtr<FSLKRCommand, ESPMode::ThreadSafe>, EQueueMode::Spsc> CommandQueue;
+
+	// Worker decoding durations
+	FSLLatencyHistogram DecodeLatency;
+
+#if SL_WITH_PROTO
+	// Command function signature
+	typedef void (*FSLKRCommandHandler)(SLKRMsgDispatcher&, const sl_pb::KRAmevaEvent&);
+
+	// Functions indexed by the command type
+	FSLKRCommandHandler CommandHandlers[sl_pb::KRAmevaEvent::FuncToCall_ARRAYSIZE];
+
+	// Time from receiving until the dispatch, indexed by the command type
+	FSLLatencyHistogram WaitLatency[sl_pb::KRAmevaEvent::FuncToCall_ARRAYSIZE];
+
+	// Execution durations, indexed by the command type
+	FSLLatencyHistogram ExecLatency[sl_pb::KRAmevaEvent::FuncToCall_ARRAYSIZE];
+#endif // SL_WITH_PROTO
+
 };
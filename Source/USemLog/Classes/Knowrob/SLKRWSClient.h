@@ -45,6 +45,12 @@ public:
 	// Send message via websocket
 	void SendResponse(const FSLKRResponse& Response);
 
+	// Stream the file from disk in chunks via websocket
+	bool SendFile(const FString& FilePath, const FString& FileName);
+
+	// Set the size of the file data messages and if their data should be compressed
+	void SetFileTransferParams(int32 InFileChunkSize, bool bInCompressFileData);
+
 protected:
 	/* IWebSocket delegate handlers */
 	// Called on connection
@@ -78,4 +84,10 @@ private:
 
 	// Received message binary
 	TArray<uint8> ReceiveBuffer;
+
+	// Size of the file data messages
+	int32 FileChunkSize;
+
+	// Compress the file data messages
+	bool bCompressFileData;
 };
\ No newline at end of file
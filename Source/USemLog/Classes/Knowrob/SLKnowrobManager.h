@@ -170,6 +170,22 @@ private:
 	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (editcondition = "bKRConnectRetry"))
 	int32 KRConnectRetryMaxNum = INDEX_NONE;
 
+	// Size of the file data messages sent to knowrob
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (ClampMin = 1))
+	int32 KRFileChunkSizeKB = 256;
+
+	// Compress (zlib) the file data messages, the receiver is notified in the file creation message
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
+	bool bKRCompressFileData = false;
+
+	// Decode the knowrob messages on a worker thread and dispatch them in the tick
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
+	bool bKRDecodeInBackground = true;
+
+	// Max number of decoded messages dispatched per tick (0 = all)
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (editcondition = "bKRDecodeInBackground", ClampMin = 0))
+	int32 KRMaxCommandsPerTick = 0;
+
 
 	// Mongo server ip addres
 	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
@@ -6,6 +6,7 @@
 #include "CoreMinimal.h"
 #include "SLMetaScannerStructs.h"
 #include "SLMetaScannerToolkit.h"
+#include "Utils/SLImageWriter.h"
 #include "SLMetaScanner.generated.h"
 
 // Forward declarations
@@ -110,8 +111,11 @@ private:
 	// Clean exit, all the Finish() methods will be triggered
 	void QuitEditor();
 
-	// Save the compressed screenshot image locally
-	void SaveImageLocally(const TArray<uint8>& CompressedBitmap);
+	// Get the local path of the current screenshot image
+	FString GetLocalImagePath() const;
+
+	// Wait for the compressed images of the current scan pose and add them to the scan pose data
+	void AddScanPoseImages();
 
 	// Print progress
 	void PrintProgress() const;
@@ -146,6 +150,12 @@ private:
 	// Contains the data of the current scan in a given camera pose
 	FSLScanPoseData ScanPoseData;
 
+	// Compresses and saves the screenshots in the background
+	FSLImageWriter ImageWriter;
+
+	// View mode name and pending compressed image of every screenshot of the current scan pose
+	TArray<TPair<FString, TSharedPtr<FSLImageWriteResult, ESPMode::ThreadSafe>>> ScanPoseImages;
+
 	//// Pointer to the parent, used for updating the metadata mongo document;
 	//USLMetadataLogger* MetadataLoggerParent;
 	
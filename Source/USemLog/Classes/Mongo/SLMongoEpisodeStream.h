@@ -0,0 +1,232 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Mongo/SLMongoQueryDBHandler.h"
+#include "Async/AsyncWork.h"
+#include "Containers/Queue.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+
+// Forward declarations
+class FSLMongoEpisodeStream;
+
+/**
+ * Episode streaming parameters
+ */
+struct FSLMongoEpisodeStreamParams
+{
+	// Stream the frames starting from this timestamp (negative for the episode start)
+	float StartTs = -1.f;
+
+	// Stream the frames until this timestamp (negative for the episode end)
+	float EndTs = -1.f;
+
+	// Episode time covered by the first chunk (kept small for a fast first frame)
+	float FirstChunkDuration = 1.f;
+
+	// Episode time covered by the following chunks
+	float ChunkDuration = 10.f;
+
+	// Max number of frames in a chunk
+	int32 MaxChunkFrames = 2048;
+
+	// Number of documents the server returns per cursor batch
+	int32 CursorBatchSize = 256;
+
+	// Max number of chunks the consumer adds per tick (the remaining ones are added in the next ticks)
+	int32 MaxChunksPerTick = 4;
+};
+
+/**
+ * Streamed batch of consecutive frames, the individuals are referenced by their id index in the stream
+ */
+struct FSLMongoEpisodeChunk
+{
+	// Id index of the first new id
+	int32 FirstNewIdIdx = 0;
+
+	// Ids seen for the first time in this chunk (id index = FirstNewIdIdx + array index)
+	TArray<FString> NewIds;
+
+	// Timestamp of every frame
+	TArray<float> Timestamps;
+
+	// Offsets of every frame in the pose arrays (Num = Timestamps.Num() + 1)
+	TArray<int32> FrameOffsets;
+
+	// Id index and pose of every stored individual, grouped by frame
+	TArray<int32> IdIndices;
+	TArray<FTransform> Poses;
+
+	// Seconds from the stream start until the chunk was published
+	double PublishLatency = 0.0;
+
+	// Number of frames in the chunk
+	int32 NumFrames() const { return Timestamps.Num(); };
+
+	// Get the [first, last) range of the poses of the frame
+	void GetPoseRange(int32 FrameIndex, int32& OutFirst, int32& OutLast) const
+	{
+		OutFirst = FrameOffsets[FrameIndex];
+		OutLast = FrameOffsets[FrameIndex + 1];
+	};
+};
+
+/**
+ * Async task reading the episode frames with a separate connection and publishing them as chunks
+ */
+class FSLMongoEpisodeStreamTask : public FNonAbandonableTask
+{
+public:
+	// Dtor
+	~FSLMongoEpisodeStreamTask();
+
+#if SL_WITH_LIBMONGO_C
+	// Create the connection to the episode collection (the mongo client is not thread safe)
+	bool Init(const mongoc_uri_t* in_uri, const char* db_name, const char* coll_name,
+		const TMap<int32, FSLMongoCompactPoseLayout>& InCompactLayouts,
+		const FSLMongoEpisodeStreamParams& InParams, FSLMongoEpisodeStream* InStream);
+#endif //SL_WITH_LIBMONGO_C
+
+	// Read the cursor and publish the chunks
+	void DoWork();
+
+	// Needed internally
+	FORCEINLINE TStatId GetStatId() const { RETURN_QUICK_DECLARE_CYCLE_STAT(FSLMongoEpisodeStreamTask, STATGROUP_ThreadPoolAsyncTasks); }
+
+private:
+#if SL_WITH_LIBMONGO_C
+	// Add the individual poses of the verbose frame document to the current chunk
+	bool AddVerboseFrame(const bson_t* doc);
+
+	// Add the packed poses of the compact frame document to the current chunk
+	bool AddCompactFrame(const bson_t* doc);
+#endif //SL_WITH_LIBMONGO_C
+
+	// Get the id index of the individual, new ids are registered in the current chunk
+	int32 GetOrAddIdIdx(const FString& Id);
+
+	// Start a new chunk if the current one covers the chunk duration or frame count
+	void CheckChunkBoundary(float Timestamp);
+
+	// Publish the current chunk to the stream
+	void PublishChunk();
+
+private:
+	// Stream to publish the chunks to
+	FSLMongoEpisodeStream* Stream = nullptr;
+
+	// Streaming parameters
+	FSLMongoEpisodeStreamParams Params;
+
+	// Task (database) of the streamed episode
+	FString TaskId;
+
+	// Layouts of the compact schema, empty for the verbose schema
+	TMap<int32, FSLMongoCompactPoseLayout> CompactLayouts;
+
+	// Layout version to its pose index to id index table (built once per layout)
+	TMap<int32, TArray<int32>> LayoutIdIndices;
+
+	// Id to id index
+	TMap<FString, int32> IdToIdx;
+
+	// Utf8 id of every id index (used for comparing the verbose ids without conversions)
+	TArray<TArray<ANSICHAR>> Utf8Ids;
+
+	// Id index of every individual position in the previous verbose frame (the order rarely changes)
+	TArray<int32> PrevFrameIdIndices;
+
+	// Chunk being filled
+	TSharedPtr<FSLMongoEpisodeChunk, ESPMode::ThreadSafe> CurrChunk;
+
+	// Number of published chunks
+	int32 NumPublishedChunks = 0;
+
+	// Seconds until the first chunk was published (negative if none yet)
+	double FirstChunkLatency = -1.0;
+
+#if SL_WITH_LIBMONGO_C
+	// Separate client of the task
+	mongoc_client_t* client = nullptr;
+
+	// Episode collection
+	mongoc_collection_t* collection = nullptr;
+#endif //SL_WITH_LIBMONGO_C
+};
+
+/**
+ * Episode frames streamed in chunks on a worker thread, consumed in order on the game thread
+ */
+class FSLMongoEpisodeStream
+{
+	friend class FSLMongoEpisodeStreamTask;
+
+public:
+	// Ctor
+	FSLMongoEpisodeStream(const FSLMongoEpisodeStreamParams& InParams = FSLMongoEpisodeStreamParams());
+
+	// Dtor, cancels and waits for the worker
+	~FSLMongoEpisodeStream();
+
+#if SL_WITH_LIBMONGO_C
+	// Connect and start reading the episode in the background
+	bool Start(const mongoc_uri_t* in_uri, const char* db_name, const char* coll_name,
+		const TMap<int32, FSLMongoCompactPoseLayout>& InCompactLayouts);
+#endif //SL_WITH_LIBMONGO_C
+
+	// Stop reading the remaining frames
+	void Cancel() { bCancelled = true; };
+
+	// Get the next chunk in order (false if none is available yet)
+	bool DequeueChunk(TSharedPtr<FSLMongoEpisodeChunk, ESPMode::ThreadSafe>& OutChunk);
+
+	// True if all the frames were read and every chunk was consumed
+	bool IsFinished() const { return bReadDone && Chunks.IsEmpty(); };
+
+	// True if the reading stopped because of an error
+	bool HasFailed() const { return bFailed; };
+
+	// Number of frames read so far
+	int32 GetNumStreamedFrames() const { return NumStreamedFrames.GetValue(); };
+
+	// Task (database) of the streamed episode
+	const FString& GetTaskId() const { return TaskId; };
+
+	// Seconds until the first chunk was published (negative if it was not consumed yet)
+	double GetFirstChunkLatency() const { return FirstChunkLatency; };
+
+	// Streaming parameters
+	const FSLMongoEpisodeStreamParams& GetParams() const { return Params; };
+
+private:
+	// Streaming parameters
+	FSLMongoEpisodeStreamParams Params;
+
+	// Published chunks (single producer, single consumer)
+	TQueue<TSharedPtr<FSLMongoEpisodeChunk, ESPMode::ThreadSafe>, EQueueMode::Spsc> Chunks;
+
+	// Set by the consumer to stop the reading
+	FThreadSafeBool bCancelled;
+
+	// Set by the worker when the cursor is exhausted
+	FThreadSafeBool bReadDone;
+
+	// Set by the worker if the cursor failed
+	FThreadSafeBool bFailed;
+
+	// Number of frames read so far
+	FThreadSafeCounter NumStreamedFrames;
+
+	// Time when the stream was started
+	double StartTime = 0.0;
+
+	// Seconds until the first chunk was published, set by the consumer from the first dequeued chunk
+	double FirstChunkLatency = -1.0;
+
+	// Worker reading the frames
+	FAsyncTask<FSLMongoEpisodeStreamTask>* StreamTask = nullptr;
+};
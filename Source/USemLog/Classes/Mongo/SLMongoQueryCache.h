@@ -0,0 +1,159 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Mongo/SLMongoQueryDBHandler.h"
+#include "Misc/ScopeLock.h"
+
+/**
+ * Type erased cached query result
+ */
+struct FSLMongoQueryCacheValue
+{
+	// Dtor
+	virtual ~FSLMongoQueryCacheValue() {};
+};
+
+/**
+ * Cached query result of the given type
+ */
+template<typename ValueType>
+struct TSLMongoQueryCacheValue : public FSLMongoQueryCacheValue
+{
+	// Init ctor
+	TSLMongoQueryCacheValue(const ValueType& InValue) : Value(InValue) {};
+
+	// Query result
+	ValueType Value;
+};
+
+/**
+ * Memory bounded least recently used cache of the query results, keyed by the query parameters,
+ * thread safe so it can be used by the async query workers as well
+ */
+class FSLMongoQueryCache
+{
+public:
+	// Ctor
+	FSLMongoQueryCache(SIZE_T InMaxSize = 256 * 1024 * 1024) : MaxSize(InMaxSize) {};
+
+	// Dtor
+	~FSLMongoQueryCache() { Empty(); };
+
+	// Set the memory budget in bytes (evicts the least recently used results if needed)
+	void SetMaxSize(SIZE_T InMaxSize);
+
+	// Copy the cached result to the output and mark it as recently used (false if the result is not cached)
+	template<typename ValueType>
+	bool Find(const FString& Key, ValueType& OutValue)
+	{
+		FScopeLock Lock(&CacheCS);
+		if (FEntry** EntryPtr = Entries.Find(Key))
+		{
+			FEntry* Entry = *EntryPtr;
+			Unlink(Entry);
+			LinkHead(Entry);
+			OutValue = static_cast<const TSLMongoQueryCacheValue<ValueType>*>(Entry->Value.Get())->Value;
+			NumHits++;
+			return true;
+		}
+		NumMisses++;
+		return false;
+	};
+
+	// Add the result, the least recently used results are evicted to stay in the memory budget
+	template<typename ValueType>
+	void Add(const FString& Key, const ValueType& Value)
+	{
+		const SIZE_T Size = GetResultSize(Value) + Key.GetAllocatedSize() + sizeof(FEntry);
+		if (Size > MaxSize)
+		{
+			return;
+		}
+		FScopeLock Lock(&CacheCS);
+		Remove(Key);
+		FEntry* Entry = new FEntry();
+		Entry->Key = Key;
+		Entry->Value = MakeUnique<TSLMongoQueryCacheValue<ValueType>>(Value);
+		Entry->Size = Size;
+		LinkHead(Entry);
+		Entries.Add(Key, Entry);
+		CurrSize += Size;
+		EvictToSize(MaxSize);
+	};
+
+	// Remove all the results (the counters are kept)
+	void Empty();
+
+	// Number of cached results
+	int32 Num() const;
+
+	// Memory used by the cached results in bytes
+	SIZE_T GetSize() const;
+
+	// Log the hit, miss and eviction counters and the memory usage
+	void LogStats() const;
+
+	/* Result sizes */
+	static SIZE_T GetResultSize(const FTransform& Value) { return sizeof(Value); };
+	static SIZE_T GetResultSize(const TArray<FTransform>& Value) { return sizeof(Value) + Value.GetAllocatedSize(); };
+	static SIZE_T GetResultSize(const TPair<FTransform, TMap<int32, FTransform>>& Value) { return sizeof(Value) + Value.Value.GetAllocatedSize(); };
+	static SIZE_T GetResultSize(const TArray<TPair<FTransform, TMap<int32, FTransform>>>& Value);
+	static SIZE_T GetResultSize(const FSLMongoTrajectories& Value);
+
+private:
+	/**
+	 * Cached result linked in the recently used order
+	 */
+	struct FEntry
+	{
+		// Query key
+		FString Key;
+
+		// Query result
+		TUniquePtr<FSLMongoQueryCacheValue> Value;
+
+		// Memory used by the entry in bytes
+		SIZE_T Size = 0;
+
+		// Neighbours in the recently used order
+		FEntry* Prev = nullptr;
+		FEntry* Next = nullptr;
+	};
+
+	// Add the entry as the most recently used
+	void LinkHead(FEntry* Entry);
+
+	// Remove the entry from the recently used order
+	void Unlink(FEntry* Entry);
+
+	// Remove the result with the given key (if cached)
+	void Remove(const FString& Key);
+
+	// Evict the least recently used results until the memory usage is within the size
+	void EvictToSize(SIZE_T Size);
+
+private:
+	// Cached results
+	TMap<FString, FEntry*> Entries;
+
+	// Most and least recently used entries
+	FEntry* Head = nullptr;
+	FEntry* Tail = nullptr;
+
+	// Memory budget in bytes
+	SIZE_T MaxSize;
+
+	// Memory used by the cached results in bytes
+	SIZE_T CurrSize = 0;
+
+	// Counters
+	uint64 NumHits = 0;
+	uint64 NumMisses = 0;
+	uint64 NumEvictions = 0;
+
+	// Protects the cache
+	mutable FCriticalSection CacheCS;
+};
@@ -4,6 +4,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Runtime/SLWorldStateCompactSchema.h"
 
 #if SL_WITH_LIBMONGO_C
 class ASLVisionPoseableMeshActor;
@@ -18,11 +19,77 @@ THIRD_PARTY_INCLUDES_START
 THIRD_PARTY_INCLUDES_END
 #endif //SL_WITH_LIBMONGO_C
 
+// Forward declarations
+class FSLMongoEpisodeStream;
+struct FSLMongoEpisodeStreamParams;
+
+/**
+ * Index to id layout of the compact world state schema
+ */
+struct FSLMongoCompactPoseLayout
+{
+	// Id of every individual in pose index order
+	TArray<FString> Ids;
+
+	// Id to pose index
+	TMap<FString, int32> IdToPoseIdx;
+
+	// Skeletal pose index to its bone (bone index, pose index) pairs
+	TMap<int32, TArray<TPair<int32, int32>>> SkeletalBones;
+};
+
+/**
+ * Trajectories of multiple individuals as flat arrays, the samples are grouped by individual and sorted by time
+ */
+struct FSLMongoTrajectories
+{
+	// Queried ids (trajectory index = array index)
+	TArray<FString> Ids;
+
+	// Offsets of every trajectory in the sample arrays (Num = Ids.Num() + 1)
+	TArray<int32> Offsets;
+
+	// Timestamp of every sample
+	TArray<float> Timestamps;
+
+	// Location and rotation of every sample
+	TArray<FVector> Locations;
+	TArray<FQuat> Rotations;
+
+	// Number of trajectories
+	int32 Num() const { return Ids.Num(); };
+
+	// Get the [first, last) range of the samples of the trajectory
+	void GetSampleRange(int32 TrajIdx, int32& OutFirst, int32& OutLast) const
+	{
+		OutFirst = Offsets[TrajIdx];
+		OutLast = Offsets[TrajIdx + 1];
+	};
+
+	// Get the trajectory as transforms
+	TArray<FTransform> GetTrajectory(int32 TrajIdx) const
+	{
+		TArray<FTransform> Trajectory;
+		int32 First;
+		int32 Last;
+		GetSampleRange(TrajIdx, First, Last);
+		Trajectory.Reserve(Last - First);
+		for (int32 SampleIdx = First; SampleIdx < Last; ++SampleIdx)
+		{
+			Trajectory.Emplace(Rotations[SampleIdx], Locations[SampleIdx]);
+		}
+		return Trajectory;
+	};
+};
+
 /**
  * 
  */
 class FSLMongoQueryDBHandler
 {
+	// Uses the static document readers
+	friend class FSLMongoEpisodeStreamTask;
+
 public:
 	// Ctor
 	FSLMongoQueryDBHandler();
@@ -33,6 +100,11 @@ public:
 	// Connect to the server
 	bool Connect(const FString& ServerIp, uint16 ServerPort);
 
+#if SL_WITH_LIBMONGO_C
+	// Connect with a client from the pool (the client is pushed back to the pool on disconnect)
+	bool Connect(mongoc_client_pool_t* InClientPool);
+#endif // SL_WITH_LIBMONGO_C
+
 	// Set database
 	bool SetDatabase(const FString& InDBName);
 
@@ -45,6 +117,9 @@ public:
 	// Everything is set in order to query the data
 	bool IsReady() const { return bConnected && bDatabaseSet && bCollectionSet; };
 
+	// True if the collection was written with the compact pose schema
+	bool IsCompactSchema() const { return CompactLayouts.Num() > 0; };
+
 	/* Queries */
 	// Get the pose of the individual at the given time
 	FTransform GetIndividualPoseAt(const FString& Id, float Ts) const;
@@ -52,6 +127,10 @@ public:
 	// Get the poses of the individual between the given timestamps
 	TArray<FTransform> GetIndividualTrajectory(const FString& Id, float StartTs, float EndTs, float DeltaT = -1.f) const;
 
+	// Get the poses of multiple individuals between the given timestamps with a single query,
+	// with DeltaT the samples are downsampled on the server to the first one of every DeltaT time bucket
+	FSLMongoTrajectories GetIndividualTrajectories(const TArray<FString>& Ids, float StartTs, float EndTs, float DeltaT = -1.f) const;
+
 	// Get skeletal individual pose
 	TPair<FTransform, TMap<int32, FTransform>> GetSkeletalIndividualPoseAt(const FString& Id, float Ts) const;
 
@@ -61,12 +140,18 @@ public:
 	// Get the whole episode data
 	TArray<TPair<float, TMap<FString, FTransform>>> GetEpisodeData() const;
 
-	// Get the whole episode data in an async thread
-	TArray<TPair<float, TMap<FString, FTransform>>> GetEpisodeDataAsync() const;
+	// Stream the episode frames in chunks from a worker thread (nullptr if the stream could not be started)
+	TSharedPtr<FSLMongoEpisodeStream, ESPMode::ThreadSafe> StartEpisodeStream(const FSLMongoEpisodeStreamParams& Params) const;
 
 	// Get the episode data at the given timestamp (frame)
 	TMap<FString, FTransform> GetFrameData(float Ts);
 
+	// Get a hash of the collection content computed on the server (empty if it could not be computed), used to detect stale local episode files
+	FString GetContentHash() const;
+
+	// Number of the failed queries so far (compared before and after a query to avoid caching the default values of a failed one)
+	int32 GetNumQueryErrors() const { return NumQueryErrors; };
+
 private:
 #if SL_WITH_LIBMONGO_C
 	/* Helpers */
@@ -74,10 +159,56 @@ private:
 	FTransform GetPose(const bson_t* doc) const;
 
 	// Get the pose data from bson iterator
-	FTransform GetPose(const bson_iter_t* iter) const;
+	static FTransform GetPose(const bson_iter_t* iter);
+
+	// Get the bone poses from the document (existing entries are kept unless overwrite is set)
+	void GetBonePoses(const bson_t* doc, bool bOverwrite, TMap<int32, FTransform>& OutBonePoses) const;
+
+	// Check if the document is a full keyframe (documents without the flag are treated as keyframes)
+	bool IsKeyframe(const bson_t* doc) const;
+
+	// Get the timestamp of the last keyframe at or before the given time holding the skeletal individual (false if there is none)
+	bool FindSkeletalKeyframeTs(const FString& Id, float Ts, float& OutKeyframeTs) const;
 
 	// Get the timestamp value from document (used for trajectory delta time comparison)
 	double GetTs(const bson_t* doc) const;
+
+	// Move the per individual samples into the flat trajectory arrays
+	static void FlattenTrajectories(TArray<TArray<TPair<float, FTransform>>>& InSamples, FSLMongoTrajectories& OutTrajectories);
+
+	/* Compact schema */
+	// Load the pose layouts of the collection from the meta collection (none if the verbose schema is used)
+	int32 LoadCompactLayouts(const FString& InCollName);
+
+	// Find the frames in the given time range sorted by their timestamp
+	mongoc_cursor_t* FindCompactFrames(float StartTs, float EndTs, bool bDescending) const;
+
+	// Get the timestamp of the last full keyframe at or before the given time (false if there is none)
+	bool FindCompactKeyframeTs(float Ts, float& OutKeyframeTs) const;
+
+	// Check if any of the pose layouts contains the individual
+	bool HasCompactId(const FString& Id) const;
+
+	// Read the compact frame view from the document (false if the document is not a valid compact frame)
+	bool ReadCompactFrame(const bson_t* doc, FSLWorldStateCompactFrame& OutFrame) const;
+
+	// Read the compact frame view from the document without checking its layout
+	static bool ReadCompactFrameView(const bson_t* doc, FSLWorldStateCompactFrame& OutFrame);
+
+	// Get the stored pose from the compact frame
+	static FTransform GetCompactPose(const FSLWorldStateCompactFrame& Frame, int32 Slot);
+
+	// Set the skeletal poses of the individual stored in the frame (return true if any was set)
+	bool ReadCompactSkeletalPoses(const FSLWorldStateCompactFrame& Frame, const FString& Id, bool bOverwrite,
+		TPair<FTransform, TMap<int32, FTransform>>& OutSkeletalPose, bool& bOutRootSet, bool& bOutComplete) const;
+
+	// Compact schema variants of the queries
+	FTransform GetCompactIndividualPoseAt(const FString& Id, float Ts) const;
+	TArray<FTransform> GetCompactIndividualTrajectory(const FString& Id, float StartTs, float EndTs, float DeltaT) const;
+	FSLMongoTrajectories GetCompactIndividualTrajectories(const TArray<FString>& Ids, float StartTs, float EndTs, float DeltaT) const;
+	TPair<FTransform, TMap<int32, FTransform>> GetCompactSkeletalIndividualPoseAt(const FString& Id, float Ts) const;
+	TArray<TPair<FTransform, TMap<int32, FTransform>>> GetCompactSkeletalIndividualTrajectory(const FString& Id, float StartTs, float EndTs, float DeltaT) const;
+	TArray<TPair<float, TMap<FString, FTransform>>> GetCompactEpisodeData() const;
 #endif // SL_WITH_LIBMONGO_C
 
 private:
@@ -90,6 +221,12 @@ private:
 	// Connected to a database
 	bool bCollectionSet;
 
+	// Number of the failed queries (not ready or cursor errors)
+	mutable int32 NumQueryErrors;
+
+	// Pose layouts of the compact schema, empty for the verbose schema
+	TMap<int32, FSLMongoCompactPoseLayout> CompactLayouts;
+
 #if SL_WITH_LIBMONGO_C
 	// Server uri
 	mongoc_uri_t* uri;
@@ -97,6 +234,9 @@ private:
 	// MongoC connection client
 	mongoc_client_t* client;
 
+	// Pool the client was popped from (nullptr if the handler owns the client)
+	mongoc_client_pool_t* client_pool;
+
 	// Database to access
 	mongoc_database_t* database;
 
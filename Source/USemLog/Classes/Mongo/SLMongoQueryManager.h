@@ -6,8 +6,13 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Info.h"
 #include "Mongo/SLMongoQueryDBHandler.h"
+#include "Mongo/SLMongoQueryPool.h"
+#include "Mongo/SLMongoQueryCache.h"
 #include "SLMongoQueryManager.generated.h"
 
+// Forward declarations
+class ASLVizManager;
+
 /**
  * 
  */
@@ -47,6 +52,18 @@ public:
 	// Check if the episode is selected
 	bool IsEpisodeSet() const { return bEpisodeSet; };
 
+	// Get the active task
+	const FString& GetTaskId() const { return TaskId; };
+
+	// Get the active episode
+	const FString& GetEpisodeId() const { return EpisodeId; };
+
+	// Set the viz manager whose cached episodes can answer the pose queries
+	void SetVizManager(ASLVizManager* InVizManager) { VizManager = InVizManager; };
+
+	// Log the query cache counters
+	void LogQueryCacheStats() const { QueryCache.LogStats(); };
+
 	/* Queries */
 	// Get the individual pose
 	FTransform GetIndividualPoseAt(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float Ts);
@@ -58,6 +75,11 @@ public:
 	TArray<FTransform> GetIndividualTrajectory(const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT = -1.f);
 	TArray<FTransform> GetIndividualTrajectory(const FString& IndividualId, float StartTs, float EndTs, float DeltaT = -1.f) const;
 
+	// Get the trajectories of multiple individuals with a single query
+	FSLMongoTrajectories GetIndividualTrajectories(const FString& InTaskId, const FString& InEpisodeId, const TArray<FString>& IndividualIds, float StartTs, float EndTs, float DeltaT = -1.f);
+	FSLMongoTrajectories GetIndividualTrajectories(const FString& InEpisodeId, const TArray<FString>& IndividualIds, float StartTs, float EndTs, float DeltaT = -1.f);
+	FSLMongoTrajectories GetIndividualTrajectories(const TArray<FString>& IndividualIds, float StartTs, float EndTs, float DeltaT = -1.f) const;
+
 	// Get skeletal individual pose
 	TPair<FTransform, TMap<int32, FTransform>> GetSkeletalIndividualPoseAt(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float Ts);
 	TPair<FTransform, TMap<int32, FTransform>> GetSkeletalIndividualPoseAt(const FString& InEpisodeId, const FString& IndividualId, float Ts);
@@ -73,9 +95,77 @@ public:
 	TArray<TPair<float, TMap<FString, FTransform>>> GetEpisodeData(const FString& InEpisodeId);
 	TArray<TPair<float, TMap<FString, FTransform>>> GetEpisodeData() const;
 
+	// Stream the episode data in chunks from a worker thread
+	TSharedPtr<FSLMongoEpisodeStream, ESPMode::ThreadSafe> StartEpisodeStream(const FString& InTaskId, const FString& InEpisodeId, const FSLMongoEpisodeStreamParams& Params);
+	TSharedPtr<FSLMongoEpisodeStream, ESPMode::ThreadSafe> StartEpisodeStream(const FString& InEpisodeId, const FSLMongoEpisodeStreamParams& Params);
+	TSharedPtr<FSLMongoEpisodeStream, ESPMode::ThreadSafe> StartEpisodeStream(const FSLMongoEpisodeStreamParams& Params) const;
+
+	// Get the content hash of the episode (used to detect stale local episode files, empty if it could not be computed)
+	FString GetEpisodeContentHash(const FString& InTaskId, const FString& InEpisodeId);
+	FString GetEpisodeContentHash(const FString& InEpisodeId);
+	FString GetEpisodeContentHash() const;
+
+	/* Async queries, run on the query workers (independent of the active task and episode),
+	 * the callbacks are called on the game thread, the default value is returned if the query fails */
+	// Get the individual pose
+	TSharedFuture<FTransform> GetIndividualPoseAtAsync(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float Ts,
+		TFunction<void(const FTransform&)> OnDone = nullptr);
+
+	// Get the individual trajectory
+	TSharedFuture<TArray<FTransform>> GetIndividualTrajectoryAsync(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT = -1.f,
+		TFunction<void(const TArray<FTransform>&)> OnDone = nullptr);
+
+	// Get the trajectories of multiple individuals with a single query
+	TSharedFuture<FSLMongoTrajectories> GetIndividualTrajectoriesAsync(const FString& InTaskId, const FString& InEpisodeId, const TArray<FString>& IndividualIds, float StartTs, float EndTs, float DeltaT = -1.f,
+		TFunction<void(const FSLMongoTrajectories&)> OnDone = nullptr);
+
+	// Get skeletal individual pose
+	TSharedFuture<TPair<FTransform, TMap<int32, FTransform>>> GetSkeletalIndividualPoseAtAsync(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float Ts,
+		TFunction<void(const TPair<FTransform, TMap<int32, FTransform>>&)> OnDone = nullptr);
+
+	// Get skeletal individual trajectory
+	TSharedFuture<TArray<TPair<FTransform, TMap<int32, FTransform>>>> GetSkeletalIndividualTrajectoryAsync(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT = -1.f,
+		TFunction<void(const TArray<TPair<FTransform, TMap<int32, FTransform>>>&)> OnDone = nullptr);
+
+	// Get the episode data
+	TSharedFuture<TArray<TPair<float, TMap<FString, FTransform>>>> GetEpisodeDataAsync(const FString& InTaskId, const FString& InEpisodeId,
+		TFunction<void(const TArray<TPair<float, TMap<FString, FTransform>>>&)> OnDone = nullptr);
+
+	// Run a custom query on the query workers, the result can be post-processed on the worker before it is returned
+	template<typename ResultType>
+	TSharedFuture<ResultType> QueryAsync(const FString& InTaskId, const FString& InEpisodeId,
+		TFunction<ResultType(const FSLMongoQueryDBHandler&)> QueryFunc, TFunction<void(const ResultType&)> OnDone = nullptr)
+	{
+		return QueryPool.Query<ResultType>(InTaskId, InEpisodeId, QueryFunc, OnDone);
+	};
+
+	// Number of async queries that can run at the same time (0 if the query workers are not connected)
+	int32 GetNumQueryWorkers() const { return QueryPool.IsConnected() ? NumQueryWorkers : 0; };
+
 	// Spawn or get manager from the world
 	static ASLMongoQueryManager* GetExistingOrSpawnNew(UWorld* World);
 
+protected:
+	// Called when actor removed from game or game ended
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	// Get the pose from the episode of the task cached in the viz manager (false if the episode or the individual pose is not cached)
+	bool GetCachedEpisodePoseAt(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float Ts, FTransform& OutPose) const;
+
+	// Get the query cache key from the query parameters
+	static FString GetQueryCacheKey(const TCHAR* QueryName, const FString& InTaskId, const FString& InEpisodeId,
+		const FString& Ids, float StartTs, float EndTs = -1.f, float DeltaT = -1.f);
+
+	// Return the cached result or run the query with the active handler and cache its result
+	template<typename ResultType>
+	ResultType CachedQuery(const FString& Key, TFunctionRef<ResultType()> QueryFunc) const;
+
+	// Return the cached result as a completed future or run the query on a worker and cache its result
+	template<typename ResultType>
+	TSharedFuture<ResultType> CachedQueryAsync(const FString& Key, const FString& InTaskId, const FString& InEpisodeId,
+		TFunction<ResultType(const FSLMongoQueryDBHandler&)> QueryFunc, TFunction<void(const ResultType&)> OnDone);
+
 protected:
 	// True when successfully connected to the server
 	bool bConnected : 1;
@@ -96,6 +186,32 @@ private:
 	// Database handler
 	FSLMongoQueryDBHandler DBHandler;
 
+	// Number of workers (connections) running the async queries
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (ClampMin = 1))
+	int32 NumQueryWorkers = 4;
+
+	// Cache the pose and trajectory query results
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
+	bool bCacheQueryResults = true;
+
+	// Memory budget of the cached query results (MB)
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (editcondition = "bCacheQueryResults", ClampMin = 1))
+	int32 QueryCacheSizeMB = 256;
+
+	// Answer the pose queries from the episodes already cached in the viz manager
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
+	bool bUseCachedEpisodes = true;
+
+	// Least recently used query results (shared with the async query workers, declared first so it outlives them)
+	mutable FSLMongoQueryCache QueryCache;
+
+	// Runs the async queries
+	FSLMongoQueryPool QueryPool;
+
+	// Holds the cached episodes
+	UPROPERTY()
+	ASLVizManager* VizManager;
+
 	///* Editor button hacks */
 	//// Server ip to connect to
 	//UPROPERTY(EditAnywhere, Category = "Semantic Logger|Buttons")
@@ -0,0 +1,170 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Mongo/SLMongoQueryDBHandler.h"
+#include "Async/Async.h"
+#include "Async/AsyncWork.h"
+#include "Async/Future.h"
+#include "HAL/ThreadSafeCounter.h"
+
+// Forward declarations
+class FSLMongoQueryPool;
+
+/**
+ * Pending query, run with the handler of a worker (nullptr if the query is cancelled or the episode could not be selected)
+ */
+struct FSLMongoQueryJob
+{
+	// Task (database) and episode (collection) to query from
+	FString TaskId;
+	FString EpisodeId;
+
+	// Runs the query and completes its promise
+	TFunction<void(const FSLMongoQueryDBHandler*)> Run;
+};
+
+/**
+ * Async task running the pending queries with the handler of a worker until the queue is empty
+ */
+class FSLMongoQueryTask : public FNonAbandonableTask
+{
+public:
+	// Ctor
+	FSLMongoQueryTask(FSLMongoQueryPool* InPool, int32 InWorkerIdx) : Pool(InPool), WorkerIdx(InWorkerIdx) {};
+
+	// Run the pending queries
+	void DoWork();
+
+	// Needed internally
+	FORCEINLINE TStatId GetStatId() const { RETURN_QUICK_DECLARE_CYCLE_STAT(FSLMongoQueryTask, STATGROUP_ThreadPoolAsyncTasks); }
+
+private:
+	// Owner of the queue and the workers
+	FSLMongoQueryPool* Pool;
+
+	// Worker whose handler runs the queries
+	int32 WorkerIdx;
+};
+
+/**
+ * Runs queries on a small number of workers, every worker has its own connection from a mongo client pool
+ * and keeps its task and episode selected between queries, the results are returned as futures
+ */
+class FSLMongoQueryPool
+{
+	// Runs the workers
+	friend class FSLMongoQueryTask;
+
+public:
+	// Ctor
+	FSLMongoQueryPool();
+
+	// Dtor
+	~FSLMongoQueryPool();
+
+	// Create the client pool and connect the workers
+	bool Connect(const FString& ServerIp, uint16 ServerPort, int32 NumWorkers);
+
+	// Cancel the pending queries (completed with default values), wait for the running ones and disconnect
+	void Disconnect();
+
+	// True if the workers are connected
+	bool IsConnected() const { return Workers.Num() > 0; };
+
+	// Number of queued queries
+	int32 NumPending() const;
+
+	// Run the query on a worker, the optional callback is called on the game thread once the query is done
+	// (the future is set on the worker thread, the game thread should not block on it while a callback is pending)
+	template<typename ResultType>
+	TSharedFuture<ResultType> Query(const FString& TaskId, const FString& EpisodeId,
+		TFunction<ResultType(const FSLMongoQueryDBHandler&)> QueryFunc, TFunction<void(const ResultType&)> OnDone = nullptr)
+	{
+		TSharedRef<TPromise<ResultType>, ESPMode::ThreadSafe> Promise = MakeShared<TPromise<ResultType>, ESPMode::ThreadSafe>();
+		TSharedFuture<ResultType> Future = Promise->GetFuture().Share();
+
+		FSLMongoQueryJob Job;
+		Job.TaskId = TaskId;
+		Job.EpisodeId = EpisodeId;
+		Job.Run = [Promise, Future, QueryFunc, OnDone](const FSLMongoQueryDBHandler* Handler)
+		{
+			Promise->SetValue(Handler ? QueryFunc(*Handler) : ResultType());
+			if (OnDone)
+			{
+				AsyncTask(ENamedThreads::GameThread, [Future, OnDone]()
+				{
+					OnDone(Future.Get());
+				});
+			}
+		};
+		AddJob(MoveTemp(Job));
+		return Future;
+	};
+
+	// Return the already known result as a completed future, the optional callback is still deferred to the game thread
+	template<typename ResultType>
+	static TSharedFuture<ResultType> MakeReadyFuture(const ResultType& Result, TFunction<void(const ResultType&)> OnDone = nullptr)
+	{
+		TPromise<ResultType> Promise;
+		TSharedFuture<ResultType> Future = Promise.GetFuture().Share();
+		Promise.SetValue(Result);
+		if (OnDone)
+		{
+			AsyncTask(ENamedThreads::GameThread, [Future, OnDone]()
+			{
+				OnDone(Future.Get());
+			});
+		}
+		return Future;
+	};
+
+private:
+	// Queue the job and start a free worker if available
+	void AddJob(FSLMongoQueryJob&& Job);
+
+	// Run the queued jobs with the worker until the queue is empty
+	void RunWorker(int32 WorkerIdx);
+
+private:
+	/**
+	 * Query handler with its own connection, the selected task and episode are kept between the queries
+	 */
+	struct FSLMongoQueryWorker
+	{
+		// Handler using a client from the pool
+		TUniquePtr<FSLMongoQueryDBHandler> Handler;
+
+		// Selected task and episode (empty if not selected)
+		FString TaskId;
+		FString EpisodeId;
+	};
+
+	// Select the task and episode of the worker if they changed (false if they could not be selected)
+	static bool SelectEpisode(FSLMongoQueryWorker& Worker, const FString& TaskId, const FString& EpisodeId);
+
+	// Workers with their handlers
+	TArray<FSLMongoQueryWorker> Workers;
+
+	// Indices of the workers without a running task
+	TArray<int32> FreeWorkers;
+
+	// Queued jobs in the order they were added
+	TArray<FSLMongoQueryJob> PendingJobs;
+
+	// Protects the queue and the free workers
+	mutable FCriticalSection JobsCS;
+
+	// Number of workers with a running task
+	FThreadSafeCounter NumActiveWorkers;
+
+#if SL_WITH_LIBMONGO_C
+	// Server uri
+	mongoc_uri_t* uri;
+
+	// Thread safe pool of the worker clients
+	mongoc_client_pool_t* client_pool;
+#endif // SL_WITH_LIBMONGO_C
+};
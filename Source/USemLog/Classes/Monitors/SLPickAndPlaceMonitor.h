@@ -7,6 +7,7 @@
 #include "USemLog.h"
 #include "Components/ActorComponent.h"
 #include "SLContactMonitorInterface.h"
+#include "Utils/SLTimeRingBuffer.h"
 #include "SLPickAndPlaceMonitor.generated.h"
 
 // Forward declaration
@@ -230,7 +231,7 @@ private:
 
 	/* PutDown related */
 	// Past locations and time during transport in order to backtrace and detect put-down events
-	TArray<TPair<float, FVector>> RecentMovementBuffer;
+	TSLTimeRingBuffer<FVector> RecentMovementBuffer;
 
 	/* Constants */
 	//constexpr static float UpdateRate = 0.035f;
@@ -245,7 +246,7 @@ private:
 	//constexpr static float MaxPickUpHeight = 12.f;
 
 	// PutDown
-	constexpr static int32 RecentMovementBufferSize = 512;
+	constexpr static int32 RecentMovementBufferMinSize = 128;
 	constexpr static float RecentMovementBufferDuration = 3.3f;
 	constexpr static float PutDownMovementBacktrackDuration = 1.5f;
 
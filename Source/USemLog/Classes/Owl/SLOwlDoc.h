@@ -5,6 +5,7 @@
 
 #include "CoreMinimal.h"
 #include "Owl/SLOwlNode.h"
+#include "Owl/SLOwlWriter.h"
 
 /**
 * OWL document
@@ -189,16 +190,14 @@ public:
 	// Return document as string
 	FString ToString() const
 	{
-		FString Indent = "";
-		FString DocStr = TEXT("<?xml version=\"1.0\" encoding=\"utf-8\"?>\n\n");
-		DocStr += EntityDefinitions.ToString();
-		FSLOwlNode Root(FSLOwlPrefixName("rdf", "RDF"), Namespaces);
-		Root.AddChildNode(OntologyImports);
-		Root.AddChildNodes(PropertyDefinitions);
-		Root.AddChildNodes(DatatypeDefinitions);
-		Root.AddChildNodes(ClassDefinitions);
-		Root.AddChildNodes(Individuals);
-		DocStr += Root.ToString(Indent);
-		return DocStr;
+		FSLOwlWriter Writer;
+		Writer.WriteDoc(*this);
+		return Writer.ToString();
+	}
+
+	// Stream the document to the file
+	bool WriteToFile(const FString& Path) const
+	{
+		return FSLOwlWriter::WriteToFile(*this, Path);
 	}
 };
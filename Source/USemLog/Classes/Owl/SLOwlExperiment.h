@@ -33,8 +33,8 @@ protected:
 	// Array of object individuals
 	TArray<FSLOwlNode> ObjectIndividuals;
 
-	// Set of registered objects (in order to avoid multiple individual declaration)
-	TSet<USLBaseIndividual*> RegisteredObjects;
+	// Ids and classes of the registered objects (in order to avoid multiple individual declaration)
+	TMap<FString, FString> RegisteredObjects;
 
 	// Experiment individual
 	FSLOwlNode ExperimentIndividual;
@@ -61,13 +61,25 @@ public:
 
 	// Add individual instalce value
 	bool RegisterObject(USLBaseIndividual* BI)
+	{
+		return BI ? RegisterObject(BI->GetIdValue(), BI->GetClassValue()) : false;
+	}
+
+	// Add individual id and class value (used when the individual itself is not available, e.g. events read from a journal)
+	bool RegisterObject(const FString& InId, const FString& InClass)
 	{
 		// Avoid logging the same individual multiple times
-		bool bIsAlreadyInSet = false;
-		RegisteredObjects.Add(BI, &bIsAlreadyInSet);
-		return bIsAlreadyInSet;
+		if (RegisteredObjects.Contains(InId))
+		{
+			return true;
+		}
+		RegisteredObjects.Add(InId, InClass);
+		return false;
 	}
 
+	// Get the ids and classes of the registered objects
+	const TMap<FString, FString>& GetRegisteredObjects() const { return RegisteredObjects; };
+
 	// Create and add experiment node individual
 	void AddExperimentIndividual(const TArray<FString>& SubActionIds, const FString& SemMapId, const FString& TaskId)
 	{
@@ -178,9 +190,9 @@ private:
 		}
 
 		// Create and add time individuals
-		for (const auto& BI : RegisteredObjects)
+		for (const auto& IdClassPair : RegisteredObjects)
 		{
-			ObjectIndividuals.Add(CreateObjectIndividual("log", BI->GetIdValue(), BI->GetClassValue()));
+			ObjectIndividuals.Add(CreateObjectIndividual("log", IdClassPair.Key, IdClassPair.Value));
 		}
 	}
 
@@ -152,78 +152,80 @@ public:
 	FString ToString(FString& Indent) const
 	{
 		FString NodeStr;
+		AppendToString(NodeStr, Indent);
+		return NodeStr;
+	}
+
+	// Append the node to the string (the children are appended in place instead of concatenating their copies)
+	void AppendToString(FString& OutStr, FString& Indent) const
+	{
 		// Add comment
 		if (!Comment.IsEmpty())
 		{
-			NodeStr += TEXT("\n") + Indent + TEXT("<!-- ") + Comment + TEXT(" -->\n");
+			OutStr += TEXT("\n");
+			OutStr += Indent;
+			OutStr += TEXT("<!-- ");
+			OutStr += Comment;
+			OutStr += TEXT(" -->\n");
 		}
 
 		// Comment only OR empty node
-		if (Name.ToString().IsEmpty())
+		if (Name.IsEmpty())
 		{
-			return NodeStr;
+			return;
 		}
 
 		// Add node name
-		NodeStr += Indent + TEXT("<") + Name.ToString();
+		const FString NameStr = Name.ToString();
+		OutStr += Indent;
+		OutStr += TEXT("<");
+		OutStr += NameStr;
 
-		// Add attributes to tag
+		// Add attributes to tag, the last attribute does not have new line
 		for (int32 i = 0; i < Attributes.Num(); ++i)
 		{
-			if (Attributes.Num() == 1)
+			OutStr += TEXT(" ");
+			OutStr += Attributes[i].ToString();
+			if (i < (Attributes.Num() - 1))
 			{
-				NodeStr += TEXT(" ") + Attributes[i].ToString();
-			}
-			else
-			{
-				if (i < (Attributes.Num() - 1))
-				{
-					NodeStr += TEXT(" ") + Attributes[i].ToString() + TEXT("\n") + Indent + INDENT_STEP;
-				}
-				else
-				{
-					// Last attribute does not have new line
-					NodeStr += TEXT(" ") + Attributes[i].ToString();
-				}
+				OutStr += TEXT("\n");
+				OutStr += Indent;
+				OutStr += INDENT_STEP;
 			}
 		}
 
-		// Check node data (children/value)
-		bool bHasChildren = ChildNodes.Num() != 0;
-		bool bHasValue = !Value.IsEmpty();
-			
 		// Node cannot have value and children
-		if (!bHasChildren && !bHasValue)
-		{
-			// No children nor value, close tag
-			NodeStr += TEXT("/>\n");
-		}
-		else if (bHasValue)
+		if (!Value.IsEmpty())
 		{
 			// Node has a value, add value
-			NodeStr += TEXT(">") + Value + TEXT("</") + Name.ToString() + TEXT(">\n");
+			OutStr += TEXT(">");
+			OutStr += Value;
+			OutStr += TEXT("</");
+			OutStr += NameStr;
+			OutStr += TEXT(">\n");
 		}
-		else if(bHasChildren)
+		else if (ChildNodes.Num() != 0)
 		{
-			// Node has children, add children
-			NodeStr += TEXT(">\n");
-			
-			// Increase indentation
+			// Node has children, add children with increased indentation
+			OutStr += TEXT(">\n");
 			Indent += INDENT_STEP;
-			
-			// Iterate children and add nodes
-			for (auto& ChildItr : ChildNodes)
+			for (const auto& ChildItr : ChildNodes)
 			{
-				NodeStr += ChildItr.ToString(Indent);
+				ChildItr.AppendToString(OutStr, Indent);
 			}
-			
-			// Decrease indentation
 			Indent.RemoveFromEnd(INDENT_STEP);
-			
+
 			// Close tag
-			NodeStr += Indent + Value + TEXT("</") + Name.ToString() + TEXT(">\n");
+			OutStr += Indent;
+			OutStr += TEXT("</");
+			OutStr += NameStr;
+			OutStr += TEXT(">\n");
+		}
+		else
+		{
+			// No children nor value, close tag
+			OutStr += TEXT("/>\n");
 		}
-		return NodeStr;
 	}
 
 	/* Static helper functions */
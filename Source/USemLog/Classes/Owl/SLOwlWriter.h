@@ -0,0 +1,91 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Owl/SLOwlNode.h"
+
+// Forward declarations
+struct FSLOwlDoc;
+class FArchive;
+
+/**
+* Streaming owl/rdf-xml serializer, writes the document as utf-8 in a single pass
+* into a reusable buffer which is flushed to the file when it gets full
+*/
+class USEMLOG_API FSLOwlWriter
+{
+public:
+	// Ctor (in memory until a file is opened)
+	FSLOwlWriter(int32 InFlushSize = 1 << 16);
+
+	// Dtor, closes the file if still open
+	~FSLOwlWriter();
+
+	// Stream to the given file (written to a temporary file and moved on close)
+	bool OpenFile(const FString& InPath);
+
+	// Flush the buffer and close the file, return false if any write failed
+	bool Close();
+
+	// Write the whole document
+	void WriteDoc(const FSLOwlDoc& Doc);
+
+	// Write the node and its children with the given indentation depth
+	void WriteNode(const FSLOwlNode& Node, int32 Depth);
+
+	// Get the in memory output as string
+	FString ToString() const;
+
+	// Write the document to the file in a single pass
+	static bool WriteToFile(const FSLOwlDoc& Doc, const FString& Path);
+
+private:
+	// Write the comment and the opening tag with its attributes (without closing the tag)
+	void WriteTagBegin(const FSLOwlNode& Node, int32 Depth);
+
+	// Write the closing tag
+	void WriteTagEnd(const FSLOwlPrefixName& Name, int32 Depth);
+
+	// Write the prefixed name
+	void WritePrefixName(const FSLOwlPrefixName& Name);
+
+	// Write the attribute (key="&ns;value")
+	void WriteAttribute(const FSLOwlAttribute& Attribute);
+
+	// Write the indentation
+	void WriteIndent(int32 Depth);
+
+	// Write the string as utf-8
+	void Write(const FString& Str) { Write(*Str, Str.Len()); };
+	void Write(const TCHAR* Str) { Write(Str, FCString::Strlen(Str)); };
+	void Write(const TCHAR* Str, int32 Len);
+
+	// Write a single ascii character
+	FORCEINLINE void WriteChar(ANSICHAR Char)
+	{
+		Buffer.Add(Char);
+		if (Ar && Buffer.Num() >= FlushSize)
+		{
+			FlushBuffer();
+		}
+	};
+
+	// Write the buffer to the file and reset it (keeps the allocation)
+	void FlushBuffer();
+
+private:
+	// Utf-8 output buffer (the whole output if no file is opened)
+	TArray<ANSICHAR> Buffer;
+
+	// Buffer size which triggers a write to the file
+	int32 FlushSize;
+
+	// File archive, nullptr if writing in memory
+	FArchive* Ar;
+
+	// Final and temporary file paths
+	FString Path;
+	FString TempPath;
+};
@@ -124,6 +124,33 @@ struct FSLLoggerStartParams
 	FName UserInputAudioStopActionName = TEXT("SLAudioStopTrigger");
 };
 
+/* World state writer behaviour when the frame queue is full */
+UENUM()
+enum class ESLWorldStateQueuePolicy : uint8
+{
+	Block				UMETA(DisplayName = "Block"),
+	DropOldest			UMETA(DisplayName = "DropOldest"),
+	Coalesce			UMETA(DisplayName = "Coalesce"),
+};
+
+/* Write concern of the world state inserts */
+UENUM()
+enum class ESLWorldStateWriteConcern : uint8
+{
+	Unacknowledged		UMETA(DisplayName = "Unacknowledged"),
+	Acknowledged		UMETA(DisplayName = "Acknowledged"),
+	Journaled			UMETA(DisplayName = "Journaled"),
+	Majority			UMETA(DisplayName = "Majority"),
+};
+
+/* Document schema of the world state frames */
+UENUM()
+enum class ESLWorldStatePoseSchema : uint8
+{
+	Verbose				UMETA(DisplayName = "Verbose"),
+	Compact				UMETA(DisplayName = "Compact"),
+};
+
 /* Holds the data needed to setup the world state logger */
 USTRUCT()
 struct FSLWorldStateLoggerParams
@@ -142,6 +169,54 @@ struct FSLWorldStateLoggerParams
 	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
 	bool bWriteSparse = true;
 
+	// Min location difference (cm) in order for a (virtual) bone to be logged
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (editcondition = "bWriteSparse"))
+	float BoneLocationTolerance = 0.1f;
+
+	// Min rotation difference (degrees) in order for a (virtual) bone to be logged
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (editcondition = "bWriteSparse"))
+	float BoneRotationTolerance = 0.5f;
+
+	// Time (seconds) between full keyframes (all individuals and bones) in sparse mode, 0 writes only the first frame in full
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (editcondition = "bWriteSparse", ClampMin = 0))
+	float KeyframeInterval = 10.f;
+
+	// Verbose (per individual sub-documents) or compact (single binary blob of packed poses per frame, index to id layout in the meta collection)
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
+	ESLWorldStatePoseSchema PoseSchema = ESLWorldStatePoseSchema::Verbose;
+
+	// Max number of frames waiting to be written
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (ClampMin = 2, ClampMax = 1024))
+	int32 QueueSize = 32;
+
+	// What to do when the queue is full (block the game thread until a frame is written, drop the oldest frame, or merge into the newest frame)
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
+	ESLWorldStateQueuePolicy QueuePolicy = ESLWorldStateQueuePolicy::Block;
+
+	// Time (seconds) the game thread can be blocked before a warning is logged (no frames are dropped, it keeps waiting)
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (editcondition = "QueuePolicy==ESLWorldStateQueuePolicy::Block"))
+	float MaxBlockTime = 0.5f;
+
+	// Number of writer workers (each with its own db connection)
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (ClampMin = 1, ClampMax = 8))
+	int32 NumWriterWorkers = 1;
+
+	// Accumulate the frame documents and insert them with a single unordered bulk operation
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
+	bool bBatchInserts = false;
+
+	// Max number of documents in a batch
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (editcondition = "bBatchInserts", ClampMin = 1))
+	int32 BatchSize = 32;
+
+	// Max time (seconds) a document waits in the batch
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger", meta = (editcondition = "bBatchInserts"))
+	float BatchMaxDelay = 0.25f;
+
+	// Write concern of the inserts
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
+	ESLWorldStateWriteConcern WriteConcern = ESLWorldStateWriteConcern::Acknowledged;
+
 	// Include individuals metadata 
 	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
 	bool bIncludeMetadata = true;
@@ -152,6 +227,62 @@ struct FSLWorldStateLoggerParams
 };
 
 
+/* World state writer statistics */
+USTRUCT()
+struct FSLWorldStateWriterStats
+{
+	GENERATED_BODY();
+
+	// Frames added to the queue
+	UPROPERTY(VisibleAnywhere, Category = "Semantic Logger")
+	int32 NumQueued = 0;
+
+	// Frames removed from the queue without being written
+	UPROPERTY(VisibleAnywhere, Category = "Semantic Logger")
+	int32 NumDropped = 0;
+
+	// Frames which failed to be stored in the database
+	UPROPERTY(VisibleAnywhere, Category = "Semantic Logger")
+	int32 NumFailed = 0;
+
+	// Frames merged into a newer frame
+	UPROPERTY(VisibleAnywhere, Category = "Semantic Logger")
+	int32 NumCoalesced = 0;
+
+	// Frames written to the database
+	UPROPERTY(VisibleAnywhere, Category = "Semantic Logger")
+	int32 NumWritten = 0;
+
+	// Times the game thread had to wait for a free slot
+	UPROPERTY(VisibleAnywhere, Category = "Semantic Logger")
+	int32 NumBlocked = 0;
+
+	// Frames currently waiting in the queue
+	UPROPERTY(VisibleAnywhere, Category = "Semantic Logger")
+	int32 NumPending = 0;
+
+	// Document serialization latency (ms)
+	UPROPERTY(VisibleAnywhere, Category = "Semantic Logger")
+	float SerializationP50 = 0.f;
+
+	UPROPERTY(VisibleAnywhere, Category = "Semantic Logger")
+	float SerializationP99 = 0.f;
+
+	// Database insert latency (ms)
+	UPROPERTY(VisibleAnywhere, Category = "Semantic Logger")
+	float InsertP50 = 0.f;
+
+	UPROPERTY(VisibleAnywhere, Category = "Semantic Logger")
+	float InsertP99 = 0.f;
+
+	// Get the stats as string
+	FString ToString() const
+	{
+		return FString::Printf(TEXT("Queued=%d; Written=%d; Failed=%d; Dropped=%d; Coalesced=%d; Blocked=%d; Pending=%d; Serialization p50/p99=%.3f/%.3f ms; Insert p50/p99=%.3f/%.3f ms;"),
+			NumQueued, NumWritten, NumFailed, NumDropped, NumCoalesced, NumBlocked, NumPending,
+			SerializationP50, SerializationP99, InsertP50, InsertP99);
+	}
+};
 
 /* Supported Events Struct*/
 USTRUCT()
@@ -219,6 +350,12 @@ struct FSLSymbolicLoggerParams
 	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
 	FLSymbolicEventsSelection EventsSelection;
 
+	/* Journal */
+	// Append the finished events to a journal file while logging, the owl and timeline files are exported from it in the background
+	// (the events are not kept, so the KnowRob REST calls are made as the events finish instead of at the end of the episode)
+	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
+	bool bWriteEventJournal = false;
+
 	/* Timelines */
 	UPROPERTY(EditAnywhere, Category = "Semantic Logger")
 	bool bWriteTimelines = true;
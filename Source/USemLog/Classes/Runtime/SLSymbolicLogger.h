@@ -9,6 +9,7 @@
 #include "Events/ISLEventHandler.h"
 #include "ROSProlog/SLPrologClient.h"
 #include "Owl/SLOwlExperiment.h"
+#include "Events/SLEventJournal.h"
 #include "Knowrob/SLKRRestClient.h"
 #include "SLSymbolicLogger.generated.h"
 
@@ -49,6 +50,9 @@ protected:
 	// Called when actor removed from game or game ended
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
+	// Called before destroying the object, the journal export should not outlive the logger
+	virtual void BeginDestroy() override;
+
 public:
 	// Init logger (called when the logger is synced externally)
 	void Init(const FSLSymbolicLoggerParams& InLoggerParameters, const FSLLoggerLocationParams& InLocationParameters);
@@ -95,6 +99,12 @@ protected:
 	// Write data to file
 	void WriteToFile();
 
+	// Write the owl and timeline files from the event journal in the background
+	void ExportEventJournal();
+
+	// Get the directory of the output files
+	FString GetOutputDirPath() const;
+
 	// Create events doc template
 	TSharedPtr<FSLOwlExperiment> CreateEventsDocTemplate(
 		ESLOwlExperimentTemplate TemplateType, const FString& InDocId);
@@ -171,9 +181,15 @@ private:
 	ASLIndividualManager* IndividualManager;
 
 
-	// Array of finished events
+	// Array of finished events (empty if the events are journaled)
 	TArray<TSharedPtr<ISLEvent>> FinishedEvents;
 
+	// Append-only file of the finished events
+	FSLEventJournal EventJournal;
+
+	// Writes the pending journal records even if no new events finish
+	FTimerHandle EventJournalFlushTimerHandle;
+
 	// Owl document of the finished events
 	TSharedPtr<FSLOwlExperiment> ExperimentDoc;
 
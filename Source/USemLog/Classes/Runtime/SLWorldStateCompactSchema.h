@@ -0,0 +1,122 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Compact world state schema, shared by the writer and the query handler
+ *
+ * Frame document:	{ timestamp, layout, poses: <bin>, idx: <bin, sparse frames only> }
+ * Layout document:	{ type_id: "pose_layout", episode_id, layout, ids: [..], skel: [{ idx, bones: [{ idx, pose_idx }] }] }
+ *
+ * Poses are packed as float32 [x y z qx qy qz qw] in the pose index order of the layout,
+ * sparse frames additionally store the uint32 pose indices (ascending) of the packed poses
+ */
+struct FSLWorldStateCompactSchema
+{
+	// Type id of the layout document in the meta collection
+	static constexpr const char* LayoutTypeId = "pose_layout";
+
+	// Number of floats per pose
+	static constexpr int32 NumPoseFloats = 7;
+
+	// Number of bytes per pose
+	static constexpr int32 PoseSize = NumPoseFloats * sizeof(float);
+
+	// Number of bytes per index
+	static constexpr int32 IndexSize = sizeof(uint32);
+
+	// Write the pose to the buffer (PoseSize bytes)
+	static void PackPose(const FTransform& Pose, uint8* OutData)
+	{
+		const FVector Loc = Pose.GetLocation();
+		const FQuat Quat = Pose.GetRotation();
+		const float Values[NumPoseFloats] = { (float)Loc.X, (float)Loc.Y, (float)Loc.Z,
+			(float)Quat.X, (float)Quat.Y, (float)Quat.Z, (float)Quat.W };
+		FMemory::Memcpy(OutData, Values, PoseSize);
+	}
+
+	// Read the pose from the buffer (PoseSize bytes, no alignment required)
+	static FTransform UnpackPose(const uint8* InData)
+	{
+		float Values[NumPoseFloats];
+		FMemory::Memcpy(Values, InData, PoseSize);
+		FQuat Quat(Values[3], Values[4], Values[5], Values[6]);
+		Quat.Normalize();
+		return FTransform(Quat, FVector(Values[0], Values[1], Values[2]));
+	}
+
+	// Read the index from the buffer (IndexSize bytes, no alignment required)
+	static int32 UnpackIndex(const uint8* InData)
+	{
+		uint32 Value;
+		FMemory::Memcpy(&Value, InData, IndexSize);
+		return static_cast<int32>(Value);
+	}
+};
+
+/**
+ * Non-owning view of the packed poses of a compact frame document
+ */
+struct FSLWorldStateCompactFrame
+{
+	// Layout version of the frame
+	int32 Layout = INDEX_NONE;
+
+	// Timestamp of the frame
+	float Timestamp = 0.f;
+
+	// Packed poses
+	const uint8* PoseData = nullptr;
+
+	// Packed pose indices (nullptr if all the poses of the layout are stored)
+	const uint8* IndexData = nullptr;
+
+	// Number of stored poses
+	int32 Num = 0;
+
+	// Get the pose index of the i-th stored pose
+	int32 GetPoseIdx(int32 Idx) const
+	{
+		return IndexData ? FSLWorldStateCompactSchema::UnpackIndex(IndexData + Idx * FSLWorldStateCompactSchema::IndexSize) : Idx;
+	}
+
+	// Get the i-th stored pose
+	FTransform GetPose(int32 Idx) const
+	{
+		return FSLWorldStateCompactSchema::UnpackPose(PoseData + Idx * FSLWorldStateCompactSchema::PoseSize);
+	}
+
+	// Find the position of the pose index in the stored poses (INDEX_NONE if not stored)
+	int32 Find(int32 PoseIdx) const
+	{
+		if (IndexData == nullptr)
+		{
+			return PoseIdx >= 0 && PoseIdx < Num ? PoseIdx : INDEX_NONE;
+		}
+
+		// Indices are stored in ascending order
+		int32 Low = 0;
+		int32 High = Num - 1;
+		while (Low <= High)
+		{
+			const int32 Mid = Low + (High - Low) / 2;
+			const int32 MidPoseIdx = GetPoseIdx(Mid);
+			if (MidPoseIdx == PoseIdx)
+			{
+				return Mid;
+			}
+			else if (MidPoseIdx < PoseIdx)
+			{
+				Low = Mid + 1;
+			}
+			else
+			{
+				High = Mid - 1;
+			}
+		}
+		return INDEX_NONE;
+	}
+};
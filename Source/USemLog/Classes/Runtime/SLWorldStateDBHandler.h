@@ -5,6 +5,7 @@
 
 #include "CoreMinimal.h"
 #include "Runtime/SLLoggerStructs.h"
+#include "Runtime/SLWorldStateFrameRing.h"
 #include "Async/AsyncWork.h"
 #if SL_WITH_LIBMONGO_C
 class ASLVisionPoseableMeshActor;
@@ -21,40 +22,34 @@ THIRD_PARTY_INCLUDES_END
 
 // Forward declarations
 class ASLIndividualManager;
-class USLBaseIndiviual;
-class USLBoneIndividual;
-class USLVirtualBoneIndividual;
-class USLBoneConstraintIndividual;
 
 /**
- * Async task to write to the database
+ * Async task to write to the database, drains the frame queue until it is empty
  */
 class FSLWorldStateDBWriterAsyncTask : public FNonAbandonableTask
 {
 public:
+	// Dtor
+	~FSLWorldStateDBWriterAsyncTask();
+
 #if SL_WITH_LIBMONGO_C
-	// Set the individuals
-	bool Init(mongoc_collection_t* in_collection, ASLIndividualManager* Manager, float PoseTolerance, bool bInWriteSparse);
+	// Set the collection (and the meta collection for the compact layouts), the frame queue to consume and the write options
+	bool Init(mongoc_collection_t* in_collection, mongoc_collection_t* in_meta_collection,
+		FSLWorldStateFrameRing* InFrameRing, const FSLWorldStateLoggerParams& InLoggerParameters);
 #endif //SL_WITH_LIBMONGO_C	
 
 	// Do the db writing here
 	void DoWork();
 
+	// Insert the batched documents (call only when the task is done, returns the number of inserted documents)
+	int32 FlushBatch();
+
 	// Needed internally
 	FORCEINLINE TStatId GetStatId() const { RETURN_QUICK_DECLARE_CYCLE_STAT(FAnalyzeMaterialTreeAsyncTask, STATGROUP_ThreadPoolAsyncTasks); }
 
-	// Set the simulation time
-	void SetTimestamp(float InTs) { Timestamp = InTs; };
-
 private:
-	// First write where all the individuals are written irregardresly of their previous position
-	int32 FirstWrite();
-
-	// Write sparse (only individuals that moved)
-	int32 WriteSparse();
-
-	// Write all individuals (event if they did not move)
-	int32 WriteAll();
+	// Write or batch the given frame, false if the upload failed
+	bool WriteFrame(const FSLWorldStateFrame& Frame);
 
 #if SL_WITH_LIBMONGO_C
 	// Add timestamp to the bson doc
@@ -66,49 +61,78 @@ private:
 	// Add only the individuals that moved (return the number of individuals added)
 	int32 AddIndividualsThatMoved(bson_t* doc);
 
-	// Add skeletal individuals (return the number of individuals added)
-	int32 AddSkeletalIndividals(bson_t* doc);
+	// Add skeletal individuals, all or only the ones with a moved root or bone (return the number of individuals added)
+	int32 AddSkeletalIndividals(bool bWriteAll, bson_t* doc);
 
-	// Add skeletal bones to the document
-	void AddSkeletalBoneIndividuals(const TArray<USLBoneIndividual*>& BoneIndividuals,
-		const TArray<USLVirtualBoneIndividual*>& VirtualBoneIndividuals,
-		bson_t* doc);
-
-	// Add skeletal bone constraints to the document
-	void AddSkeletalConstraintIndividuals(const TArray<USLBoneConstraintIndividual*>& ConstraintIndividuals,
-		bson_t* doc);
-
-	// Add robot individuals (return the number of individuals added)
-	int32 AddRobotIndividuals(bson_t* doc);
+	// Add skeletal bones (all or only the moved ones) of the given skeletal layout index to the document
+	void AddSkeletalBoneIndividuals(int32 SkelIdx, bool bWriteAll, bson_t* doc);
 
 	// Add pose document
 	void AddPose(FTransform Pose, bson_t* doc);
 
+	// Add the layout version and the packed poses (all or only the moved ones) as binary (return the number of poses added)
+	int32 AddCompactPoses(bool bWriteAll, bson_t* doc);
+
+	// Upsert the index to id layout of the current snapshot into the meta collection
+	bool WriteCompactLayout();
+
 	// Write the bson doc to the collection
 	bool UploadDoc(bson_t* doc);
-#endif //SL_WITH_LIBMONGO_C
 
+	// Add the bson doc to the bulk operation, flush if the batch is full
+	void AddToBatch(bson_t* doc);
+#endif //SL_WITH_LIBMONGO_C
 
 private:
-	// DoWork function pointers
-	typedef int32 (FSLWorldStateDBWriterAsyncTask::*WriteTypeFunctionPtr)();
-	WriteTypeFunctionPtr WriteFunctionPtr;
+	// Frames to write, filled on the game thread
+	FSLWorldStateFrameRing* FrameRing = nullptr;
 
-	// Access to the individual manager
-	ASLIndividualManager* IndividualManager;
-
-	// The timestamp to write to the collection
-	float Timestamp;
-
-	// Pose diff tolerance
-	float MinPoseDiff;
+	// Pose snapshot of the frame currently written
+	const FSLIndividualPoseSnapshot* Snapshot = nullptr;
 
 	// Write mode
 	bool bWriteSparse;
 
+	// Write the poses as packed binary blobs
+	bool bCompactSchema = false;
+
+	// Version of the last layout written to the meta collection
+	int32 WrittenLayoutVersion = INDEX_NONE;
+
+	// Reused buffers for the packed poses and indices
+	TArray<uint8> CompactPoseBuffer;
+	TArray<uint32> CompactIndexBuffer;
+
+	// Max number of documents in a bulk operation (1 means no batching)
+	int32 BatchSize = 1;
+
+	// Max time a document waits in the bulk operation
+	float BatchMaxDelay = 0.f;
+
+	// Number of documents in the current bulk operation
+	int32 NumBatched = 0;
+
+	// Time when the first document of the current bulk operation was added
+	double BatchStartTime = 0.0;
+
+	// True if the server acknowledges the writes
+	bool bAcknowledged = true;
+
 #if SL_WITH_LIBMONGO_C
 	// Database collection
 	mongoc_collection_t* mongo_collection;
+
+	// Meta collection (compact layouts)
+	mongoc_collection_t* mongo_meta_collection = nullptr;
+
+	// Insert options (write concern)
+	bson_t* insert_opts = nullptr;
+
+	// Bulk options (unordered, write concern)
+	bson_t* bulk_opts = nullptr;
+
+	// Current bulk operation
+	mongoc_bulk_operation_t* bulk = nullptr;
 #endif //SL_WITH_LIBMONGO_C	
 };
 
@@ -125,39 +149,53 @@ public:
 	// Dtor
 	~FSLWorldStateDBHandler();
 
-	// Connect to the db and set up the async writer
-	bool Init(ASLIndividualManager* IndividualManager,
+	// Connect to the db and set up the async writers
+	bool Init(ASLIndividualManager* InIndividualManager,
 		const FSLWorldStateLoggerParams& InLoggerParameters,
 		const FSLLoggerLocationParams& InLocationParameters,
 		const FSLLoggerDBServerParams& InDBServerParameters);
 
-	// Delegate first job to the async task
+	// Snapshot all the poses and queue them for writing
 	void FirstWrite(float Timestamp);
 
-	// Delegate job to the async task (true if the previous job was done)
+	// Snapshot the poses and queue them for writing (false if a frame was dropped or coalesced)
 	bool Write(float Timestamp);
 
-	// Disconnect from db, clear task
+	// Write the remaining frames, disconnect from db, clear tasks
 	void Finish();
 
+	// Get the writer counters and latencies
+	FSLWorldStateWriterStats GetStats() const { return FrameRing.GetStats(); };
+
 private:
 	// Connect to the database
 	bool Connect(const FString& DBName, const FString& CollName, const FString& ServerIp,
 		uint16 ServerPort, bool bOverwrite);
 
+#if SL_WITH_LIBMONGO_C
+	// Create a separate connection for every additional writer
+	bool ConnectWorkers(int32 NumWorkers);
+#endif //SL_WITH_LIBMONGO_C	
+
 	// Write metadata
-	bool WriteMetadata(ASLIndividualManager* IndividualManager, const FString& MetaCollName, bool bOverwrite);
+	bool WriteMetadata(const FString& MetaCollName, bool bOverwrite);
 
 #if SL_WITH_LIBMONGO_C
-	int32 AddIndividualsMetadata(ASLIndividualManager* IndividualManager, bson_t* doc);
+	int32 AddIndividualsMetadata(bson_t* doc);
 #endif //SL_WITH_LIBMONGO_C	
 
-	// Disconnect and clean db connection
-	void Disconnect() const;
+	// Disconnect and clean db connection (the handles are reset, safe to call multiple times)
+	void Disconnect();
 
 	// Create indexes on the inserted data
 	bool CreateIndexes() const;
 
+	// Snapshot the poses into the queue (false if a frame was dropped or coalesced)
+	bool EnqueueFrame(float Timestamp, const FSLIndividualPoseTolerance& Tolerance, bool bWriteAll);
+
+	// Start the idle writers
+	void StartIdleWriterTasks();
+
 private:
 	// True if connected to the db
 	bool bIsInit;
@@ -168,10 +206,31 @@ private:
 	// Call time of the previous writing task
 	double PrevWriteCallTime;
 
-	// Async writing to the database
-	FAsyncTask<FSLWorldStateDBWriterAsyncTask>* DBWriterTask;
+	// Async writers to the database
+	TArray<FAsyncTask<FSLWorldStateDBWriterAsyncTask>*> DBWriterTasks;
+
+	// Frames waiting to be written
+	FSLWorldStateFrameRing FrameRing;
+
+	// Access to the individuals (game thread only)
+	ASLIndividualManager* IndividualManager;
+
+	// Pose diff tolerances in sparse mode
+	FSLIndividualPoseTolerance SparseTolerance;
+
+	// Time between the full keyframes in sparse mode (0 for no keyframes)
+	float KeyframeInterval;
+
+	// Timestamp of the last full keyframe
+	float LastKeyframeTs;
+
+	// Write mode
+	bool bWriteSparse;
 
 #if SL_WITH_LIBMONGO_C
+	// True if mongoc_init was called and requires a mongoc_cleanup
+	bool bMongocInit;
+
 	// Server uri
 	mongoc_uri_t* uri;
 
@@ -183,5 +242,14 @@ private:
 
 	// Database collection
 	mongoc_collection_t* collection;
+
+	// Connections of the additional writers (mongoc clients are not thread safe)
+	TArray<mongoc_client_t*> worker_clients;
+
+	// Collections of the additional writers
+	TArray<mongoc_collection_t*> worker_collections;
+
+	// Meta collections of every writer (compact schema only)
+	TArray<mongoc_collection_t*> worker_meta_collections;
 #endif //SL_WITH_LIBMONGO_C	
 };
@@ -0,0 +1,130 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Runtime/SLLoggerStructs.h"
+#include "Individuals/SLIndividualPoseSnapshot.h"
+#include "Utils/SLLatencyHistogram.h"
+
+/**
+ * Frame waiting to be written by the world state writer
+ */
+struct FSLWorldStateFrame
+{
+	// Poses of the frame
+	FSLIndividualPoseSnapshot Snapshot;
+
+	// Write all individuals (first frame, or non-sparse logging)
+	bool bWriteAll = false;
+
+	// Time when the frame was queued
+	double QueuedTime = 0.0;
+};
+
+/**
+ * Bounded, lock-free ring of preallocated frames, filled by the game thread and
+ * consumed by one or more writer workers; slot ownership is handed over using atomic state transitions
+ */
+class FSLWorldStateFrameRing
+{
+public:
+	// Ctor
+	FSLWorldStateFrameRing();
+
+	// Preallocate the slots and set the full queue policy
+	void Init(int32 Capacity, ESLWorldStateQueuePolicy InPolicy, float InMaxBlockTime);
+
+	/* Producer (game thread) */
+	// Acquire a slot to fill, bOutMerged is true if the slot still holds an older queued frame (INDEX_NONE on failure),
+	// OnBlocked is called while blocking on a full queue (e.g. to restart the idle writers)
+	int32 BeginEnqueue(bool& bOutMerged, const TFunction<void()>& OnBlocked = nullptr);
+
+	// Publish the filled slot to the writers
+	void EndEnqueue(int32 SlotIdx, bool bWriteAll, bool bMerged);
+
+	/* Consumers (writer workers) */
+	// Claim the oldest queued frame (INDEX_NONE if the queue is empty)
+	int32 TryDequeue();
+
+	// Give the slot back after the frame has been written or batched
+	void Release(int32 SlotIdx);
+
+	// Count frames stored in the database
+	void AddWritten(int32 Num) { NumWritten.Add(Num); };
+
+	// Count frames which failed to be stored in the database
+	void AddFailed(int32 Num) { NumFailed.Add(Num); };
+
+	// Access the frame of a slot owned by the caller
+	FSLWorldStateFrame& GetFrame(int32 SlotIdx) { return Slots[SlotIdx].Frame; };
+
+	// Number of frames queued, being written or batched
+	int32 NumPending() const;
+
+	// True if there are frames waiting to be claimed by a writer
+	bool HasQueued() const { return FindQueued(true) != INDEX_NONE; };
+
+	/* Stats */
+	// Document serialization latency
+	FSLLatencyHistogram& GetSerializationLatency() { return SerializationLatency; };
+
+	// Database insert latency
+	FSLLatencyHistogram& GetInsertLatency() { return InsertLatency; };
+
+	// Get the current counters and latencies
+	FSLWorldStateWriterStats GetStats() const;
+
+private:
+	// Slot ownership states
+	enum ESlotState : int32
+	{
+		Free = 0,
+		Filling = 1,
+		Queued = 2,
+		Writing = 3
+	};
+
+	// Frame with its ownership state
+	struct FSlot
+	{
+		FSLWorldStateFrame Frame;
+		volatile int32 State = Free;
+		volatile int64 Sequence = 0;
+	};
+
+	// Atomically change the state of the slot, true on success
+	bool TryTransition(int32 SlotIdx, ESlotState From, ESlotState To);
+
+	// Claim any free slot for filling
+	int32 AcquireFree();
+
+	// Find the oldest or newest queued slot
+	int32 FindQueued(bool bOldest) const;
+
+private:
+	// Preallocated frames
+	TArray<FSlot> Slots;
+
+	// Full queue policy
+	ESLWorldStateQueuePolicy Policy;
+
+	// Max time to block the producer
+	float MaxBlockTime;
+
+	// Sequence number of the next published frame (producer only)
+	int64 NextSequence;
+
+	// Counters
+	FThreadSafeCounter NumQueued;
+	FThreadSafeCounter NumDropped;
+	FThreadSafeCounter NumFailed;
+	FThreadSafeCounter NumCoalesced;
+	FThreadSafeCounter NumWritten;
+	FThreadSafeCounter NumBlocked;
+
+	// Latencies
+	FSLLatencyHistogram SerializationLatency;
+	FSLLatencyHistogram InsertLatency;
+};
@@ -64,6 +64,9 @@ public:
 	// Check if the manager is running independently
 	bool IsRunningIndependently() const { return bUseIndependently; };
 
+	// Get the db writer counters and latencies (updated every logger tick)
+	const FSLWorldStateWriterStats& GetWriterStats() const { return WriterStats; };
+
 protected:
 	// Init logger (called when the logger is used independently)
 	void InitImpl();
@@ -128,6 +131,10 @@ private:
 	UPROPERTY(VisibleAnywhere, Transient, Category = "Semantic Logger")
 	ASLIndividualManager* IndividualManager;
 
+	// Queued, dropped and written frames, serialization and insert latencies
+	UPROPERTY(VisibleAnywhere, Transient, Category = "Semantic Logger")
+	FSLWorldStateWriterStats WriterStats;
+
 	// Database handler
 	TSharedPtr<FSLWorldStateDBHandler> DBHandler;
 };
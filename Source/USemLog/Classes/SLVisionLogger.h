@@ -13,6 +13,7 @@
 #include "Vision/SLVisionDBHandler.h"
 #include "Vision/SLVisionMaskImageHandler.h"
 #include "Vision/SLVisionOverlapCalc.h"
+#include "Utils/SLImageWriter.h"
 
 #include "SLVisionLogger.generated.h"
 
@@ -21,6 +22,18 @@ class UGameViewportClient;
 class ASLVirtualCameraView;
 class USLSkeletalDataComponent;
 
+/**
+ * Finished frame waiting for its images to be compressed before it is written to the database
+ */
+struct FSLVisionPendingFrame
+{
+	// Vision data of all the views
+	FSLVisionFrameData Data;
+
+	// View index, image type and pending compressed image of every screenshot of the frame
+	TArray<TTuple<int32, FString, TSharedPtr<FSLImageWriteResult, ESPMode::ThreadSafe>>> Images;
+};
+
 /**
  * Replays episodes from different perspectives and view modes,
  * while updating the data with vision related annotations
@@ -130,8 +143,14 @@ private:
 	// Clean exit, all the Finish() methods will be triggered
 	void QuitEditor();
 	
-	// Save the compressed screenshot image locally
-	void SaveImageLocally(const TArray<uint8>& CompressedBitmap);
+	// Get the local path of the current screenshot image
+	FString GetLocalImagePath() const;
+
+	// Queue the current frame, it is written once its images are compressed
+	void QueueCurrFrame();
+
+	// Write the frames with compressed images in order, block on the oldest frames while more than the given number are pending
+	void WritePendingFrames(int32 MaxPending);
 	
 	// Output progress to terminal
 	void PrintProgress() const;
@@ -175,6 +194,18 @@ private:
 	// Holds the current view vision data
 	FSLVisionViewData CurrViewData;
 
+	// Compresses and saves the screenshots in the background
+	FSLImageWriter ImageWriter;
+
+	// View index, image type and pending compressed image of every screenshot of the current frame
+	TArray<TTuple<int32, FString, TSharedPtr<FSLImageWriteResult, ESPMode::ThreadSafe>>> CurrFrameImages;
+
+	// Finished frames waiting for their compressed images (in order)
+	TArray<FSLVisionPendingFrame> PendingFrames;
+
+	// Max number of finished frames waiting for their images before the logger blocks
+	int32 MaxPendingFrames;
+
 	// Map from the skeletal entities to the poseable meshes
 	UPROPERTY() // Avoid GC
 	TMap<ASkeletalMeshActor*, ASLVisionPoseableMeshActor*> SkelToPoseableMap;
@@ -222,4 +253,7 @@ private:
 
 	// Image resolution 
 	FIntPoint Resolution;
+
+	// Encoding of the mask images
+	ESLImageFormat MaskImageFormat;
 };
@@ -0,0 +1,74 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeCounter64.h"
+
+/**
+* Image encodings
+*/
+enum class ESLImageFormat : uint8
+{
+	// Generic, readable everywhere
+	PNG,
+
+	// Fast lossless run-length encoding, for images with large flat regions (masks)
+	RLE,
+
+	Num
+};
+
+/**
+* Thread safe encoding counters of an image format
+*/
+struct FSLImageCodecStats
+{
+	// Number of encoded images
+	FThreadSafeCounter64 NumImages;
+
+	// Size of the raw and the encoded images
+	FThreadSafeCounter64 RawBytes;
+	FThreadSafeCounter64 EncodedBytes;
+
+	// Time spent encoding
+	FThreadSafeCounter64 EncodeMicroseconds;
+
+	// Add an encoded image (can be called from any thread)
+	void Add(int64 InRawBytes, int64 InEncodedBytes, double DurationInSeconds)
+	{
+		NumImages.Increment();
+		RawBytes.Add(InRawBytes);
+		EncodedBytes.Add(InEncodedBytes);
+		EncodeMicroseconds.Add((int64)(DurationInSeconds * 1000000.0));
+	};
+};
+
+/**
+* Image encoders and the decoder of the run-length format
+*
+* RLE layout (little endian):
+*	uint32 magic ("SLRL"), uint32 version, int32 width, int32 height, int32 rows per tile, int32 number of tiles,
+*	uint32 tile end offsets (relative to the end of the header),
+*	tiles of runs: uint8 b, g, r, a followed by the run length as a varint (7 bits per byte, high bit set if more follow),
+*	the runs of a tile cover its rows left to right, top to bottom, the tiles are encoded and decoded in parallel
+*/
+class USEMLOG_API FSLImageCodec
+{
+public:
+	// Encode the image in the given format
+	static bool Encode(ESLImageFormat Format, int32 SizeX, int32 SizeY, const TArray<FColor>& Bitmap, TArray<uint8>& OutData);
+
+	// Run-length encode the image, the tiles of rows are encoded in parallel
+	static bool EncodeRLE(int32 SizeX, int32 SizeY, const TArray<FColor>& Bitmap, TArray<uint8>& OutData, int32 RowsPerTile = 64);
+
+	// Decode the run-length encoded image
+	static bool DecodeRLE(const TArray<uint8>& Data, int32& OutSizeX, int32& OutSizeY, TArray<FColor>& OutBitmap);
+
+	// Get the name of the format
+	static const TCHAR* GetFormatName(ESLImageFormat Format);
+
+	// Get the file extension of the format (with the dot)
+	static const TCHAR* GetFileExtension(ESLImageFormat Format);
+};
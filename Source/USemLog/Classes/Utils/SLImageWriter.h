@@ -0,0 +1,122 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/AsyncWork.h"
+#include "HAL/ThreadSafeBool.h"
+#include "Utils/SLImageCodec.h"
+
+/**
+ * Output of an image write job, the compressed image is only valid once the job is done
+ */
+struct FSLImageWriteResult
+{
+	// Compressed image, kept only if requested
+	TArray<uint8> CompressedBitmap;
+
+	// Encoding of the compressed image
+	ESLImageFormat Format = ESLImageFormat::PNG;
+
+	// Set by the worker when the image is compressed and stored
+	FThreadSafeBool bDone = false;
+};
+
+/**
+ * Async task post-processing, compressing and storing a captured image
+ */
+class FSLImageWriteTask : public FNonAbandonableTask
+{
+public:
+	// Ctor
+	FSLImageWriteTask(int32 InSizeX, int32 InSizeY, TArray<FColor>&& InBitmap, const TArray<FString>& InPaths,
+		TFunction<void(TArray<FColor>&)> InPostProcess, bool bInKeepCompressed, ESLImageFormat InFormat,
+		TSharedPtr<FSLImageWriteResult, ESPMode::ThreadSafe> InResult, FSLImageCodecStats* InStats);
+
+	// Post-process, compress and save the image
+	void DoWork();
+
+	// Needed internally
+	FORCEINLINE TStatId GetStatId() const { RETURN_QUICK_DECLARE_CYCLE_STAT(FSLImageWriteTask, STATGROUP_ThreadPoolAsyncTasks); }
+
+private:
+	// Image size
+	int32 SizeX;
+	int32 SizeY;
+
+	// Raw image
+	TArray<FColor> Bitmap;
+
+	// Files to save the compressed image to
+	TArray<FString> Paths;
+
+	// Applied on the raw image before the compression
+	TFunction<void(TArray<FColor>&)> PostProcess;
+
+	// Keep the compressed image in the result
+	bool bKeepCompressed;
+
+	// Image encoding
+	ESLImageFormat Format;
+
+	// Shared with the caller
+	TSharedPtr<FSLImageWriteResult, ESPMode::ThreadSafe> Result;
+
+	// Encoding stats of the format (owned by the writer, which outlives its tasks)
+	FSLImageCodecStats* Stats;
+};
+
+/**
+ * Bounded pool of image write tasks, the screenshot callbacks hand over the raw images
+ * and continue with the next view while the images are compressed and stored in the background
+ */
+class USEMLOG_API FSLImageWriter
+{
+public:
+	// Ctor
+	FSLImageWriter(int32 InMaxPendingImages = 8);
+
+	// Dtor, waits for the pending images
+	~FSLImageWriter();
+
+	// Set the max number of images in flight (new images block the caller until a slot is free)
+	void SetMaxPendingImages(int32 InMaxPendingImages) { MaxPendingImages = FMath::Max(InMaxPendingImages, 1); };
+
+	// Post-process (optional), compress and save the image on a worker thread (no paths skips saving)
+	TSharedPtr<FSLImageWriteResult, ESPMode::ThreadSafe> AddImage(int32 SizeX, int32 SizeY, TArray<FColor>&& Bitmap,
+		const TArray<FString>& Paths, TFunction<void(TArray<FColor>&)> PostProcess = nullptr, bool bKeepCompressed = false,
+		ESLImageFormat Format = ESLImageFormat::PNG);
+
+	// Block until the given image is done (the images are processed in order, the older ones are waited for as well)
+	void Wait(const TSharedPtr<FSLImageWriteResult, ESPMode::ThreadSafe>& Result);
+
+	// Block until all the pending images are done
+	void Flush();
+
+	// Number of images in flight
+	int32 NumPending() const { return PendingTasks.Num(); };
+
+	// Log the number of written images, the time the caller was blocked and the per-format size and throughput
+	void LogStats() const;
+
+private:
+	// Delete the finished tasks from the front of the queue
+	void RemoveDoneTasks();
+
+private:
+	// Max number of images in flight
+	int32 MaxPendingImages;
+
+	// Tasks in the order they were added
+	TArray<FAsyncTask<FSLImageWriteTask>*> PendingTasks;
+
+	// Number of added images
+	int32 NumImages = 0;
+
+	// Seconds the caller was blocked waiting for a free slot
+	double BlockedDuration = 0.0;
+
+	// Encoding stats indexed by the format
+	FSLImageCodecStats FormatStats[(int32)ESLImageFormat::Num];
+};
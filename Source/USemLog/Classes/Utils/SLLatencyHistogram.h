@@ -0,0 +1,50 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeCounter.h"
+
+/**
+ * Thread safe, fixed size, log-scale histogram of durations (microseconds resolution),
+ * used to report percentiles without storing every sample
+ */
+class USEMLOG_API FSLLatencyHistogram
+{
+public:
+	// Ctor
+	FSLLatencyHistogram() {};
+
+	// Add a sample in seconds (can be called from any thread)
+	void AddSample(double DurationInSeconds);
+
+	// Get the approximated percentile (0-1) in milliseconds
+	double GetPercentileMs(float Percentile) const;
+
+	// Get the number of samples
+	int32 Num() const { return NumSamples.GetValue(); };
+
+	// Remove all samples
+	void Reset();
+
+private:
+	// Get the bucket index of the duration in microseconds
+	static int32 GetBucketIdx(double DurationInUs);
+
+	// Get the representative duration (microseconds) of the bucket
+	static double GetBucketValue(int32 BucketIdx);
+
+private:
+	// Number of buckets per power of two
+	static constexpr int32 NumSubBuckets = 4;
+
+	// Covers durations from 1us to ~1h
+	static constexpr int32 NumBuckets = 32 * NumSubBuckets + 1;
+
+	// Sample counts per bucket
+	FThreadSafeCounter Buckets[NumBuckets];
+
+	// Total number of samples
+	FThreadSafeCounter NumSamples;
+};
@@ -0,0 +1,142 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * History of timestamped values, pushing and evicting is O(1) (no shifting),
+ * samples older than the max duration (relative to the newest one) are evicted on push,
+ * if a max duration is set and the buffer is full with samples inside of it, the capacity is doubled,
+ * index 0 is the oldest sample, the timestamps are expected to be non-decreasing
+ */
+template<typename ValueType>
+class TSLTimeRingBuffer
+{
+public:
+	// Timestamp and value
+	typedef TPair<float, ValueType> SampleType;
+
+	// Ctor, a max duration <= 0 only evicts when the capacity is reached (the capacity is then fixed)
+	TSLTimeRingBuffer(int32 InCapacity = 1024, float InMaxDuration = 0.f) { Init(InCapacity, InMaxDuration); };
+
+	// Set the capacity and max duration (removes the samples)
+	void Init(int32 InCapacity, float InMaxDuration)
+	{
+		Samples.SetNum(FMath::Max(InCapacity, 1));
+		MaxDuration = InMaxDuration;
+		Reset();
+	};
+
+	// Remove the samples (keeps the allocation)
+	void Reset()
+	{
+		Head = 0;
+		Count = 0;
+	};
+
+	// Add a new sample, evicts the ones older than the max duration, if full the oldest one is evicted or the capacity grows
+	void Push(float Time, const ValueType& Value)
+	{
+		if (Count == Samples.Num())
+		{
+			if (MaxDuration > 0.f && Time - Samples[Head].Key <= MaxDuration)
+			{
+				Grow();
+			}
+			else
+			{
+				Head = WrapIdx(Head + 1);
+				Count--;
+			}
+		}
+		Samples[WrapIdx(Head + Count)] = SampleType(Time, Value);
+		Count++;
+
+		if (MaxDuration > 0.f)
+		{
+			while (Count > 1 && Time - Samples[Head].Key > MaxDuration)
+			{
+				Head = WrapIdx(Head + 1);
+				Count--;
+			}
+		}
+	};
+
+	// Number of samples
+	int32 Num() const { return Count; };
+
+	// True if there are no samples
+	bool IsEmpty() const { return Count == 0; };
+
+	// Max number of samples
+	int32 GetCapacity() const { return Samples.Num(); };
+
+	// Get the sample at the index (0 is the oldest)
+	const SampleType& operator[](int32 Idx) const
+	{
+		check(Idx >= 0 && Idx < Count);
+		return Samples[WrapIdx(Head + Idx)];
+	};
+
+	// Get the newest sample
+	const SampleType& Last() const { return (*this)[Count - 1]; };
+
+	// Index of the newest sample with the time less or equal to the given one (INDEX_NONE if all are newer)
+	int32 FindLastLessEqual(float Time) const
+	{
+		// First index with a greater time, minus one
+		return FindFirstGreater(Time) - 1;
+	};
+
+	// Index of the oldest sample with the time greater than the given one (Num() if there is none)
+	int32 FindFirstGreater(float Time) const
+	{
+		int32 Low = 0;
+		int32 High = Count;
+		while (Low < High)
+		{
+			const int32 Mid = Low + (High - Low) / 2;
+			if ((*this)[Mid].Key <= Time)
+			{
+				Low = Mid + 1;
+			}
+			else
+			{
+				High = Mid;
+			}
+		}
+		return Low;
+	};
+
+private:
+	// Double the capacity, the samples are moved to the start of the storage in chronological order
+	void Grow()
+	{
+		TArray<SampleType> NewSamples;
+		NewSamples.SetNum(Samples.Num() * 2);
+		for (int32 Idx = 0; Idx < Count; ++Idx)
+		{
+			NewSamples[Idx] = MoveTemp(Samples[WrapIdx(Head + Idx)]);
+		}
+		Samples = MoveTemp(NewSamples);
+		Head = 0;
+	};
+
+	// Wrap the storage index
+	FORCEINLINE int32 WrapIdx(int32 Idx) const { return Idx < Samples.Num() ? Idx : Idx - Samples.Num(); };
+
+private:
+	// Storage, sized to the capacity
+	TArray<SampleType> Samples;
+
+	// Storage index of the oldest sample
+	int32 Head;
+
+	// Number of samples
+	int32 Count;
+
+	// Samples older than this (relative to the newest) are evicted
+	float MaxDuration;
+};
@@ -6,6 +6,7 @@
 #include "CoreMinimal.h"
 #include "Vision/SLVisionStructs.h"
 #include "Animation/SkeletalMeshActor.h"
+#include "Misc/SecureHash.h"
 
 #if SL_WITH_LIBMONGO_C
 class ASLVisionPoseableMeshActor;
@@ -45,7 +46,7 @@ public:
 		FSLVisionEpisode& OutEpisode);
 
 	// Write current frame
-	void WriteFrame(const FSLVisionFrameData& Frame) const;
+	void WriteFrame(const FSLVisionFrameData& Frame);
 
 private:
 	// Remove any previously added vision data from the database
@@ -65,8 +66,14 @@ private:
 		const TMap<ASkeletalMeshActor*, ASLVisionPoseableMeshActor*>& InSkelToPoseableMap,
 		TMap<ASLVisionPoseableMeshActor*, TMap<FName, FTransform>>& OutSkeletalPoses) const;
 
-	// Save image to gridfs, get the file oid and return true if succeeded
-	bool AddToGridFs(const TArray<uint8>& InData, bson_oid_t* out_oid) const;
+	// Save image to gridfs (or reuse the file of an identical image), get the file oid and return true if succeeded
+	bool AddToGridFs(const TArray<uint8>& InData, bson_oid_t* out_oid);
+
+	// Load the content hashes of the images already stored in the gridfs bucket (orphaned files of an interrupted run)
+	void LoadGridFsHashes();
+
+	// Log the number of written and deduplicated images
+	void LogGridFsStats() const;
 
 	// Write the bson doc containing the vision data to the entry corresponding to the timestamp
 	bool WriteToWorldColl_Legacy(bson_t* doc, float Timestamp) const;
@@ -97,5 +104,14 @@ private:
 
 	// Store image binaries
 	mongoc_gridfs_t* gridfs;
+
+	// Content hash (sha1) to the gridfs file of the stored images, also saved in the file metadata
+	TMap<FSHAHash, bson_oid_t> GridFsHashes;
+
+	// Deduplication stats
+	int32 NumGridFsImages = 0;
+	int32 NumGridFsFiles = 0;
+	int64 GridFsImageBytes = 0;
+	int64 GridFsFileBytes = 0;
 #endif //SL_WITH_LIBMONGO_C	
 };
@@ -91,6 +91,10 @@ public:
 	// Load the color to entities mapping
 	bool Init();
 
+	// Use the given color to entities mapping (e.g. synthetic masks)
+	bool Init(const TMap<FColor, FSLVisionMaskEntityInfo>& InRenderedColorToEntityInfo,
+		const TMap<FColor, FSLVisionMaskSkelInfo>& InRenderedColorToSkelInfo);
+
 	// Clear init flag and mappings
 	void Reset();
 
@@ -99,6 +103,24 @@ public:
 
 private:
 	/* Helper functions */
+	// Build the rendered color to slot lookup table from the entity mappings
+	void BuildColorSlots();
+
+	// Get the slot of the packed rendered color (INDEX_NONE if it has no mapping)
+	FORCEINLINE int32 FindColorSlot(uint32 PackedColor) const
+	{
+		uint32 TableIdx = (PackedColor * 0x9E3779B1u) >> (32 - SlotTableBits);
+		while (SlotTableValues[TableIdx] != INDEX_NONE)
+		{
+			if (SlotTableKeys[TableIdx] == PackedColor)
+			{
+				return SlotTableValues[TableIdx];
+			}
+			TableIdx = (TableIdx + 1) & ((1u << SlotTableBits) - 1);
+		}
+		return INDEX_NONE;
+	}
+
 	// Restore the color of the pixel to its original mask value (offseted by screenshot rendering artifacts), returns true if restoration happened
 	bool RestoreColorValueFromArray(FColor& PixelColor, const TArray<FColor>& InOriginalMaskColors, uint8 Tolerance = 13) const;
 
@@ -117,4 +139,21 @@ private:
 
 	// Rendered color to skeletal entity data
 	TMap<FColor, FSLVisionMaskSkelInfo> RenderedColorToSkelInfo;
+
+	// Rendered color and original mask color of every slot
+	TArray<FColor> SlotRenderedColors;
+	TArray<FColor> SlotOriginalColors;
+
+	// Open addressing table of the packed rendered colors and their slots (INDEX_NONE marks an empty entry)
+	TArray<uint32> SlotTableKeys;
+	TArray<int32> SlotTableValues;
+
+	// Log2 of the table size
+	uint32 SlotTableBits;
+
+	// Color data of every slot per image band, reused between the images (only the touched slots are reset)
+	mutable TArray<FSLVisionImageColorInfo> BandColorsData;
+
+	// Slots touched by every band in the current image
+	mutable TArray<TArray<int32>> BandTouchedSlots;
 };
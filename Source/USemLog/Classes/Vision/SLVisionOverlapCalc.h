@@ -32,7 +32,8 @@ public:
 	~USLVisionOverlapCalc();
 
 	// Give control to the overlap calc to pause and start its parent (vision logger)
-	void Init(USLVisionLogger* InParent, FIntPoint InResolution, const FString& InSaveLocallyPath = FString());
+	// (batch mode: the entities with non overlapping screen bounds share the same screenshot)
+	void Init(USLVisionLogger* InParent, FIntPoint InResolution, const FString& InSaveLocallyPath = FString(), bool bInBatchEntities = false);
 
 	// Calculate overlaps for the given scene
 	void Start(struct FSLVisionViewData* CurrViewData, float Timestamp, int32 FrameIdx);
@@ -49,6 +50,16 @@ public:
 	// Get finished state
 	bool IsFinished() const { return bIsFinished; };
 
+	// Count the white (non occluded) pixels inside the rectangle, and check if any of them touches the image edge
+	static void CountNonOccludedPixels(const TArray<FColor>& NonOccludedImage, int32 ImgWidth, int32 ImgHeight,
+		const FIntRect& Rect, int64& OutNum, bool& bOutIsClipped);
+
+	// Get the occlusion percentage from the visible and the non occluded image percentages
+	static float GetOcclusionPercentage(float ImgPerc, float NonOccImgPerc);
+
+	// Greedily group the rectangles into batches without overlapping rectangles (empty rectangles fit in any batch)
+	static void GroupNonOverlappingRects(const TArray<FIntRect>& Rects, TArray<TArray<int32>>& OutBatches);
+
 protected:
 	// Trigger the screenshot on the game thread
 	void RequestScreenshot();
@@ -93,6 +104,22 @@ private:
 	// Calculate overlap
 	void CalculateOverlap(const TArray<FColor>& NonOccludedImage, int32 ImgWidth, int32 ImgHeight);
 
+	/* Batch mode */
+	// Group the entities with non overlapping screen bounds, return false if there are no entities
+	bool BuildEntityBatches();
+
+	// Get the conservative screen rectangle of the actor bounds in the overlap screenshot (false if it cannot be projected)
+	bool GetScreenRect(AStaticMeshActor* SMA, FIntRect& OutRect) const;
+
+	// Apply the non occluding material to all the entities of the current batch
+	void ApplyBatchNonOccludingMaterial();
+
+	// Re-apply the original materials to the entities of the current batch
+	void ReApplyBatchOriginalMaterial();
+
+	// Calculate the overlaps of all the entities of the current batch in a single pass over the image
+	void CalculateBatchOverlaps(const TArray<FColor>& NonOccludedImage, int32 ImgWidth, int32 ImgHeight);
+
 	// Print out the progress in the terminal
 	void PrintProgress() const;
 
@@ -117,6 +144,24 @@ private:
 	// True if the active item is a bone
 	bool bSkelBoneActive;
 
+	// Calculate the entity overlaps in batches
+	bool bBatchEntities;
+
+	// True if the entity batches are active
+	bool bEntityBatchActive;
+
+	// Entity indices of every batch (the screen rectangles of the entities in a batch do not overlap)
+	TArray<TArray<int32>> EntityBatches;
+
+	// Screen rectangle of every entity (full image if the bounds could not be projected)
+	TArray<FIntRect> EntityScreenRects;
+
+	// Mask clone of every entity (nullptr if not found)
+	TArray<AStaticMeshActor*> EntityClones;
+
+	// Index of the active batch
+	int32 EntityBatchIndex;
+
 	// Use this to let the parent know that the overlap calc is done
 	USLVisionLogger* Parent;
 
@@ -7,6 +7,7 @@
 #include "Engine/StaticMeshActor.h"
 #include "Vision/SLVisionPoseableMeshActor.h"
 #include "Vision/SLVirtualCameraView.h"
+#include "Utils/SLImageCodec.h"
 
 /**
 * View modes
@@ -43,6 +44,12 @@ struct FSLVisionLoggerParams
 	// Make screenshots for calculating overlaps smaller for faster logging
 	uint8 OverlapResolutionDivisor;
 
+	// Calculate the overlaps of the entities with non overlapping screen bounds in the same screenshot
+	bool bBatchOverlaps = false;
+
+	// Encoding of the mask images (the other view modes are stored as png)
+	ESLImageFormat MaskImageFormat = ESLImageFormat::PNG;
+
 	// Default ctor
 	FSLVisionLoggerParams() {};
 
@@ -52,12 +59,16 @@ struct FSLVisionLoggerParams
 		FIntPoint InResolution,
 		bool bInIncludeLocally,
 		bool InCalculateOverlaps,
-		uint8 InOverlapResolutionDivisor) :
+		uint8 InOverlapResolutionDivisor,
+		bool bInBatchOverlaps = false,
+		ESLImageFormat InMaskImageFormat = ESLImageFormat::PNG) :
 		UpdateRate(InUpdateRate),
 		Resolution(InResolution),
 		bIncludeLocally(bInIncludeLocally),
 		bCalculateOverlaps(InCalculateOverlaps),
-		OverlapResolutionDivisor(InOverlapResolutionDivisor)
+		OverlapResolutionDivisor(InOverlapResolutionDivisor),
+		bBatchOverlaps(bInBatchOverlaps),
+		MaskImageFormat(InMaskImageFormat)
 	{};
 };
 
@@ -336,11 +347,18 @@ struct FSLVisionImageData
 	// Init ctor
 	FSLVisionImageData(const FString& InType, const TArray<uint8> InData) : Type(InType), Data(InData) {};
 
+	// Init ctor with the encoding
+	FSLVisionImageData(const FString& InType, TArray<uint8>&& InData, ESLImageFormat InFormat) :
+		Type(InType), Data(MoveTemp(InData)), Format(InFormat) {};
+
 	// Image type
 	FString Type;
 
 	// Data
 	TArray<uint8> Data;
+
+	// Encoding of the data
+	ESLImageFormat Format = ESLImageFormat::PNG;
 };
 
 /**
@@ -10,64 +10,185 @@
 
 // Forward declaration
 class UPoseableMeshComponent;
+class ASLIndividualManager;
+class FSLMongoEpisodeStream;
 class APlayerController;
 
 /*
-* Holds the poses of all the individuals in the world
-*/
-struct FSLVizEpisodeFrameData
-{
-	// Array of the actors and their poses
-	TMap<AActor*, FTransform> ActorPoses;
-
-	// Array of the skeletal components and their bone poses (the actor locations are included above)
-	TMap<UPoseableMeshComponent*, TMap<int32, FTransform>> BonePoses;
-};
-
-/*
-* Holds the frames from the recorded episode
+* Holds the frames from the recorded episode as keyframes (every KeyframeInterval frames) plus per frame deltas,
+* poses are addressed by a flat target index (an actor or a poseable mesh bone)
 */
 struct FSLVizEpisodeData
 {
-	// Id of the episode
+	// Episode id
 	FString Id;
 
+	// Task (database) of the episode
+	FString TaskId;
+
 	// Array of the timestamps
 	TArray<float> Timestamps;
 
-	// Array of the compact frames (used for fast gotos)
-	TArray<FSLVizEpisodeFrameData> FullFrames;
+	// Individual id of every target (used to resolve the targets again when loaded from an episode file)
+	TArray<FString> TargetIds;
+
+	// Target index of every individual id (avoids the linear search in the pose queries)
+	TMap<FString, int32> TargetIdToIdx;
+
+	// Frame index of the first sample of every target (INDEX_NONE if the target has no sample)
+	TArray<int32> TargetFirstFrames;
+
+	// Actor of every target (nullptr for bone targets)
+	TArray<AActor*> TargetActors;
 
-	// Array of the compact frames (used for fast replays)
-	TArray<FSLVizEpisodeFrameData> CompactFrames;
+	// Poseable mesh component and bone index of every target (nullptr and INDEX_NONE for actor targets)
+	TArray<UPoseableMeshComponent*> TargetBoneComponents;
+	TArray<int32> TargetBoneIndices;
+
+	// Number of frames between two keyframes
+	int32 KeyframeInterval = 64;
+
+	// Full poses of every keyframe (NumKeyframes x NumTargets, keyframe k holds the state of frame k * KeyframeInterval)
+	TArray<FTransform> KeyframePoses;
+
+	// Offsets of every frame in the delta arrays (Num = Timestamps.Num() + 1)
+	TArray<int32> DeltaOffsets;
+
+	// Target indices and poses that changed in every frame (grouped by frame)
+	TArray<int32> DeltaTargets;
+	TArray<FTransform> DeltaPoses;
 
 	// Default ctor
 	FSLVizEpisodeData() {};
 
-	// Reserve array size ctor
+	// Init ctor
 	FSLVizEpisodeData(int32 ArraySize)
 	{
 		Timestamps.Reserve(ArraySize);
-		FullFrames.Reserve(ArraySize);
-		CompactFrames.Reserve(ArraySize);
+		DeltaOffsets.Reserve(ArraySize + 1);
+	};
+
+	// Number of frames in the episode
+	int32 NumFrames() const { return Timestamps.Num(); };
+
+	// Number of pose targets (actors and bones)
+	int32 NumTargets() const { return TargetActors.Num(); };
+
+	// Number of keyframes
+	int32 NumKeyframes() const { return KeyframeInterval > 0 ? (Timestamps.Num() + KeyframeInterval - 1) / KeyframeInterval : 0; };
+
+	// True if the target index belongs to a bone
+	bool IsBoneTarget(int32 TargetIdx) const { return TargetBoneComponents[TargetIdx] != nullptr; };
+
+	// Get the [first, last) range of the changes of the frame in the delta arrays
+	void GetDeltaRange(int32 FrameIndex, int32& OutFirst, int32& OutLast) const
+	{
+		OutFirst = DeltaOffsets[FrameIndex];
+		OutLast = DeltaOffsets[FrameIndex + 1];
 	};
 
+	// Add a new target, the already stored keyframes get the initial pose of the target (returns the target index)
+	int32 AddTarget(const FString& TargetId, AActor* Actor, UPoseableMeshComponent* BoneComponent, int32 BoneIndex, const FTransform& InitialPose);
+
+	// Append a frame with the given changes, ChangedPoses holds the state of all targets after the changes (used for the keyframes)
+	void AddFrame(float Timestamp, const TArray<TPair<int32, FTransform>>& Changes, const TArray<FTransform>& ChangedPoses);
+
+	// Reconstruct the full poses of the frame from its keyframe and the following deltas (O(KeyframeInterval))
+	void GetFramePoses(int32 FrameIndex, TArray<FTransform>& OutPoses) const;
+
+	// Set the first sample frame of every target from the delta arrays (used when the deltas are loaded as a whole)
+	void SetTargetFirstFrames();
+
+	// Get the pose of the target with the given individual id at the given time (false if the target is missing or has no sample until the given time)
+	bool GetTargetPoseAt(const FString& TargetId, float Ts, FTransform& OutPose) const;
+
+	// Allocated memory of the episode data in bytes
+	SIZE_T GetAllocatedSize() const;
+
 	// Check if there is data in the episode and it is in sync
 	bool IsValid() const 
 	{
-		return Timestamps.Num() > 2 && Timestamps.Num() == FullFrames.Num();
+		return Timestamps.Num() > 2 
+			&& DeltaOffsets.Num() == Timestamps.Num() + 1
+			&& KeyframePoses.Num() == NumKeyframes() * NumTargets();
 	};
 
 	// Clear all the data in the episode
-	void Clear() 
+	void Clear()
 	{
 		Id = "";
+		TaskId = "";
 		Timestamps.Empty(); 
-		FullFrames.Empty();
-		CompactFrames.Empty();
+		TargetIds.Empty();
+		TargetIdToIdx.Empty();
+		TargetFirstFrames.Empty();
+		TargetActors.Empty();
+		TargetBoneComponents.Empty();
+		TargetBoneIndices.Empty();
+		KeyframePoses.Empty();
+		DeltaOffsets.Empty();
+		DeltaTargets.Empty();
+		DeltaPoses.Empty();
 	};
 };
 
+/*
+* Incremental build state of the episode data (the data can be built from a whole episode or from streamed chunks)
+*/
+struct FSLVizEpisodeBuildState
+{
+	// Pose target index of every individual id (INDEX_NONE for the ignored individual types)
+	TMap<FString, int32> IdToTarget;
+
+	// Pose target index of every id index of the episode stream
+	TArray<int32> StreamIdxToTarget;
+
+	// Current poses of all the targets
+	TArray<FTransform> CurrPoses;
+
+	// Reused buffer of the frame changes
+	TArray<TPair<int32, FTransform>> FrameChanges;
+};
+
+/*
+* Replay target of an individual with its current pose, resolved on the game thread so the episode data can be built on worker threads
+*/
+struct FSLVizEpisodeTarget
+{
+	// Actor moved by the individual (nullptr for the bone targets and the ignored individual types)
+	AActor* Actor = nullptr;
+
+	// Poseable mesh component and bone index moved by the individual (nullptr and INDEX_NONE for the actor targets and the ignored individual types)
+	UPoseableMeshComponent* BoneComponent = nullptr;
+	int32 BoneIndex = INDEX_NONE;
+
+	// World pose of the target when it was resolved
+	FTransform InitialPose;
+};
+
+/*
+* Replay state of a poseable mesh, the world poses of the bones are kept and applied in one parent-first pass
+*/
+struct FSLVizReplayPoseableMesh
+{
+	// Replayed component
+	UPoseableMeshComponent* Component = nullptr;
+
+	// Parent index of every bone (the parents come before their children)
+	TArray<int32> ParentIndices;
+
+	// World pose of every bone, the bones missing from the frame keep their previous world pose
+	TArray<FTransform> WorldPoses;
+
+	// Component space pose of every bone, recomputed on apply
+	TArray<FTransform> ComponentSpacePoses;
+
+	// True if any of the bones changed
+	bool bDirty = false;
+};
+
+// Called when all the frames of a streamed episode are loaded
+DECLARE_MULTICAST_DELEGATE_OneParam(FSLVizEpisodeStreamedSignature, TSharedPtr<FSLVizEpisodeData, ESPMode::ThreadSafe> /*EpisodeData*/);
 
 /**
  * Class to load and skim through episodes
@@ -92,14 +213,25 @@ public:
 	// True if initalized
 	bool IsWorldConverted() const { return bWorldSetAsVisualOnly; };
 
-	// Load episode data
-	void LoadEpisode(const FSLVizEpisodeData& InEpisodeData);
+	// Load episode data (the data is shared with the cache, not copied)
+	void LoadEpisode(TSharedPtr<const FSLVizEpisodeData, ESPMode::ThreadSafe> InEpisodeData);
+
+	// Load the episode from the stream, the replay (or the goto) starts as soon as the frames of the start time are streamed
+	// (if the episode is already streaming only the replay parameters are updated)
+	bool LoadEpisodeStream(ASLIndividualManager* IndividualManager, const FString& InEpisodeId,
+		TSharedPtr<FSLMongoEpisodeStream, ESPMode::ThreadSafe> InStream, const FSLVizEpisodePlayParams& PlayParams, bool bPlay);
+
+	// Check if the episode is currently being streamed
+	bool IsEpisodeStreaming(const FString& InEpisodeId) const;
+
+	// Stop streaming, the already loaded frames are kept
+	void CancelEpisodeStream();
 
 	// Check if an episode is loaded
 	bool IsEpisodeLoaded() const { return bEpisodeLoaded; };
 
 	// Get loaded episode id
-	FString GetEpisodeId() const { return EpisodeData.Id; };
+	FString GetEpisodeId() const { return EpisodeData.IsValid() ? EpisodeData->Id : FString(); };
 
 	// Remove episode data
 	void ClearEpisode();
@@ -122,8 +254,8 @@ public:
 	// Play the episode timeline
 	bool PlayTimeline(float StartTime, float EndTime);
 
-	// Set replay parameters (loop replay, frame update rate, number of steps per frame)
-	void SetReplayParams(bool bLoop, float UpdateRate = -1.f, int32 StepSize = 1);
+	// Set replay parameters (loop replay, tick update rate, speed relative to the recorded time, pose interpolation)
+	void SetReplayParams(bool bLoop, float UpdateRate = -1.f, float PlaybackSpeed = 1.f, bool bInterpolate = true);
 
 	// Set replay to pause or play
 	void SetPauseReplay(bool bPause);
@@ -135,14 +267,33 @@ private:
 	// Start replay
 	void StartReplay();
 
-	// Apply frame poses
-	void ApplyPoses(const FSLVizEpisodeFrameData& Frame);
+	// Apply the full poses of all targets
+	void ApplyPoses(const TArray<FTransform>& Poses);
+
+	// Advance the replay time, apply the changed targets and interpolate towards the next frame (return false if there are no more frames)
+	bool AdvanceReplay(double DeltaTime);
+
+	// Set the pose of the target, bone poses are applied with the next ApplyBonePoses call
+	void SetTargetPose(int32 TargetIdx, const FTransform& Pose);
+
+	// Apply the changed bone poses of every poseable mesh in component space (parent-first)
+	void ApplyBonePoses();
 
-	// Apply next frame changes (return false if there are no more frames)
-	bool ApplyNextFrameChanges();
+	// Bind the new targets of the episode data to their poseable mesh replay state
+	void BindReplayTargets();
 
-	// Calculate an approximation of the update rate value to coincide with realtime
-	void CalcRealtimeAproxUpdateRateValue(int32 MaxNumSteps);
+	// Add the replay state of the poseable mesh (returns its index)
+	int32 AddReplayPoseableMesh(UPoseableMeshComponent* PMC);
+
+	// Add the streamed chunks to the episode data, start the replay when enough frames are available
+	void UpdateEpisodeStream();
+
+	// Set the streamed episode as loaded and start the pending replay or goto
+	void StartStreamedEpisode();
+
+public:
+	// Called when all the frames of a streamed episode are loaded
+	FSLVizEpisodeStreamedSignature OnEpisodeStreamed;
 
 protected:
 	// True if the world is set as visual only
@@ -158,7 +309,32 @@ protected:
 	uint8 bReplayRunning : 1;
 
 	// Episode data
-	FSLVizEpisodeData EpisodeData;
+	TSharedPtr<const FSLVizEpisodeData, ESPMode::ThreadSafe> EpisodeData;
+
+	// Reused buffer for reconstructing the frame poses
+	TArray<FTransform> FramePosesBuffer;
+
+	// Active episode stream
+	TSharedPtr<FSLMongoEpisodeStream, ESPMode::ThreadSafe> EpisodeStream;
+
+	// Episode data filled by the stream (the loaded episode data points to it once enough frames are available)
+	TSharedPtr<FSLVizEpisodeData, ESPMode::ThreadSafe> StreamedEpisodeData;
+
+	// Build state of the streamed episode data
+	FSLVizEpisodeBuildState StreamBuildState;
+
+	// Resolves the streamed individual ids
+	UPROPERTY()
+	ASLIndividualManager* StreamIndividualManager;
+
+	// Replay parameters applied once the stream has the start time frames
+	FSLVizEpisodePlayParams StreamPlayParams;
+
+	// True if the streamed episode should be replayed, otherwise it goes to the start time frame
+	uint8 bStreamPlay : 1;
+
+	// Replay end time (negative if the replay runs until the last frame, which can grow while streaming)
+	float ReplayEndTime;
 
 	// Current frame index
 	int32 ActiveFrameIndex;
@@ -169,11 +345,30 @@ protected:
 	// Replay end frame
 	int32 ReplayLastFrameIndex;
 
-	// Replay step size
-	int32 ReplayStepSize;
+	// Episode time of the replay
+	double ReplayTime;
+
+	// Wall-clock time of the last replay update
+	double ReplayWallTime;
+
+	// Replay speed relative to the recorded time
+	float ReplaySpeed;
+
+	// True if the poses are interpolated between the frames
+	uint8 bInterpolateReplay : 1;
+
+	// Replay state of the poseable meshes
+	TArray<FSLVizReplayPoseableMesh> ReplayMeshes;
+
+	// Poseable mesh replay state index of every target (INDEX_NONE for actor targets)
+	TArray<int32> TargetMeshIndices;
+
+	// Targets changed by the frames passed since the last update
+	TArray<int32> ChangedTargets;
+	TBitArray<> ChangedTargetFlags;
 
-	// Default replay update rate
-	float EpisodeDefaultUpdateRate;
+	// Targets interpolated in the current update
+	TBitArray<> InterpolatedTargetFlags;
 };
 
 
@@ -9,8 +9,12 @@
 // Forward declarations
 class UWorld;
 class AActor;
+class UPoseableMeshComponent;
 class ASLIndividualManager;
 struct FSLVizEpisodeData;
+struct FSLVizEpisodeBuildState;
+struct FSLVizEpisodeTarget;
+struct FSLMongoEpisodeChunk;
 
 /**
  * Viz visual parameters (color and material type)
@@ -24,15 +28,58 @@ public:
 	// Add a poseable mesh component clone to the skeletal actors
 	static void AddPoseablMeshComponentsToSkeletalActors(UWorld* World);	
 
-	// Build the full replay episode data from the mongo compact form (returns true if no errors occured)
+	// Build the keyframe + delta replay episode data from the mongo compact form (returns true if no errors occured)
 	static bool BuildEpisodeData(ASLIndividualManager* IndividualManager, 
 		const TArray<TPair<float, TMap<FString, FTransform>>>& InMongoEpisodeData,
 		FSLVizEpisodeData& OutVizEpisodeData);
 
+	// Resolve the replay targets of all the individuals (game thread only)
+	static void GetEpisodeTargets(ASLIndividualManager* IndividualManager, TMap<FString, FSLVizEpisodeTarget>& OutTargets);
+
+	// Build the episode data with the already resolved targets, the world is not accessed so it can run on worker threads (returns true if no errors occured)
+	static bool BuildEpisodeData(const TMap<FString, FSLVizEpisodeTarget>& Targets,
+		const TArray<TPair<float, TMap<FString, FTransform>>>& InMongoEpisodeData,
+		FSLVizEpisodeData& OutVizEpisodeData);
+
+	// Append the frames of the streamed chunk to the episode data (returns true if no errors occured)
+	static bool AddEpisodeChunk(ASLIndividualManager* IndividualManager,
+		const FSLMongoEpisodeChunk& InChunk, FSLVizEpisodeBuildState& BuildState,
+		FSLVizEpisodeData& OutVizEpisodeData);
+
+	// Get the path of the local episode file
+	static FString GetEpisodeFilePath(const FString& TaskId, const FString& EpisodeId);
+
+	// Write the episode data to the local episode file, tagged with the content hash of its mongo collection
+	static bool WriteEpisodeFile(const FString& Path, const FString& ContentHash, const FSLVizEpisodeData& InVizEpisodeData);
+
+	// Read the episode data from the memory mapped local episode file (false if missing, invalid or stale, an empty content hash skips the staleness check)
+	static bool ReadEpisodeFile(ASLIndividualManager* IndividualManager, const FString& Path, const FString& ContentHash,
+		FSLVizEpisodeData& OutVizEpisodeData);
+
 	// Executes a binary search for element Item in array Array using the <= operator (from ProfilerCommon::FBinaryFindIndex)
 	static int32 BinarySearchLessEqual(const TArray<float>& Array, float Value);
 
 private:
+	// Append the mongo frames to the episode data, the target index of every individual id is given by the callback (false on errors)
+	static bool AddEpisodeFrames(const TArray<TPair<float, TMap<FString, FTransform>>>& InMongoEpisodeData,
+		TFunctionRef<bool(const FString&, int32&)> GetTargetIdx, FSLVizEpisodeBuildState& BuildState,
+		FSLVizEpisodeData& OutVizEpisodeData);
+
+	// Add the resolved target to the episode data (returns the target index, INDEX_NONE for the ignored individual types)
+	static int32 AddEpisodeTarget(const FString& Id, const FSLVizEpisodeTarget& Target,
+		FSLVizEpisodeBuildState& BuildState, FSLVizEpisodeData& OutVizEpisodeData);
+
+	// Get the pose target of the individual, unknown individuals are added as new targets (false if the individual does not exist)
+	static bool GetOrAddEpisodeTarget(ASLIndividualManager* IndividualManager, const FString& Id,
+		FSLVizEpisodeBuildState& BuildState, FSLVizEpisodeData& OutVizEpisodeData, int32& OutTargetIdx);
+
+	// Get the actor or the poseable mesh bone moved by the individual (false if the individual does not exist, both are nullptr for the ignored types)
+	static bool GetEpisodeTarget(ASLIndividualManager* IndividualManager, const FString& Id,
+		AActor*& OutActor, UPoseableMeshComponent*& OutBoneComponent, int32& OutBoneIndex);
+
+	// Append the frame with the changes gathered in the build state
+	static void AddEpisodeFrame(float Timestamp, FSLVizEpisodeBuildState& BuildState, FSLVizEpisodeData& OutVizEpisodeData);
+
 	// Check if actor requires any special attention when switching to visual only world (return true if the components should be left alone)
 	static bool IsSpecialCaseActor(AActor* Actor);
 
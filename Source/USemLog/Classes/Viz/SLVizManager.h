@@ -162,11 +162,39 @@ public:
 	bool IsWorldConvertedToVisualizationMode() const;
 
 	// Cache the mongo data into an episode format
-	bool CacheEpisodeData(const FString& Id, const TArray<TPair<float, TMap<FString, FTransform>>>& InMongoEpisodeData);
+	bool CacheEpisodeData(const FString& TaskId, const FString& Id, const TArray<TPair<float, TMap<FString, FTransform>>>& InMongoEpisodeData);
+
+	// Cache the already built episode data (e.g. built on a worker thread)
+	bool CacheEpisodeData(TSharedPtr<FSLVizEpisodeData, ESPMode::ThreadSafe> VizEpisodeData);
+
+	// Resolve the replay targets of all the individuals, used for building episode data on worker threads
+	bool GetEpisodeTargets(TMap<FString, FSLVizEpisodeTarget>& OutTargets) const;
 
 	// Check if the episode is already cached
 	bool IsEpisodeCached(const FString& Id) const { return CachedEpisodeData.Contains(Id); };
 
+	// Get the cached episode (nullptr if not cached)
+	TSharedPtr<const FSLVizEpisodeData, ESPMode::ThreadSafe> GetCachedEpisodeData(const FString& Id) const
+	{
+		const TSharedPtr<FSLVizEpisodeData, ESPMode::ThreadSafe>* EpisodeDataPtr = CachedEpisodeData.Find(Id);
+		return EpisodeDataPtr ? *EpisodeDataPtr : nullptr;
+	};
+
+	// Get the allocated memory (bytes) of the cached episode (0 if not cached)
+	SIZE_T GetCachedEpisodeDataSize(const FString& Id) const;
+
+	// Get the allocated memory (bytes) of all the cached episodes
+	SIZE_T GetCachedEpisodesDataSize() const;
+
+	// Log the allocated memory of every cached episode
+	void LogCachedEpisodesDataSize() const;
+
+	// Cache the episode from its local episode file (false if there is no valid file, an empty content hash skips the staleness check)
+	bool CacheEpisodeFile(const FString& TaskId, const FString& Id, const FString& ContentHash);
+
+	// Write the cached episode to its local episode file (if the episode is still streaming the file is written once it is cached)
+	bool SaveEpisodeFile(const FString& TaskId, const FString& Id, const FString& ContentHash);
+
 	// Load cached episode data
 	bool LoadCachedEpisodeData(const FString& Id);
 
@@ -176,6 +204,13 @@ public:
 	// Goto cached episode frame
 	bool GotoCachedEpisodeFrame(const FString& Id, float Ts);
 
+	// Load the episode from the stream, the replay (or goto) starts with the first streamed frames, the episode is cached once fully streamed
+	bool LoadEpisodeStream(const FString& Id, TSharedPtr<FSLMongoEpisodeStream, ESPMode::ThreadSafe> Stream,
+		const FSLVizEpisodePlayParams& Params, bool bPlay);
+
+	// Check if the episode is currently being streamed
+	bool IsEpisodeStreaming(const FString& Id) const;
+
 	// Change the data into an episode format and load it to the episode replay manager
 	void LoadEpisodeData(const TArray<TPair<float, TMap<FString, FTransform>>>& InCompactEpisodeData);
 
@@ -227,6 +262,9 @@ private:
 
 	// Get the vizualization camera director from the world (or spawn a new one)
 	bool SetCameraDirector();
+
+	// Cache the fully streamed episode
+	void OnEpisodeStreamed(TSharedPtr<FSLVizEpisodeData, ESPMode::ThreadSafe> VizEpisodeData);
 	
 private:
 	// True if the manager is initialized
@@ -265,6 +303,9 @@ private:
 
 
 	/* Cached data */
-	// Episode id to viz episode data
-	TMap<FString, FSLVizEpisodeData> CachedEpisodeData;
+	// Episode id to viz episode data (shared with the episode manager when loaded)
+	TMap<FString, TSharedPtr<FSLVizEpisodeData, ESPMode::ThreadSafe>> CachedEpisodeData;
+
+	// Streamed episode id to the task id and content hash of its local episode file, written once streamed
+	TMap<FString, TPair<FString, FString>> PendingEpisodeFiles;
 };
@@ -140,22 +140,25 @@ struct FSLVizEpisodePlayParams
 	UPROPERTY(EditAnywhere, Category = "Properties")
 	bool bLoop = false;
 
-	// How quickly to move to the next frame (if negative, it will calculate an average update rate from the episode data)
+	// How often to update the replay (if not positive it updates every frame), the replay speed does not depend on it
 	UPROPERTY(EditAnywhere, Category = "Properties")
 	float UpdateRate = -1.f;
 
-	// How many steps to update every frame
+	// Replay speed relative to the recorded (wall-clock) time
+	UPROPERTY(EditAnywhere, Category = "Properties", meta = (ClampMin = 0.01))
+	float PlaybackSpeed = 1.f;
+
+	// Interpolate the poses between the recorded frames
 	UPROPERTY(EditAnywhere, Category = "Properties")
-	int32 StepSize = 1;
+	bool bInterpolate = true;
 
 	// Default ctor
 	FSLVizEpisodePlayParams() {};
 
 	// Init ctor
-	FSLVizEpisodePlayParams(bool bLoopValue, float InUpdateRate, int32 InStepSize, const FString& InTargetViewId) :
+	FSLVizEpisodePlayParams(bool bLoopValue, float InUpdateRate, const FString& InTargetViewId) :
 	bLoop(bLoopValue),
-	UpdateRate(InUpdateRate),
-	StepSize(InStepSize) {}
+	UpdateRate(InUpdateRate) {}
 };
 
 /**
@@ -9,6 +9,107 @@
 
 // Forward declaration
 class ASLKnowrobManager;
+class ASLVizManager;
+class ASLMongoQueryManager;
+struct FSLVizEpisodeData;
+struct FSLVizEpisodeTarget;
+
+/**
+ * Result of a prefetch job, built on a query worker
+ */
+struct FSLVizQEpisodePrefetchResult
+{
+	// Built episode data (nullptr if the episode could not be fetched or built)
+	TSharedPtr<FSLVizEpisodeData, ESPMode::ThreadSafe> VizEpisodeData;
+
+	// Memory of the fetched mongo episode data in bytes (released once the episode is built)
+	SIZE_T TransferSize = 0;
+};
+
+/**
+ * Fetches and builds the episodes concurrently on the mongo query workers,
+ * the finished episodes are published to the viz manager on the game thread
+ */
+class FSLVizQEpisodePrefetch : public TSharedFromThis<FSLVizQEpisodePrefetch, ESPMode::ThreadSafe>
+{
+public:
+	// Ctor
+	FSLVizQEpisodePrefetch(ASLVizManager* InVizManager, ASLMongoQueryManager* InMongoQueryManager,
+		const FString& InTask, SIZE_T InMemoryBudget, bool bInUseEpisodeFiles);
+
+	// Add an episode to prefetch
+	void AddEpisode(const FString& Episode);
+
+	// Start the prefetch (false if it could not be started)
+	bool Start();
+
+private:
+	// Start the next jobs as long as there are free workers and the memory budget allows it
+	void StartNextJobs();
+
+	// Compute the content hash of the episode on a worker
+	void StartHashJob(const FString& Episode);
+
+	// Fetch and build the episode on a worker
+	void StartFetchJob(const FString& Episode, const FString& ContentHash);
+
+	// Load the episode from its local file if it is up to date, otherwise queue its fetch (game thread)
+	void OnEpisodeHashed(const FString& Episode, const FString& ContentHash);
+
+	// Publish the built episode (game thread)
+	void OnEpisodeBuilt(const FString& Episode, const FString& ContentHash, const FSLVizQEpisodePrefetchResult& Result);
+
+	// Count the finished episode and continue with the next jobs (game thread)
+	void OnEpisodeDone(const FString& Episode, bool bCached);
+
+	// Check if the managers are still valid, abort the prefetch otherwise
+	bool CheckManagers();
+
+private:
+	// Managers, only accessed from the game thread
+	TWeakObjectPtr<ASLVizManager> VizManager;
+	TWeakObjectPtr<ASLMongoQueryManager> MongoQueryManager;
+
+	// Task of the episodes
+	FString Task;
+
+	// Check the local episode files first (written once the episodes are built)
+	bool bUseEpisodeFiles;
+
+	// Replay targets of the individuals, resolved once on the game thread and shared (read only) with the workers
+	TSharedPtr<const TMap<FString, FSLVizEpisodeTarget>, ESPMode::ThreadSafe> Targets;
+
+	// Episodes waiting for their content hash
+	TArray<FString> PendingHashes;
+
+	// Episodes waiting to be fetched with their content hashes
+	TArray<TPair<FString, FString>> PendingFetches;
+
+	// Memory budget of all the cached episodes in bytes
+	SIZE_T MemoryBudget;
+
+	// Memory of the cached episodes in bytes
+	SIZE_T UsedMemory = 0;
+
+	// Largest fetched mongo data and built episode, used to estimate the peak memory of the next fetches
+	SIZE_T LargestTransferSize = 0;
+	SIZE_T LargestEpisodeSize = 0;
+
+	// Maximal number of jobs running at the same time
+	int32 MaxRunning = 0;
+
+	// Progress
+	int32 NumTotal = 0;
+	int32 NumRunning = 0;
+	int32 NumFetching = 0;
+	int32 NumFetched = 0;
+	int32 NumCached = 0;
+	int32 NumFailed = 0;
+	int32 NumSkipped = 0;
+
+	// Start time of the prefetch
+	double StartTime = 0.0;
+};
 
 /**
  * 
@@ -28,4 +129,18 @@ protected:
 
 	UPROPERTY(EditAnywhere, Category = "Cache Episodes")
 	TArray<FString> Episodes;
+
+	// Load the episodes from their local files if they are up to date, the files are written after the first load from mongo
+	UPROPERTY(EditAnywhere, Category = "Cache Episodes")
+	bool bUseEpisodeFiles = true;
+
+	// Fetch and build the episodes concurrently on the query workers, the execution returns before the episodes are cached
+	// (queries executed right after this one will not see the episodes until they are published)
+	UPROPERTY(EditAnywhere, Category = "Cache Episodes")
+	bool bParallelPrefetch = false;
+
+	// Memory budget of all the cached episodes (MB), the peak memory of the next fetches is estimated from the
+	// previous ones (the first fetch runs alone), the episodes which are not expected to fit are skipped
+	UPROPERTY(EditAnywhere, Category = "Cache Episodes", meta = (editcondition = "bParallelPrefetch", ClampMin = 1))
+	int32 PrefetchMemoryBudgetMB = 4096;
 };
@@ -45,6 +45,14 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "Replay")
 	ESLVizQReplayType Type = ESLVizQReplayType::Goto;
 
+	// Start as soon as the first frames are streamed instead of waiting for the whole episode
+	UPROPERTY(EditAnywhere, Category = "Replay")
+	bool bStreamEpisode = true;
+
+	// Load the episode from its local file if it is up to date, the file is written after the first load from mongo
+	UPROPERTY(EditAnywhere, Category = "Replay")
+	bool bUseEpisodeFile = true;
+
 	UPROPERTY(EditAnywhere, Category = "Replay")
 	float StartTime = 0.f;
 
@@ -57,8 +65,11 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "Replay", meta = (editcondition = "Type==ESLVizQReplayType::Replay"))
 	float UpdateRate = -1.f;
 
+	UPROPERTY(EditAnywhere, Category = "Replay", meta = (editcondition = "Type==ESLVizQReplayType::Replay", ClampMin = 0.01))
+	float PlaybackSpeed = 1.f;
+
 	UPROPERTY(EditAnywhere, Category = "Replay", meta = (editcondition = "Type==ESLVizQReplayType::Replay"))
-	int32 StepSize = 1;
+	bool bInterpolate = true;
 
 
 	/* Manual interaction */
@@ -46,6 +46,7 @@ ASLCVScanner::ASLCVScanner()
 	bScanOnlySelectedIndividuals = true;
 	bReplaceBackgroundPixels = false;
 	bUseIndividualMaskValue = false;
+	bEncodeMasksAsRLE = false;
 	bDisablePostProcessVolumes = false;
 	bDisableAO = false;
 
@@ -367,6 +368,10 @@ void ASLCVScanner::Finish(bool bForced)
 		return;
 	}
 
+	// Make sure all the images are stored
+	ImageWriter.Flush();
+	ImageWriter.LogStats();
+
 	bIsStarted = false;
 	bIsInit = false;
 	bIsFinished = true;
@@ -410,28 +415,21 @@ void ASLCVScanner::ScreenshotCapturedCallback(int32 SizeX, int32 SizeY, const TA
 		PrintProgress();
 	}
 
-	// Compressed image
-	TArray<uint8> CompressedBitmap;
-
-	// Check if the background should be replaced or not
-	if (bReplaceBackgroundPixels)
-	{
-		// Switch pixel colors (switch black background color with a custom one)
-		TArray<FColor> NewImage  = FSLCVUtils::ReplacePixels(InBitmap, FColor::Black, CustomBackgroundColor, CustomBackgroundColorTolerance);
-
-		// Compress the modified image
-		FImageUtils::CompressImageArray(SizeX, SizeY, NewImage, CompressedBitmap);
-	}
-	else
-	{
-		// Compress the original image
-		FImageUtils::CompressImageArray(SizeX, SizeY, InBitmap, CompressedBitmap);
-	}
-
-	// Check if the image should be stored locally
+	// Check if the image should be stored locally, the background replacement and the compression run in the background
 	if (bSaveToFile)
 	{
-		SaveToFile(CompressedBitmap);
+		TFunction<void(TArray<FColor>&)> PostProcess;
+		if (bReplaceBackgroundPixels)
+		{
+			// Switch pixel colors (switch black background color with a custom one)
+			const FColor BackgroundColor = CustomBackgroundColor;
+			const int32 BackgroundColorTolerance = CustomBackgroundColorTolerance;
+			PostProcess = [BackgroundColor, BackgroundColorTolerance](TArray<FColor>& Bitmap)
+			{
+				Bitmap = FSLCVUtils::ReplacePixels(Bitmap, FColor::Black, BackgroundColor, BackgroundColorTolerance);
+			};
+		}
+		ImageWriter.AddImage(SizeX, SizeY, TArray<FColor>(InBitmap), GetImagePaths(), PostProcess, false, GetCurrImageFormat());
 	}
 
 	// Set and trigger the next shot
@@ -1343,20 +1341,26 @@ void ASLCVScanner::PrintProgress() const
 		CurrScan, TotalNumScans);
 }
 
-// Save image to file
-void ASLCVScanner::SaveToFile(const TArray<uint8>& CompressedBitmap) const
+// Get the file paths of the current image
+TArray<FString> ASLCVScanner::GetImagePaths() const
 {
 	//const FString TaskFolderPath = TaskId + "/Scans/" + IndividualId + "/" + ViewModeString + "/";
 	const FString TaskFolderPath = "/SL/" + TaskId + "/Scans/" + SceneNameString + /*"/" + ViewModeString*/ + "/";
-	FString Path = FPaths::ProjectDir() + TaskFolderPath + CurrImageName + ".png";
+	const FString Extension = FSLImageCodec::GetFileExtension(GetCurrImageFormat());
+	FString Path = FPaths::ProjectDir() + TaskFolderPath + CurrImageName + Extension;
 	FPaths::RemoveDuplicateSlashes(Path);
-	FFileHelper::SaveArrayToFile(CompressedBitmap, *Path);
 
 	// Include image in a folder with all of them mixed
 	int32 CurrMixedIdx = CameraPoseIdx * RenderModes.Num() + RenderModeIdx + 1;
 	const FString CurrMixedImageName = "A/img" + FString::FromInt(10000 + CurrMixedIdx); //ffmpg friendly
 
-	FString MixedPath = FPaths::ProjectDir() + TaskFolderPath + CurrMixedImageName + ".png";
+	FString MixedPath = FPaths::ProjectDir() + TaskFolderPath + CurrMixedImageName + Extension;
 	FPaths::RemoveDuplicateSlashes(MixedPath);
-	FFileHelper::SaveArrayToFile(CompressedBitmap, *MixedPath);
+	return TArray<FString>({ Path, MixedPath });
+}
+
+// Get the encoding of the current image
+ESLImageFormat ASLCVScanner::GetCurrImageFormat() const
+{
+	return bEncodeMasksAsRLE && RenderModes[RenderModeIdx] == ESLCVRenderMode::Mask ? ESLImageFormat::RLE : ESLImageFormat::PNG;
 }
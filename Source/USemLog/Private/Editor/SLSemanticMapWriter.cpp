@@ -51,7 +51,7 @@ bool FSLSemanticMapWriter::WriteToFile(UWorld* World, const FSLSemanticMapWriter
 	AddWorldIndividuals(SemMap, World);
 
 	// Write map to file	
-	return FFileHelper::SaveStringToFile(SemMap->ToString(), *FullFilePath);
+	return SemMap->WriteToFile(FullFilePath);
 }
 
 // Create semantic map template
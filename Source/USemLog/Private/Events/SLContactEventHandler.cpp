@@ -95,8 +95,10 @@ void FSLContactEventHandler::AddNewContactEvent(const FSLContactResult& InResult
 		FSLUuid::PairEncodeCantor(InResult.Self->GetUniqueID(), InResult.Other->GetUniqueID()),
 		InResult.Self, InResult.Other));
 	Event->EpisodeId = EpisodeId;
-	// Add event to the pending contacts array
-	StartedContactEvents.Emplace(Event);
+	// If the pair is already in contact the older event is finished at the start of the new one
+	FinishContactEvent(Event->PairId, InResult.Time);
+	// Add event to the pending contacts
+	StartedContactEvents.Add(Event->PairId, Event);
 
 	// Start a semantic Pouring event, if particles are involved in contact
 	// TODO: Replace this with the Parent->OnPouringBegin.AddRaw
@@ -108,31 +110,20 @@ void FSLContactEventHandler::AddNewContactEvent(const FSLContactResult& InResult
 }
 
 // Publish finished event
-bool FSLContactEventHandler::FinishContactEvent(USLBaseIndividual* InOther, float EndTime)
+bool FSLContactEventHandler::FinishContactEvent(uint64 InPairId, float EndTime)
 {
-	// Use iterator to be able to remove the entry from the array
-	for (auto EventItr(StartedContactEvents.CreateIterator()); EventItr; ++EventItr)
+	TSharedPtr<FSLContactEvent> Event;
+	if (StartedContactEvents.RemoveAndCopyValue(InPairId, Event))
 	{
-		// It is enough to compare against the other id when searching
-		if ((*EventItr)->Individual2 == InOther)
-		{
-			// Set the event end time
-			(*EventItr)->EndTime = EndTime;
-
-			// Avoid publishing short events
-			if (((*EventItr)->EndTime - (*EventItr)->StartTime) > ContactEventMin)
-			{
-				OnSemanticEvent.ExecuteIfBound(*EventItr);
-			}
-			
-			
-			// Remove event from the pending list
-			EventItr.RemoveCurrent();
-
-			
+		// Set the event end time
+		Event->EndTime = EndTime;
 
-			return true;
+		// Avoid publishing short events
+		if ((Event->EndTime - Event->StartTime) > ContactEventMin)
+		{
+			OnSemanticEvent.ExecuteIfBound(Event);
 		}
+		return true;
 	}
 	return false;
 }
@@ -146,30 +137,26 @@ void FSLContactEventHandler::AddNewSupportedByEvent(USLBaseIndividual* Supported
 	TSharedPtr<FSLSupportedByEvent> Event = MakeShareable(new FSLSupportedByEvent(
 		FSLUuid::NewGuidInBase64Url(), StartTime, EventPairId, Supported, Supporting));
 	Event->EpisodeId = EpisodeId;
-	// Add event to the pending array
-	StartedSupportedByEvents.Emplace(Event);
+	// If the pair is already started the older event is finished at the start of the new one
+	FinishSupportedByEvent(EventPairId, StartTime);
+	// Add event to the pending events
+	StartedSupportedByEvents.Add(EventPairId, Event);
 }
 
 // Finish then publish the event
 bool FSLContactEventHandler::FinishSupportedByEvent(const uint64 InPairId, float EndTime)
 {
-	// Use iterator to be able to remove the entry from the array
-	for (auto EventItr(StartedSupportedByEvents.CreateIterator()); EventItr; ++EventItr)
+	TSharedPtr<FSLSupportedByEvent> Event;
+	if (StartedSupportedByEvents.RemoveAndCopyValue(InPairId, Event))
 	{
-		// It is enough to compare against the other id when searching
-		if ((*EventItr)->PairId == InPairId)
+		// Ignore short events
+		if (EndTime - Event->StartTime > SupportedByEventMin)
 		{
-			// Ignore short events
-			if (EndTime - (*EventItr)->StartTime > SupportedByEventMin)
-			{
-				// Set end time and publish event
-				(*EventItr)->EndTime = EndTime;
-				OnSemanticEvent.ExecuteIfBound(*EventItr);
-			}
-			// Remove event from the pending list
-			EventItr.RemoveCurrent();
-			return true;
+			// Set end time and publish event
+			Event->EndTime = EndTime;
+			OnSemanticEvent.ExecuteIfBound(Event);
 		}
+		return true;
 	}
 	return false;
 }
@@ -178,8 +165,9 @@ bool FSLContactEventHandler::FinishSupportedByEvent(const uint64 InPairId, float
 void FSLContactEventHandler::FinishAllEvents(float EndTime)
 {
 	// Finish contact events
-	for (auto& Ev : StartedContactEvents)
+	for (auto& Pair : StartedContactEvents)
 	{
+		TSharedPtr<FSLContactEvent>& Ev = Pair.Value;
 		// Ignore short events
 		if (EndTime - Ev->StartTime > ContactEventMin)
 		{
@@ -191,8 +179,9 @@ void FSLContactEventHandler::FinishAllEvents(float EndTime)
 	StartedContactEvents.Empty();
 
 	// Finish supported by events
-	for (auto& Ev : StartedSupportedByEvents)
+	for (auto& Pair : StartedSupportedByEvents)
 	{
+		TSharedPtr<FSLSupportedByEvent>& Ev = Pair.Value;
 		// Ignore short events
 		if ((EndTime - Ev->StartTime) > SupportedByEventMin)
 		{
@@ -203,113 +192,180 @@ void FSLContactEventHandler::FinishAllEvents(float EndTime)
 	}
 	StartedSupportedByEvents.Empty();
 
-	// Finish pouring events
+	// Add the extreme poses of the running pouring events to their samples
+	for (auto& Pair : SourceContainers)
+	{
+		FinishPouringContainer(Pair.Value, Pair.Value.Event->PouringPoseForSourceContainer);
+	}
+	SourceContainers.Empty();
+	for (auto& Pair : DestinationContainers)
+	{
+		FinishPouringContainer(Pair.Value, Pair.Value.Event->PouringPoseForDestinationContainer);
+	}
+	DestinationContainers.Empty();
+
+	// Finish pouring events (the end time is the time of the last particle contact)
 	for (auto& Ev : StartedPouringEvents)
 	{
 		// Ignore short events
 		if (EndTime - Ev->StartTime > PouringEventMin)
 		{
-			// Set end time and publish event
-			Ev->NumberOfParticles = particlesOverlapEnded;
-			Ev->PouringPoseForSourceContainer = PouringPoseForSourceContainer;
-			Ev->PouringPoseForDestinationContainer = PouringPoseForDestinationContainer;
-			
-
 			OnSemanticEvent.ExecuteIfBound(Ev);
 		}
 	}
-
 	StartedPouringEvents.Empty();
-
-	
 }
 
 // Start new Pouring event
 void FSLContactEventHandler::AddNewPouringEvent(const FSLContactResult& InResult)
 {
+	// Only particle contacts are relevant (called for every particle, avoid any per-particle allocations)
+	if (InResult.Other->GetClass() != USLParticleIndividual::StaticClass())
+	{
+		return;
+	}
+
 	// find out the angle of the containers and define which one is the source and which one is the destination container
-	float ContainerEulerXAngle = InResult.Self->GetCachedPose().GetRotation().Euler().X;
-	float ContainerEulerYAngle = InResult.Self->GetCachedPose().GetRotation().Euler().Y;
+	const FTransform& ContainerPose = InResult.Self->GetCachedPose();
+	const FVector ContainerEuler = ContainerPose.GetRotation().Euler();
+	const FString& ContainerName = InResult.Self->GetClassValue();
 
 	// Start a semantic Pouring event, check if the source container has required angles around X and Y axis in oder to consider it as source container	
-if (InResult.Other->GetClass() == USLParticleIndividual::StaticClass() &&
-		(ContainerEulerXAngle > 45.00 || ContainerEulerXAngle < -45.00 
-			|| ContainerEulerYAngle > 45.00 || ContainerEulerYAngle < -45.00)) {
-		
+	if (ContainerEuler.X > 45.00 || ContainerEuler.X < -45.00 || ContainerEuler.Y > 45.00 || ContainerEuler.Y < -45.00)
+	{
 		// check if the pouring event with given source conainer is already running, if yes then do not create new one
-		if (!IsPouringEventCurrentlyRunning(SourceContainersList, InResult)) {
-			//if (StartedPouringEvents.Num() == 0 || !HasPouringEventHappened(SourceContainers, InResult)) {
-			CurrentPouringEvent = MakeShareable(new FSLPouringEvent(
+		if (!IsPouringEventCurrentlyRunning(SourceContainers, ContainerName, InResult.Time))
+		{
+			TSharedPtr<FSLPouringEvent> Event = MakeShareable(new FSLPouringEvent(
 				FSLUuid::NewGuidInBase64Url(), InResult.Time,
 				FSLUuid::PairEncodeCantor(InResult.Self->GetUniqueID(), InResult.Other->GetUniqueID()),
 				InResult.Self, InResult.Other, USLPouringEventTypes::PouredOut));
-			CurrentPouringEvent->EpisodeId = EpisodeId;
-			CurrentPouringEvent->SourceContainerName = InResult.Self->GetClassValue();
+			Event->EpisodeId = EpisodeId;
+			Event->SourceContainerName = ContainerName;
 			// Add event to the pending Pourings array
-			StartedPouringEvents.Emplace(CurrentPouringEvent);
+			StartedPouringEvents.Emplace(Event);
 
+			// Close the sample of the previous event of the container and reset its state
+			FSLPouringContainerState& State = SourceContainers.FindOrAdd(ContainerName);
+			if (State.Event.IsValid())
+			{
+				FinishPouringContainer(State, State.Event->PouringPoseForSourceContainer);
+			}
+			State = FSLPouringContainerState();
+			State.Event = Event;
 		}
 
 		// needs to keep updated due to potential role change in next event
-		SourceContainersList.Add({ InResult.Self->GetClassValue(), InResult.Time });
-		
-		// Add current pose for source container
-		PouringPoseForSourceContainer.Add(InResult.Self->GetCachedPose());
-
-		// Not working
-		CurrentPouringEvent->DestinationContainerName = DestinationContainerName;
-
-		// Due to overlapping issues between multiple pouring events, we use last particle start time as endtime of current pouring event
-		if (CurrentPouringEvent != NULL && CurrentPouringEvent->Individual1 == InResult.Self)
-			CurrentPouringEvent->EndTime = InResult.Time;
-		
-		
+		FSLPouringContainerState& State = SourceContainers.FindChecked(ContainerName);
+		UpdatePouringContainer(State, State.Event->PouringPoseForSourceContainer, ContainerPose, InResult.Time);
 	}
-	else if (InResult.Other->GetClass() == USLParticleIndividual::StaticClass() &&
-		(ContainerEulerXAngle < 45.00 || ContainerEulerXAngle > -45.00
-			|| ContainerEulerYAngle < 45.00 || ContainerEulerYAngle > -45.00)) {
-		
+	else
+	{
 		// check if the pouring event with given destination conainer is already running, if yes then do not create new one
-		if (!IsPouringEventCurrentlyRunning(DestinationContainersList, InResult)) {
-			
-			CurrentPouringEvent = MakeShareable(new FSLPouringEvent(
+		if (!IsPouringEventCurrentlyRunning(DestinationContainers, ContainerName, InResult.Time))
+		{
+			TSharedPtr<FSLPouringEvent> Event = MakeShareable(new FSLPouringEvent(
 				FSLUuid::NewGuidInBase64Url(), InResult.Time,
 				FSLUuid::PairEncodeCantor(InResult.Self->GetUniqueID(), InResult.Other->GetUniqueID()),
 				InResult.Self, InResult.Other, USLPouringEventTypes::PouredInto));
-			CurrentPouringEvent->EpisodeId = EpisodeId;
-			CurrentPouringEvent->DestinationContainerName = InResult.Self->GetClassValue();
+			Event->EpisodeId = EpisodeId;
+			Event->DestinationContainerName = ContainerName;
 			// Add event to the pending Pourings array
-			StartedPouringEvents.Emplace(CurrentPouringEvent);
+			StartedPouringEvents.Emplace(Event);
+
+			// Close the sample of the previous event of the container and reset its state
+			FSLPouringContainerState& State = DestinationContainers.FindOrAdd(ContainerName);
+			if (State.Event.IsValid())
+			{
+				FinishPouringContainer(State, State.Event->PouringPoseForDestinationContainer);
+			}
+			State = FSLPouringContainerState();
+			State.Event = Event;
 		}
 
 		// needs to keep updated due to potential role change in next event
-		DestinationContainersList.Add({ InResult.Self->GetClassValue(), InResult.Time });
-		// Add current pose for desti container
-		PouringPoseForDestinationContainer.Add(InResult.Self->GetCachedPose());
+		FSLPouringContainerState& State = DestinationContainers.FindChecked(ContainerName);
+		UpdatePouringContainer(State, State.Event->PouringPoseForDestinationContainer, ContainerPose, InResult.Time);
+	}
+}
 
-		// Due to overlapping issues between multiple pouring events, we use last particle start time as endtime of current pouring event
-		if (CurrentPouringEvent != NULL && CurrentPouringEvent->Individual1 == InResult.Self)
-			CurrentPouringEvent->EndTime = InResult.Time;
+// Check if the container has a pouring event running in the given role
+bool FSLContactEventHandler::IsPouringEventCurrentlyRunning(const TMap<FString, FSLPouringContainerState>& Containers, const FString& ContainerName, float Time) const
+{
+	// if the pouring event with same container had no particle contact for more than 5 seconds, a new event will be created
+	if (const FSLPouringContainerState* State = Containers.Find(ContainerName))
+	{
+		return (Time - State->LastTime) < MaxPouringEventTime;
+	}
+	return false;
+}
 
+// Add the particle contact to the running pouring event of the container
+void FSLContactEventHandler::UpdatePouringContainer(FSLPouringContainerState& State, TArray<FTransform>& OutPoses, const FTransform& Pose, float Time)
+{
+	// Due to overlapping issues between multiple pouring events, the last particle contact time is the end time of the event
+	State.LastTime = Time;
+	State.Event->EndTime = Time;
+
+	// Track the poses with the extreme roll separately, the sample might skip them
+	const float Roll = Pose.GetRotation().Euler().X;
+	if (State.NumPoses == 0 || Roll < State.MinRoll)
+	{
+		State.MinRoll = Roll;
+		State.MinRollPose = Pose;
+		State.MinRollIdx = State.NumPoses;
+	}
+	if (State.NumPoses == 0 || Roll > State.MaxRoll)
+	{
+		State.MaxRoll = Roll;
+		State.MaxRollPose = Pose;
+		State.MaxRollIdx = State.NumPoses;
 	}
 
+	// Keep every n-th pose, if the sample is full drop every second pose and double the stride
+	if (State.NumPoses % State.PoseStride == 0)
+	{
+		if (OutPoses.Num() >= MaxPouringPoses)
+		{
+			for (int32 Idx = 0; Idx < OutPoses.Num() / 2; ++Idx)
+			{
+				OutPoses[Idx] = OutPoses[Idx * 2];
+			}
+			OutPoses.SetNum(OutPoses.Num() / 2, false);
+			State.PoseStride *= 2;
+		}
+		if (State.NumPoses % State.PoseStride == 0)
+		{
+			OutPoses.Add(Pose);
+		}
+	}
+	State.NumPoses++;
 }
 
-/*
-*  Check if for the given list of Pouring events the container name is the same, if yes then the event has started
-*/
-
-bool FSLContactEventHandler::IsPouringEventCurrentlyRunning(TArray<std::tuple<FString, float>> Containers, const FSLContactResult& InResult) {
-	for (std::tuple<FString, float> Container : Containers) {
-		// check for the same container if the time is below limit or above?
-		if (std::get<0>(Container) == InResult.Self->GetClassValue()) {
-			// if the pouring event with same container lasts more than 5 seconds, a new event will be created
-			if((InResult.Time - std::get<1>(Container)) < MaxPouringEventTime)
-				return true;
+// Insert the poses with the min and max roll into the sample of the event (in chronological order)
+void FSLContactEventHandler::FinishPouringContainer(FSLPouringContainerState& State, TArray<FTransform>& OutPoses)
+{
+	// The sample holds every n-th pose, the poses on the stride are already in it; the later pose is inserted
+	// first so the sample position of the earlier one stays valid
+	const int32 Stride = State.PoseStride;
+	auto InsertPose = [&OutPoses, Stride](int32 PoseIdx, const FTransform& Pose)
+	{
+		if (PoseIdx % Stride != 0)
+		{
+			OutPoses.Insert(Pose, FMath::Min(PoseIdx / Stride + 1, OutPoses.Num()));
 		}
+	};
 
+	if (Stride > 1)
+	{
+		const bool bMaxFirst = State.MaxRollIdx > State.MinRollIdx;
+		InsertPose(bMaxFirst ? State.MaxRollIdx : State.MinRollIdx, bMaxFirst ? State.MaxRollPose : State.MinRollPose);
+		if (State.MaxRollIdx != State.MinRollIdx)
+		{
+			InsertPose(bMaxFirst ? State.MinRollIdx : State.MaxRollIdx, bMaxFirst ? State.MinRollPose : State.MaxRollPose);
+		}
 	}
-	return false;
+	State.PoseStride = 1;
 }
 
 // NOT CALLED: Publish finished event
@@ -348,13 +404,22 @@ void FSLContactEventHandler::OnSLOverlapBegin(const FSLContactResult& InResult)
 // Event called when a semantic overlap event ends
 void FSLContactEventHandler::OnSLOverlapEnd(USLBaseIndividual* Self, USLBaseIndividual* Other, float Time)
 {
-	FinishContactEvent(Other, Time);
-
+	FinishContactEvent(FSLUuid::PairEncodeCantor(Self->GetUniqueID(), Other->GetUniqueID()), Time);
 
-	// for pouring contacts do some more calculation about what time it should end
-	if (Other->GetClass() == USLParticleIndividual::StaticClass()) {
-		// find out how many particles are ending overlap with source container
-		particlesOverlapEnded = particlesOverlapEnded + 1;
+	// for pouring contacts count the particles ending the overlap with the container in its latest pouring event
+	if (Other->GetClass() == USLParticleIndividual::StaticClass())
+	{
+		const FString& ContainerName = Self->GetClassValue();
+		const FSLPouringContainerState* Source = SourceContainers.Find(ContainerName);
+		const FSLPouringContainerState* Destination = DestinationContainers.Find(ContainerName);
+		if (Source && (!Destination || Source->LastTime >= Destination->LastTime))
+		{
+			Source->Event->NumberOfParticles++;
+		}
+		else if (Destination)
+		{
+			Destination->Event->NumberOfParticles++;
+		}
 	}
 }
 
@@ -0,0 +1,341 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Events/SLEventJournal.h"
+#include "Owl/SLOwlExperimentStatics.h"
+#include "HAL/FileManager.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/Crc.h"
+
+// Journal file identifier and version
+static const uint32 SL_EVENT_JOURNAL_MAGIC = 0x4A454C53; // "SLEJ"
+static const int32 SL_EVENT_JOURNAL_VERSION = 2;
+
+// Serialize the owl node and its children
+static void SerializeOwlNode(FArchive& Ar, FSLOwlNode& Node)
+{
+	Ar << Node.Name.Prefix << Node.Name.LocalName << Node.Value << Node.Comment;
+
+	int32 NumAttributes = Node.Attributes.Num();
+	Ar << NumAttributes;
+	if (Ar.IsLoading())
+	{
+		Node.Attributes.SetNum(FMath::Max(NumAttributes, 0));
+	}
+	for (auto& Attribute : Node.Attributes)
+	{
+		Ar << Attribute.Key.Prefix << Attribute.Key.LocalName << Attribute.Value.Ns << Attribute.Value.LocalValue;
+	}
+
+	int32 NumChildren = Node.ChildNodes.Num();
+	Ar << NumChildren;
+	if (Ar.IsLoading())
+	{
+		Node.ChildNodes.SetNum(FMath::Max(NumChildren, 0));
+	}
+	for (auto& Child : Node.ChildNodes)
+	{
+		SerializeOwlNode(Ar, Child);
+	}
+}
+
+// Create the record from the event (game thread, the event can reference individuals)
+FSLEventJournalRecord::FSLEventJournalRecord(ISLEvent& Event) :
+	Id(Event.Id),
+	TypeName(Event.TypeName()),
+	Context(Event.Context()),
+	Tooltip(Event.Tooltip()),
+	StartTime(Event.StartTime),
+	EndTime(Event.EndTime)
+{
+	// The event adds its owl node and registers its objects as it would in the experiment document
+	FSLOwlExperiment EventDoc;
+	Event.AddToOwlDoc(&EventDoc);
+	if (EventDoc.Individuals.Num() > 0)
+	{
+		OwlNode = MoveTemp(EventDoc.Individuals.Last());
+	}
+	Objects = EventDoc.GetRegisteredObjects();
+}
+
+// Serialize the record
+FArchive& operator<<(FArchive& Ar, FSLEventJournalRecord& Record)
+{
+	Ar << Record.Id << Record.TypeName << Record.Context << Record.Tooltip << Record.StartTime << Record.EndTime;
+	SerializeOwlNode(Ar, Record.OwlNode);
+	Ar << Record.Objects;
+	return Ar;
+}
+
+
+/* Write task */
+// Append the records and flush the file
+void FSLEventJournalWriteTask::DoWork()
+{
+	TArray<uint8> Payload;
+	for (auto& Record : Records)
+	{
+		// Size and checksum prefix, a partially written record is detected when reading
+		Payload.Reset();
+		FMemoryWriter Writer(Payload);
+		Writer << Record;
+		uint32 Size = Payload.Num();
+		uint32 Crc = FCrc::MemCrc32(Payload.GetData(), Payload.Num());
+		*Ar << Size << Crc;
+		Ar->Serialize(Payload.GetData(), Payload.Num());
+	}
+	Ar->Flush();
+}
+
+
+/* Export task */
+// Export the journal
+void FSLEventJournalExportTask::DoWork()
+{
+	FSLEventJournal::Export(Path, Params);
+}
+
+
+/* Journal */
+// Ctor
+FSLEventJournal::FSLEventJournal(int32 InMaxPendingRecords, float InMaxPendingSeconds) :
+	Ar(nullptr),
+	WriteTask(nullptr),
+	ExportTask(nullptr),
+	MaxPendingRecords(FMath::Max(InMaxPendingRecords, 1)),
+	MaxPendingSeconds(InMaxPendingSeconds),
+	FirstPendingTime(0.0),
+	NumRecords(0)
+{
+}
+
+// Dtor, closes the journal and waits for the export
+FSLEventJournal::~FSLEventJournal()
+{
+	Close();
+	WaitForExport();
+}
+
+// Create the journal file (overwrites any previous journal, waits for its export first)
+bool FSLEventJournal::Open(const FString& InPath)
+{
+	if (Ar)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Journal %s is already open.."), *FString(__FUNCTION__), __LINE__, *Path);
+		return false;
+	}
+
+	// The export could still be reading the previous journal file
+	WaitForExport();
+
+	Path = InPath;
+	FPaths::RemoveDuplicateSlashes(Path);
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(Path), true);
+	Ar = IFileManager::Get().CreateFileWriter(*Path);
+	if (!Ar)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not create the event journal %s.."), *FString(__FUNCTION__), __LINE__, *Path);
+		return false;
+	}
+
+	uint32 Magic = SL_EVENT_JOURNAL_MAGIC;
+	int32 Version = SL_EVENT_JOURNAL_VERSION;
+	*Ar << Magic << Version;
+	Ar->Flush();
+	NumRecords = 0;
+	return true;
+}
+
+// Add the finished event, the records are appended in batches in the background
+void FSLEventJournal::AddEvent(const TSharedPtr<ISLEvent>& Event)
+{
+	if (!Ar || !Event.IsValid())
+	{
+		return;
+	}
+
+	if (PendingRecords.Num() == 0)
+	{
+		FirstPendingTime = FPlatformTime::Seconds();
+	}
+	PendingRecords.Emplace(*Event.Get());
+	NumRecords++;
+
+	if (PendingRecords.Num() >= MaxPendingRecords || FPlatformTime::Seconds() - FirstPendingTime > MaxPendingSeconds)
+	{
+		TryWritePending(false);
+	}
+}
+
+// Write the pending records if the oldest one waits for longer than the max pending time (call periodically)
+void FSLEventJournal::FlushIfDue()
+{
+	if (Ar && PendingRecords.Num() > 0 && FPlatformTime::Seconds() - FirstPendingTime > MaxPendingSeconds)
+	{
+		TryWritePending(false);
+	}
+}
+
+// Write the pending records and close the file
+void FSLEventJournal::Close()
+{
+	if (!Ar)
+	{
+		return;
+	}
+
+	TryWritePending(true);
+	if (WriteTask)
+	{
+		WriteTask->EnsureCompletion();
+		delete WriteTask;
+		WriteTask = nullptr;
+	}
+
+	Ar->Close();
+	if (Ar->IsError())
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Errors while writing the event journal %s.."), *FString(__FUNCTION__), __LINE__, *Path);
+	}
+	delete Ar;
+	Ar = nullptr;
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Journal %s closed with %d events.."), *FString(__FUNCTION__), __LINE__, *Path, NumRecords);
+}
+
+// Start writing the pending records if the previous write is done
+void FSLEventJournal::TryWritePending(bool bWait)
+{
+	if (WriteTask)
+	{
+		if (!WriteTask->IsDone() && !bWait)
+		{
+			// Keep collecting until the current write is done
+			return;
+		}
+		WriteTask->EnsureCompletion();
+		delete WriteTask;
+		WriteTask = nullptr;
+	}
+
+	if (PendingRecords.Num() > 0)
+	{
+		WriteTask = new FAsyncTask<FSLEventJournalWriteTask>(Ar, MoveTemp(PendingRecords));
+		WriteTask->StartBackgroundTask();
+		PendingRecords.Reset();
+	}
+}
+
+// Read the valid records of the journal (a truncated last record is skipped)
+bool FSLEventJournal::ReadRecords(const FString& InPath, TArray<FSLEventJournalRecord>& OutRecords)
+{
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *InPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not read the event journal %s.."), *FString(__FUNCTION__), __LINE__, *InPath);
+		return false;
+	}
+
+	FMemoryReader Reader(Data);
+	uint32 Magic = 0;
+	int32 Version = 0;
+	if (Data.Num() >= sizeof(Magic) + sizeof(Version))
+	{
+		Reader << Magic << Version;
+	}
+	if (Magic != SL_EVENT_JOURNAL_MAGIC || Version != SL_EVENT_JOURNAL_VERSION)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d %s is not a valid event journal.."), *FString(__FUNCTION__), __LINE__, *InPath);
+		return false;
+	}
+
+	const int64 PrefixSize = sizeof(uint32) * 2;
+	while (Reader.Tell() + PrefixSize <= Data.Num())
+	{
+		uint32 Size = 0;
+		uint32 Crc = 0;
+		Reader << Size << Crc;
+		const int64 Offset = Reader.Tell();
+		if (Offset + Size > Data.Num() || FCrc::MemCrc32(Data.GetData() + Offset, Size) != Crc)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d Journal %s ends with an incomplete record (interrupted session), ignoring it.."),
+				*FString(__FUNCTION__), __LINE__, *InPath);
+			break;
+		}
+		Reader << OutRecords.AddDefaulted_GetRef();
+		Reader.Seek(Offset + Size);
+	}
+	return true;
+}
+
+// Write the owl and timeline files from the journal (can be re-run on the journal of an interrupted session)
+bool FSLEventJournal::Export(const FString& InPath, const FSLEventJournalExportParams& Params)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	if (!Params.ExperimentDoc.IsValid())
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d No experiment document given.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	TArray<FSLEventJournalRecord> Records;
+	if (!ReadRecords(InPath, Records))
+	{
+		return false;
+	}
+
+	TArray<TSharedPtr<ISLEvent>> Events;
+	Events.Reserve(Records.Num());
+	for (auto& Record : Records)
+	{
+		Events.Emplace(MakeShareable(new FSLJournalEvent(MoveTemp(Record))));
+	}
+	Records.Empty();
+
+	// Same as writing the finished events directly
+	TArray<FString> SubActionIds;
+	for (const auto& Ev : Events)
+	{
+		Ev->AddToOwlDoc(Params.ExperimentDoc.Get());
+		SubActionIds.Add(Ev->Id);
+	}
+	Params.ExperimentDoc->AddTimepointIndividuals();
+	Params.ExperimentDoc->AddExperimentIndividual(SubActionIds, Params.SemanticMapId, Params.TaskId);
+
+	if (Params.bWriteTimelines)
+	{
+		FSLGoogleCharts::WriteTimelines(Events, Params.DirPath, Params.TimelinesParams.EpisodeId, Params.TimelinesParams);
+	}
+	FSLOwlExperimentStatics::WriteToFile(Params.ExperimentDoc, Params.DirPath, Params.bOverwrite);
+
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Duration: export(events=%d)=[%f] seconds..;"),
+		*FString(__FUNCTION__), __LINE__, Events.Num(), FPlatformTime::Seconds() - StartTime);
+	return true;
+}
+
+// Export the closed journal on a worker thread, waits for the previous export first (the params are moved, the document should not be shared with the caller)
+void FSLEventJournal::ExportAsync(FSLEventJournalExportParams&& Params)
+{
+	if (Ar)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Journal %s is still open, close it before the export.."), *FString(__FUNCTION__), __LINE__, *Path);
+		return;
+	}
+
+	WaitForExport();
+	ExportTask = new FAsyncTask<FSLEventJournalExportTask>(Path, MoveTemp(Params));
+	ExportTask->StartBackgroundTask();
+}
+
+// Wait for the running export (if any)
+void FSLEventJournal::WaitForExport()
+{
+	if (ExportTask)
+	{
+		ExportTask->EnsureCompletion();
+		delete ExportTask;
+		ExportTask = nullptr;
+	}
+}
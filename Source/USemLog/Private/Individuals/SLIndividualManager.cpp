@@ -6,6 +6,8 @@
 #include "Individuals/SLIndividualUtils.h"
 #include "Individuals/Type/SLBaseIndividual.h"
 #include "Individuals/Type/SLSkeletalIndividual.h"
+#include "Individuals/Type/SLBoneIndividual.h"
+#include "Individuals/Type/SLVirtualBoneIndividual.h"
 #include "Individuals/Type/SLRobotIndividual.h"
 
 #include "EngineUtils.h"
@@ -218,6 +220,82 @@ ASLIndividualManager* ASLIndividualManager::GetExistingOrSpawnNew(UWorld* World)
 	return Manager;
 }
 
+// Get the pose index layout of the individuals (rebuilt if the cache changed)
+TSharedPtr<const FSLIndividualPoseLayout, ESPMode::ThreadSafe> ASLIndividualManager::GetPoseLayout()
+{
+	if (!PoseLayout.IsValid())
+	{
+		BuildPoseLayout();
+	}
+	return PoseLayout;
+}
+
+// Update the cached poses of all individuals and write them to the snapshot (game thread only, returns the number of moved individuals)
+int32 ASLIndividualManager::CachePosesToSnapshot(const FSLIndividualPoseTolerance& Tolerance, float Timestamp, FSLIndividualPoseSnapshot& OutSnapshot, bool bKeepMovedFlags)
+{
+	const auto Layout = GetPoseLayout();
+	if (OutSnapshot.Layout != Layout || !OutSnapshot.IsValid())
+	{
+		OutSnapshot.Prepare(Layout);
+	}
+	else if (!bKeepMovedFlags)
+	{
+		OutSnapshot.Moved.SetRange(0, OutSnapshot.Moved.Num(), false);
+		OutSnapshot.NumMoved = 0;
+	}
+
+	// New layout, every bone is reported as moved the first time
+	const int32 NumIndividuals = Individuals.Num();
+	if (BoneRefLocations.Num() != NumIndividuals)
+	{
+		BoneRefLocations.Init(FVector(BIG_NUMBER), NumIndividuals);
+		BoneRefRotations.Init(FQuat::Identity, NumIndividuals);
+	}
+	const float BoneLocToleranceSquared = FMath::Square(Tolerance.BoneLocation);
+	const float BoneRotTolerance = FMath::DegreesToRadians(Tolerance.BoneRotation);
+
+	OutSnapshot.Timestamp = Timestamp;
+	int32 NumMoved = 0;
+	for (int32 Idx = 0; Idx < NumIndividuals; ++Idx)
+	{
+		FTransform Pose;
+		bool bMoved;
+		if (Layout->BoneFlags[Idx])
+		{
+			// The bone cache is refreshed every time, the change is checked against the last reported pose
+			Individuals[Idx]->UpdateCachedPose(0.f, &Pose);
+			bMoved = FVector::DistSquared(Pose.GetLocation(), BoneRefLocations[Idx]) > BoneLocToleranceSquared
+				|| Pose.GetRotation().AngularDistance(BoneRefRotations[Idx]) > BoneRotTolerance;
+			if (bMoved)
+			{
+				BoneRefLocations[Idx] = Pose.GetLocation();
+				BoneRefRotations[Idx] = Pose.GetRotation();
+			}
+			else
+			{
+				Pose = FTransform(BoneRefRotations[Idx], BoneRefLocations[Idx]);
+			}
+		}
+		else
+		{
+			bMoved = Individuals[Idx]->UpdateCachedPose(Tolerance.Pose, &Pose);
+		}
+
+		if (bMoved)
+		{
+			if (!OutSnapshot.Moved[Idx])
+			{
+				OutSnapshot.Moved[Idx] = true;
+				OutSnapshot.NumMoved++;
+			}
+			NumMoved++;
+		}
+		OutSnapshot.Locations[Idx] = Pose.GetLocation();
+		OutSnapshot.Rotations[Idx] = Pose.GetRotation();
+	}
+	return NumMoved;
+}
+
 // Clear all cached references
 void ASLIndividualManager::InitReset()
 {
@@ -405,6 +483,9 @@ void ASLIndividualManager::ClearCache()
 	/* Quick acess id based mapping*/
 	IdToIndividuals.Empty();
 	IdToIndividualComponents.Empty();
+
+	/* Pose snapshot layout */
+	PoseLayout.Reset();
 	if (HasCache())
 	{
 		UE_LOG(LogTemp, Error, TEXT("%s::%d Somethig went wrong on clearing the cache.."), *FString(__FUNCTION__), __LINE__);
@@ -417,6 +498,7 @@ void ASLIndividualManager::ClearCache()
 void ASLIndividualManager::AddToCache(USLIndividualComponent* IC)
 {
 	bThreadSafeToRead = false;
+	PoseLayout.Reset();
 
 	IndividualComponents.Add(IC);
 
@@ -487,6 +569,7 @@ void ASLIndividualManager::AddToCache(USLIndividualComponent* IC)
 bool ASLIndividualManager::RemoveFromCache(USLIndividualComponent* IC)
 {
 	bThreadSafeToRead = false;
+	PoseLayout.Reset();
 
 	bool bAnyRemoved = false;
 
@@ -540,6 +623,68 @@ bool ASLIndividualManager::RemoveFromCache(USLIndividualComponent* IC)
 	return bAnyRemoved;
 }
 
+// Build the pose index layout from the current cache
+void ASLIndividualManager::BuildPoseLayout()
+{
+	TSharedPtr<FSLIndividualPoseLayout, ESPMode::ThreadSafe> NewLayout = MakeShared<FSLIndividualPoseLayout, ESPMode::ThreadSafe>();
+	NewLayout->Version = ++PoseLayoutVersion;
+
+	// Pose index is the index in the individuals array
+	TMap<USLBaseIndividual*, int32> IndividualToPoseIdx;
+	IndividualToPoseIdx.Reserve(Individuals.Num());
+	NewLayout->Ids.Reserve(Individuals.Num());
+	for (int32 Idx = 0; Idx < Individuals.Num(); ++Idx)
+	{
+		NewLayout->Ids.Add(Individuals[Idx]->GetIdValue());
+		IndividualToPoseIdx.Add(Individuals[Idx], Idx);
+	}
+
+	NewLayout->SkeletalPoseIndices.Reserve(SkeletalIndividuals.Num());
+	NewLayout->SkeletalBoneOffsets.Reserve(SkeletalIndividuals.Num() + 1);
+	NewLayout->SkeletalBoneOffsets.Add(0);
+	for (const auto& SkelIndividual : SkeletalIndividuals)
+	{
+		const int32* SkelPoseIdx = IndividualToPoseIdx.Find(SkelIndividual);
+		if (!SkelPoseIdx)
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d %s is not in the individuals cache, skipping from pose layout.."),
+				*FString(__FUNCTION__), __LINE__, *SkelIndividual->GetFullName());
+			continue;
+		}
+		NewLayout->SkeletalPoseIndices.Add(*SkelPoseIdx);
+
+		for (const auto& BI : SkelIndividual->GetBoneIndividuals())
+		{
+			if (const int32* BonePoseIdx = IndividualToPoseIdx.Find(BI))
+			{
+				NewLayout->BonePoseIndices.Add(*BonePoseIdx);
+				NewLayout->BoneIndices.Add(BI->GetBoneIndex());
+			}
+		}
+		for (const auto& VBI : SkelIndividual->GetVirtualBoneIndividuals())
+		{
+			if (const int32* BonePoseIdx = IndividualToPoseIdx.Find(VBI))
+			{
+				NewLayout->BonePoseIndices.Add(*BonePoseIdx);
+				NewLayout->BoneIndices.Add(VBI->GetBoneIndex());
+			}
+		}
+		NewLayout->SkeletalBoneOffsets.Add(NewLayout->BonePoseIndices.Num());
+	}
+
+	NewLayout->BoneFlags.Init(false, NewLayout->Num());
+	for (const int32 BonePoseIdx : NewLayout->BonePoseIndices)
+	{
+		NewLayout->BoneFlags[BonePoseIdx] = true;
+	}
+
+	// Pose indices changed, the bone references are reinitialized on the next snapshot
+	BoneRefLocations.Empty();
+	BoneRefRotations.Empty();
+
+	PoseLayout = NewLayout;
+}
+
 // Remove destroyed individuals from array
 void ASLIndividualManager::OnIndividualComponentDestroyed(USLIndividualComponent* DestroyedComponent)
 {
@@ -5,6 +5,7 @@
 #include "Individuals/SLIndividualComponent.h"
 #include "Individuals/Type/SLIndividualTypes.h"
 #include "Individuals/SLIgnore.h"
+#include "Individuals/SLMaskColorAllocator.h"
 
 #include "Skeletal/SLSkeletalDataAsset.h"
 #include "AssetRegistryModule.h" // FindSkeletalDataAsset
@@ -384,15 +385,19 @@ int32 FSLIndividualUtils::ClearClasses(const TArray<AActor*>& Actors)
 // Add unique masks for all the visual individuals
 int32 FSLIndividualUtils::WriteUniqueVisualMasks(UWorld* World, bool bOverwrite)
 {
+	const double StartTime = FPlatformTime::Seconds();
 	int32 Num = 0;
-	TArray<FColor> ConsumedColors = GetAllConsumedVisualMaskColorsInWorld(World);
+	FSLMaskColorAllocator ColorAllocator;
+	ColorAllocator.AddConsumedColors(GetAllConsumedVisualMaskColorsInWorld(World));
 	for (TActorIterator<AActor> ActItr(World); ActItr; ++ActItr)
 	{
-		if (WriteUniqueVisualMask(*ActItr, ConsumedColors, bOverwrite))
+		if (WriteUniqueVisualMask(*ActItr, ColorAllocator, bOverwrite))
 		{
 			Num++;
 		}
 	}
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Duration: write masks(individuals=%d; colors=%d)=[%f] seconds..;"),
+		*FString(__func__), __LINE__, Num, ColorAllocator.Num(), FPlatformTime::Seconds() - StartTime);
 	return Num;
 }
 
@@ -402,10 +407,11 @@ int32 FSLIndividualUtils::WriteUniqueVisualMasks(const TArray<AActor*>& Actors,
 	int32 Num = 0;
 	if (Actors.Num())
 	{	
-		TArray<FColor> ConsumedColors = GetAllConsumedVisualMaskColorsInWorld(Actors[0]->GetWorld());
+		FSLMaskColorAllocator ColorAllocator;
+		ColorAllocator.AddConsumedColors(GetAllConsumedVisualMaskColorsInWorld(Actors[0]->GetWorld()));
 		for (const auto& Act : Actors)
 		{
-			if (WriteUniqueVisualMask(Act, ConsumedColors, bOverwrite))
+			if (WriteUniqueVisualMask(Act, ColorAllocator, bOverwrite))
 			{
 				Num++;
 			}
@@ -925,11 +931,8 @@ bool FSLIndividualUtils::ClearClass(AActor* Actor)
 
 /* Visual Mask */
 // Add unique visual mask color (colors if it has children) to the individual of the actor
-bool FSLIndividualUtils::WriteUniqueVisualMask(AActor* Actor, TArray<FColor>& ConsumedColors, bool bOverwrite)
+bool FSLIndividualUtils::WriteUniqueVisualMask(AActor* Actor, FSLMaskColorAllocator& ColorAllocator, bool bOverwrite)
 {
-	static const int32 NumTrials = 255;
-	static const int32 MinManhattanDist = 17;
-
 	if (UActorComponent* AC = Actor->GetComponentByClass(USLIndividualComponent::StaticClass()))
 	{
 		USLIndividualComponent* IC = CastChecked<USLIndividualComponent>(AC);
@@ -938,7 +941,7 @@ bool FSLIndividualUtils::WriteUniqueVisualMask(AActor* Actor, TArray<FColor>& Co
 			bool bRetVal = false;
 			if (!VI->IsVisualMaskValueSet() || bOverwrite)
 			{
-				FColor NewUniqueColor = GenerateRandomUniqueColor(ConsumedColors, NumTrials, MinManhattanDist);
+				FColor NewUniqueColor = ColorAllocator.Allocate();
 				if (NewUniqueColor != FColor::Black)
 				{
 					VI->SetVisualMaskValue(NewUniqueColor.ToHex());
@@ -957,7 +960,7 @@ bool FSLIndividualUtils::WriteUniqueVisualMask(AActor* Actor, TArray<FColor>& Co
 				{
 					if (!BI->IsVisualMaskValueSet() || bOverwrite)
 					{
-						FColor NewUniqueColor = GenerateRandomUniqueColor(ConsumedColors, NumTrials, MinManhattanDist);
+						FColor NewUniqueColor = ColorAllocator.Allocate();
 						if (NewUniqueColor != FColor::Black)
 						{
 							BI->SetVisualMaskValue(NewUniqueColor.ToHex());
@@ -1026,45 +1029,6 @@ TArray<FColor> FSLIndividualUtils::GetAllConsumedVisualMaskColorsInWorld(UWorld*
 	return ConsumedMaskColors;
 }
 
-// Generate random colors until a unique one if found (return black if failed)
-FColor FSLIndividualUtils::GenerateRandomUniqueColor(TArray<FColor>& ConsumedColors, int32 NumTrials, int32 MinManhattanDist)
-{
-	// Avoid colors close to black or white
-	static const uint8 MinDistToBlack = 23;
-	static const uint8 MinDistToWhite = 23;
-
-	for (int32 TrialIdx = 0; TrialIdx < NumTrials; ++TrialIdx)
-	{
-		// Generate a random color that differs of black
-		//FColor RC = FColor::MakeRandomColor(); // Pretty colors, but does not generate many options
-		FColor RandColor = CreateRandomRGBColor();
-
-		// Avoid very dark or very bright colors
-		if (AreColorsAlmostEqual(RandColor, FColor::Black, MinDistToBlack) ||
-			AreColorsAlmostEqual(RandColor, FColor::White, MinDistToWhite))
-		{
-			//UE_LOG(LogTemp, Error, TEXT("%s::%d Got a very dark or very bright (reserved) color, hex=%s, trying again.."),
-			//	*FString(__func__), __LINE__, *RandColor.ToHex());
-			continue;
-		}
-
-		/* Nested lambda for the array FindByPredicate functionality */
-		const auto EqualWithToleranceLambda = [RandColor, MinManhattanDist](const FColor& Item)
-		{
-			return AreColorsAlmostEqual(RandColor, Item, MinManhattanDist);
-		};
-
-		// Check that the randomly generated color is not in the consumed color array
-		if (!ConsumedColors.FindByPredicate(EqualWithToleranceLambda))
-		{
-			ConsumedColors.Emplace(RandColor);
-			return RandColor;
-		}
-	}
-	//UE_LOG(LogTemp, Error, TEXT("%s::%d Could not generate a unique color for, saving as black.."), *FString(__func__), __LINE__);
-	return FColor::Black;
-}
-
 /* Import/export values */
 // Export individual values of the actor
 bool FSLIndividualUtils::ExportValues(AActor* Actor, bool bOverwrite)
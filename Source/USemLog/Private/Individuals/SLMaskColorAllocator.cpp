@@ -0,0 +1,124 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Individuals/SLMaskColorAllocator.h"
+
+// Ctor, colors closer or equal to the min distance are considered equal
+FSLMaskColorAllocator::FSLMaskColorAllocator(int32 InMinManhattanDist, int32 InMinDistToBlackWhite, int32 Seed) :
+	MinManhattanDist(FMath::Max(InMinManhattanDist, 0)),
+	MinDistToBlackWhite(InMinDistToBlackWhite),
+	CandidateIdx(0),
+	NumConsumed(0),
+	RandStream(Seed)
+{
+	// Colors closer than the cell size differ by at most one cell on every axis
+	CellSize = MinManhattanDist + 1;
+	NumCellsPerAxis = 255 / CellSize + 1;
+	Cells.SetNum(NumCellsPerAxis * NumCellsPerAxis * NumCellsPerAxis);
+	InitCandidates();
+}
+
+// Mark the color as used (e.g. existing masks in the world)
+void FSLMaskColorAllocator::AddConsumedColor(const FColor& Color)
+{
+	Cells[GetCellIdx(GetCellCoord(Color.R), GetCellCoord(Color.G), GetCellCoord(Color.B))].Add(Color);
+	NumConsumed++;
+}
+
+// Mark the colors as used
+void FSLMaskColorAllocator::AddConsumedColors(const TArray<FColor>& Colors)
+{
+	for (const auto& Color : Colors)
+	{
+		AddConsumedColor(Color);
+	}
+}
+
+// Check if the color is far enough from the consumed and the reserved (black, white) colors
+bool FSLMaskColorAllocator::IsColorAvailable(const FColor& Color) const
+{
+	if (GetManhattanDistance(Color, FColor::Black) <= MinDistToBlackWhite ||
+		GetManhattanDistance(Color, FColor::White) <= MinDistToBlackWhite)
+	{
+		return false;
+	}
+
+	const int32 X = GetCellCoord(Color.R);
+	const int32 Y = GetCellCoord(Color.G);
+	const int32 Z = GetCellCoord(Color.B);
+	for (int32 CX = FMath::Max(X - 1, 0); CX <= FMath::Min(X + 1, NumCellsPerAxis - 1); ++CX)
+	{
+		for (int32 CY = FMath::Max(Y - 1, 0); CY <= FMath::Min(Y + 1, NumCellsPerAxis - 1); ++CY)
+		{
+			for (int32 CZ = FMath::Max(Z - 1, 0); CZ <= FMath::Min(Z + 1, NumCellsPerAxis - 1); ++CZ)
+			{
+				for (const auto& Consumed : Cells[GetCellIdx(CX, CY, CZ)])
+				{
+					if (GetManhattanDistance(Color, Consumed) <= MinManhattanDist)
+					{
+						return false;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+// Get a new unique color, random trials are used if the lattice is exhausted (return black if failed)
+FColor FSLMaskColorAllocator::Allocate(int32 NumRandomTrials)
+{
+	while (CandidateIdx < Candidates.Num())
+	{
+		const FColor Candidate = Candidates[CandidateIdx++];
+		if (IsColorAvailable(Candidate))
+		{
+			AddConsumedColor(Candidate);
+			return Candidate;
+		}
+	}
+
+	// Lattice exhausted (or blocked by the existing colors), try the gaps
+	for (int32 TrialIdx = 0; TrialIdx < NumRandomTrials; ++TrialIdx)
+	{
+		const FColor RandColor((uint8)RandStream.RandRange(0, 255), (uint8)RandStream.RandRange(0, 255), (uint8)RandStream.RandRange(0, 255));
+		if (IsColorAvailable(RandColor))
+		{
+			AddConsumedColor(RandColor);
+			return RandColor;
+		}
+	}
+	return FColor::Black;
+}
+
+// Create the shuffled lattice candidates
+void FSLMaskColorAllocator::InitCandidates()
+{
+	// Points with an even coordinate sum on a cubic grid of this step are at least twice the step apart (manhattan)
+	const int32 Step = FMath::Max(MinManhattanDist / 2 + 1, 1);
+	const int32 NumSteps = 255 / Step;
+	const int32 Offset = (255 - NumSteps * Step) / 2;
+
+	Candidates.Reserve((NumSteps + 1) * (NumSteps + 1) * (NumSteps + 1) / 2 + 1);
+	for (int32 I = 0; I <= NumSteps; ++I)
+	{
+		for (int32 J = 0; J <= NumSteps; ++J)
+		{
+			for (int32 K = (I + J) % 2; K <= NumSteps; K += 2)
+			{
+				const FColor Color((uint8)(Offset + I * Step), (uint8)(Offset + J * Step), (uint8)(Offset + K * Step));
+				if (GetManhattanDistance(Color, FColor::Black) > MinDistToBlackWhite &&
+					GetManhattanDistance(Color, FColor::White) > MinDistToBlackWhite)
+				{
+					Candidates.Add(Color);
+				}
+			}
+		}
+	}
+
+	// Neighbouring individuals should not get similar colors
+	for (int32 Idx = Candidates.Num() - 1; Idx > 0; --Idx)
+	{
+		Candidates.Swap(Idx, RandStream.RandRange(0, Idx));
+	}
+}
@@ -13,14 +13,31 @@
 #include "Misc/FileHelper.h"
 #include "TimerManager.h"
 
+/* Decode task */
+// Decode the pending messages
+void FSLKRDecodeTask::DoWork()
+{
+	Dispatcher->DecodePending();
+}
+
+
+/* Dispatcher */
 // Ctor
 SLKRMsgDispatcher::SLKRMsgDispatcher()
 {
+#if SL_WITH_PROTO
+	InitCommandHandlers();
+#endif // SL_WITH_PROTO
 }
 
 // Dtor
 SLKRMsgDispatcher::~SLKRMsgDispatcher()
 {
+	// The decode task uses the queues of the dispatcher
+	while (NumPendingRaw.GetValue() > 0)
+	{
+		FPlatformProcess::Sleep(0.001f);
+	}
 }
 
 // Set up required manager
@@ -59,78 +76,140 @@ void SLKRMsgDispatcher::Reset()
 }
 
 // Parse the proto sequence and trigger function
-void  SLKRMsgDispatcher::ProcessProtobuf(std::string ProtoStr)
-{	
+void SLKRMsgDispatcher::ProcessProtobuf(const std::string& ProtoStr)
+{
 #if SL_WITH_PROTO
-	sl_pb::KRAmevaEvent AmevaEvent;
-	AmevaEvent.ParseFromString(ProtoStr);
-	if (AmevaEvent.functocall() == AmevaEvent.SetTask)
+	FSLKRCommand Command;
+	Command.ReceiveTime = FPlatformTime::Seconds();
+	if (!Command.Event.ParseFromString(ProtoStr))
 	{
-		SetTask(AmevaEvent.settaskparam());
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not parse the message.."), *FString(__FUNCTION__), __LINE__);
+		return;
 	}
-	else if (AmevaEvent.functocall() == AmevaEvent.SetEpisode)
-	{
-		SetEpisode(AmevaEvent.setepisodeparams());
-	}
-	else if (AmevaEvent.functocall() == AmevaEvent.DrawMarkerAt)
-	{
-		DrawMarker(AmevaEvent.drawmarkeratparams());
-	}
-	else if (AmevaEvent.functocall() == AmevaEvent.DrawMarkerTraj)
-	{
-		DrawMarkerTraj(AmevaEvent.drawmarkertrajparams());
-	}
-	else if (AmevaEvent.functocall() == AmevaEvent.LoadLevel)
-	{
-		LoadLevel(AmevaEvent.loadlevelparams());
-	}
-	else if (AmevaEvent.functocall() == AmevaEvent.StartSimulation)
-	{
-		StartSimulation(AmevaEvent.startsimulationparams());
-	}
-	else if (AmevaEvent.functocall() == AmevaEvent.StopSimulation)
-	{
-		StopSimulation(AmevaEvent.stopsimulationparams());
-	}
-	else if (AmevaEvent.functocall() == AmevaEvent.StartLogging)
-	{
-		StartLogging(AmevaEvent.startloggingparams());
-	}
-	else if (AmevaEvent.functocall() == AmevaEvent.StopLogging)
-	{
-		StopLogging();
-	}
-	else if (AmevaEvent.functocall() == AmevaEvent.GetEpisodeData)
-	{
-		SendEpisodeData(AmevaEvent.getepisodedataparams());
-	}
-	else if (AmevaEvent.functocall() == AmevaEvent.SetIndividualPose)
-	{
-		SetIndividualPose(AmevaEvent.setindividualposeparams());
-	}
-	else if (AmevaEvent.functocall() == AmevaEvent.ApplyForceTo)
+	DispatchCommand(Command);
+#endif // SL_WITH_PROTO
+}
+
+// Add the received message to be decoded in the background (can be called from any thread)
+void SLKRMsgDispatcher::EnqueueProtobuf(std::string&& ProtoStr)
+{
+	RawQueue.Enqueue(TPair<double, std::string>(FPlatformTime::Seconds(), MoveTemp(ProtoStr)));
+
+	// Only one decode task runs at a time, it keeps the order of the messages
+	if (NumPendingRaw.Increment() == 1)
 	{
-		ApplyForceTo(AmevaEvent.applyforcetoparams());
+		(new FAutoDeleteAsyncTask<FSLKRDecodeTask>(this))->StartBackgroundTask();
 	}
-	else if (AmevaEvent.functocall() == AmevaEvent.Highlight)
+}
+
+// Decode the pending messages until the raw queue is empty (worker thread)
+void SLKRMsgDispatcher::DecodePending()
+{
+	do
+	{
+		TPair<double, std::string> Raw;
+		if (!RawQueue.Dequeue(Raw))
+		{
+			continue;
+		}
+		const double StartTime = FPlatformTime::Seconds();
+		TSharedPtr<FSLKRCommand, ESPMode::ThreadSafe> Command = MakeShared<FSLKRCommand, ESPMode::ThreadSafe>();
+		Command->ReceiveTime = Raw.Key;
+#if SL_WITH_PROTO
+		if (!Command->Event.ParseFromArray(Raw.Value.data(), Raw.Value.size()))
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Could not parse the message, skipping it.."), *FString(__FUNCTION__), __LINE__);
+			continue;
+		}
+#endif // SL_WITH_PROTO
+		CommandQueue.Enqueue(Command);
+		DecodeLatency.AddSample(FPlatformTime::Seconds() - StartTime);
+	// The dispatcher is not accessed after the last decrement
+	} while (NumPendingRaw.Decrement() > 0);
+}
+
+// Trigger the functions of the decoded messages (game thread), MaxCommands <= 0 dispatches all, returns the number of dispatched commands
+int32 SLKRMsgDispatcher::DispatchCommands(int32 MaxCommands)
+{
+	int32 NumDispatched = 0;
+	TSharedPtr<FSLKRCommand, ESPMode::ThreadSafe> Command;
+	while ((MaxCommands <= 0 || NumDispatched < MaxCommands) && CommandQueue.Dequeue(Command))
 	{
-		HighlightIndividual(AmevaEvent.highlightparams());
+		DispatchCommand(*Command);
+		NumDispatched++;
 	}
-	else if (AmevaEvent.functocall() == AmevaEvent.RemoveHighlight)
-	{
-		RemoveIndividualHighlight(AmevaEvent.removehighlightparams());
+	return NumDispatched;
+}
+
+// Log the per-command latencies
+void SLKRMsgDispatcher::LogStats() const
+{
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Decode: num=%d; p50=%.3fms; p99=%.3fms;"), *FString(__FUNCTION__), __LINE__,
+		DecodeLatency.Num(), DecodeLatency.GetPercentileMs(0.5f), DecodeLatency.GetPercentileMs(0.99f));
+#if SL_WITH_PROTO
+	for (int32 Idx = 0; Idx < sl_pb::KRAmevaEvent::FuncToCall_ARRAYSIZE; ++Idx)
+	{
+		if (ExecLatency[Idx].Num() == 0)
+		{
+			continue;
+		}
+		const FString Name = UTF8_TO_TCHAR(sl_pb::KRAmevaEvent::FuncToCall_Name(static_cast<sl_pb::KRAmevaEvent::FuncToCall>(Idx)).c_str());
+		UE_LOG(LogTemp, Log, TEXT("%s::%d %s: num=%d; wait(p50=%.3fms; p99=%.3fms); exec(p50=%.3fms; p99=%.3fms);"),
+			*FString(__FUNCTION__), __LINE__, *Name, ExecLatency[Idx].Num(),
+			WaitLatency[Idx].GetPercentileMs(0.5f), WaitLatency[Idx].GetPercentileMs(0.99f),
+			ExecLatency[Idx].GetPercentileMs(0.5f), ExecLatency[Idx].GetPercentileMs(0.99f));
 	}
-	else if (AmevaEvent.functocall() == AmevaEvent.RemoveAllHighlight)
+#endif // SL_WITH_PROTO
+}
+
+// Call the function of the decoded command
+void SLKRMsgDispatcher::DispatchCommand(const FSLKRCommand& Command)
+{
+#if SL_WITH_PROTO
+	const int32 FuncIdx = Command.Event.functocall();
+	if (FuncIdx < 0 || FuncIdx >= sl_pb::KRAmevaEvent::FuncToCall_ARRAYSIZE || CommandHandlers[FuncIdx] == nullptr)
 	{
-		RemoveAllIndividualHighlight();
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Unknown function %d, skipping.."), *FString(__FUNCTION__), __LINE__, FuncIdx);
+		return;
 	}
 
+	const double StartTime = FPlatformTime::Seconds();
+	WaitLatency[FuncIdx].AddSample(StartTime - Command.ReceiveTime);
+	CommandHandlers[FuncIdx](*this, Command.Event);
+	ExecLatency[FuncIdx].AddSample(FPlatformTime::Seconds() - StartTime);
 #endif // SL_WITH_PROTO
 }
 
+#if SL_WITH_PROTO
+// Fill in the function table
+void SLKRMsgDispatcher::InitCommandHandlers()
+{
+	for (auto& Handler : CommandHandlers)
+	{
+		Handler = nullptr;
+	}
+	typedef sl_pb::KRAmevaEvent Ev;
+	CommandHandlers[Ev::SetTask] = [](SLKRMsgDispatcher& D, const Ev& E) { D.SetTask(E.settaskparam()); };
+	CommandHandlers[Ev::SetEpisode] = [](SLKRMsgDispatcher& D, const Ev& E) { D.SetEpisode(E.setepisodeparams()); };
+	CommandHandlers[Ev::DrawMarkerAt] = [](SLKRMsgDispatcher& D, const Ev& E) { D.DrawMarker(E.drawmarkeratparams()); };
+	CommandHandlers[Ev::DrawMarkerTraj] = [](SLKRMsgDispatcher& D, const Ev& E) { D.DrawMarkerTraj(E.drawmarkertrajparams()); };
+	CommandHandlers[Ev::LoadLevel] = [](SLKRMsgDispatcher& D, const Ev& E) { D.LoadLevel(E.loadlevelparams()); };
+	CommandHandlers[Ev::StartSimulation] = [](SLKRMsgDispatcher& D, const Ev& E) { D.StartSimulation(E.startsimulationparams()); };
+	CommandHandlers[Ev::StopSimulation] = [](SLKRMsgDispatcher& D, const Ev& E) { D.StopSimulation(E.stopsimulationparams()); };
+	CommandHandlers[Ev::StartLogging] = [](SLKRMsgDispatcher& D, const Ev& E) { D.StartLogging(E.startloggingparams()); };
+	CommandHandlers[Ev::StopLogging] = [](SLKRMsgDispatcher& D, const Ev& E) { D.StopLogging(); };
+	CommandHandlers[Ev::GetEpisodeData] = [](SLKRMsgDispatcher& D, const Ev& E) { D.SendEpisodeData(E.getepisodedataparams()); };
+	CommandHandlers[Ev::SetIndividualPose] = [](SLKRMsgDispatcher& D, const Ev& E) { D.SetIndividualPose(E.setindividualposeparams()); };
+	CommandHandlers[Ev::ApplyForceTo] = [](SLKRMsgDispatcher& D, const Ev& E) { D.ApplyForceTo(E.applyforcetoparams()); };
+	CommandHandlers[Ev::Highlight] = [](SLKRMsgDispatcher& D, const Ev& E) { D.HighlightIndividual(E.highlightparams()); };
+	CommandHandlers[Ev::RemoveHighlight] = [](SLKRMsgDispatcher& D, const Ev& E) { D.RemoveIndividualHighlight(E.removehighlightparams()); };
+	CommandHandlers[Ev::RemoveAllHighlight] = [](SLKRMsgDispatcher& D, const Ev& E) { D.RemoveAllIndividualHighlight(); };
+}
+#endif // SL_WITH_PROTO
+
 #if SL_WITH_PROTO
 // Set the task of MongoManager
-void SLKRMsgDispatcher::SetTask(sl_pb::SetTaskParams params)
+void SLKRMsgDispatcher::SetTask(const sl_pb::SetTaskParams& params)
 {
 	const FString TaskId = FString(UTF8_TO_TCHAR(params.task().c_str()));
 	bool bSuccess = MongoManager->SetTask(TaskId);
@@ -148,7 +227,7 @@ void SLKRMsgDispatcher::SetTask(sl_pb::SetTaskParams params)
 }
 
 // Set the episode of MongoManager
-void SLKRMsgDispatcher::SetEpisode(sl_pb::SetEpisodeParams params)
+void SLKRMsgDispatcher::SetEpisode(const sl_pb::SetEpisodeParams& params)
 {
 	const FString EpId = FString(UTF8_TO_TCHAR(params.episode().c_str()));
 	bool bSuccess = MongoManager->SetEpisode(EpId);
@@ -166,7 +245,7 @@ void SLKRMsgDispatcher::SetEpisode(sl_pb::SetEpisodeParams params)
 }
 
 // Draw the individual marker
-void SLKRMsgDispatcher::DrawMarker(sl_pb::DrawMarkerAtParams params)
+void SLKRMsgDispatcher::DrawMarker(const sl_pb::DrawMarkerAtParams& params)
 {
 	FString Id = UTF8_TO_TCHAR(params.id().c_str());
 	float TimeStamp = params.timestamp();
@@ -174,18 +253,29 @@ void SLKRMsgDispatcher::DrawMarker(sl_pb::DrawMarkerAtParams params)
 	ESLVizPrimitiveMarkerType Type = GetMarkerType(params.marker());
 	ESLVizMaterialType MaterialType = GetMarkerMaterialType(UTF8_TO_TCHAR(params.material().c_str()));
 	FLinearColor Color = GetMarkerColor(UTF8_TO_TCHAR(params.color().c_str()));
-	FTransform Pose = MongoManager->GetIndividualPoseAt(Id, TimeStamp);
-	TArray<FTransform> Poses;
-	Poses.Add(Pose);
-	VizManager->CreatePrimitiveMarker(Id, Poses, Type, params.scale(), Color, MaterialType);
-	FSLKRResponse Response;
-	Response.Type = ResponseType::TEXT;
-	Response.Text = TEXT("Completed - Draw marker");
-	KRWSClient->SendResponse(Response);
+	const float Size = params.scale();
+
+	// Query on the mongo workers, the marker is drawn on the game thread once the pose is available
+	TWeakObjectPtr<ASLVizManager> WeakVizManager = VizManager;
+	TSharedPtr<FSLKRWSClient> WSClient = KRWSClient;
+	MongoManager->GetIndividualPoseAtAsync(MongoManager->GetTaskId(), MongoManager->GetEpisodeId(), Id, TimeStamp,
+		[WeakVizManager, WSClient, Id, Type, Size, Color, MaterialType](const FTransform& Pose)
+	{
+		if (WeakVizManager.IsValid())
+		{
+			TArray<FTransform> Poses;
+			Poses.Add(Pose);
+			WeakVizManager->CreatePrimitiveMarker(Id, Poses, Type, Size, Color, MaterialType);
+		}
+		FSLKRResponse Response;
+		Response.Type = ResponseType::TEXT;
+		Response.Text = TEXT("Completed - Draw marker");
+		WSClient->SendResponse(Response);
+	});
 }
 
 // Draw the individual trajectory
-void SLKRMsgDispatcher::DrawMarkerTraj(sl_pb::DrawMarkerTrajParams params)
+void SLKRMsgDispatcher::DrawMarkerTraj(const sl_pb::DrawMarkerTrajParams& params)
 {
 	FString Id = UTF8_TO_TCHAR(params.id().c_str());
 	float Start = params.start();
@@ -194,15 +284,26 @@ void SLKRMsgDispatcher::DrawMarkerTraj(sl_pb::DrawMarkerTrajParams params)
 	ESLVizPrimitiveMarkerType Type = GetMarkerType(params.marker());
 	ESLVizMaterialType MaterialType = GetMarkerMaterialType(UTF8_TO_TCHAR(params.material().c_str()));
 	FLinearColor Color = GetMarkerColor(UTF8_TO_TCHAR(params.color().c_str()));
-	TArray<FTransform> Poses = MongoManager->GetIndividualTrajectory(Id, Start, End);
-	VizManager->CreatePrimitiveMarker(Id, Poses, Type, params.scale(), Color, MaterialType);
-	FSLKRResponse Response;
-	Response.Type = ResponseType::TEXT;
-	Response.Text = TEXT("Completed - Draw trajectory");
-	KRWSClient->SendResponse(Response);
+	const float Size = params.scale();
+
+	// Query on the mongo workers, the marker is drawn on the game thread once the trajectory is available
+	TWeakObjectPtr<ASLVizManager> WeakVizManager = VizManager;
+	TSharedPtr<FSLKRWSClient> WSClient = KRWSClient;
+	MongoManager->GetIndividualTrajectoryAsync(MongoManager->GetTaskId(), MongoManager->GetEpisodeId(), Id, Start, End, -1.f,
+		[WeakVizManager, WSClient, Id, Type, Size, Color, MaterialType](const TArray<FTransform>& Poses)
+	{
+		if (WeakVizManager.IsValid())
+		{
+			WeakVizManager->CreatePrimitiveMarker(Id, Poses, Type, Size, Color, MaterialType);
+		}
+		FSLKRResponse Response;
+		Response.Type = ResponseType::TEXT;
+		Response.Text = TEXT("Completed - Draw trajectory");
+		WSClient->SendResponse(Response);
+	});
 }
 // Hightlight the individual
-void SLKRMsgDispatcher::HighlightIndividual(sl_pb::HighlightParams params)
+void SLKRMsgDispatcher::HighlightIndividual(const sl_pb::HighlightParams& params)
 {
 	FString Id = UTF8_TO_TCHAR(params.id().c_str());
 	ESLVizMaterialType MaterialType = GetMarkerMaterialType(UTF8_TO_TCHAR(params.material().c_str()));
@@ -215,7 +316,7 @@ void SLKRMsgDispatcher::HighlightIndividual(sl_pb::HighlightParams params)
 }
 
 // Remove the individual hightlight
-void SLKRMsgDispatcher::RemoveIndividualHighlight(sl_pb::RemoveHighlightParams params)
+void SLKRMsgDispatcher::RemoveIndividualHighlight(const sl_pb::RemoveHighlightParams& params)
 {
 	FString Id = UTF8_TO_TCHAR(params.id().c_str());
 	VizManager->RemoveIndividualHighlight(Id);
@@ -236,7 +337,7 @@ void SLKRMsgDispatcher::RemoveAllIndividualHighlight()
 }
 
 // Load the Semantic Map
-void SLKRMsgDispatcher::LoadLevel(sl_pb::LoadLevelParams params)
+void SLKRMsgDispatcher::LoadLevel(const sl_pb::LoadLevelParams& params)
 {
 	FString Level = UTF8_TO_TCHAR(params.level().c_str());
 	LevelManager->SwitchLevelTo(FName(*Level));
@@ -247,7 +348,7 @@ void SLKRMsgDispatcher::LoadLevel(sl_pb::LoadLevelParams params)
 }
 
 // Start Symbolic and World State Logger
-void SLKRMsgDispatcher::StartLogging(sl_pb::StartLoggingParams params)
+void SLKRMsgDispatcher::StartLogging(const sl_pb::StartLoggingParams& params)
 {
 	FString TaskId = UTF8_TO_TCHAR(params.taskid().c_str());
 	FString EpisodeId = UTF8_TO_TCHAR(params.episodeid().c_str());
@@ -322,7 +423,7 @@ void SLKRMsgDispatcher::StopLogging()
 }
 
 // Send the Symbolic log owl file
-void SLKRMsgDispatcher::SendEpisodeData(sl_pb::GetEpisodeDataParams params)
+void SLKRMsgDispatcher::SendEpisodeData(const sl_pb::GetEpisodeDataParams& params)
 {
 	FString TaskId = UTF8_TO_TCHAR(params.taskid().c_str());
 	FString EpisodeId = UTF8_TO_TCHAR(params.episodeid().c_str());
@@ -332,12 +433,14 @@ void SLKRMsgDispatcher::SendEpisodeData(sl_pb::GetEpisodeDataParams params)
 	FPaths::RemoveDuplicateSlashes(FullFilePath);
 	if (FPaths::FileExists(FullFilePath))
 	{
-		TArray<uint8> FileBinary;
-		FSLKRResponse Response;
-		Response.Type = ResponseType::FILE;
-		Response.FileName = EpisodeId + TEXT("_ED.owl");
-		FFileHelper::LoadFileToArray(Response.FileData, *FullFilePath);
-		KRWSClient->SendResponse(Response);
+		// Stream the file in chunks instead of loading it whole, an aborted transfer is reported to knowrob
+		if (!KRWSClient->SendFile(FullFilePath, EpisodeId + TEXT("_ED.owl")))
+		{
+			FSLKRResponse Response;
+			Response.Type = ResponseType::TEXT;
+			Response.Text = TEXT("Error: File transfer failed");
+			KRWSClient->SendResponse(Response);
+		}
 	}
 	else 
 	{
@@ -349,7 +452,7 @@ void SLKRMsgDispatcher::SendEpisodeData(sl_pb::GetEpisodeDataParams params)
 }
 
 // Start Simulation
-void SLKRMsgDispatcher::StartSimulation(sl_pb::StartSimulationParams params)
+void SLKRMsgDispatcher::StartSimulation(const sl_pb::StartSimulationParams& params)
 {
 	TArray<FString> Ids;
 	for (int i = 0; i < params.id_size(); i++) 
@@ -377,7 +480,7 @@ void SLKRMsgDispatcher::StartSimulation(sl_pb::StartSimulationParams params)
 }
 
 // Stop Simulation
-void SLKRMsgDispatcher::StopSimulation(sl_pb::StopSimulationParams params)
+void SLKRMsgDispatcher::StopSimulation(const sl_pb::StopSimulationParams& params)
 {
 	TArray<FString> Ids;
 	for (int i = 0; i < params.id_size(); i++)
@@ -404,7 +507,7 @@ void SLKRMsgDispatcher::StopSimulation(sl_pb::StopSimulationParams params)
 }
 
 // Move Individual
-void SLKRMsgDispatcher::SetIndividualPose(sl_pb::SetIndividualPoseParams params)
+void SLKRMsgDispatcher::SetIndividualPose(const sl_pb::SetIndividualPoseParams& params)
 {
 	FString Id = UTF8_TO_TCHAR(params.id().c_str());
 	FVector Loc = FVector(params.vecx(), params.vecy(), params.vecz());
@@ -427,7 +530,7 @@ void SLKRMsgDispatcher::SetIndividualPose(sl_pb::SetIndividualPoseParams params)
 	KRWSClient->SendResponse(Response);
 }
 
-void SLKRMsgDispatcher::ApplyForceTo(sl_pb::ApplyForceToParams params)
+void SLKRMsgDispatcher::ApplyForceTo(const sl_pb::ApplyForceToParams& params)
 {
 	FString Id = UTF8_TO_TCHAR(params.id().c_str());
 	FVector Force = FVector(params.forcex(), params.forcey(), params.forcez());
@@ -3,13 +3,98 @@
 
 #include "Knowrob/SLKRWSClient.h"
 #include "WebSocketsModule.h"
+#include "HAL/FileManager.h"
+#include "Misc/Compression.h"
 #if SL_WITH_PROTO
 #include "Knowrob/Proto/SLProtoMsgType.h"
 #endif // SL_WITH_PROTO	
 
+#if SL_WITH_PROTO
+/**
+ * Sends a file as creation, data chunks and finish messages, the data message and the buffers are reused for every chunk
+ */
+struct FSLKRFileSender
+{
+	// Notify knowrob to create the file (the text field announces the compression of the data chunks)
+	FSLKRFileSender(IWebSocket& InWebSocket, const FString& FileName, bool bInCompress) :
+		WebSocket(InWebSocket), FileNameStr(TCHAR_TO_UTF8(*FileName)), bCompress(bInCompress)
+	{
+		sl_pb::KRAmevaResponse CreationResponse;
+		CreationResponse.set_type(sl_pb::KRAmevaResponse::FileCreation);
+		CreationResponse.set_filename(FileNameStr);
+		if (bCompress)
+		{
+			CreationResponse.set_text("zlib");
+		}
+		Send(CreationResponse);
+		DataResponse.set_type(sl_pb::KRAmevaResponse::FileData);
+	}
+
+	// Send the binary chunk (data length is always the uncompressed size), false if the chunk could not be sent
+	bool SendChunk(const uint8* Data, int32 Num)
+	{
+		DataResponse.set_datalength(Num);
+		if (bCompress)
+		{
+			int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, Num);
+			CompressedData.SetNumUninitialized(CompressedSize, false);
+			if (FCompression::CompressMemory(NAME_Zlib, CompressedData.GetData(), CompressedSize, Data, Num))
+			{
+				DataResponse.set_filedata(CompressedData.GetData(), CompressedSize);
+			}
+			else
+			{
+				UE_LOG(LogTemp, Error, TEXT("%s::%d Could not compress the file data.."), *FString(__FUNCTION__), __LINE__);
+				return false;
+			}
+		}
+		else
+		{
+			DataResponse.set_filedata(Data, Num);
+		}
+		Send(DataResponse);
+		return true;
+	}
+
+	// Notify that all the data is sent
+	void Finish()
+	{
+		sl_pb::KRAmevaResponse FinishResponse;
+		FinishResponse.set_type(sl_pb::KRAmevaResponse::FileFinish);
+		FinishResponse.set_filename(FileNameStr);
+		Send(FinishResponse);
+	}
+
+	// Serialize into the reused buffer and send as binary
+	void Send(const sl_pb::KRAmevaResponse& Response)
+	{
+		Response.SerializeToString(&ProtoStr);
+		WebSocket.Send(ProtoStr.data(), ProtoStr.size(), true);
+		NumMessages++;
+	}
+
+	// Websocket to send through
+	IWebSocket& WebSocket;
+
+	// Name of the file on the knowrob side
+	std::string FileNameStr;
+
+	// Compress the data chunks
+	bool bCompress;
+
+	// Reused data message, serialization and compression buffers
+	sl_pb::KRAmevaResponse DataResponse;
+	std::string ProtoStr;
+	TArray<uint8> CompressedData;
+
+	// Number of sent messages
+	int32 NumMessages = 0;
+};
+#endif // SL_WITH_PROTO
+
 
 // Ctor
-FSLKRWSClient::FSLKRWSClient()
+FSLKRWSClient::FSLKRWSClient() : FileChunkSize(256 * 1024), bCompressFileData(false)
 {
 }
 
@@ -187,36 +272,73 @@ void FSLKRWSClient::SendResponse(const FSLKRResponse& Response)
 	}
 	else if (Response.Type == ResponseType::FILE)
 	{
-		// Notify knowrob to create a file
-		std::string FLNameStr(TCHAR_TO_UTF8(*Response.FileName));
-		sl_pb::KRAmevaResponse CreationResponse;
-		CreationResponse.set_type(sl_pb::KRAmevaResponse::FileCreation);
-		CreationResponse.set_filename(FLNameStr);
-		std::string ProtoStr = CreationResponse.SerializeAsString();
-		WebSocket->Send(ProtoStr.data(), ProtoStr.size(), true);
-
-		// Slice the file data into frames and send them to knowrob
-		const int DefaultFrameSize = 64;
-		for (int Offset = 0; Offset < Response.FileData.Num(); Offset += DefaultFrameSize)
+		// Slice the file data into chunks and send them to knowrob, an incomplete file is never finished
+		FSLKRFileSender Sender(*WebSocket, Response.FileName, bCompressFileData);
+		for (int32 Offset = 0; Offset < Response.FileData.Num(); Offset += FileChunkSize)
 		{
-			sl_pb::KRAmevaResponse DataResponse;
-			DataResponse.set_type(sl_pb::KRAmevaResponse::FileData);
-			int32 FrameSize = Response.FileData.Num() - Offset < DefaultFrameSize ? Response.FileData.Num() - Offset : DefaultFrameSize;
-			const uint8* FileData = Response.FileData.GetData();
-			uint8 DataFrame[DefaultFrameSize];
-			memcpy(DataFrame, FileData + Offset, FrameSize);
-			DataResponse.set_datalength(FrameSize);
-			DataResponse.set_filedata((char*)DataFrame);
-			ProtoStr = DataResponse.SerializeAsString();
-			WebSocket->Send(ProtoStr.data(), ProtoStr.size(), true);
+			if (!Sender.SendChunk(Response.FileData.GetData() + Offset, FMath::Min(FileChunkSize, Response.FileData.Num() - Offset)))
+			{
+				UE_LOG(LogTemp, Error, TEXT("%s::%d Transfer of %s aborted.."), *FString(__FUNCTION__), __LINE__, *Response.FileName);
+				return;
+			}
 		}
+		Sender.Finish();
+	}
+#endif // SL_WITH_PROTO	
+}
 
-		// Notify that all the data is sent
-		sl_pb::KRAmevaResponse FinishResponse;
-		FinishResponse.set_type(sl_pb::KRAmevaResponse::FileFinish);
-		FinishResponse.set_filename(FLNameStr);
-		ProtoStr = FinishResponse.SerializeAsString();
-		WebSocket->Send(ProtoStr.data(), ProtoStr.size(), true);
+// Stream the file from disk in chunks via websocket
+bool FSLKRWSClient::SendFile(const FString& FilePath, const FString& FileName)
+{
+#if SL_WITH_PROTO
+	if (!IsConnected())
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d WebSocket is not connected.."), *FString(__FUNCTION__), __LINE__);
+		return false;
 	}
+
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*FilePath));
+	if (!Reader)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not open %s.."), *FString(__FUNCTION__), __LINE__, *FilePath);
+		return false;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	const int64 TotalSize = Reader->TotalSize();
+	TArray<uint8> Chunk;
+	Chunk.SetNumUninitialized(FMath::Min<int64>(FileChunkSize, TotalSize));
+
+	// Only one chunk of the file is in memory at a time, an incomplete file is never finished
+	FSLKRFileSender Sender(*WebSocket, FileName, bCompressFileData);
+	for (int64 Offset = 0; Offset < TotalSize; Offset += FileChunkSize)
+	{
+		const int32 Num = (int32)FMath::Min<int64>(FileChunkSize, TotalSize - Offset);
+		Reader->Serialize(Chunk.GetData(), Num);
+		if (Reader->IsError())
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Error while reading %s, transfer aborted.."), *FString(__FUNCTION__), __LINE__, *FilePath);
+			return false;
+		}
+		if (!Sender.SendChunk(Chunk.GetData(), Num))
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Could not send %s, transfer aborted.."), *FString(__FUNCTION__), __LINE__, *FilePath);
+			return false;
+		}
+	}
+	Sender.Finish();
+
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Duration: %s(bytes=%lld, msgs=%d)=[%f] seconds..;"),
+		*FString(__FUNCTION__), __LINE__, *FileName, TotalSize, Sender.NumMessages, FPlatformTime::Seconds() - StartTime);
+	return true;
+#else
+	return false;
 #endif // SL_WITH_PROTO	
-}
\ No newline at end of file
+}
+
+// Set the size of the file data messages and if their data should be compressed
+void FSLKRWSClient::SetFileTransferParams(int32 InFileChunkSize, bool bInCompressFileData)
+{
+	FileChunkSize = FMath::Max(InFileChunkSize, 1024);
+	bCompressFileData = bInCompressFileData;
+}
@@ -23,7 +23,8 @@
 ASLKnowrobManager::ASLKnowrobManager()
 {
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = false;
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
 
 	bIgnore = false;
 	bIsInit = false;
@@ -176,6 +177,12 @@ void ASLKnowrobManager::PostEditChangeProperty(struct FPropertyChangedEvent& Pro
 void ASLKnowrobManager::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
+
+	// Dispatch the messages decoded in the background
+	if (KRMsgDispatcher.IsValid())
+	{
+		KRMsgDispatcher->DispatchCommands(KRMaxCommandsPerTick);
+	}
 }
 
 // Called when actor removed from game or game ended
@@ -203,6 +210,7 @@ void ASLKnowrobManager::Init()
 	{
 		KRWSClient = MakeShareable<FSLKRWSClient>(new FSLKRWSClient());
 		KRWSClient->Init(KRServerIP, KRServerPort, KRWSProtocol);
+		KRWSClient->SetFileTransferParams(KRFileChunkSizeKB * 1024, bKRCompressFileData);
 	}
 
 	// Get and connect the mongo query manager
@@ -238,6 +246,9 @@ void ASLKnowrobManager::Init()
 		VizManager->ConvertWorldToVisualizationMode();
 	}
 
+	// Let the pose queries use the already cached episodes
+	MongoQueryManager->SetVizManager(VizManager);
+
 	// Get the map manager
     if (!SetSemancticMapManager())
     {
@@ -342,6 +353,12 @@ void ASLKnowrobManager::Start()
 	// Bind user inputs
 	SetupInputBindings();
 
+	// The decoded messages are dispatched in the tick
+	if (bKRDecodeInBackground)
+	{
+		SetActorTickEnabled(true);
+	}
+
 	bIsStarted = true;
 	UE_LOG(LogTemp, Warning, TEXT("%s::%d %s succesfully started.."),
 		*FString(__FUNCTION__), __LINE__, *GetName());
@@ -373,6 +390,12 @@ void ASLKnowrobManager::Finish(bool bForced)
 		KRWSClient.Reset();
 	}
 
+	SetActorTickEnabled(false);
+	if (KRMsgDispatcher.IsValid())
+	{
+		KRMsgDispatcher->LogStats();
+	}
+
 	bIsStarted = false;
 	bIsInit = false;
 	bIsFinished = true;
@@ -481,8 +504,16 @@ void ASLKnowrobManager::OnKRMsg()
 	while (KRWSClient->MessageQueue.Dequeue(ProtoMsgBinary))
 	{
 #if SL_WITH_PROTO
-		UE_LOG(LogTemp, Log, TEXT("%s::%d Processing message.."), *FString(__FUNCTION__), __LINE__);
-		KRMsgDispatcher->ProcessProtobuf(ProtoMsgBinary);
+		if (bKRDecodeInBackground)
+		{
+			// Decoded on a worker thread, dispatched in the tick
+			KRMsgDispatcher->EnqueueProtobuf(MoveTemp(ProtoMsgBinary));
+		}
+		else
+		{
+			UE_LOG(LogTemp, Log, TEXT("%s::%d Processing message.."), *FString(__FUNCTION__), __LINE__);
+			KRMsgDispatcher->ProcessProtobuf(ProtoMsgBinary);
+		}
 #endif // SL_WITH_PROTO	
 	}
 }
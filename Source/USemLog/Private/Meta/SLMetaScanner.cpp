@@ -175,6 +175,10 @@ void USLMetaScanner::Finish()
 {
 	if (!bIsFinished && (bIsInit || bIsStarted))
 	{
+		// Make sure all the screenshots are stored
+		ImageWriter.Flush();
+		ImageWriter.LogStats();
+
 		bIsStarted = false;
 		bIsInit = false;
 		bIsFinished = true;
@@ -219,18 +223,14 @@ void USLMetaScanner::ScreenshotCB(int32 SizeX, int32 SizeY, const TArray<FColor>
 	//// Remove const-ness from array
 	//TArray<FColor>& BitmapRef = const_cast<TArray<FColor>&>(Bitmap)
 
-	// Compress image
-	TArray<uint8> CompressedBitmap;
-	FImageUtils::CompressImageArray(SizeX, SizeY, Bitmap, CompressedBitmap);
-
-	// Add image current scan data
-	ScanPoseData.Images.Emplace(GetViewModeName(ViewModes[CurrViewModeIdx]), CompressedBitmap);
-
-	// Save the png locally
+	// Compress (and save locally) in the background, the images are added to the scan data when the scan pose is done
+	TArray<FString> Paths;
 	if (!SaveLocallyFolderName.IsEmpty())
 	{
-		SaveImageLocally(CompressedBitmap);
+		Paths.Add(GetLocalImagePath());
 	}
+	ScanPoseImages.Emplace(GetViewModeName(ViewModes[CurrViewModeIdx]),
+		ImageWriter.AddImage(SizeX, SizeY, TArray<FColor>(Bitmap), Paths, nullptr, true));
 
 	// Item and camera in position, check for other view modes
 	if (SetupNextViewMode())
@@ -248,16 +248,20 @@ void USLMetaScanner::ScreenshotCB(int32 SizeX, int32 SizeY, const TArray<FColor>
 		// Check for next camera poses
 		if (GotoNextScanPose())
 		{
+			//AddScanPoseImages();
 			//MetadataLoggerParent->AddScanPoseEntry(ScanPoseData);
 			ScanPoseData.Images.Empty();
+			ScanPoseImages.Empty();
 			ScanPoseData.CameraPose = CameraPoseActor->GetActorTransform(); //ScanPoses[CurrPoseIdx];
 
 			RequestScreenshot();
 		}
 		else
 		{
+			//AddScanPoseImages();
 			//MetadataLoggerParent->AddScanPoseEntry(ScanPoseData);
 			ScanPoseData.Images.Empty();
+			ScanPoseImages.Empty();
 			//MetadataLoggerParent->FinishScanEntry();
 
 			if (SetupNextItem())
@@ -903,13 +907,24 @@ void USLMetaScanner::QuitEditor()
 #endif // WITH_EDITOR
 }
 
-// Save the compressed screenshot image locally
-void USLMetaScanner::SaveImageLocally(const TArray<uint8>& CompressedBitmap)
+// Get the local path of the current screenshot image
+FString USLMetaScanner::GetLocalImagePath() const
 {
 	FString ItemClassFolder = ScanItems[CurrItemIdx].Value + "_" + ViewModeString + "/";
 	FString Path = FPaths::ProjectDir() + SaveLocallyFolderName + ItemClassFolder + CurrScanName + ".png";
 	FPaths::RemoveDuplicateSlashes(Path);
-	FFileHelper::SaveArrayToFile(CompressedBitmap, *Path);
+	return Path;
+}
+
+// Wait for the compressed images of the current scan pose and add them to the scan pose data
+void USLMetaScanner::AddScanPoseImages()
+{
+	for (auto& ScanPoseImage : ScanPoseImages)
+	{
+		ImageWriter.Wait(ScanPoseImage.Value);
+		ScanPoseData.Images.Emplace(ScanPoseImage.Key, MoveTemp(ScanPoseImage.Value->CompressedBitmap));
+	}
+	ScanPoseImages.Empty();
 }
 
 // Output progress to terminal
@@ -0,0 +1,320 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Mongo/SLMongoEpisodeStream.h"
+
+/* Episode Stream Async Task */
+// Dtor
+FSLMongoEpisodeStreamTask::~FSLMongoEpisodeStreamTask()
+{
+#if SL_WITH_LIBMONGO_C
+	if (collection)
+	{
+		mongoc_collection_destroy(collection);
+	}
+	if (client)
+	{
+		mongoc_client_destroy(client);
+	}
+#endif //SL_WITH_LIBMONGO_C
+}
+
+#if SL_WITH_LIBMONGO_C
+// Create the connection to the episode collection (the mongo client is not thread safe)
+bool FSLMongoEpisodeStreamTask::Init(const mongoc_uri_t* in_uri, const char* db_name, const char* coll_name,
+	const TMap<int32, FSLMongoCompactPoseLayout>& InCompactLayouts,
+	const FSLMongoEpisodeStreamParams& InParams, FSLMongoEpisodeStream* InStream)
+{
+	client = mongoc_client_new_from_uri(in_uri);
+	if (!client)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not create the stream mongo client.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+	mongoc_client_set_appname(client,
+		TCHAR_TO_UTF8(*FString::Printf(TEXT("MongoQA_Stream_%s"), UTF8_TO_TCHAR(coll_name))));
+	collection = mongoc_client_get_collection(client, db_name, coll_name);
+
+	CompactLayouts = InCompactLayouts;
+	Params = InParams;
+	Stream = InStream;
+	return true;
+}
+#endif //SL_WITH_LIBMONGO_C
+
+// Read the cursor and publish the chunks
+void FSLMongoEpisodeStreamTask::DoWork()
+{
+#if SL_WITH_LIBMONGO_C
+	const bool bCompactSchema = CompactLayouts.Num() > 0;
+	const double StartTs = Params.StartTs < 0.f ? -BIG_NUMBER : Params.StartTs;
+	const double EndTs = Params.EndTs < 0.f ? BIG_NUMBER : Params.EndTs;
+
+	// The range filter also skips any non frame documents
+	bson_t* filter = BCON_NEW(
+		"timestamp",
+		"{",
+			"$gte", BCON_DOUBLE(StartTs),
+			"$lte", BCON_DOUBLE(EndTs),
+		"}");
+
+	// Sorting on the indexed timestamp lets the server return the first batch without reading the whole collection
+	bson_t* opts = bCompactSchema
+		? BCON_NEW(
+			"sort", "{", "timestamp", BCON_INT32(1), "}",
+			"projection", "{", "_id", BCON_INT32(0), "}",
+			"batchSize", BCON_INT32(FMath::Max(Params.CursorBatchSize, 1)))
+		: BCON_NEW(
+			"sort", "{", "timestamp", BCON_INT32(1), "}",
+			"projection", "{", "_id", BCON_INT32(0), "timestamp", BCON_INT32(1), "individuals", BCON_INT32(1), "}",
+			"batchSize", BCON_INT32(FMath::Max(Params.CursorBatchSize, 1)));
+
+	mongoc_cursor_t* cursor = mongoc_collection_find_with_opts(collection, filter, opts, NULL);
+
+	CurrChunk = MakeShared<FSLMongoEpisodeChunk, ESPMode::ThreadSafe>();
+	CurrChunk->FrameOffsets.Add(0);
+
+	const bson_t* doc;
+	while (!Stream->bCancelled && mongoc_cursor_next(cursor, &doc))
+	{
+		bCompactSchema ? AddCompactFrame(doc) : AddVerboseFrame(doc);
+	}
+
+	bson_error_t error;
+	if (mongoc_cursor_error(cursor, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+		Stream->bFailed = true;
+	}
+
+	if (!Stream->bCancelled && CurrChunk->NumFrames() > 0)
+	{
+		PublishChunk();
+	}
+
+	mongoc_cursor_destroy(cursor);
+	bson_destroy(filter);
+	bson_destroy(opts);
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Durations: first chunk=[%f], total(frames=%d, chunks=%d, ids=%d)=[%f] seconds%s..;"),
+		*FString(__func__), __LINE__, FirstChunkLatency, Stream->NumStreamedFrames.GetValue(), NumPublishedChunks,
+		Utf8Ids.Num(), FPlatformTime::Seconds() - Stream->StartTime, Stream->bCancelled ? TEXT(" (cancelled)") : TEXT(""));
+#endif //SL_WITH_LIBMONGO_C
+
+	Stream->bReadDone = true;
+}
+
+#if SL_WITH_LIBMONGO_C
+// Add the individual poses of the verbose frame document to the current chunk
+bool FSLMongoEpisodeStreamTask::AddVerboseFrame(const bson_t* doc)
+{
+	bson_iter_t frame_iter;
+	if (!bson_iter_init(&frame_iter, doc) || !bson_iter_find(&frame_iter, "timestamp"))
+	{
+		return false;
+	}
+	const float Ts = bson_iter_double(&frame_iter);
+	CheckChunkBoundary(Ts);
+
+	bson_iter_t individuals_iter;
+	if (bson_iter_init(&frame_iter, doc) && bson_iter_find(&frame_iter, "individuals") && bson_iter_recurse(&frame_iter, &individuals_iter))
+	{
+		int32 Position = 0;
+		while (bson_iter_next(&individuals_iter))
+		{
+			bson_iter_t individual_val_iter;
+			if (!bson_iter_recurse(&individuals_iter, &individual_val_iter) || !bson_iter_find(&individual_val_iter, "id"))
+			{
+				continue;
+			}
+			const char* id_chr = bson_iter_utf8(&individual_val_iter, NULL);
+
+			// The individuals are usually written in the same order, check the previous frame first
+			int32 IdIdx = INDEX_NONE;
+			if (PrevFrameIdIndices.IsValidIndex(Position))
+			{
+				const int32 PrevIdIdx = PrevFrameIdIndices[Position];
+				if (FCStringAnsi::Strcmp(id_chr, Utf8Ids[PrevIdIdx].GetData()) == 0)
+				{
+					IdIdx = PrevIdIdx;
+				}
+			}
+			if (IdIdx == INDEX_NONE)
+			{
+				IdIdx = GetOrAddIdIdx(FString(UTF8_TO_TCHAR(id_chr)));
+				if (PrevFrameIdIndices.IsValidIndex(Position))
+				{
+					PrevFrameIdIndices[Position] = IdIdx;
+				}
+				else
+				{
+					PrevFrameIdIndices.Add(IdIdx);
+				}
+			}
+
+			CurrChunk->IdIndices.Add(IdIdx);
+			CurrChunk->Poses.Add(FSLMongoQueryDBHandler::GetPose(&individuals_iter));
+			Position++;
+		}
+	}
+
+	CurrChunk->Timestamps.Add(Ts);
+	CurrChunk->FrameOffsets.Add(CurrChunk->IdIndices.Num());
+	return true;
+}
+
+// Add the packed poses of the compact frame document to the current chunk
+bool FSLMongoEpisodeStreamTask::AddCompactFrame(const bson_t* doc)
+{
+	FSLWorldStateCompactFrame Frame;
+	if (!FSLMongoQueryDBHandler::ReadCompactFrameView(doc, Frame) || !CompactLayouts.Contains(Frame.Layout))
+	{
+		return false;
+	}
+	CheckChunkBoundary(Frame.Timestamp);
+
+	// Map the pose indices of the layout to id indices once
+	TArray<int32>* IdIndices = LayoutIdIndices.Find(Frame.Layout);
+	if (IdIndices == nullptr)
+	{
+		IdIndices = &LayoutIdIndices.Add(Frame.Layout);
+		for (const FString& Id : CompactLayouts[Frame.Layout].Ids)
+		{
+			IdIndices->Add(GetOrAddIdIdx(Id));
+		}
+	}
+
+	for (int32 Slot = 0; Slot < Frame.Num; ++Slot)
+	{
+		const int32 PoseIdx = Frame.GetPoseIdx(Slot);
+		if (IdIndices->IsValidIndex(PoseIdx))
+		{
+			CurrChunk->IdIndices.Add((*IdIndices)[PoseIdx]);
+			CurrChunk->Poses.Add(FSLMongoQueryDBHandler::GetCompactPose(Frame, Slot));
+		}
+	}
+
+	CurrChunk->Timestamps.Add(Frame.Timestamp);
+	CurrChunk->FrameOffsets.Add(CurrChunk->IdIndices.Num());
+	return true;
+}
+#endif //SL_WITH_LIBMONGO_C
+
+// Get the id index of the individual, new ids are registered in the current chunk
+int32 FSLMongoEpisodeStreamTask::GetOrAddIdIdx(const FString& Id)
+{
+	if (const int32* IdIdx = IdToIdx.Find(Id))
+	{
+		return *IdIdx;
+	}
+
+	const int32 NewIdIdx = Utf8Ids.Num();
+	IdToIdx.Add(Id, NewIdIdx);
+	FTCHARToUTF8 Utf8Id(*Id);
+	TArray<ANSICHAR>& Utf8IdChars = Utf8Ids.AddDefaulted_GetRef();
+	Utf8IdChars.Append(Utf8Id.Get(), Utf8Id.Length());
+	Utf8IdChars.Add('\0');
+
+	CurrChunk->NewIds.Add(Id);
+	return NewIdIdx;
+}
+
+// Start a new chunk if the current one covers the chunk duration or frame count
+void FSLMongoEpisodeStreamTask::CheckChunkBoundary(float Timestamp)
+{
+	const int32 NumFrames = CurrChunk->NumFrames();
+	if (NumFrames == 0)
+	{
+		return;
+	}
+
+	const float Duration = NumPublishedChunks == 0 ? Params.FirstChunkDuration : Params.ChunkDuration;
+	if (Timestamp - CurrChunk->Timestamps[0] >= Duration || NumFrames >= Params.MaxChunkFrames)
+	{
+		PublishChunk();
+	}
+}
+
+// Publish the current chunk to the stream
+void FSLMongoEpisodeStreamTask::PublishChunk()
+{
+	const int32 NumFrames = CurrChunk->NumFrames();
+	CurrChunk->PublishLatency = FPlatformTime::Seconds() - Stream->StartTime;
+	if (NumPublishedChunks == 0)
+	{
+		FirstChunkLatency = CurrChunk->PublishLatency;
+	}
+	Stream->Chunks.Enqueue(CurrChunk);
+	Stream->NumStreamedFrames.Add(NumFrames);
+	NumPublishedChunks++;
+
+	// Continue the id indices in the next chunk
+	CurrChunk = MakeShared<FSLMongoEpisodeChunk, ESPMode::ThreadSafe>();
+	CurrChunk->FirstNewIdIdx = Utf8Ids.Num();
+	CurrChunk->Timestamps.Reserve(NumFrames);
+	CurrChunk->FrameOffsets.Reserve(NumFrames + 1);
+	CurrChunk->FrameOffsets.Add(0);
+}
+
+
+/* Episode Stream */
+// Ctor
+FSLMongoEpisodeStream::FSLMongoEpisodeStream(const FSLMongoEpisodeStreamParams& InParams) : Params(InParams)
+{
+	bCancelled = false;
+	bReadDone = false;
+	bFailed = false;
+}
+
+// Dtor, cancels and waits for the worker
+FSLMongoEpisodeStream::~FSLMongoEpisodeStream()
+{
+	if (StreamTask)
+	{
+		bCancelled = true;
+		StreamTask->EnsureCompletion();
+		delete StreamTask;
+		StreamTask = nullptr;
+	}
+}
+
+// Get the next chunk in order (false if none is available yet)
+bool FSLMongoEpisodeStream::DequeueChunk(TSharedPtr<FSLMongoEpisodeChunk, ESPMode::ThreadSafe>& OutChunk)
+{
+	if (Chunks.Dequeue(OutChunk))
+	{
+		// The latency is published with the chunk, it is only written and read by the consumer
+		if (FirstChunkLatency < 0.0)
+		{
+			FirstChunkLatency = OutChunk->PublishLatency;
+		}
+		return true;
+	}
+	return false;
+}
+
+#if SL_WITH_LIBMONGO_C
+// Connect and start reading the episode in the background
+bool FSLMongoEpisodeStream::Start(const mongoc_uri_t* in_uri, const char* db_name, const char* coll_name,
+	const TMap<int32, FSLMongoCompactPoseLayout>& InCompactLayouts)
+{
+	if (StreamTask)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Stream is already started.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	StreamTask = new FAsyncTask<FSLMongoEpisodeStreamTask>();
+	if (!StreamTask->GetTask().Init(in_uri, db_name, coll_name, InCompactLayouts, Params, this))
+	{
+		delete StreamTask;
+		StreamTask = nullptr;
+		return false;
+	}
+
+	TaskId = UTF8_TO_TCHAR(db_name);
+	StartTime = FPlatformTime::Seconds();
+	StreamTask->StartBackgroundTask();
+	return true;
+}
+#endif //SL_WITH_LIBMONGO_C
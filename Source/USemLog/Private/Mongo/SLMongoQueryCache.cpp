@@ -0,0 +1,138 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Mongo/SLMongoQueryCache.h"
+
+// Set the memory budget in bytes (evicts the least recently used results if needed)
+void FSLMongoQueryCache::SetMaxSize(SIZE_T InMaxSize)
+{
+	FScopeLock Lock(&CacheCS);
+	MaxSize = InMaxSize;
+	EvictToSize(MaxSize);
+}
+
+// Remove all the results (the counters are kept)
+void FSLMongoQueryCache::Empty()
+{
+	FScopeLock Lock(&CacheCS);
+	for (auto& KeyEntryPair : Entries)
+	{
+		delete KeyEntryPair.Value;
+	}
+	Entries.Empty();
+	Head = nullptr;
+	Tail = nullptr;
+	CurrSize = 0;
+}
+
+// Number of cached results
+int32 FSLMongoQueryCache::Num() const
+{
+	FScopeLock Lock(&CacheCS);
+	return Entries.Num();
+}
+
+// Memory used by the cached results in bytes
+SIZE_T FSLMongoQueryCache::GetSize() const
+{
+	FScopeLock Lock(&CacheCS);
+	return CurrSize;
+}
+
+// Log the hit, miss and eviction counters and the memory usage
+void FSLMongoQueryCache::LogStats() const
+{
+	FScopeLock Lock(&CacheCS);
+	const uint64 NumQueries = NumHits + NumMisses;
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Query cache: hits=%llu (%.1f%%), misses=%llu, evictions=%llu, results=%d, memory=%.2f/%.2f MB;"),
+		*FString(__FUNCTION__), __LINE__, NumHits, NumQueries > 0 ? 100.0 * NumHits / NumQueries : 0.0, NumMisses, NumEvictions,
+		Entries.Num(), CurrSize / (1024.f * 1024.f), MaxSize / (1024.f * 1024.f));
+}
+
+// Size of the skeletal trajectory
+SIZE_T FSLMongoQueryCache::GetResultSize(const TArray<TPair<FTransform, TMap<int32, FTransform>>>& Value)
+{
+	SIZE_T Size = sizeof(Value) + Value.GetAllocatedSize();
+	for (const auto& SkeletalPose : Value)
+	{
+		Size += SkeletalPose.Value.GetAllocatedSize();
+	}
+	return Size;
+}
+
+// Size of the trajectories
+SIZE_T FSLMongoQueryCache::GetResultSize(const FSLMongoTrajectories& Value)
+{
+	SIZE_T Size = sizeof(Value) + Value.Ids.GetAllocatedSize() + Value.Offsets.GetAllocatedSize() + Value.Timestamps.GetAllocatedSize()
+		+ Value.Locations.GetAllocatedSize() + Value.Rotations.GetAllocatedSize();
+	for (const auto& Id : Value.Ids)
+	{
+		Size += Id.GetAllocatedSize();
+	}
+	return Size;
+}
+
+// Add the entry as the most recently used
+void FSLMongoQueryCache::LinkHead(FEntry* Entry)
+{
+	Entry->Prev = nullptr;
+	Entry->Next = Head;
+	if (Head)
+	{
+		Head->Prev = Entry;
+	}
+	Head = Entry;
+	if (!Tail)
+	{
+		Tail = Entry;
+	}
+}
+
+// Remove the entry from the recently used order
+void FSLMongoQueryCache::Unlink(FEntry* Entry)
+{
+	if (Entry->Prev)
+	{
+		Entry->Prev->Next = Entry->Next;
+	}
+	else
+	{
+		Head = Entry->Next;
+	}
+	if (Entry->Next)
+	{
+		Entry->Next->Prev = Entry->Prev;
+	}
+	else
+	{
+		Tail = Entry->Prev;
+	}
+	Entry->Prev = nullptr;
+	Entry->Next = nullptr;
+}
+
+// Remove the result with the given key (if cached)
+void FSLMongoQueryCache::Remove(const FString& Key)
+{
+	FEntry* Entry = nullptr;
+	if (Entries.RemoveAndCopyValue(Key, Entry))
+	{
+		Unlink(Entry);
+		CurrSize -= Entry->Size;
+		delete Entry;
+	}
+}
+
+// Evict the least recently used results until the memory usage is within the size
+void FSLMongoQueryCache::EvictToSize(SIZE_T Size)
+{
+	while (CurrSize > Size && Tail)
+	{
+		FEntry* Entry = Tail;
+		Unlink(Entry);
+		Entries.Remove(Entry->Key);
+		CurrSize -= Entry->Size;
+		delete Entry;
+		NumEvictions++;
+	}
+}
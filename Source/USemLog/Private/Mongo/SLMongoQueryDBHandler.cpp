@@ -2,6 +2,7 @@
 // Author: Andrei Haidu (http://haidu.eu)
 
 #include "Mongo/SLMongoQueryDBHandler.h"
+#include "Mongo/SLMongoEpisodeStream.h"
 
 #if SL_WITH_ROS_CONVERSIONS
 #include "Conversions.h"
@@ -13,6 +14,16 @@ FSLMongoQueryDBHandler::FSLMongoQueryDBHandler()
 	bConnected = false;
 	bDatabaseSet = false;
 	bCollectionSet = false;
+	NumQueryErrors = 0;
+
+#if SL_WITH_LIBMONGO_C
+	uri = nullptr;
+	client = nullptr;
+	client_pool = nullptr;
+	database = nullptr;
+	collection = nullptr;
+	meta_collection = nullptr;
+#endif // SL_WITH_LIBMONGO_C
 }
 
 // Dtor
@@ -88,6 +99,42 @@ bool FSLMongoQueryDBHandler::Connect(const FString& ServerIp, uint16 ServerPort)
 #endif // SL_WITH_LIBMONGO_C
 }
 
+#if SL_WITH_LIBMONGO_C
+// Connect with a client from the pool (the client is pushed back to the pool on disconnect)
+bool FSLMongoQueryDBHandler::Connect(mongoc_client_pool_t* InClientPool)
+{
+	if (bConnected)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Handler is already connected to the server.."), *FString(__func__), __LINE__);
+		return true;
+	}
+
+	// Blocks until a client is available
+	client = mongoc_client_pool_pop(InClientPool);
+	if (!client)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not get a client from the pool.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+	client_pool = InClientPool;
+
+	// Check server. Ping the "admin" database
+	bson_error_t error;
+	bson_t* server_ping_cmd = BCON_NEW("ping", BCON_INT32(1));
+	const bool bPinged = mongoc_client_command_simple(client, "admin", server_ping_cmd, NULL, NULL, &error);
+	bson_destroy(server_ping_cmd);
+	if (!bPinged)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Check server err.: %s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+		return false;
+	}
+
+	bConnected = true;
+	return true;
+}
+#endif // SL_WITH_LIBMONGO_C
+
 // Set database
 bool FSLMongoQueryDBHandler::SetDatabase(const FString& InDBName)
 {
@@ -139,6 +186,25 @@ bool FSLMongoQueryDBHandler::SetDatabase(const FString& InDBName)
 		}
 	}
 
+	// Release the previous database, its collections are not valid anymore
+	if (meta_collection)
+	{
+		mongoc_collection_destroy(meta_collection);
+		meta_collection = nullptr;
+	}
+	if (collection)
+	{
+		mongoc_collection_destroy(collection);
+		collection = nullptr;
+	}
+	if (database)
+	{
+		mongoc_database_destroy(database);
+		database = nullptr;
+	}
+	bCollectionSet = false;
+	CompactLayouts.Empty();
+
 	// Set the database
 	database = mongoc_client_get_database(client, TCHAR_TO_UTF8(*InDBName));
 
@@ -185,9 +251,21 @@ bool FSLMongoQueryDBHandler::SetCollection(const FString& InCollName)
 		}
 	}
 
-	// Set collection
+	// Set collection (release the previous one)
+	if (collection)
+	{
+		mongoc_collection_destroy(collection);
+	}
 	collection = mongoc_database_get_collection(database, TCHAR_TO_UTF8(*InCollName));
 	bCollectionSet = true;
+
+	// Check if the collection uses the compact schema
+	const int32 NumLayouts = LoadCompactLayouts(InCollName);
+	if (NumLayouts > 0)
+	{
+		UE_LOG(LogTemp, Log, TEXT("%s::%d Collection %s uses the compact schema (%d pose layouts).."),
+			*FString(__func__), __LINE__, *InCollName, NumLayouts);
+	}
 	return true;
 #else
 	UE_LOG(LogTemp, Error, TEXT("%s::%d Mongo module is missing.."), *FString(__func__), __LINE__);
@@ -202,28 +280,45 @@ void FSLMongoQueryDBHandler::Disconnect()
 	bConnected = false;
 	bDatabaseSet = false;
 	bCollectionSet = false;
+	CompactLayouts.Empty();
 
 #if SL_WITH_LIBMONGO_C
 	// Release handles and clean up libmongoc
 	if (meta_collection)
 	{
 		mongoc_collection_destroy(meta_collection);
+		meta_collection = nullptr;
 	}
 	if (collection)
 	{
 		mongoc_collection_destroy(collection);
+		collection = nullptr;
 	}
 	if (database)
 	{
 		mongoc_database_destroy(database);
+		database = nullptr;
 	}
 	if (uri)
 	{
 		mongoc_uri_destroy(uri);
+		uri = nullptr;
+	}
+	if (client_pool)
+	{
+		// The pool owner cleans up libmongoc
+		if (client)
+		{
+			mongoc_client_pool_push(client_pool, client);
+			client = nullptr;
+		}
+		client_pool = nullptr;
+		return;
 	}
 	if (client)
 	{
 		mongoc_client_destroy(client);
+		client = nullptr;
 	}
 	mongoc_cleanup();
 #endif //SL_WITH_LIBMONGO_C
@@ -237,10 +332,16 @@ FTransform FSLMongoQueryDBHandler::GetIndividualPoseAt(const FString& Id, float
 	if (!IsReady())
 	{
 		UE_LOG(LogTemp, Warning, TEXT("%s::%d DB handler is not ready, make sure the server, database, and collection is set.."), *FString(__FUNCTION__), __LINE__);
+		NumQueryErrors++;
 		return Pose;
 	}
 
 #if SL_WITH_LIBMONGO_C	
+	if (IsCompactSchema())
+	{
+		return GetCompactIndividualPoseAt(Id, Ts);
+	}
+
 	double ExecBegin = FPlatformTime::Seconds();
 
 	bson_error_t error;
@@ -302,6 +403,7 @@ FTransform FSLMongoQueryDBHandler::GetIndividualPoseAt(const FString& Id, float
 	{
 		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
 			*FString(__func__), __LINE__, *FString(error.message));
+		NumQueryErrors++;
 	}
 	double CursorReadDuration = FPlatformTime::Seconds() - ExecBegin - QueryDuration;
 
@@ -320,10 +422,16 @@ TArray<FTransform> FSLMongoQueryDBHandler::GetIndividualTrajectory(const FString
 	if (!IsReady())
 	{
 		UE_LOG(LogTemp, Log, TEXT("%s::%d DB handler is not ready, make sure the server, database, and collection is set.."), *FString(__FUNCTION__), __LINE__);
+		NumQueryErrors++;
 		return Trajectory;
 	}
 
 #if SL_WITH_LIBMONGO_C
+	if (IsCompactSchema())
+	{
+		return GetCompactIndividualTrajectory(Id, StartTs, EndTs, DeltaT);
+	}
+
 	double ExecBegin = FPlatformTime::Seconds();
 
 	bson_error_t error;
@@ -402,6 +510,7 @@ TArray<FTransform> FSLMongoQueryDBHandler::GetIndividualTrajectory(const FString
 	{
 		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
 			*FString(__func__), __LINE__, *FString(error.message));
+		NumQueryErrors++;
 	}
 	double CursorReadDuration = FPlatformTime::Seconds() - ExecBegin - QueryDuration;
 
@@ -417,6 +526,231 @@ TArray<FTransform> FSLMongoQueryDBHandler::GetIndividualTrajectory(const FString
 	return Trajectory;
 }
 
+// Get the poses of multiple individuals between the given timestamps with a single query
+FSLMongoTrajectories FSLMongoQueryDBHandler::GetIndividualTrajectories(const TArray<FString>& Ids, float StartTs, float EndTs, float DeltaT) const
+{
+	FSLMongoTrajectories Trajectories;
+	if (!IsReady())
+	{
+		UE_LOG(LogTemp, Log, TEXT("%s::%d DB handler is not ready, make sure the server, database, and collection is set.."), *FString(__FUNCTION__), __LINE__);
+		NumQueryErrors++;
+		return Trajectories;
+	}
+
+#if SL_WITH_LIBMONGO_C
+	if (IsCompactSchema())
+	{
+		return GetCompactIndividualTrajectories(Ids, StartTs, EndTs, DeltaT);
+	}
+
+	double ExecBegin = FPlatformTime::Seconds();
+
+	bson_error_t error;
+	const bson_t *doc;
+	mongoc_cursor_t *cursor;
+	bson_t *pipeline;
+
+	// Array of the searched ids
+	bson_t ids_arr;
+	bson_init(&ids_arr);
+	TMap<FString, int32> IdToTrajIdx;
+	for (const FString& Id : Ids)
+	{
+		if (!IdToTrajIdx.Contains(Id))
+		{
+			char idx_str[16];
+			const char* idx_key;
+			bson_uint32_to_string(IdToTrajIdx.Num(), &idx_key, idx_str, sizeof idx_str);
+			BSON_APPEND_UTF8(&ids_arr, idx_key, TCHAR_TO_UTF8(*Id));
+			IdToTrajIdx.Add(Id, IdToTrajIdx.Num());
+			Trajectories.Ids.Add(Id);
+		}
+	}
+
+	if (DeltaT > 0.f)
+	{
+		// Keep the first sample of every individual in every DeltaT bucket
+		pipeline = BCON_NEW("pipeline", "[",
+			"{",
+				"$match",
+				"{",
+					"timestamp",
+					"{",
+						"$gte", BCON_DOUBLE(StartTs),
+						"$lte", BCON_DOUBLE(EndTs),
+					"}",
+					"individuals.id", "{", "$in", BCON_ARRAY(&ids_arr), "}",
+				"}",
+			"}",
+			"{",
+				"$sort",
+				"{",
+					"timestamp", BCON_INT32(1),								// no time penalty if the collection is indexed
+				"}",
+			"}",
+			"{",
+				"$project",
+				"{",
+					"_id", BCON_INT32(0),
+					"timestamp", BCON_INT32(1),
+					"individuals",											// drop the other individuals before unwinding
+					"{",
+						"$filter",
+						"{",
+							"input", BCON_UTF8("$individuals"),
+							"as", BCON_UTF8("ind"),
+							"cond", "{", "$in", "[", BCON_UTF8("$$ind.id"), BCON_ARRAY(&ids_arr), "]", "}",
+						"}",
+					"}",
+				"}",
+			"}",
+			"{",
+				"$unwind", BCON_UTF8("$individuals"),
+			"}",
+			"{",
+				"$group",
+				"{",
+					"_id",
+					"{",
+						"id", BCON_UTF8("$individuals.id"),
+						"bucket",
+						"{",
+							"$floor",
+							"{",
+								"$divide", "[", "{", "$subtract", "[", BCON_UTF8("$timestamp"), BCON_DOUBLE(StartTs), "]", "}", BCON_DOUBLE(DeltaT), "]",
+							"}",
+						"}",
+					"}",
+					"timestamp", "{", "$first", BCON_UTF8("$timestamp"), "}",
+					"loc", "{", "$first", BCON_UTF8("$individuals.loc"), "}",
+					"quat", "{", "$first", BCON_UTF8("$individuals.quat"), "}",
+				"}",
+			"}",
+			"{",
+				"$sort",
+				"{",
+					"timestamp", BCON_INT32(1),
+				"}",
+			"}",
+			"{",
+				"$project",
+				"{",
+					"_id", BCON_INT32(0),
+					"id", BCON_UTF8("$_id.id"),
+					"timestamp", BCON_INT32(1),
+					"loc", BCON_INT32(1),
+					"quat", BCON_INT32(1),
+				"}",
+			"}",
+			"]");
+	}
+	else
+	{
+		pipeline = BCON_NEW("pipeline", "[",
+			"{",
+				"$match",
+				"{",
+					"timestamp",
+					"{",
+						"$gte", BCON_DOUBLE(StartTs),
+						"$lte", BCON_DOUBLE(EndTs),
+					"}",
+					"individuals.id", "{", "$in", BCON_ARRAY(&ids_arr), "}",
+				"}",
+			"}",
+			"{",
+				"$sort",
+				"{",
+					"timestamp", BCON_INT32(1),								// no time penalty if the collection is indexed
+				"}",
+			"}",
+			"{",
+				"$project",
+				"{",
+					"_id", BCON_INT32(0),
+					"timestamp", BCON_INT32(1),
+					"individuals",											// drop the other individuals before unwinding
+					"{",
+						"$filter",
+						"{",
+							"input", BCON_UTF8("$individuals"),
+							"as", BCON_UTF8("ind"),
+							"cond", "{", "$in", "[", BCON_UTF8("$$ind.id"), BCON_ARRAY(&ids_arr), "]", "}",
+						"}",
+					"}",
+				"}",
+			"}",
+			"{",
+				"$unwind", BCON_UTF8("$individuals"),
+			"}",
+			"{",
+				"$project",
+				"{",
+					"id", BCON_UTF8("$individuals.id"),
+					"timestamp", BCON_INT32(1),
+					"loc", BCON_UTF8("$individuals.loc"),
+					"quat", BCON_UTF8("$individuals.quat"),
+				"}",
+			"}",
+			"]");
+	}
+
+	// The bucket grouping might need the disk for large time windows
+	bson_t opts;
+	bson_init(&opts);
+	BSON_APPEND_BOOL(&opts, "allowDiskUse", true);
+	cursor = mongoc_collection_aggregate(
+		collection, MONGOC_QUERY_NONE, pipeline, &opts, NULL);
+	double QueryDuration = FPlatformTime::Seconds() - ExecBegin;
+
+	// Read cursor if no errors occured, the samples arrive sorted by time
+	TArray<TArray<TPair<float, FTransform>>> Samples;
+	Samples.SetNum(Trajectories.Ids.Num());
+	int32 NumSamples = 0;
+	if (!mongoc_cursor_error(cursor, &error))
+	{
+		bson_iter_t iter;
+		while (mongoc_cursor_next(cursor, &doc))
+		{
+			if (bson_iter_init(&iter, doc) && bson_iter_find(&iter, "id") && BSON_ITER_HOLDS_UTF8(&iter))
+			{
+				if (const int32* TrajIdx = IdToTrajIdx.Find(FString(UTF8_TO_TCHAR(bson_iter_utf8(&iter, NULL)))))
+				{
+					Samples[*TrajIdx].Emplace(GetTs(doc), GetPose(doc));
+					NumSamples++;
+				}
+			}
+		}
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+		NumQueryErrors++;
+	}
+	double CursorReadDuration = FPlatformTime::Seconds() - ExecBegin - QueryDuration;
+
+	// Same as the single trajectory query, individuals without samples in the interval keep their last pose before it
+	for (int32 TrajIdx = 0; TrajIdx < Samples.Num(); ++TrajIdx)
+	{
+		if (Samples[TrajIdx].Num() == 0)
+		{
+			Samples[TrajIdx].Emplace(StartTs, GetIndividualPoseAt(Trajectories.Ids[TrajIdx], StartTs));
+		}
+	}
+
+	FlattenTrajectories(Samples, Trajectories);
+
+	mongoc_cursor_destroy(cursor);
+	bson_destroy(pipeline);
+	bson_destroy(&opts);
+	bson_destroy(&ids_arr);
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Durations: query=[%f], cursor=[%f], total=[%f] seconds, Ids=[%d], Num=[%d]..;"),
+		*FString(__func__), __LINE__, QueryDuration, CursorReadDuration, FPlatformTime::Seconds() - ExecBegin, Trajectories.Num(), NumSamples);
+#endif
+	return Trajectories;
+}
+
 // Get skeletal individual pose
 TPair<FTransform, TMap<int32, FTransform>> FSLMongoQueryDBHandler::GetSkeletalIndividualPoseAt(const FString& Id, float Ts) const
 {
@@ -424,12 +758,25 @@ TPair<FTransform, TMap<int32, FTransform>> FSLMongoQueryDBHandler::GetSkeletalIn
 	if (!IsReady())
 	{
 		UE_LOG(LogTemp, Warning, TEXT("%s::%d DB handler is not ready, make sure the server, database, and collection is set.."), *FString(__FUNCTION__), __LINE__);
+		NumQueryErrors++;
 		return SkeletalPosePair;
 	}
 
 #if SL_WITH_LIBMONGO_C	
+	if (IsCompactSchema())
+	{
+		return GetCompactSkeletalIndividualPoseAt(Id, Ts);
+	}
+
 	double ExecBegin = FPlatformTime::Seconds();
 
+	// Only the frames since the last keyframe are needed to collect all the bones
+	float KeyframeTs;
+	if (!FindSkeletalKeyframeTs(Id, Ts, KeyframeTs))
+	{
+		return SkeletalPosePair;
+	}
+
 	bson_error_t error;
 	const bson_t *doc;
 	mongoc_cursor_t *cursor;
@@ -439,7 +786,7 @@ TPair<FTransform, TMap<int32, FTransform>> FSLMongoQueryDBHandler::GetSkeletalIn
 		"{",
 			"$match",
 			"{",
-				"timestamp", "{", "$lte", BCON_DOUBLE(Ts), "}",
+				"timestamp", "{", "$gte", BCON_DOUBLE(KeyframeTs), "$lte", BCON_DOUBLE(Ts), "}",
 				"skel_individuals.id", BCON_UTF8(TCHAR_TO_ANSI(*Id)),		// yields faster results if we match against the id from the start
 			"}",
 		"}",
@@ -449,9 +796,6 @@ TPair<FTransform, TMap<int32, FTransform>> FSLMongoQueryDBHandler::GetSkeletalIn
 				"timestamp", BCON_INT32(-1),
 			"}",
 		"}",
-		"{",
-			"$limit", BCON_INT32(1),
-		"}",
 		"{",
 			"$unwind", BCON_UTF8("$skel_individuals"),
 		"}",
@@ -470,6 +814,7 @@ TPair<FTransform, TMap<int32, FTransform>> FSLMongoQueryDBHandler::GetSkeletalIn
 				"loc", BCON_UTF8("$skel_individuals.loc"),			// actor loc
 				"quat", BCON_UTF8("$skel_individuals.quat"),		// actor quat
 				"pose", BCON_UTF8("$skel_individuals.pose"),
+				"keyframe", BCON_INT32(1),
 			"}",
 		"}",
 		"]");
@@ -482,28 +827,14 @@ TPair<FTransform, TMap<int32, FTransform>> FSLMongoQueryDBHandler::GetSkeletalIn
 	// Read cursor if no errors occured
 	if (!mongoc_cursor_error(cursor, &error))
 	{
+		// Sparse frames only hold the moved bones, collect them backwards until a frame with all the bones
 		if (mongoc_cursor_next(cursor, &doc))
 		{
 			SkeletalPosePair.Key = GetPose(doc);
-
-			// Get bones data
-			bson_iter_t bones;
-			if (bson_iter_init(&bones, doc) && bson_iter_find(&bones, "bones"))
+			GetBonePoses(doc, false, SkeletalPosePair.Value);
+			while (!IsKeyframe(doc) && mongoc_cursor_next(cursor, &doc))
 			{
-				bson_iter_t bone;
-				if (bson_iter_recurse(&bones, &bone))
-				{
-					int32 BoneIndex;
-					bson_iter_t value;
-					while (bson_iter_next(&bone))
-					{
-						if (bson_iter_recurse(&bone, &value) && bson_iter_find(&value, "idx"))
-						{
-							BoneIndex = bson_iter_int32(&value);							
-						}
-						SkeletalPosePair.Value.Emplace(BoneIndex, GetPose(&bone));
-					}
-				}
+				GetBonePoses(doc, false, SkeletalPosePair.Value);
 			}
 		}
 	}
@@ -511,6 +842,7 @@ TPair<FTransform, TMap<int32, FTransform>> FSLMongoQueryDBHandler::GetSkeletalIn
 	{
 		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
 			*FString(__func__), __LINE__, *FString(error.message));
+		NumQueryErrors++;
 	}
 	double CursorReadDuration = FPlatformTime::Seconds() - ExecBegin - QueryDuration;
 
@@ -529,10 +861,19 @@ TArray<TPair<FTransform, TMap<int32, FTransform>>> FSLMongoQueryDBHandler::GetSk
 	if (!IsReady())
 	{
 		UE_LOG(LogTemp, Log, TEXT("%s::%d DB handler is not ready, make sure the server, database, and collection is set.."), *FString(__FUNCTION__), __LINE__);
+		NumQueryErrors++;
 		return SkeletalTrajectoryPair;
 	}
 
 #if SL_WITH_LIBMONGO_C
+	if (IsCompactSchema())
+	{
+		return GetCompactSkeletalIndividualTrajectory(Id, StartTs, EndTs, DeltaT);
+	}
+
+	// Sparse frames only hold the moved bones, they are applied on top of the pose at the start time
+	TPair<FTransform, TMap<int32, FTransform>> CurrSkeletalPose = GetSkeletalIndividualPoseAt(Id, StartTs);
+
 	double ExecBegin = FPlatformTime::Seconds();
 
 	bson_error_t error;
@@ -593,32 +934,13 @@ TArray<TPair<FTransform, TMap<int32, FTransform>>> FSLMongoQueryDBHandler::GetSk
 			double PrevTs = -BIG_NUMBER;
 			while (mongoc_cursor_next(cursor, &doc))
 			{
+				// Skipped frames still update the bones they hold
+				CurrSkeletalPose.Key = GetPose(doc);
+				GetBonePoses(doc, true, CurrSkeletalPose.Value);
 				double CurrTs = GetTs(doc);
 				if (CurrTs - PrevTs > DeltaT)
 				{
-					TPair<FTransform, TMap<int32, FTransform>> SkeletalPosePair;
-					SkeletalPosePair.Key = GetPose(doc);
-
-					// Get bones data
-					bson_iter_t bones;
-					if (bson_iter_init(&bones, doc) && bson_iter_find(&bones, "bones"))
-					{
-						bson_iter_t bone;
-						if (bson_iter_recurse(&bones, &bone))
-						{
-							int32 BoneIndex;
-							bson_iter_t value;
-							while (bson_iter_next(&bone))
-							{
-								if (bson_iter_recurse(&bone, &value) && bson_iter_find(&value, "idx"))
-								{
-									BoneIndex = bson_iter_int32(&value);
-								}
-								SkeletalPosePair.Value.Emplace(BoneIndex, GetPose(&bone));
-							}
-						}
-					}
-					SkeletalTrajectoryPair.Add(SkeletalPosePair);
+					SkeletalTrajectoryPair.Add(CurrSkeletalPose);
 					PrevTs = CurrTs;
 				}
 			}
@@ -627,29 +949,9 @@ TArray<TPair<FTransform, TMap<int32, FTransform>>> FSLMongoQueryDBHandler::GetSk
 		{
 			while (mongoc_cursor_next(cursor, &doc))
 			{
-				TPair<FTransform, TMap<int32, FTransform>> SkeletalPosePair;
-				SkeletalPosePair.Key = GetPose(doc);
-
-				// Get bones data
-				bson_iter_t bones;
-				if (bson_iter_init(&bones, doc) && bson_iter_find(&bones, "bones"))
-				{
-					bson_iter_t bone;
-					if (bson_iter_recurse(&bones, &bone))
-					{
-						int32 BoneIndex;
-						bson_iter_t value;
-						while (bson_iter_next(&bone))
-						{
-							if (bson_iter_recurse(&bone, &value) && bson_iter_find(&value, "idx"))
-							{
-								BoneIndex = bson_iter_int32(&value);
-							}
-							SkeletalPosePair.Value.Emplace(BoneIndex, GetPose(&bone));
-						}
-					}
-				}
-				SkeletalTrajectoryPair.Add(SkeletalPosePair);
+				CurrSkeletalPose.Key = GetPose(doc);
+				GetBonePoses(doc, true, CurrSkeletalPose.Value);
+				SkeletalTrajectoryPair.Add(CurrSkeletalPose);
 			}
 		}
 	}
@@ -657,6 +959,7 @@ TArray<TPair<FTransform, TMap<int32, FTransform>>> FSLMongoQueryDBHandler::GetSk
 	{
 		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
 			*FString(__func__), __LINE__, *FString(error.message));
+		NumQueryErrors++;
 	}
 	double CursorReadDuration = FPlatformTime::Seconds() - ExecBegin - QueryDuration;
 
@@ -679,10 +982,16 @@ TArray<TPair<float, TMap<FString, FTransform>>> FSLMongoQueryDBHandler::GetEpiso
 	if (!IsReady())
 	{
 		UE_LOG(LogTemp, Warning, TEXT("%s::%d DB handler is not ready, make sure the server, database, and collection is set.."), *FString(__FUNCTION__), __LINE__);
+		NumQueryErrors++;
 		return EpisodeData;
 	}	
 
 #if SL_WITH_LIBMONGO_C
+	if (IsCompactSchema())
+	{
+		return GetCompactEpisodeData();
+	}
+
 	double ExecBegin = FPlatformTime::Seconds();
 
 	bson_error_t error;
@@ -765,6 +1074,7 @@ TArray<TPair<float, TMap<FString, FTransform>>> FSLMongoQueryDBHandler::GetEpiso
 	{
 		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
 			*FString(__func__), __LINE__, *FString(error.message));
+		NumQueryErrors++;
 	}
 	double CursorReadDuration = FPlatformTime::Seconds() - ExecBegin - QueryDuration;
 
@@ -776,11 +1086,25 @@ TArray<TPair<float, TMap<FString, FTransform>>> FSLMongoQueryDBHandler::GetEpiso
 	return EpisodeData;
 }
 
-// Get the whole episode data in an async thread
-TArray<TPair<float, TMap<FString, FTransform>>> FSLMongoQueryDBHandler::GetEpisodeDataAsync() const
+// Stream the episode frames in chunks from a worker thread (nullptr if the stream could not be started)
+TSharedPtr<FSLMongoEpisodeStream, ESPMode::ThreadSafe> FSLMongoQueryDBHandler::StartEpisodeStream(const FSLMongoEpisodeStreamParams& Params) const
 {
-	// TODO
-	return TArray<TPair<float, TMap<FString, FTransform>>>();
+	if (!IsReady())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d DB handler is not ready, make sure the server, database, and collection is set.."), *FString(__FUNCTION__), __LINE__);
+		NumQueryErrors++;
+		return nullptr;
+	}
+
+#if SL_WITH_LIBMONGO_C
+	TSharedPtr<FSLMongoEpisodeStream, ESPMode::ThreadSafe> Stream = MakeShared<FSLMongoEpisodeStream, ESPMode::ThreadSafe>(Params);
+	if (Stream->Start(mongoc_client_get_uri(client), mongoc_database_get_name(database), mongoc_collection_get_name(collection), CompactLayouts))
+	{
+		return Stream;
+	}
+	UE_LOG(LogTemp, Error, TEXT("%s::%d Could not start the episode stream.."), *FString(__FUNCTION__), __LINE__);
+#endif // SL_WITH_LIBMONGO_C
+	return nullptr;
 }
 
 // Get the episode data at the given timestamp (frame)
@@ -789,6 +1113,89 @@ TMap<FString, FTransform> FSLMongoQueryDBHandler::GetFrameData(float Ts)
 	return TMap<FString, FTransform>();
 }
 
+// Get a hash of the collection content computed on the server (empty if it could not be computed), used to detect stale local episode files
+FString FSLMongoQueryDBHandler::GetContentHash() const
+{
+	FString ContentHash;
+	if (!IsReady())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d DB handler is not ready, make sure the server, database, and collection is set.."), *FString(__FUNCTION__), __LINE__);
+		NumQueryErrors++;
+		return ContentHash;
+	}
+
+#if SL_WITH_LIBMONGO_C
+	double ExecBegin = FPlatformTime::Seconds();
+	const char* coll_name = mongoc_collection_get_name(collection);
+	bson_error_t error;
+	bson_t reply;
+
+	// Only the md5 of the collection is transferred
+	bson_t* cmd = BCON_NEW("dbHash", BCON_INT32(1), "collections", "[", BCON_UTF8(coll_name), "]");
+	if (mongoc_database_command_simple(database, cmd, NULL, &reply, &error))
+	{
+		bson_iter_t iter;
+		bson_iter_t colls_iter;
+		if (bson_iter_init_find(&iter, &reply, "collections")
+			&& bson_iter_recurse(&iter, &colls_iter)
+			&& bson_iter_find(&colls_iter, coll_name)
+			&& BSON_ITER_HOLDS_UTF8(&colls_iter))
+		{
+			ContentHash = FString(UTF8_TO_TCHAR(bson_iter_utf8(&colls_iter, NULL)));
+		}
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d dbHash failed, using the collection stats instead; Err.:%s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+	}
+	bson_destroy(&reply);
+	bson_destroy(cmd);
+
+	// The dbHash command is not available on every deployment (e.g. sharded clusters, missing privileges)
+	if (ContentHash.IsEmpty())
+	{
+		cmd = BCON_NEW("collStats", BCON_UTF8(coll_name));
+		if (mongoc_database_command_simple(database, cmd, NULL, &reply, &error))
+		{
+			bson_iter_t iter;
+			int64 NumDocs = -1;
+			int64 Size = -1;
+			if (bson_iter_init_find(&iter, &reply, "count"))
+			{
+				NumDocs = bson_iter_as_int64(&iter);
+			}
+			if (bson_iter_init_find(&iter, &reply, "size"))
+			{
+				Size = bson_iter_as_int64(&iter);
+			}
+			if (NumDocs >= 0 && Size >= 0)
+			{
+				ContentHash = FString::Printf(TEXT("stats_%lld_%lld"), NumDocs, Size);
+			}
+		}
+		else
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
+				*FString(__func__), __LINE__, *FString(error.message));
+			NumQueryErrors++;
+		}
+		bson_destroy(&reply);
+		bson_destroy(cmd);
+	}
+
+	// The compact frames are only readable with their layouts
+	if (!ContentHash.IsEmpty() && IsCompactSchema())
+	{
+		ContentHash.Append(FString::Printf(TEXT("_l%d"), CompactLayouts.Num()));
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Duration: hash(%s)=[%f] seconds..;"),
+		*FString(__func__), __LINE__, *ContentHash, FPlatformTime::Seconds() - ExecBegin);
+#endif // SL_WITH_LIBMONGO_C
+	return ContentHash;
+}
+
 /* Helpers */
 #if SL_WITH_LIBMONGO_C
 // Get the pose data from document
@@ -866,7 +1273,7 @@ FTransform FSLMongoQueryDBHandler::GetPose(const bson_t* doc) const
 }
 
 // Get the pose data from iterator
-FTransform FSLMongoQueryDBHandler::GetPose(const bson_iter_t* iter) const
+FTransform FSLMongoQueryDBHandler::GetPose(const bson_iter_t* iter)
 {
 	FVector Loc;
 	FQuat Quat;
@@ -939,14 +1346,679 @@ FTransform FSLMongoQueryDBHandler::GetPose(const bson_iter_t* iter) const
 #endif // SL_WITH_ROS_CONVERSIONS	
 }
 
-// Get the timestamp value from document (used for trajectory delta time comparison)
-double FSLMongoQueryDBHandler::GetTs(const bson_t* doc) const
+// Get the bone poses from the document (existing entries are kept unless overwrite is set)
+void FSLMongoQueryDBHandler::GetBonePoses(const bson_t* doc, bool bOverwrite, TMap<int32, FTransform>& OutBonePoses) const
 {
-	bson_iter_t iter;
-	if (bson_iter_init(&iter, doc) && bson_iter_find(&iter, "timestamp"))
+	bson_iter_t bones;
+	bson_iter_t bone;
+	if (bson_iter_init(&bones, doc) && bson_iter_find(&bones, "bones") && bson_iter_recurse(&bones, &bone))
 	{
-		return bson_iter_double(&iter);
+		bson_iter_t value;
+		while (bson_iter_next(&bone))
+		{
+			if (bson_iter_recurse(&bone, &value) && bson_iter_find(&value, "idx"))
+			{
+				const int32 BoneIndex = bson_iter_int32(&value);
+				if (bOverwrite || !OutBonePoses.Contains(BoneIndex))
+				{
+					OutBonePoses.Emplace(BoneIndex, GetPose(&bone));
+				}
+			}
+		}
+	}
+}
+
+// Check if the document is a full keyframe (documents without the flag are treated as keyframes)
+bool FSLMongoQueryDBHandler::IsKeyframe(const bson_t* doc) const
+{
+	bson_iter_t iter;
+	if (bson_iter_init(&iter, doc) && bson_iter_find(&iter, "keyframe"))
+	{
+		return bson_iter_as_bool(&iter);
+	}
+	return true;
+}
+
+// Get the timestamp of the last keyframe at or before the given time holding the skeletal individual (false if there is none)
+bool FSLMongoQueryDBHandler::FindSkeletalKeyframeTs(const FString& Id, float Ts, float& OutKeyframeTs) const
+{
+	// Documents without the flag are keyframes as well
+	bson_t* filter = BCON_NEW(
+		"timestamp", "{", "$lte", BCON_DOUBLE(Ts), "}",
+		"skel_individuals.id", BCON_UTF8(TCHAR_TO_UTF8(*Id)),
+		"keyframe", "{", "$ne", BCON_BOOL(false), "}");
+	bson_t* opts = BCON_NEW(
+		"sort", "{", "timestamp", BCON_INT32(-1), "}",
+		"limit", BCON_INT64(1),
+		"projection", "{", "_id", BCON_INT32(0), "timestamp", BCON_INT32(1), "}");
+
+	bson_error_t error;
+	const bson_t* doc;
+	bool bFound = false;
+	mongoc_cursor_t* cursor = mongoc_collection_find_with_opts(collection, filter, opts, NULL);
+	if (mongoc_cursor_next(cursor, &doc))
+	{
+		OutKeyframeTs = GetTs(doc);
+		bFound = true;
+	}
+
+	if (mongoc_cursor_error(cursor, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+		NumQueryErrors++;
+	}
+
+	mongoc_cursor_destroy(cursor);
+	bson_destroy(filter);
+	bson_destroy(opts);
+	return bFound;
+}
+
+// Get the timestamp value from document (used for trajectory delta time comparison)
+double FSLMongoQueryDBHandler::GetTs(const bson_t* doc) const
+{
+	bson_iter_t iter;
+	if (bson_iter_init(&iter, doc) && bson_iter_find(&iter, "timestamp"))
+	{
+		return bson_iter_double(&iter);
 	}
 	return -1.f;
 }
-#endif // SL_WITH_LIBMONGO_C
\ No newline at end of file
+
+// Move the per individual samples into the flat trajectory arrays
+void FSLMongoQueryDBHandler::FlattenTrajectories(TArray<TArray<TPair<float, FTransform>>>& InSamples, FSLMongoTrajectories& OutTrajectories)
+{
+	int32 NumSamples = 0;
+	for (const auto& IndividualSamples : InSamples)
+	{
+		NumSamples += IndividualSamples.Num();
+	}
+
+	OutTrajectories.Offsets.Reset(InSamples.Num() + 1);
+	OutTrajectories.Timestamps.Reset(NumSamples);
+	OutTrajectories.Locations.Reset(NumSamples);
+	OutTrajectories.Rotations.Reset(NumSamples);
+	OutTrajectories.Offsets.Add(0);
+	for (auto& IndividualSamples : InSamples)
+	{
+		for (const auto& Sample : IndividualSamples)
+		{
+			OutTrajectories.Timestamps.Add(Sample.Key);
+			OutTrajectories.Locations.Add(Sample.Value.GetLocation());
+			OutTrajectories.Rotations.Add(Sample.Value.GetRotation());
+		}
+		OutTrajectories.Offsets.Add(OutTrajectories.Timestamps.Num());
+		IndividualSamples.Empty();
+	}
+}
+
+/* Compact schema */
+// Load the pose layouts of the collection from the meta collection (none if the verbose schema is used)
+int32 FSLMongoQueryDBHandler::LoadCompactLayouts(const FString& InCollName)
+{
+	CompactLayouts.Empty();
+	if (!meta_collection)
+	{
+		return 0;
+	}
+
+	bson_error_t error;
+	const bson_t* doc;
+	bson_t* filter = BCON_NEW(
+		"type_id", BCON_UTF8(FSLWorldStateCompactSchema::LayoutTypeId),
+		"episode_id", BCON_UTF8(TCHAR_TO_UTF8(*InCollName)));
+	mongoc_cursor_t* cursor = mongoc_collection_find_with_opts(meta_collection, filter, NULL, NULL);
+
+	while (mongoc_cursor_next(cursor, &doc))
+	{
+		bson_iter_t iter;
+		if (!bson_iter_init_find(&iter, doc, "layout") || !BSON_ITER_HOLDS_INT32(&iter))
+		{
+			continue;
+		}
+		FSLMongoCompactPoseLayout& Layout = CompactLayouts.Add(bson_iter_int32(&iter));
+
+		// Ids in pose index order
+		bson_iter_t ids_iter;
+		if (bson_iter_init_find(&iter, doc, "ids") && bson_iter_recurse(&iter, &ids_iter))
+		{
+			while (bson_iter_next(&ids_iter))
+			{
+				const int32 PoseIdx = Layout.Ids.Add(FString(UTF8_TO_TCHAR(bson_iter_utf8(&ids_iter, NULL))));
+				Layout.IdToPoseIdx.Add(Layout.Ids[PoseIdx], PoseIdx);
+			}
+		}
+
+		// Skeletal individuals with their bones
+		bson_iter_t skel_iter;
+		if (bson_iter_init_find(&iter, doc, "skel") && bson_iter_recurse(&iter, &skel_iter))
+		{
+			while (bson_iter_next(&skel_iter))
+			{
+				bson_iter_t value;
+				bson_iter_t bones_iter;
+				if (!bson_iter_recurse(&skel_iter, &value) || !bson_iter_find(&value, "idx"))
+				{
+					continue;
+				}
+				TArray<TPair<int32, int32>>& Bones = Layout.SkeletalBones.Add(bson_iter_int32(&value));
+				if (bson_iter_recurse(&skel_iter, &value) && bson_iter_find(&value, "bones") && bson_iter_recurse(&value, &bones_iter))
+				{
+					while (bson_iter_next(&bones_iter))
+					{
+						bson_iter_t bone_value;
+						int32 BoneIdx = INDEX_NONE;
+						int32 BonePoseIdx = INDEX_NONE;
+						if (bson_iter_recurse(&bones_iter, &bone_value) && bson_iter_find(&bone_value, "idx"))
+						{
+							BoneIdx = bson_iter_int32(&bone_value);
+						}
+						if (bson_iter_recurse(&bones_iter, &bone_value) && bson_iter_find(&bone_value, "pose_idx"))
+						{
+							BonePoseIdx = bson_iter_int32(&bone_value);
+						}
+						Bones.Emplace(BoneIdx, BonePoseIdx);
+					}
+				}
+			}
+		}
+	}
+
+	if (mongoc_cursor_error(cursor, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+		NumQueryErrors++;
+	}
+
+	mongoc_cursor_destroy(cursor);
+	bson_destroy(filter);
+	return CompactLayouts.Num();
+}
+
+// Find the frames in the given time range sorted by their timestamp
+mongoc_cursor_t* FSLMongoQueryDBHandler::FindCompactFrames(float StartTs, float EndTs, bool bDescending) const
+{
+	bson_t* filter = BCON_NEW(
+		"timestamp",
+		"{",
+			"$gte", BCON_DOUBLE(StartTs),
+			"$lte", BCON_DOUBLE(EndTs),
+		"}");
+	bson_t* opts = BCON_NEW(
+		"sort", "{", "timestamp", BCON_INT32(bDescending ? -1 : 1), "}",	// no time penalty if the collection is indexed
+		"projection", "{", "_id", BCON_INT32(0), "}");
+
+	mongoc_cursor_t* cursor = mongoc_collection_find_with_opts(collection, filter, opts, NULL);
+
+	bson_destroy(filter);
+	bson_destroy(opts);
+	return cursor;
+}
+
+// Get the timestamp of the last full keyframe at or before the given time (false if there is none)
+bool FSLMongoQueryDBHandler::FindCompactKeyframeTs(float Ts, float& OutKeyframeTs) const
+{
+	// Full frames are stored without the pose indices
+	bson_t* filter = BCON_NEW(
+		"timestamp", "{", "$lte", BCON_DOUBLE(Ts), "}",
+		"idx", "{", "$exists", BCON_BOOL(false), "}");
+	bson_t* opts = BCON_NEW(
+		"sort", "{", "timestamp", BCON_INT32(-1), "}",
+		"limit", BCON_INT64(1),
+		"projection", "{", "_id", BCON_INT32(0), "timestamp", BCON_INT32(1), "}");
+
+	bson_error_t error;
+	const bson_t* doc;
+	bool bFound = false;
+	mongoc_cursor_t* cursor = mongoc_collection_find_with_opts(collection, filter, opts, NULL);
+	if (mongoc_cursor_next(cursor, &doc))
+	{
+		OutKeyframeTs = GetTs(doc);
+		bFound = true;
+	}
+
+	if (mongoc_cursor_error(cursor, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+		NumQueryErrors++;
+	}
+
+	mongoc_cursor_destroy(cursor);
+	bson_destroy(filter);
+	bson_destroy(opts);
+	return bFound;
+}
+
+// Check if any of the pose layouts contains the individual
+bool FSLMongoQueryDBHandler::HasCompactId(const FString& Id) const
+{
+	for (const auto& LayoutPair : CompactLayouts)
+	{
+		if (LayoutPair.Value.IdToPoseIdx.Contains(Id))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// Read the compact frame view from the document (false if the document is not a valid compact frame)
+bool FSLMongoQueryDBHandler::ReadCompactFrame(const bson_t* doc, FSLWorldStateCompactFrame& OutFrame) const
+{
+	return ReadCompactFrameView(doc, OutFrame) && CompactLayouts.Contains(OutFrame.Layout);
+}
+
+// Read the compact frame view from the document without checking its layout
+bool FSLMongoQueryDBHandler::ReadCompactFrameView(const bson_t* doc, FSLWorldStateCompactFrame& OutFrame)
+{
+	OutFrame = FSLWorldStateCompactFrame();
+	uint32_t PoseDataLen = 0;
+	uint32_t IndexDataLen = 0;
+
+	bson_iter_t iter;
+	if (!bson_iter_init(&iter, doc))
+	{
+		return false;
+	}
+
+	while (bson_iter_next(&iter))
+	{
+		const char* key = bson_iter_key(&iter);
+		if (FCStringAnsi::Strcmp(key, "timestamp") == 0)
+		{
+			OutFrame.Timestamp = bson_iter_double(&iter);
+		}
+		else if (FCStringAnsi::Strcmp(key, "layout") == 0 && BSON_ITER_HOLDS_INT32(&iter))
+		{
+			OutFrame.Layout = bson_iter_int32(&iter);
+		}
+		else if (FCStringAnsi::Strcmp(key, "poses") == 0 && BSON_ITER_HOLDS_BINARY(&iter))
+		{
+			bson_subtype_t subtype;
+			bson_iter_binary(&iter, &subtype, &PoseDataLen, &OutFrame.PoseData);
+		}
+		else if (FCStringAnsi::Strcmp(key, "idx") == 0 && BSON_ITER_HOLDS_BINARY(&iter))
+		{
+			bson_subtype_t subtype;
+			bson_iter_binary(&iter, &subtype, &IndexDataLen, &OutFrame.IndexData);
+		}
+	}
+
+	if (OutFrame.PoseData == nullptr)
+	{
+		return false;
+	}
+
+	OutFrame.Num = PoseDataLen / FSLWorldStateCompactSchema::PoseSize;
+	if (OutFrame.IndexData && IndexDataLen / FSLWorldStateCompactSchema::IndexSize != OutFrame.Num)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d [%f] Pose and index data sizes do not match, skipping frame.."),
+			*FString(__func__), __LINE__, OutFrame.Timestamp);
+		return false;
+	}
+	return true;
+}
+
+// Get the stored pose from the compact frame
+FTransform FSLMongoQueryDBHandler::GetCompactPose(const FSLWorldStateCompactFrame& Frame, int32 Slot)
+{
+#if SL_WITH_ROS_CONVERSIONS
+	return FConversions::ROSToU(Frame.GetPose(Slot));
+#else
+	return Frame.GetPose(Slot);
+#endif // SL_WITH_ROS_CONVERSIONS
+}
+
+// Set the skeletal poses of the individual stored in the frame (return true if any was set)
+bool FSLMongoQueryDBHandler::ReadCompactSkeletalPoses(const FSLWorldStateCompactFrame& Frame, const FString& Id, bool bOverwrite,
+	TPair<FTransform, TMap<int32, FTransform>>& OutSkeletalPose, bool& bOutRootSet, bool& bOutComplete) const
+{
+	const FSLMongoCompactPoseLayout& Layout = CompactLayouts[Frame.Layout];
+	const int32* PoseIdx = Layout.IdToPoseIdx.Find(Id);
+	if (PoseIdx == nullptr)
+	{
+		bOutComplete = false;
+		return false;
+	}
+
+	bool bAnySet = false;
+	if (bOverwrite || !bOutRootSet)
+	{
+		const int32 Slot = Frame.Find(*PoseIdx);
+		if (Slot != INDEX_NONE)
+		{
+			OutSkeletalPose.Key = GetCompactPose(Frame, Slot);
+			bOutRootSet = true;
+			bAnySet = true;
+		}
+	}
+
+	int32 NumBones = 0;
+	if (const TArray<TPair<int32, int32>>* Bones = Layout.SkeletalBones.Find(*PoseIdx))
+	{
+		NumBones = Bones->Num();
+		for (const auto& BonePair : *Bones)
+		{
+			if (!bOverwrite && OutSkeletalPose.Value.Contains(BonePair.Key))
+			{
+				continue;
+			}
+			const int32 Slot = Frame.Find(BonePair.Value);
+			if (Slot != INDEX_NONE)
+			{
+				OutSkeletalPose.Value.Emplace(BonePair.Key, GetCompactPose(Frame, Slot));
+				bAnySet = true;
+			}
+		}
+	}
+
+	bOutComplete = bOutRootSet && OutSkeletalPose.Value.Num() >= NumBones;
+	return bAnySet;
+}
+
+// Get the pose of the individual at the given time (the frames since the last keyframe are searched backwards until the individual is found)
+FTransform FSLMongoQueryDBHandler::GetCompactIndividualPoseAt(const FString& Id, float Ts) const
+{
+	FTransform Pose;
+	double ExecBegin = FPlatformTime::Seconds();
+
+	// Avoid scanning the frames for unknown individuals
+	float KeyframeTs;
+	if (!HasCompactId(Id) || !FindCompactKeyframeTs(Ts, KeyframeTs))
+	{
+		return Pose;
+	}
+
+	bson_error_t error;
+	const bson_t* doc;
+	mongoc_cursor_t* cursor = FindCompactFrames(KeyframeTs, Ts, true);
+
+	FSLWorldStateCompactFrame Frame;
+	while (mongoc_cursor_next(cursor, &doc))
+	{
+		if (ReadCompactFrame(doc, Frame))
+		{
+			const int32* PoseIdx = CompactLayouts[Frame.Layout].IdToPoseIdx.Find(Id);
+			const int32 Slot = PoseIdx ? Frame.Find(*PoseIdx) : INDEX_NONE;
+			if (Slot != INDEX_NONE)
+			{
+				Pose = GetCompactPose(Frame, Slot);
+				break;
+			}
+		}
+	}
+
+	if (mongoc_cursor_error(cursor, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+		NumQueryErrors++;
+	}
+
+	mongoc_cursor_destroy(cursor);
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Duration: total=[%f] seconds..;"),
+		*FString(__func__), __LINE__, FPlatformTime::Seconds() - ExecBegin);
+	return Pose;
+}
+
+// Get the poses of the individual between the given timestamps
+TArray<FTransform> FSLMongoQueryDBHandler::GetCompactIndividualTrajectory(const FString& Id, float StartTs, float EndTs, float DeltaT) const
+{
+	TArray<FTransform> Trajectory;
+	double ExecBegin = FPlatformTime::Seconds();
+
+	bson_error_t error;
+	const bson_t* doc;
+	mongoc_cursor_t* cursor = FindCompactFrames(StartTs, EndTs, false);
+
+	FSLWorldStateCompactFrame Frame;
+	double PrevTs = -BIG_NUMBER;
+	while (mongoc_cursor_next(cursor, &doc))
+	{
+		if (ReadCompactFrame(doc, Frame) && (DeltaT <= 0.f || Frame.Timestamp - PrevTs > DeltaT))
+		{
+			const int32* PoseIdx = CompactLayouts[Frame.Layout].IdToPoseIdx.Find(Id);
+			const int32 Slot = PoseIdx ? Frame.Find(*PoseIdx) : INDEX_NONE;
+			if (Slot != INDEX_NONE)
+			{
+				Trajectory.Add(GetCompactPose(Frame, Slot));
+				PrevTs = Frame.Timestamp;
+			}
+		}
+	}
+
+	if (mongoc_cursor_error(cursor, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+		NumQueryErrors++;
+	}
+
+	mongoc_cursor_destroy(cursor);
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Duration: total=[%f] seconds, Num=[%d]..;"),
+		*FString(__func__), __LINE__, FPlatformTime::Seconds() - ExecBegin, Trajectory.Num());
+
+	if (Trajectory.Num() == 0)
+	{
+		Trajectory.Add(GetCompactIndividualPoseAt(Id, StartTs));
+	}
+	return Trajectory;
+}
+
+// Get the poses of multiple individuals between the given timestamps with a single query (downsampled while reading the frames)
+FSLMongoTrajectories FSLMongoQueryDBHandler::GetCompactIndividualTrajectories(const TArray<FString>& Ids, float StartTs, float EndTs, float DeltaT) const
+{
+	FSLMongoTrajectories Trajectories;
+	double ExecBegin = FPlatformTime::Seconds();
+
+	for (const FString& Id : Ids)
+	{
+		Trajectories.Ids.AddUnique(Id);
+	}
+
+	// Pose index of every trajectory in every layout version
+	TMap<int32, TArray<int32>> LayoutPoseIndices;
+	for (const auto& LayoutPair : CompactLayouts)
+	{
+		TArray<int32>& PoseIndices = LayoutPoseIndices.Add(LayoutPair.Key);
+		for (const FString& Id : Trajectories.Ids)
+		{
+			const int32* PoseIdx = LayoutPair.Value.IdToPoseIdx.Find(Id);
+			PoseIndices.Add(PoseIdx ? *PoseIdx : INDEX_NONE);
+		}
+	}
+
+	bson_error_t error;
+	const bson_t* doc;
+	mongoc_cursor_t* cursor = FindCompactFrames(StartTs, EndTs, false);
+
+	// Same time buckets as the verbose aggregation, the first sample of every bucket is kept
+	TArray<TArray<TPair<float, FTransform>>> Samples;
+	Samples.SetNum(Trajectories.Ids.Num());
+	TArray<int64> LastBuckets;
+	LastBuckets.Init(-1, Trajectories.Ids.Num());
+	int32 NumSamples = 0;
+
+	FSLWorldStateCompactFrame Frame;
+	while (mongoc_cursor_next(cursor, &doc))
+	{
+		if (!ReadCompactFrame(doc, Frame))
+		{
+			continue;
+		}
+
+		const int64 Bucket = DeltaT > 0.f ? FMath::FloorToInt((Frame.Timestamp - StartTs) / DeltaT) : 0;
+		const TArray<int32>& PoseIndices = LayoutPoseIndices[Frame.Layout];
+		for (int32 TrajIdx = 0; TrajIdx < PoseIndices.Num(); ++TrajIdx)
+		{
+			if (PoseIndices[TrajIdx] == INDEX_NONE || (DeltaT > 0.f && Bucket == LastBuckets[TrajIdx]))
+			{
+				continue;
+			}
+
+			const int32 Slot = Frame.Find(PoseIndices[TrajIdx]);
+			if (Slot != INDEX_NONE)
+			{
+				Samples[TrajIdx].Emplace(Frame.Timestamp, GetCompactPose(Frame, Slot));
+				LastBuckets[TrajIdx] = Bucket;
+				NumSamples++;
+			}
+		}
+	}
+
+	if (mongoc_cursor_error(cursor, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+		NumQueryErrors++;
+	}
+
+	// Individuals which did not move in the interval are missing from the sparse frames, they keep their last pose before it
+	for (int32 TrajIdx = 0; TrajIdx < Samples.Num(); ++TrajIdx)
+	{
+		if (Samples[TrajIdx].Num() == 0)
+		{
+			Samples[TrajIdx].Emplace(StartTs, GetCompactIndividualPoseAt(Trajectories.Ids[TrajIdx], StartTs));
+		}
+	}
+
+	FlattenTrajectories(Samples, Trajectories);
+
+	mongoc_cursor_destroy(cursor);
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Duration: total=[%f] seconds, Ids=[%d], Num=[%d]..;"),
+		*FString(__func__), __LINE__, FPlatformTime::Seconds() - ExecBegin, Trajectories.Num(), NumSamples);
+	return Trajectories;
+}
+
+// Get skeletal individual pose (the frames since the last keyframe are searched backwards until every bone is found)
+TPair<FTransform, TMap<int32, FTransform>> FSLMongoQueryDBHandler::GetCompactSkeletalIndividualPoseAt(const FString& Id, float Ts) const
+{
+	TPair<FTransform, TMap<int32, FTransform>> SkeletalPosePair;
+	double ExecBegin = FPlatformTime::Seconds();
+
+	// Avoid scanning the frames for unknown individuals
+	float KeyframeTs;
+	if (!HasCompactId(Id) || !FindCompactKeyframeTs(Ts, KeyframeTs))
+	{
+		return SkeletalPosePair;
+	}
+
+	bson_error_t error;
+	const bson_t* doc;
+	mongoc_cursor_t* cursor = FindCompactFrames(KeyframeTs, Ts, true);
+
+	FSLWorldStateCompactFrame Frame;
+	bool bRootSet = false;
+	bool bComplete = false;
+	while (!bComplete && mongoc_cursor_next(cursor, &doc))
+	{
+		if (ReadCompactFrame(doc, Frame))
+		{
+			ReadCompactSkeletalPoses(Frame, Id, false, SkeletalPosePair, bRootSet, bComplete);
+		}
+	}
+
+	if (mongoc_cursor_error(cursor, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+		NumQueryErrors++;
+	}
+
+	mongoc_cursor_destroy(cursor);
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Duration: total=[%f] seconds..;"),
+		*FString(__func__), __LINE__, FPlatformTime::Seconds() - ExecBegin);
+	return SkeletalPosePair;
+}
+
+// Get skeletal individual trajectory, the sparse frames are applied on top of the pose at the start time
+TArray<TPair<FTransform, TMap<int32, FTransform>>> FSLMongoQueryDBHandler::GetCompactSkeletalIndividualTrajectory(const FString& Id, float StartTs, float EndTs, float DeltaT) const
+{
+	TArray<TPair<FTransform, TMap<int32, FTransform>>> SkeletalTrajectoryPair;
+	TPair<FTransform, TMap<int32, FTransform>> CurrSkeletalPose = GetCompactSkeletalIndividualPoseAt(Id, StartTs);
+	double ExecBegin = FPlatformTime::Seconds();
+
+	bson_error_t error;
+	const bson_t* doc;
+	mongoc_cursor_t* cursor = FindCompactFrames(StartTs, EndTs, false);
+
+	FSLWorldStateCompactFrame Frame;
+	bool bRootSet = true;
+	bool bComplete = false;
+	double PrevTs = -BIG_NUMBER;
+	while (mongoc_cursor_next(cursor, &doc))
+	{
+		if (ReadCompactFrame(doc, Frame) && ReadCompactSkeletalPoses(Frame, Id, true, CurrSkeletalPose, bRootSet, bComplete))
+		{
+			if (DeltaT <= 0.f || Frame.Timestamp - PrevTs > DeltaT)
+			{
+				SkeletalTrajectoryPair.Add(CurrSkeletalPose);
+				PrevTs = Frame.Timestamp;
+			}
+		}
+	}
+
+	if (mongoc_cursor_error(cursor, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+		NumQueryErrors++;
+	}
+
+	mongoc_cursor_destroy(cursor);
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Duration: total=[%f] seconds, Num=[%d]..;"),
+		*FString(__func__), __LINE__, FPlatformTime::Seconds() - ExecBegin, SkeletalTrajectoryPair.Num());
+
+	if (SkeletalTrajectoryPair.Num() == 0)
+	{
+		SkeletalTrajectoryPair.Add(CurrSkeletalPose);
+	}
+	return SkeletalTrajectoryPair;
+}
+
+// Get the whole episode data, every frame holds the poses stored in its document
+TArray<TPair<float, TMap<FString, FTransform>>> FSLMongoQueryDBHandler::GetCompactEpisodeData() const
+{
+	TArray<TPair<float, TMap<FString, FTransform>>> EpisodeData;
+	double ExecBegin = FPlatformTime::Seconds();
+
+	bson_error_t error;
+	const bson_t* doc;
+	mongoc_cursor_t* cursor = FindCompactFrames(-BIG_NUMBER, BIG_NUMBER, false);
+
+	FSLWorldStateCompactFrame Frame;
+	while (mongoc_cursor_next(cursor, &doc))
+	{
+		if (ReadCompactFrame(doc, Frame))
+		{
+			const FSLMongoCompactPoseLayout& Layout = CompactLayouts[Frame.Layout];
+			TMap<FString, FTransform> CurrIndividualsData;
+			CurrIndividualsData.Reserve(Frame.Num);
+			for (int32 Slot = 0; Slot < Frame.Num; ++Slot)
+			{
+				const int32 PoseIdx = Frame.GetPoseIdx(Slot);
+				if (Layout.Ids.IsValidIndex(PoseIdx))
+				{
+					CurrIndividualsData.Emplace(Layout.Ids[PoseIdx], GetCompactPose(Frame, Slot));
+				}
+			}
+			EpisodeData.Emplace(Frame.Timestamp, MoveTemp(CurrIndividualsData));
+		}
+	}
+
+	if (mongoc_cursor_error(cursor, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+		NumQueryErrors++;
+	}
+
+	mongoc_cursor_destroy(cursor);
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Duration: total(num=%d)=[%f] seconds..;"),
+		*FString(__func__), __LINE__, EpisodeData.Num(), FPlatformTime::Seconds() - ExecBegin);
+	return EpisodeData;
+}
+#endif // SL_WITH_LIBMONGO_C
@@ -2,6 +2,7 @@
 // Author: Andrei Haidu (http://haidu.eu)
 
 #include "Mongo/SLMongoQueryManager.h"
+#include "Viz/SLVizManager.h"
 #include "EngineUtils.h"
 
 // Ctor
@@ -14,6 +15,7 @@ ASLMongoQueryManager::ASLMongoQueryManager()
 	bConnected = false;
 	bTaskSet = false;
 	bEpisodeSet = false;
+	VizManager = nullptr;
 
 #if WITH_EDITORONLY_DATA
 	// Make manager sprite smaller (used to easily find the actor in the world)
@@ -139,6 +141,14 @@ bool ASLMongoQueryManager::Connect(const FString& ServerIp, uint16 ServerPort)
 	if (DBHandler.Connect(ServerIp, ServerPort))
 	{
 		bConnected = true;
+		QueryCache.SetMaxSize(SIZE_T(QueryCacheSizeMB) * 1024 * 1024);
+
+		// The async queries use their own connections
+		if (!QueryPool.Connect(ServerIp, ServerPort, NumQueryWorkers))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d Query workers could not connect, the async queries will return default values.."),
+				*FString(__FUNCTION__), __LINE__);
+		}
 	}
 	else
 	{
@@ -152,7 +162,11 @@ void ASLMongoQueryManager::Disconnect()
 {
 	if (bConnected)
 	{
+		// Cancel the queued async queries and wait for the running ones
+		QueryPool.Disconnect();
 		DBHandler.Disconnect();
+		QueryCache.LogStats();
+		QueryCache.Empty();
 		TaskId = "";
 		EpisodeId = "";
 		
@@ -174,6 +188,9 @@ bool ASLMongoQueryManager::SetTask(const FString& InTaskId)
 	{
 		return true;
 	}
+	// The collection of the previous task is not valid anymore
+	EpisodeId = "";
+	bEpisodeSet = false;
 	if (DBHandler.SetDatabase(InTaskId))
 	{
 		TaskId = InTaskId;
@@ -218,6 +235,61 @@ bool ASLMongoQueryManager::SetEpisode(const FString& InEpisodeId)
 	return bEpisodeSet;
 }
 
+// Return the cached result or run the query with the active handler and cache its result
+template<typename ResultType>
+ResultType ASLMongoQueryManager::CachedQuery(const FString& Key, TFunctionRef<ResultType()> QueryFunc) const
+{
+	ResultType Result;
+	if (!bCacheQueryResults)
+	{
+		return QueryFunc();
+	}
+	if (QueryCache.Find(Key, Result))
+	{
+		return Result;
+	}
+	const int32 NumErrors = DBHandler.GetNumQueryErrors();
+	Result = QueryFunc();
+
+	// Do not cache the default values of the failed queries
+	if (DBHandler.GetNumQueryErrors() == NumErrors)
+	{
+		QueryCache.Add(Key, Result);
+	}
+	return Result;
+}
+
+// Return the cached result as a completed future or run the query on a worker and cache its result
+template<typename ResultType>
+TSharedFuture<ResultType> ASLMongoQueryManager::CachedQueryAsync(const FString& Key, const FString& InTaskId, const FString& InEpisodeId,
+	TFunction<ResultType(const FSLMongoQueryDBHandler&)> QueryFunc, TFunction<void(const ResultType&)> OnDone)
+{
+	if (!bCacheQueryResults)
+	{
+		return QueryPool.Query<ResultType>(InTaskId, InEpisodeId, QueryFunc, OnDone);
+	}
+	ResultType Result;
+	if (QueryCache.Find(Key, Result))
+	{
+		return FSLMongoQueryPool::MakeReadyFuture<ResultType>(Result, OnDone);
+	}
+
+	// Cancelled queries never run the query function, the failed ones return default values which are not cached either
+	FSLMongoQueryCache* Cache = &QueryCache;
+	return QueryPool.Query<ResultType>(InTaskId, InEpisodeId,
+		[Cache, Key, QueryFunc](const FSLMongoQueryDBHandler& Handler)
+		{
+			const int32 NumErrors = Handler.GetNumQueryErrors();
+			ResultType QueryResult = QueryFunc(Handler);
+			if (Handler.GetNumQueryErrors() == NumErrors)
+			{
+				Cache->Add(Key, QueryResult);
+			}
+			return QueryResult;
+		},
+		OnDone);
+}
+
 /* Queries */
 // Get the individual pose with task and episode init
 FTransform ASLMongoQueryManager::GetIndividualPoseAt(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float Ts)
@@ -250,7 +322,13 @@ FTransform ASLMongoQueryManager::GetIndividualPoseAt(const FString& InEpisodeId,
 // Get the individual pose
 FTransform ASLMongoQueryManager::GetIndividualPoseAt(const FString& IndividualId, float Ts) const
 {
-	return DBHandler.GetIndividualPoseAt(IndividualId, Ts);
+	FTransform Pose;
+	if (GetCachedEpisodePoseAt(TaskId, EpisodeId, IndividualId, Ts, Pose))
+	{
+		return Pose;
+	}
+	return CachedQuery<FTransform>(GetQueryCacheKey(TEXT("Pose"), TaskId, EpisodeId, IndividualId, Ts),
+		[&]() { return DBHandler.GetIndividualPoseAt(IndividualId, Ts); });
 }
 
 // Get the individual trajectory with task and episode init
@@ -284,7 +362,43 @@ TArray<FTransform> ASLMongoQueryManager::GetIndividualTrajectory(const FString&
 // Get the individual trajectory 
 TArray<FTransform> ASLMongoQueryManager::GetIndividualTrajectory(const FString& IndividualId, float StartTs, float EndTs, float DeltaT) const
 {
-	return DBHandler.GetIndividualTrajectory(IndividualId, StartTs, EndTs, DeltaT);
+	return CachedQuery<TArray<FTransform>>(GetQueryCacheKey(TEXT("Traj"), TaskId, EpisodeId, IndividualId, StartTs, EndTs, DeltaT),
+		[&]() { return DBHandler.GetIndividualTrajectory(IndividualId, StartTs, EndTs, DeltaT); });
+}
+
+// Get the trajectories of multiple individuals with task and episode init
+FSLMongoTrajectories ASLMongoQueryManager::GetIndividualTrajectories(const FString& InTaskId, const FString& InEpisodeId, const TArray<FString>& IndividualIds, float StartTs, float EndTs, float DeltaT)
+{
+	if (SetTask(InTaskId))
+	{
+		return GetIndividualTrajectories(InEpisodeId, IndividualIds, StartTs, EndTs, DeltaT);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not set task: %s .."), *FString(__FUNCTION__), __LINE__, *InTaskId);
+		return FSLMongoTrajectories();
+	}
+}
+
+// Get the trajectories of multiple individuals with episode init
+FSLMongoTrajectories ASLMongoQueryManager::GetIndividualTrajectories(const FString& InEpisodeId, const TArray<FString>& IndividualIds, float StartTs, float EndTs, float DeltaT)
+{
+	if (SetEpisode(InEpisodeId))
+	{
+		return GetIndividualTrajectories(IndividualIds, StartTs, EndTs, DeltaT);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not set episode: %s .."), *FString(__FUNCTION__), __LINE__, *InEpisodeId);
+		return FSLMongoTrajectories();
+	}
+}
+
+// Get the trajectories of multiple individuals
+FSLMongoTrajectories ASLMongoQueryManager::GetIndividualTrajectories(const TArray<FString>& IndividualIds, float StartTs, float EndTs, float DeltaT) const
+{
+	return CachedQuery<FSLMongoTrajectories>(GetQueryCacheKey(TEXT("Trajs"), TaskId, EpisodeId, FString::Join(IndividualIds, TEXT(",")), StartTs, EndTs, DeltaT),
+		[&]() { return DBHandler.GetIndividualTrajectories(IndividualIds, StartTs, EndTs, DeltaT); });
 }
 
 
@@ -319,7 +433,8 @@ TPair<FTransform, TMap<int32, FTransform>> ASLMongoQueryManager::GetSkeletalIndi
 // Get skeletal individual pose
 TPair<FTransform, TMap<int32, FTransform>> ASLMongoQueryManager::GetSkeletalIndividualPoseAt(const FString& IndividualId, float Ts) const
 {
-	return DBHandler.GetSkeletalIndividualPoseAt(IndividualId, Ts);	
+	return CachedQuery<TPair<FTransform, TMap<int32, FTransform>>>(GetQueryCacheKey(TEXT("SkelPose"), TaskId, EpisodeId, IndividualId, Ts),
+		[&]() { return DBHandler.GetSkeletalIndividualPoseAt(IndividualId, Ts); });
 }
 
 // Get skeletal individual trajectory with task and episode init
@@ -354,7 +469,8 @@ TArray<TPair<FTransform, TMap<int32, FTransform>>> ASLMongoQueryManager::GetSkel
 // Get skeletal individual trajectory
 TArray<TPair<FTransform, TMap<int32, FTransform>>> ASLMongoQueryManager::GetSkeletalIndividualTrajectory(const FString& IndividualId, float StartTs, float EndTs, float DeltaT) const
 {
-	return DBHandler.GetSkeletalIndividualTrajectory(IndividualId, StartTs, EndTs, DeltaT);
+	return CachedQuery<TArray<TPair<FTransform, TMap<int32, FTransform>>>>(GetQueryCacheKey(TEXT("SkelTraj"), TaskId, EpisodeId, IndividualId, StartTs, EndTs, DeltaT),
+		[&]() { return DBHandler.GetSkeletalIndividualTrajectory(IndividualId, StartTs, EndTs, DeltaT); });
 }
 
 // Get the episode data with task and episode init
@@ -391,6 +507,162 @@ TArray<TPair<float, TMap<FString, FTransform>>> ASLMongoQueryManager::GetEpisode
 	return DBHandler.GetEpisodeData();
 }
 
+// Stream the episode data with task and episode init
+TSharedPtr<FSLMongoEpisodeStream, ESPMode::ThreadSafe> ASLMongoQueryManager::StartEpisodeStream(const FString& InTaskId, const FString& InEpisodeId, const FSLMongoEpisodeStreamParams& Params)
+{
+	if (SetTask(InTaskId))
+	{
+		return StartEpisodeStream(InEpisodeId, Params);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not set task: %s .."), *FString(__FUNCTION__), __LINE__, *InTaskId);
+		return nullptr;
+	}
+}
+
+// Stream the episode data with episode init
+TSharedPtr<FSLMongoEpisodeStream, ESPMode::ThreadSafe> ASLMongoQueryManager::StartEpisodeStream(const FString& InEpisodeId, const FSLMongoEpisodeStreamParams& Params)
+{
+	if (SetEpisode(InEpisodeId))
+	{
+		return StartEpisodeStream(Params);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not set episode: %s .."), *FString(__FUNCTION__), __LINE__, *InEpisodeId);
+		return nullptr;
+	}
+}
+
+// Stream the episode data
+TSharedPtr<FSLMongoEpisodeStream, ESPMode::ThreadSafe> ASLMongoQueryManager::StartEpisodeStream(const FSLMongoEpisodeStreamParams& Params) const
+{
+	return DBHandler.StartEpisodeStream(Params);
+}
+
+// Get the content hash of the episode with task and episode init
+FString ASLMongoQueryManager::GetEpisodeContentHash(const FString& InTaskId, const FString& InEpisodeId)
+{
+	if (SetTask(InTaskId))
+	{
+		return GetEpisodeContentHash(InEpisodeId);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not set task: %s .."), *FString(__FUNCTION__), __LINE__, *InTaskId);
+		return FString();
+	}
+}
+
+// Get the content hash of the episode with episode init
+FString ASLMongoQueryManager::GetEpisodeContentHash(const FString& InEpisodeId)
+{
+	if (SetEpisode(InEpisodeId))
+	{
+		return GetEpisodeContentHash();
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not set episode: %s .."), *FString(__FUNCTION__), __LINE__, *InEpisodeId);
+		return FString();
+	}
+}
+
+// Get the content hash of the episode
+FString ASLMongoQueryManager::GetEpisodeContentHash() const
+{
+	return DBHandler.GetContentHash();
+}
+
+/* Async queries */
+// Get the individual pose
+TSharedFuture<FTransform> ASLMongoQueryManager::GetIndividualPoseAtAsync(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float Ts,
+	TFunction<void(const FTransform&)> OnDone)
+{
+	FTransform Pose;
+	if (GetCachedEpisodePoseAt(InTaskId, InEpisodeId, IndividualId, Ts, Pose))
+	{
+		return FSLMongoQueryPool::MakeReadyFuture<FTransform>(Pose, OnDone);
+	}
+	return CachedQueryAsync<FTransform>(GetQueryCacheKey(TEXT("Pose"), InTaskId, InEpisodeId, IndividualId, Ts), InTaskId, InEpisodeId,
+		[IndividualId, Ts](const FSLMongoQueryDBHandler& Handler) { return Handler.GetIndividualPoseAt(IndividualId, Ts); },
+		OnDone);
+}
+
+// Get the individual trajectory
+TSharedFuture<TArray<FTransform>> ASLMongoQueryManager::GetIndividualTrajectoryAsync(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT,
+	TFunction<void(const TArray<FTransform>&)> OnDone)
+{
+	return CachedQueryAsync<TArray<FTransform>>(GetQueryCacheKey(TEXT("Traj"), InTaskId, InEpisodeId, IndividualId, StartTs, EndTs, DeltaT), InTaskId, InEpisodeId,
+		[IndividualId, StartTs, EndTs, DeltaT](const FSLMongoQueryDBHandler& Handler) { return Handler.GetIndividualTrajectory(IndividualId, StartTs, EndTs, DeltaT); },
+		OnDone);
+}
+
+// Get the trajectories of multiple individuals with a single query
+TSharedFuture<FSLMongoTrajectories> ASLMongoQueryManager::GetIndividualTrajectoriesAsync(const FString& InTaskId, const FString& InEpisodeId, const TArray<FString>& IndividualIds, float StartTs, float EndTs, float DeltaT,
+	TFunction<void(const FSLMongoTrajectories&)> OnDone)
+{
+	return CachedQueryAsync<FSLMongoTrajectories>(GetQueryCacheKey(TEXT("Trajs"), InTaskId, InEpisodeId, FString::Join(IndividualIds, TEXT(",")), StartTs, EndTs, DeltaT), InTaskId, InEpisodeId,
+		[IndividualIds, StartTs, EndTs, DeltaT](const FSLMongoQueryDBHandler& Handler) { return Handler.GetIndividualTrajectories(IndividualIds, StartTs, EndTs, DeltaT); },
+		OnDone);
+}
+
+// Get skeletal individual pose
+TSharedFuture<TPair<FTransform, TMap<int32, FTransform>>> ASLMongoQueryManager::GetSkeletalIndividualPoseAtAsync(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float Ts,
+	TFunction<void(const TPair<FTransform, TMap<int32, FTransform>>&)> OnDone)
+{
+	return CachedQueryAsync<TPair<FTransform, TMap<int32, FTransform>>>(GetQueryCacheKey(TEXT("SkelPose"), InTaskId, InEpisodeId, IndividualId, Ts), InTaskId, InEpisodeId,
+		[IndividualId, Ts](const FSLMongoQueryDBHandler& Handler) { return Handler.GetSkeletalIndividualPoseAt(IndividualId, Ts); },
+		OnDone);
+}
+
+// Get skeletal individual trajectory
+TSharedFuture<TArray<TPair<FTransform, TMap<int32, FTransform>>>> ASLMongoQueryManager::GetSkeletalIndividualTrajectoryAsync(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float StartTs, float EndTs, float DeltaT,
+	TFunction<void(const TArray<TPair<FTransform, TMap<int32, FTransform>>>&)> OnDone)
+{
+	return CachedQueryAsync<TArray<TPair<FTransform, TMap<int32, FTransform>>>>(GetQueryCacheKey(TEXT("SkelTraj"), InTaskId, InEpisodeId, IndividualId, StartTs, EndTs, DeltaT), InTaskId, InEpisodeId,
+		[IndividualId, StartTs, EndTs, DeltaT](const FSLMongoQueryDBHandler& Handler) { return Handler.GetSkeletalIndividualTrajectory(IndividualId, StartTs, EndTs, DeltaT); },
+		OnDone);
+}
+
+// Get the episode data
+TSharedFuture<TArray<TPair<float, TMap<FString, FTransform>>>> ASLMongoQueryManager::GetEpisodeDataAsync(const FString& InTaskId, const FString& InEpisodeId,
+	TFunction<void(const TArray<TPair<float, TMap<FString, FTransform>>>&)> OnDone)
+{
+	return QueryPool.Query<TArray<TPair<float, TMap<FString, FTransform>>>>(InTaskId, InEpisodeId,
+		[](const FSLMongoQueryDBHandler& Handler) { return Handler.GetEpisodeData(); },
+		OnDone);
+}
+
+// Get the pose from the episode of the task cached in the viz manager (false if the episode or the individual pose is not cached)
+bool ASLMongoQueryManager::GetCachedEpisodePoseAt(const FString& InTaskId, const FString& InEpisodeId, const FString& IndividualId, float Ts, FTransform& OutPose) const
+{
+	// The cached episodes are only accessed from the game thread
+	if (!bUseCachedEpisodes || !VizManager || !VizManager->IsValidLowLevel() || VizManager->IsPendingKillOrUnreachable())
+	{
+		return false;
+	}
+	TSharedPtr<const FSLVizEpisodeData, ESPMode::ThreadSafe> EpisodeData = VizManager->GetCachedEpisodeData(InEpisodeId);
+	return EpisodeData.IsValid() && EpisodeData->TaskId.Equals(InTaskId) && EpisodeData->GetTargetPoseAt(IndividualId, Ts, OutPose);
+}
+
+// Get the query cache key from the query parameters
+FString ASLMongoQueryManager::GetQueryCacheKey(const TCHAR* QueryName, const FString& InTaskId, const FString& InEpisodeId,
+	const FString& Ids, float StartTs, float EndTs, float DeltaT)
+{
+	return FString::Printf(TEXT("%s|%s|%s|%s|%f|%f|%f"), QueryName, *InTaskId, *InEpisodeId, *Ids, StartTs, EndTs, DeltaT);
+}
+
+// Called when actor removed from game or game ended
+void ASLMongoQueryManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+
+	// Do not leave workers running on a destroyed manager
+	QueryPool.Disconnect();
+}
+
 // Spawn or get manager from the world
 ASLMongoQueryManager* ASLMongoQueryManager::GetExistingOrSpawnNew(UWorld* World)
 {
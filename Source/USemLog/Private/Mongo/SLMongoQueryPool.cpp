@@ -0,0 +1,216 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Mongo/SLMongoQueryPool.h"
+#include "Misc/ScopeLock.h"
+#include "HAL/PlatformProcess.h"
+
+// Run the pending queries
+void FSLMongoQueryTask::DoWork()
+{
+	Pool->RunWorker(WorkerIdx);
+}
+
+// Ctor
+FSLMongoQueryPool::FSLMongoQueryPool()
+{
+#if SL_WITH_LIBMONGO_C
+	uri = nullptr;
+	client_pool = nullptr;
+#endif // SL_WITH_LIBMONGO_C
+}
+
+// Dtor
+FSLMongoQueryPool::~FSLMongoQueryPool()
+{
+	Disconnect();
+}
+
+// Create the client pool and connect the workers
+bool FSLMongoQueryPool::Connect(const FString& ServerIp, uint16 ServerPort, int32 NumWorkers)
+{
+	if (IsConnected())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Query pool is already connected to the server.."), *FString(__FUNCTION__), __LINE__);
+		return true;
+	}
+
+#if SL_WITH_LIBMONGO_C
+	// Required to initialize libmongoc's internals
+	mongoc_init();
+
+	bson_error_t error;
+	FString Uri = TEXT("mongodb://") + ServerIp + TEXT(":") + FString::FromInt(ServerPort);
+	uri = mongoc_uri_new_with_error(TCHAR_TO_UTF8(*Uri), &error);
+	if (!uri)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.:%s"), *FString(__FUNCTION__), __LINE__, *FString(error.message));
+		return false;
+	}
+
+	// Every worker pops its client once, the pool never has to create more
+	NumWorkers = FMath::Max(NumWorkers, 1);
+	client_pool = mongoc_client_pool_new(uri);
+	mongoc_client_pool_max_size(client_pool, NumWorkers);
+	mongoc_client_pool_set_appname(client_pool, "MongoQA");
+
+	Workers.SetNum(NumWorkers);
+	for (int32 WorkerIdx = 0; WorkerIdx < NumWorkers; ++WorkerIdx)
+	{
+		Workers[WorkerIdx].Handler = MakeUnique<FSLMongoQueryDBHandler>();
+		if (!Workers[WorkerIdx].Handler->Connect(client_pool))
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Query worker %d could not connect to %s.."),
+				*FString(__FUNCTION__), __LINE__, WorkerIdx, *Uri);
+			Disconnect();
+			return false;
+		}
+		FreeWorkers.Add(WorkerIdx);
+	}
+	return true;
+#else
+	UE_LOG(LogTemp, Error, TEXT("%s::%d Mongo module is missing.."), *FString(__FUNCTION__), __LINE__);
+	return false;
+#endif // SL_WITH_LIBMONGO_C
+}
+
+// Cancel the pending queries (completed with default values), wait for the running ones and disconnect
+void FSLMongoQueryPool::Disconnect()
+{
+	TArray<FSLMongoQueryJob> CancelledJobs;
+	{
+		FScopeLock Lock(&JobsCS);
+		CancelledJobs = MoveTemp(PendingJobs);
+		PendingJobs.Reset();
+	}
+	for (FSLMongoQueryJob& Job : CancelledJobs)
+	{
+		Job.Run(nullptr);
+	}
+
+	// The running workers stop once they see the empty queue
+	while (NumActiveWorkers.GetValue() > 0)
+	{
+		FPlatformProcess::Sleep(0.001f);
+	}
+
+	// Make sure the last worker released the lock
+	FScopeLock Lock(&JobsCS);
+	for (FSLMongoQueryWorker& Worker : Workers)
+	{
+		if (Worker.Handler.IsValid())
+		{
+			Worker.Handler->Disconnect();
+		}
+	}
+	Workers.Empty();
+	FreeWorkers.Empty();
+
+#if SL_WITH_LIBMONGO_C
+	// The clients are returned to the pool by the handlers
+	if (client_pool)
+	{
+		mongoc_client_pool_destroy(client_pool);
+		client_pool = nullptr;
+	}
+	if (uri)
+	{
+		mongoc_uri_destroy(uri);
+		uri = nullptr;
+	}
+#endif // SL_WITH_LIBMONGO_C
+}
+
+// Number of queued queries
+int32 FSLMongoQueryPool::NumPending() const
+{
+	FScopeLock Lock(&JobsCS);
+	return PendingJobs.Num();
+}
+
+// Queue the job and start a free worker if available
+void FSLMongoQueryPool::AddJob(FSLMongoQueryJob&& Job)
+{
+	if (!IsConnected())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Query pool is not connected, the query returns the default value.."),
+			*FString(__FUNCTION__), __LINE__);
+		Job.Run(nullptr);
+		return;
+	}
+
+	FScopeLock Lock(&JobsCS);
+
+	// Prefer a free worker which already has the episode selected
+	int32 FreeIdx = FreeWorkers.IndexOfByPredicate([this, &Job](int32 WorkerIdx)
+	{
+		return Workers[WorkerIdx].TaskId.Equals(Job.TaskId) && Workers[WorkerIdx].EpisodeId.Equals(Job.EpisodeId);
+	});
+	if (FreeIdx == INDEX_NONE && FreeWorkers.Num() > 0)
+	{
+		FreeIdx = FreeWorkers.Num() - 1;
+	}
+
+	PendingJobs.Add(MoveTemp(Job));
+	if (FreeIdx != INDEX_NONE)
+	{
+		const int32 WorkerIdx = FreeWorkers[FreeIdx];
+		FreeWorkers.RemoveAtSwap(FreeIdx, 1, false);
+		NumActiveWorkers.Increment();
+		(new FAutoDeleteAsyncTask<FSLMongoQueryTask>(this, WorkerIdx))->StartBackgroundTask();
+	}
+}
+
+// Run the queued jobs with the worker until the queue is empty
+void FSLMongoQueryPool::RunWorker(int32 WorkerIdx)
+{
+	FSLMongoQueryWorker& Worker = Workers[WorkerIdx];
+	while (true)
+	{
+		FSLMongoQueryJob Job;
+		{
+			FScopeLock Lock(&JobsCS);
+			if (PendingJobs.Num() == 0)
+			{
+				FreeWorkers.Add(WorkerIdx);
+				NumActiveWorkers.Decrement();
+				return;
+			}
+			Job = MoveTemp(PendingJobs[0]);
+			PendingJobs.RemoveAt(0, 1, false);
+		}
+
+		const bool bSelected = SelectEpisode(Worker, Job.TaskId, Job.EpisodeId);
+		if (!bSelected)
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Could not select %s.%s, the query returns the default value.."),
+				*FString(__FUNCTION__), __LINE__, *Job.TaskId, *Job.EpisodeId);
+		}
+		Job.Run(bSelected ? Worker.Handler.Get() : nullptr);
+	}
+}
+
+// Select the task and episode of the worker if they changed (false if they could not be selected)
+bool FSLMongoQueryPool::SelectEpisode(FSLMongoQueryWorker& Worker, const FString& TaskId, const FString& EpisodeId)
+{
+	if (!Worker.TaskId.Equals(TaskId))
+	{
+		Worker.EpisodeId.Empty();
+		if (!Worker.Handler->SetDatabase(TaskId))
+		{
+			Worker.TaskId.Empty();
+			return false;
+		}
+		Worker.TaskId = TaskId;
+	}
+	if (!Worker.EpisodeId.Equals(EpisodeId))
+	{
+		if (!Worker.Handler->SetCollection(EpisodeId))
+		{
+			Worker.EpisodeId.Empty();
+			return false;
+		}
+		Worker.EpisodeId = EpisodeId;
+	}
+	return Worker.Handler->IsReady();
+}
@@ -54,7 +54,7 @@ USLPickAndPlaceMonitor::USLPickAndPlaceMonitor()
 	bPickUpHappened = false;
 
 	/* PutDown */
-	RecentMovementBuffer.Reserve(RecentMovementBufferSize);
+	RecentMovementBuffer.Init(RecentMovementBufferMinSize, RecentMovementBufferDuration);
 }
 
 // Dtor
@@ -130,6 +130,10 @@ void USLPickAndPlaceMonitor::Start()
 			if(UpdateRate > 0.f)
 			{
 				SetComponentTickInterval(UpdateRate);
+
+				// Size the movement history to cover the backtrack window at the update rate (it grows if ticks are more frequent)
+				RecentMovementBuffer.Init(FMath::Max(FMath::CeilToInt(RecentMovementBufferDuration / UpdateRate) + 1,
+					RecentMovementBufferMinSize), RecentMovementBufferDuration);
 			}
 
 			// Mark as started
@@ -363,9 +367,10 @@ bool USLPickAndPlaceMonitor::HasPutDownEventHappened(const float CurrTime, const
 			*FString(__FUNCTION__), __LINE__, GetWorld()->GetTimeSeconds(), *GetOwner()->GetName());
 	}
 
-	// Backtrack movement buffer and see when put-down might have started
+	// Backtrack movement buffer and see when put-down might have started (only the samples within the backtrack duration)
+	const int32 BacktrackStartIdx = FMath::Max(RecentMovementBuffer.FindFirstGreater(CurrTime - PutDownMovementBacktrackDuration), 1);
 	OutPutDownEndIdx = RecentMovementBuffer.Num() - 1;
-	while(OutPutDownEndIdx > 0 && CurrTime - RecentMovementBuffer[OutPutDownEndIdx].Key < PutDownMovementBacktrackDuration)
+	while((int32)OutPutDownEndIdx >= BacktrackStartIdx)
 	{
 		if(RecentMovementBuffer[OutPutDownEndIdx].Value.Z - CurrObjLocation.Z > MinPutDownHeight)
 		{
@@ -659,7 +664,7 @@ void USLPickAndPlaceMonitor::Update_TransportOrPutDown()
 		}
 
 		// Clear movement buffer
-		RecentMovementBuffer.Reset(RecentMovementBufferSize);
+		RecentMovementBuffer.Reset();
 
 		if (bLogAllEventsDebug || bLogSlideDebug)
 		{
@@ -676,26 +681,8 @@ void USLPickAndPlaceMonitor::Update_TransportOrPutDown()
 	}
 	else
 	{
-		// Cache recent movements 
-		if(RecentMovementBuffer.Num() > 1)
-		{
-			RecentMovementBuffer.Push(TPair<float, FVector>(CurrTime, CurrObjLocation));
-
-			// Remove values older than RecentMovementBufferDuration
-			int32 Count = 0;
-			while(RecentMovementBuffer.Last().Key - RecentMovementBuffer[Count].Key > RecentMovementBufferDuration)
-			{
-				Count++;
-			}
-			if(Count > 0)
-			{
-				RecentMovementBuffer.RemoveAt(0, Count, false);
-			}
-		}
-		else
-		{
-			RecentMovementBuffer.Push(TPair<float, FVector>(CurrTime, CurrObjLocation));
-		}
+		// Cache recent movements (values older than RecentMovementBufferDuration are evicted)
+		RecentMovementBuffer.Push(CurrTime, CurrObjLocation);
 	}
 }
 
@@ -116,7 +116,7 @@ void FSLOwlExperimentStatics::WriteToFile(TSharedPtr<FSLOwlExperiment> Experimen
 		FPaths::RemoveDuplicateSlashes(FullFilePath);
 		if (!FPaths::FileExists(FullFilePath) || bOverwrite)
 		{
-			FFileHelper::SaveStringToFile(Experiment->ToString(), *FullFilePath);
+			Experiment->WriteToFile(FullFilePath);
 		}
 	}
 }
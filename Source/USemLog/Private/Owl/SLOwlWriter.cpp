@@ -0,0 +1,282 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Owl/SLOwlWriter.h"
+#include "Owl/SLOwlDoc.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+// Ctor (in memory until a file is opened)
+FSLOwlWriter::FSLOwlWriter(int32 InFlushSize) : FlushSize(FMath::Max(InFlushSize, 1024)), Ar(nullptr)
+{
+	Buffer.Reserve(FlushSize);
+}
+
+// Dtor, closes the file if still open
+FSLOwlWriter::~FSLOwlWriter()
+{
+	Close();
+}
+
+// Stream to the given file (written to a temporary file and moved on close)
+bool FSLOwlWriter::OpenFile(const FString& InPath)
+{
+	if (Ar)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d File %s is already open.."), *FString(__FUNCTION__), __LINE__, *Path);
+		return false;
+	}
+
+	Path = InPath;
+	TempPath = InPath + TEXT(".tmp");
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(Path), true);
+	Ar = IFileManager::Get().CreateFileWriter(*TempPath);
+	if (!Ar)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not create %s.."), *FString(__FUNCTION__), __LINE__, *TempPath);
+		return false;
+	}
+
+	// Write what was already added in memory
+	FlushBuffer();
+	return true;
+}
+
+// Flush the buffer and close the file, return false if any write failed
+bool FSLOwlWriter::Close()
+{
+	if (!Ar)
+	{
+		return true;
+	}
+
+	FlushBuffer();
+	Ar->Close();
+	const bool bSuccess = !Ar->IsError();
+	delete Ar;
+	Ar = nullptr;
+
+	if (!bSuccess || !IFileManager::Get().Move(*Path, *TempPath, true))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not write %s.."), *FString(__FUNCTION__), __LINE__, *Path);
+		IFileManager::Get().Delete(*TempPath);
+		return false;
+	}
+	return true;
+}
+
+// Write the whole document
+void FSLOwlWriter::WriteDoc(const FSLOwlDoc& Doc)
+{
+	Write(TEXT("<?xml version=\"1.0\" encoding=\"utf-8\"?>\n\n"));
+
+	// Entity declarations
+	if (Doc.EntityDefinitions.EntityPairs.Num() > 0)
+	{
+		Write(TEXT("<!DOCTYPE "));
+		WritePrefixName(Doc.EntityDefinitions.Name);
+		Write(TEXT("[\n"));
+		for (const auto& Pair : Doc.EntityDefinitions.EntityPairs)
+		{
+			WriteIndent(1);
+			Write(TEXT("<!ENTITY "));
+			Write(Pair.Key);
+			Write(TEXT(" \""));
+			Write(Pair.Value);
+			Write(TEXT("\">\n"));
+		}
+		Write(TEXT("]>\n\n"));
+	}
+
+	// Root node with the namespaces, the document nodes are written in place without copying them into the root
+	const FSLOwlNode Root(FSLOwlPrefixName("rdf", "RDF"), Doc.Namespaces);
+	WriteTagBegin(Root, 0);
+	Write(TEXT(">\n"));
+	WriteNode(Doc.OntologyImports, 1);
+	for (const auto& Node : Doc.PropertyDefinitions)
+	{
+		WriteNode(Node, 1);
+	}
+	for (const auto& Node : Doc.DatatypeDefinitions)
+	{
+		WriteNode(Node, 1);
+	}
+	for (const auto& Node : Doc.ClassDefinitions)
+	{
+		WriteNode(Node, 1);
+	}
+	for (const auto& Node : Doc.Individuals)
+	{
+		WriteNode(Node, 1);
+	}
+	WriteTagEnd(Root.Name, 0);
+}
+
+// Write the node and its children with the given indentation depth
+void FSLOwlWriter::WriteNode(const FSLOwlNode& Node, int32 Depth)
+{
+	WriteTagBegin(Node, Depth);
+
+	// Comment only OR empty node
+	if (Node.Name.IsEmpty())
+	{
+		return;
+	}
+
+	// Node cannot have value and children
+	if (!Node.Value.IsEmpty())
+	{
+		WriteChar('>');
+		Write(Node.Value);
+		Write(TEXT("</"));
+		WritePrefixName(Node.Name);
+		Write(TEXT(">\n"));
+	}
+	else if (Node.ChildNodes.Num() > 0)
+	{
+		Write(TEXT(">\n"));
+		for (const auto& Child : Node.ChildNodes)
+		{
+			WriteNode(Child, Depth + 1);
+		}
+		WriteTagEnd(Node.Name, Depth);
+	}
+	else
+	{
+		Write(TEXT("/>\n"));
+	}
+}
+
+// Get the in memory output as string
+FString FSLOwlWriter::ToString() const
+{
+	FUTF8ToTCHAR Converted(Buffer.GetData(), Buffer.Num());
+	return FString(Converted.Length(), Converted.Get());
+}
+
+// Write the document to the file in a single pass
+bool FSLOwlWriter::WriteToFile(const FSLOwlDoc& Doc, const FString& Path)
+{
+	const double StartTime = FPlatformTime::Seconds();
+	FSLOwlWriter Writer;
+	if (!Writer.OpenFile(Path))
+	{
+		return false;
+	}
+	Writer.WriteDoc(Doc);
+	const bool bSuccess = Writer.Close();
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Duration: %s=[%f] seconds..;"),
+		*FString(__FUNCTION__), __LINE__, *FPaths::GetCleanFilename(Path), FPlatformTime::Seconds() - StartTime);
+	return bSuccess;
+}
+
+// Write the comment and the opening tag with its attributes (without closing the tag)
+void FSLOwlWriter::WriteTagBegin(const FSLOwlNode& Node, int32 Depth)
+{
+	if (!Node.Comment.IsEmpty())
+	{
+		WriteChar('\n');
+		WriteIndent(Depth);
+		Write(TEXT("<!-- "));
+		Write(Node.Comment);
+		Write(TEXT(" -->\n"));
+	}
+
+	if (Node.Name.IsEmpty())
+	{
+		return;
+	}
+
+	WriteIndent(Depth);
+	WriteChar('<');
+	WritePrefixName(Node.Name);
+
+	// Every attribute except the last one is followed by a new line
+	for (int32 Idx = 0; Idx < Node.Attributes.Num(); ++Idx)
+	{
+		WriteChar(' ');
+		WriteAttribute(Node.Attributes[Idx]);
+		if (Idx < Node.Attributes.Num() - 1)
+		{
+			WriteChar('\n');
+			WriteIndent(Depth + 1);
+		}
+	}
+}
+
+// Write the closing tag
+void FSLOwlWriter::WriteTagEnd(const FSLOwlPrefixName& Name, int32 Depth)
+{
+	WriteIndent(Depth);
+	Write(TEXT("</"));
+	WritePrefixName(Name);
+	Write(TEXT(">\n"));
+}
+
+// Write the prefixed name
+void FSLOwlWriter::WritePrefixName(const FSLOwlPrefixName& Name)
+{
+	Write(Name.Prefix);
+	if (!Name.LocalName.IsEmpty())
+	{
+		WriteChar(':');
+		Write(Name.LocalName);
+	}
+}
+
+// Write the attribute (key="&ns;value")
+void FSLOwlWriter::WriteAttribute(const FSLOwlAttribute& Attribute)
+{
+	WritePrefixName(Attribute.Key);
+	Write(TEXT("=\""));
+	if (!Attribute.Value.Ns.IsEmpty())
+	{
+		WriteChar('&');
+		Write(Attribute.Value.Ns);
+		WriteChar(';');
+	}
+	Write(Attribute.Value.LocalValue);
+	WriteChar('"');
+}
+
+// Write the indentation
+void FSLOwlWriter::WriteIndent(int32 Depth)
+{
+	for (int32 Idx = 0; Idx < Depth; ++Idx)
+	{
+		Write(INDENT_STEP);
+	}
+}
+
+// Write the string as utf-8
+void FSLOwlWriter::Write(const TCHAR* Str, int32 Len)
+{
+	for (int32 Idx = 0; Idx < Len; ++Idx)
+	{
+		if (Str[Idx] < 0x80)
+		{
+			WriteChar((ANSICHAR)Str[Idx]);
+		}
+		else
+		{
+			// Convert the rest of the string
+			FTCHARToUTF8 Converted(Str + Idx, Len - Idx);
+			Buffer.Append(Converted.Get(), Converted.Length());
+			if (Ar && Buffer.Num() >= FlushSize)
+			{
+				FlushBuffer();
+			}
+			return;
+		}
+	}
+}
+
+// Write the buffer to the file and reset it (keeps the allocation)
+void FSLOwlWriter::FlushBuffer()
+{
+	if (Ar && Buffer.Num() > 0)
+	{
+		Ar->Serialize(Buffer.GetData(), Buffer.Num());
+		Buffer.Reset();
+	}
+}
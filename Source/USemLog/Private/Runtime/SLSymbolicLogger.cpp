@@ -137,6 +137,13 @@ void ASLSymbolicLogger::EndPlay(const EEndPlayReason::Type EndPlayReason)
 	}
 }
 
+// Called before destroying the object, the journal export should not outlive the logger
+void ASLSymbolicLogger::BeginDestroy()
+{
+	EventJournal.WaitForExport();
+	Super::BeginDestroy();
+}
+
 // Init logger (called when the logger is synced externally)
 void ASLSymbolicLogger::Init(const FSLSymbolicLoggerParams& InLoggerParameters,
 	const FSLLoggerLocationParams& InLocationParameters)
@@ -350,6 +357,19 @@ void ASLSymbolicLogger::StartImpl()
 	//	Monitor->Start();
 	//}
 
+	// Journal the finished events instead of keeping them in memory
+	if (LoggerParameters.bWriteEventJournal)
+	{
+		if (EventJournal.Open(GetOutputDirPath() + LocationParameters.EpisodeId + TEXT("_EJ.slej")))
+		{
+			// The pending records are otherwise only written when the next event finishes
+			FTimerDelegate TimerDelegateJournalFlush;
+			TimerDelegateJournalFlush.BindLambda([this] { EventJournal.FlushIfDue(); });
+			GetWorld()->GetTimerManager().SetTimer(EventJournalFlushTimerHandle, TimerDelegateJournalFlush,
+				FMath::Max(EventJournal.GetMaxPendingSeconds(), 0.1f), true);
+		}
+	}
+
 	EpisodeStartTime = GetWorld()->GetTimeSeconds();
 
 	bIsStarted = true;
@@ -426,8 +446,25 @@ void ASLSymbolicLogger::FinishImpl(bool bForced)
 	//}
 	//ContainerMonitors.Empty();
 
+	// The pending events are written, the outputs are created from the journal on a worker thread
+	const bool bEventsJournaled = EventJournal.IsOpen();
+	if (bEventsJournaled)
+	{
+		if (GetWorld())
+		{
+			GetWorld()->GetTimerManager().ClearTimer(EventJournalFlushTimerHandle);
+		}
+		EventJournal.Close();
+		ExportEventJournal();
+
+		// Nothing is left to wait for the export when forced
+		if (bForced)
+		{
+			EventJournal.WaitForExport();
+		}
+	}
 	// Create the experiment owl doc	
-	if (ExperimentDoc.IsValid())
+	else if (ExperimentDoc.IsValid())
 	{
 		TArray<FString> SubActionIds;		
 		for (const auto& Ev : FinishedEvents)
@@ -451,7 +488,10 @@ void ASLSymbolicLogger::FinishImpl(bool bForced)
 	}
 
 	// Write events to file
-	WriteToFile();
+	if (!bEventsJournaled)
+	{
+		WriteToFile();
+	}
 
 #if SL_WITH_ROSBRIDGE
 	// Finish ROS Connection
@@ -502,7 +542,20 @@ void ASLSymbolicLogger::SemanticEventFinishedCallback(TSharedPtr<ISLEvent> Event
 	GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Yellow, FString::Printf(TEXT("%s::%d %s"), *FString(__func__), __LINE__, *Event->ToString()));
 	//UE_LOG(LogTemp,Error , TEXT("%s::%d %s"), *FString(__func__), __LINE__, *Event->ToString());
 	//UE_LOG(LogTemp, Error, TEXT(">> %s::%d %s"), *FString(__func__), __LINE__, *Event->ToString());
-	FinishedEvents.Add(Event);
+	if (EventJournal.IsOpen())
+	{
+		EventJournal.AddEvent(Event);
+
+		// The event is not kept, make the rest call to knowrob now
+		if (fSLKRRestClient)
+		{
+			Event->RESTCallToKnowRob(fSLKRRestClient);
+		}
+	}
+	else
+	{
+		FinishedEvents.Add(Event);
+	}
 
 #if SL_WITH_ROSBRIDGE
 	if (LoggerParameters.bPublishToROS)
@@ -515,7 +568,7 @@ void ASLSymbolicLogger::SemanticEventFinishedCallback(TSharedPtr<ISLEvent> Event
 // Write data to file
 void ASLSymbolicLogger::WriteToFile()
 {
-	const FString DirPath = FPaths::ProjectDir() + "/SL/Tasks/" + LocationParameters.TaskId /*+ TEXT("/Episodes/")*/ + "/";
+	const FString DirPath = GetOutputDirPath();
 
 	// Write events timelines to file
 	if (LoggerParameters.bWriteTimelines)
@@ -548,6 +601,32 @@ void ASLSymbolicLogger::WriteToFile()
 	//}
 }
 
+// Write the owl and timeline files from the event journal in the background
+void ASLSymbolicLogger::ExportEventJournal()
+{
+	FSLEventJournalExportParams Params;
+	Params.ExperimentDoc = MoveTemp(ExperimentDoc);
+	Params.DirPath = GetOutputDirPath();
+	Params.SemanticMapId = LocationParameters.SemanticMapId;
+	Params.TaskId = LocationParameters.TaskId;
+	Params.bOverwrite = LocationParameters.bOverwrite;
+	Params.bWriteTimelines = LoggerParameters.bWriteTimelines;
+	Params.TimelinesParams.bTooltips = true;
+	Params.TimelinesParams.StartTime = EpisodeStartTime;
+	Params.TimelinesParams.EndTime = EpisodeEndTime;
+	Params.TimelinesParams.TaskId = LocationParameters.TaskId;
+	Params.TimelinesParams.EpisodeId = LocationParameters.EpisodeId;
+	Params.TimelinesParams.bOverwrite = LocationParameters.bOverwrite;
+	Params.TimelinesParams.EventsSelection = LoggerParameters.TimelineEventsSelection;
+	EventJournal.ExportAsync(MoveTemp(Params));
+}
+
+// Get the directory of the output files
+FString ASLSymbolicLogger::GetOutputDirPath() const
+{
+	return FPaths::ProjectDir() + "/SL/Tasks/" + LocationParameters.TaskId /*+ TEXT("/Episodes/")*/ + "/";
+}
+
 // Create events doc template
 TSharedPtr<FSLOwlExperiment> ASLSymbolicLogger::CreateEventsDocTemplate(ESLOwlExperimentTemplate TemplateType, const FString& InDocId)
 {
@@ -3,12 +3,7 @@
 
 #include "Runtime/SLWorldStateDBHandler.h"
 #include "Individuals/SLIndividualManager.h"
-
-#include "Individuals/Type/SLBaseIndividual.h"
-#include "Individuals/Type/SLSkeletalIndividual.h"
-#include "Individuals/Type/SLBoneIndividual.h"
-#include "Individuals/Type/SLVirtualBoneIndividual.h"
-#include "Individuals/Type/SLRobotIndividual.h"
+#include "Runtime/SLWorldStateCompactSchema.h"
 
 // UUtils
 #if SL_WITH_ROS_CONVERSIONS
@@ -16,137 +11,230 @@
 #endif // SL_WITH_ROS_CONVERSIONS
 
 /* DB Write Async Task */
+// Dtor
+FSLWorldStateDBWriterAsyncTask::~FSLWorldStateDBWriterAsyncTask()
+{
+#if SL_WITH_LIBMONGO_C
+	if (bulk)
+	{
+		mongoc_bulk_operation_destroy(bulk);
+	}
+	if (insert_opts)
+	{
+		bson_destroy(insert_opts);
+	}
+	if (bulk_opts)
+	{
+		bson_destroy(bulk_opts);
+	}
+#endif //SL_WITH_LIBMONGO_C	
+}
+
 // Init task
 #if SL_WITH_LIBMONGO_C
-bool FSLWorldStateDBWriterAsyncTask::Init(mongoc_collection_t* in_collection, ASLIndividualManager* Manager, float PoseTolerance, bool bInWriteSparse)
+bool FSLWorldStateDBWriterAsyncTask::Init(mongoc_collection_t* in_collection, mongoc_collection_t* in_meta_collection,
+	FSLWorldStateFrameRing* InFrameRing, const FSLWorldStateLoggerParams& InLoggerParameters)
 {
-	IndividualManager = Manager;
 	mongo_collection = in_collection;
-	MinPoseDiff = PoseTolerance;
-	bWriteSparse = bInWriteSparse;
+	mongo_meta_collection = in_meta_collection;
+	FrameRing = InFrameRing;
+	bWriteSparse = InLoggerParameters.bWriteSparse;
+	bCompactSchema = InLoggerParameters.PoseSchema == ESLWorldStatePoseSchema::Compact;
+	BatchSize = InLoggerParameters.bBatchInserts ? FMath::Max(InLoggerParameters.BatchSize, 1) : 1;
+	BatchMaxDelay = InLoggerParameters.BatchMaxDelay;
+
+	// Write concern
+	mongoc_write_concern_t* write_concern = mongoc_write_concern_new();
+	switch (InLoggerParameters.WriteConcern)
+	{
+	case ESLWorldStateWriteConcern::Unacknowledged:
+		mongoc_write_concern_set_w(write_concern, MONGOC_WRITE_CONCERN_W_UNACKNOWLEDGED);
+		break;
+	case ESLWorldStateWriteConcern::Journaled:
+		mongoc_write_concern_set_w(write_concern, 1);
+		mongoc_write_concern_set_journal(write_concern, true);
+		break;
+	case ESLWorldStateWriteConcern::Majority:
+		mongoc_write_concern_set_wmajority(write_concern, 0);
+		break;
+	default:
+		mongoc_write_concern_set_w(write_concern, 1);
+		break;
+	}
+	bAcknowledged = mongoc_write_concern_is_acknowledged(write_concern);
 
-	// Set the write function pointer (first write is without optimization, write all individuals)
-	WriteFunctionPtr = &FSLWorldStateDBWriterAsyncTask::FirstWrite;
+	insert_opts = bson_new();
+	mongoc_write_concern_append(write_concern, insert_opts);
 
-	return true;
+	bulk_opts = bson_new();
+	BSON_APPEND_BOOL(bulk_opts, "ordered", false);
+	mongoc_write_concern_append(write_concern, bulk_opts);
+
+	mongoc_write_concern_destroy(write_concern);
+
+	return mongo_collection != nullptr && FrameRing != nullptr && (!bCompactSchema || mongo_meta_collection != nullptr);
 }
 #endif //SL_WITH_LIBMONGO_C	
 
 // Do the db writing here
 void FSLWorldStateDBWriterAsyncTask::DoWork()
 {
-	const double StartTime = FPlatformTime::Seconds();
-
-	// Call the write function pointer
-	int32 NumEntries = (this->*WriteFunctionPtr)();
+	// Write until the queue is empty
+	int32 SlotIdx = FrameRing->TryDequeue();
+	while (SlotIdx != INDEX_NONE)
+	{
+		const FSLWorldStateFrame& Frame = FrameRing->GetFrame(SlotIdx);
+		if (Frame.Snapshot.IsValid())
+		{
+			WriteFrame(Frame);
+		}
+		else
+		{
+			FrameRing->AddFailed(1);
+		}
+		Snapshot = nullptr;
+		FrameRing->Release(SlotIdx);
+		SlotIdx = FrameRing->TryDequeue();
+	}
 
-	//double Duration = FPlatformTime::Seconds() - StartTime;
-	//UE_LOG(LogTemp, Warning, TEXT("%s::%d \t\t\t Async work (written %ld entries) duration:\t%f (s)"),
-	//	*FString(__FUNCTION__), __LINE__, NumEntries, Duration);
+	// Queue is empty, insert the batch if it waited long enough
+	if (NumBatched > 0 && FPlatformTime::Seconds() - BatchStartTime >= BatchMaxDelay)
+	{
+		FlushBatch();
+	}
 }
 
-// First write where all the individuals are written irregardresly of their previous position
-int32 FSLWorldStateDBWriterAsyncTask::FirstWrite()
+// Insert the batched documents (call only when the task is done, returns the number of inserted documents)
+int32 FSLWorldStateDBWriterAsyncTask::FlushBatch()
 {
-	// Count the number of entries written to the document (if 0, skip upload)
-	int32 Num = 0;
-
+	int32 NumInserted = 0;
 #if SL_WITH_LIBMONGO_C
-	bson_t* ws_doc;
-	ws_doc = bson_new();
-
-	AddTimestamp(ws_doc);
-
-	Num += AddAllIndividuals(ws_doc);
-	Num += AddSkeletalIndividals(ws_doc);
-	//Num += AddRobotIndividuals(ws_doc);
-
-	// Write only if there are any entries in the document
-	if (Num > 0)
+	if (bulk == nullptr || NumBatched == 0)
 	{
-		UploadDoc(ws_doc);
+		return 0;
 	}
 
-	// Clean up
-	bson_destroy(ws_doc);
-#endif //SL_WITH_LIBMONGO_C	
-
-	// Change the write function pointer to write only individuals that are moving
-	if (bWriteSparse)
+	const double StartTime = FPlatformTime::Seconds();
+	bson_t reply;
+	bson_error_t error;
+	if (mongoc_bulk_operation_execute(bulk, &reply, &error))
 	{
-		WriteFunctionPtr = &FSLWorldStateDBWriterAsyncTask::WriteSparse;
+		NumInserted = NumBatched;
 	}
 	else
 	{
-		WriteFunctionPtr = &FSLWorldStateDBWriterAsyncTask::WriteAll;
+		// Unordered bulk, some of the documents might still have been inserted
+		bson_iter_t iter;
+		if (bAcknowledged && bson_iter_init_find(&iter, &reply, "nInserted") && BSON_ITER_HOLDS_INT32(&iter))
+		{
+			NumInserted = bson_iter_int32(&iter);
+		}
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Bulk insert err.: %s (inserted %d/%d)"),
+			*FString(__func__), __LINE__, *FString(error.message), NumInserted, NumBatched);
 	}
+	FrameRing->GetInsertLatency().AddSample(FPlatformTime::Seconds() - StartTime);
+	FrameRing->AddWritten(NumInserted);
+	FrameRing->AddFailed(NumBatched - NumInserted);
 
-	return Num;
+	// Clean up
+	bson_destroy(&reply);
+	mongoc_bulk_operation_destroy(bulk);
+	bulk = nullptr;
+	NumBatched = 0;
+#endif //SL_WITH_LIBMONGO_C
+	return NumInserted;
 }
 
-// Write only the indviduals that changed pose
-int32 FSLWorldStateDBWriterAsyncTask::WriteSparse()
+// Write or batch the given frame, false if the upload failed
+bool FSLWorldStateDBWriterAsyncTask::WriteFrame(const FSLWorldStateFrame& Frame)
 {
+	Snapshot = &Frame.Snapshot;
+
 	// Count the number of entries written to the document (if 0, skip upload)
 	int32 Num = 0;
+	bool bRetVal = true;
 
 #if SL_WITH_LIBMONGO_C
+	const double StartTime = FPlatformTime::Seconds();
+
 	bson_t* ws_doc;
 	ws_doc = bson_new();
 
 	AddTimestamp(ws_doc);
 
-	Num += AddIndividualsThatMoved(ws_doc);
-	Num += AddSkeletalIndividals(ws_doc);
-	//Num += AddRobotIndividuals(ws_doc);
-
-	// Write only if there are any entries in the document
-	if (Num > 0)
+	if (bCompactSchema)
 	{
-		UploadDoc(ws_doc);
-	}
-
-	// Clean up
-	bson_destroy(ws_doc);
-#endif //SL_WITH_LIBMONGO_C
-
-	return Num;
-}
-
-// Write all individuals
-int32 FSLWorldStateDBWriterAsyncTask::WriteAll()
-{
-	// Count the number of entries written to the document (if 0, skip upload)
-	int32 Num = 0;
+		// The frames reference the index layout, (re)write it if it changed
+		if (Snapshot->Layout->Version != WrittenLayoutVersion && WriteCompactLayout())
+		{
+			WrittenLayoutVersion = Snapshot->Layout->Version;
+		}
 
-#if SL_WITH_LIBMONGO_C
-	bson_t* ws_doc;
-	ws_doc = bson_new();
+		// Bones are part of the individuals layout, no separate skeletal entries are needed
+		Num += AddCompactPoses(Frame.bWriteAll || !bWriteSparse, ws_doc);
+	}
+	else
+	{
+		// Sparse readers collect the bones backwards until the last full keyframe
+		if (bWriteSparse)
+		{
+			BSON_APPEND_BOOL(ws_doc, "keyframe", Frame.bWriteAll);
+		}
 
-	AddTimestamp(ws_doc);
+		// First frame is written without optimization, afterwards only the individuals that moved (if sparse)
+		if (Frame.bWriteAll || !bWriteSparse)
+		{
+			Num += AddAllIndividuals(ws_doc);
+		}
+		else
+		{
+			Num += AddIndividualsThatMoved(ws_doc);
+		}
+		Num += AddSkeletalIndividals(Frame.bWriteAll || !bWriteSparse, ws_doc);
+	}
 
-	Num += AddAllIndividuals(ws_doc);
-	Num += AddSkeletalIndividals(ws_doc);
-	//Num += AddRobotIndividuals(ws_doc);
+	const double SerializedTime = FPlatformTime::Seconds();
+	FrameRing->GetSerializationLatency().AddSample(SerializedTime - StartTime);
 
 	// Write only if there are any entries in the document
 	if (Num > 0)
 	{
-		UploadDoc(ws_doc);
+		if (BatchSize > 1)
+		{
+			AddToBatch(ws_doc);
+		}
+		else
+		{
+			bRetVal = UploadDoc(ws_doc);
+			FrameRing->GetInsertLatency().AddSample(FPlatformTime::Seconds() - SerializedTime);
+			if (bRetVal)
+			{
+				FrameRing->AddWritten(1);
+			}
+			else
+			{
+				FrameRing->AddFailed(1);
+			}
+		}
+	}
+	else
+	{
+		// Nothing to write
+		FrameRing->AddWritten(1);
 	}
 
 	// Clean up
 	bson_destroy(ws_doc);
-#endif //SL_WITH_LIBMONGO_C
+#endif //SL_WITH_LIBMONGO_C	
 
-	return Num;
+	return bRetVal;
 }
 
 #if SL_WITH_LIBMONGO_C
 // Add timestamp to the bson doc
 void FSLWorldStateDBWriterAsyncTask::AddTimestamp(bson_t* doc)
 {
-	BSON_APPEND_DOUBLE(doc, "timestamp", Timestamp);
+	BSON_APPEND_DOUBLE(doc, "timestamp", Snapshot->Timestamp);
 }
 
 // Add all individuals (return the number of individuals added)
@@ -156,14 +244,11 @@ int32 FSLWorldStateDBWriterAsyncTask::AddAllIndividuals(bson_t* doc)
 	bson_t arr_obj;
 	uint32_t arr_idx = 0;
 
+	const FSLIndividualPoseLayout& Layout = *Snapshot->Layout;
+
 	BSON_APPEND_ARRAY_BEGIN(doc, "individuals", &arr_obj);
-	for (const auto& Individual : IndividualManager->GetIndividuals())
+	for (int32 PoseIdx = 0; PoseIdx < Layout.Num(); ++PoseIdx)
 	{
-		Individual->UpdateCachedPose(0.0);
-
-		//// TODO workaround
-		//Individual->SetHasMovedFlag(true);
-
 		bson_t individual_obj;
 		char idx_str[16];
 		const char* idx_key;
@@ -171,9 +256,9 @@ int32 FSLWorldStateDBWriterAsyncTask::AddAllIndividuals(bson_t* doc)
 		bson_uint32_to_string(arr_idx, &idx_key, idx_str, sizeof idx_str);
 		BSON_APPEND_DOCUMENT_BEGIN(&arr_obj, idx_key, &individual_obj);
 			// Id
-			BSON_APPEND_UTF8(&individual_obj, "id", TCHAR_TO_UTF8(*Individual->GetIdValue()));			
+			BSON_APPEND_UTF8(&individual_obj, "id", TCHAR_TO_UTF8(*Layout.Ids[PoseIdx]));
 			// Pose
-			AddPose(Individual->GetCachedPose(), &individual_obj);
+			AddPose(Snapshot->GetPose(PoseIdx), &individual_obj);
 		bson_append_document_end(&arr_obj, &individual_obj);
 
 		arr_idx++;
@@ -191,79 +276,86 @@ int32 FSLWorldStateDBWriterAsyncTask::AddIndividualsThatMoved(bson_t* doc)
 	bson_t individuals_arr;
 	uint32_t arr_idx = 0;
 
+	const FSLIndividualPoseLayout& Layout = *Snapshot->Layout;
+
 	BSON_APPEND_ARRAY_BEGIN(doc, "individuals", &individuals_arr);
-	for (const auto& Individual : IndividualManager->GetIndividuals())
+	for (TConstSetBitIterator<> MovedItr(Snapshot->Moved); MovedItr; ++MovedItr)
 	{
-		if (Individual->UpdateCachedPose(MinPoseDiff))
-		{
-			//// TODO workaround
-			//Individual->SetHasMovedFlag(true);
-
-			bson_t individual_obj;
-			char idx_str[16];
-			const char* idx_key;
-
-			bson_uint32_to_string(arr_idx, &idx_key, idx_str, sizeof idx_str);
-			BSON_APPEND_DOCUMENT_BEGIN(&individuals_arr, idx_key, &individual_obj);
-				// Id
-				BSON_APPEND_UTF8(&individual_obj, "id", TCHAR_TO_UTF8(*Individual->GetIdValue()));
-				// Pose
-				AddPose(Individual->GetCachedPose(), &individual_obj);
-			bson_append_document_end(&individuals_arr, &individual_obj);
-
-			arr_idx++;
-			Num++;
-		}
+		const int32 PoseIdx = MovedItr.GetIndex();
+
+		bson_t individual_obj;
+		char idx_str[16];
+		const char* idx_key;
+
+		bson_uint32_to_string(arr_idx, &idx_key, idx_str, sizeof idx_str);
+		BSON_APPEND_DOCUMENT_BEGIN(&individuals_arr, idx_key, &individual_obj);
+			// Id
+			BSON_APPEND_UTF8(&individual_obj, "id", TCHAR_TO_UTF8(*Layout.Ids[PoseIdx]));
+			// Pose
+			AddPose(Snapshot->GetPose(PoseIdx), &individual_obj);
+		bson_append_document_end(&individuals_arr, &individual_obj);
+
+		arr_idx++;
+		Num++;
 	}
 	bson_append_array_end(doc, &individuals_arr);
 	return Num;
 }
 
-// Add skeletal individuals (return the number of individuals added)
-int32 FSLWorldStateDBWriterAsyncTask::AddSkeletalIndividals(bson_t* doc)
+// Add skeletal individuals, all or only the ones with a moved root or bone (return the number of individuals added)
+int32 FSLWorldStateDBWriterAsyncTask::AddSkeletalIndividals(bool bWriteAll, bson_t* doc)
 {
 	int32 Num = 0;
 	bson_t arr_obj;
 	uint32_t arr_idx = 0;
 
+	const FSLIndividualPoseLayout& Layout = *Snapshot->Layout;
+
 	BSON_APPEND_ARRAY_BEGIN(doc, "skel_individuals", &arr_obj);
-	for (const auto& SkelIndividual : IndividualManager->GetSkeletalIndividuals())
-	{
-		//// Check if it was marked as "moved" by the previous iterator function
-		//if (SkelIndividual->HasMovedFlagSet())
-		//{
-		//	SkelIndividual->SetHasMovedFlag(false);
-
-			bson_t individual_obj;
-			char idx_str[16];
-			const char* idx_key;
-
-			bson_uint32_to_string(arr_idx, &idx_key, idx_str, sizeof idx_str);
-			BSON_APPEND_DOCUMENT_BEGIN(&arr_obj, idx_key, &individual_obj);
-				// Id
-				BSON_APPEND_UTF8(&individual_obj, "id", TCHAR_TO_UTF8(*SkelIndividual->GetIdValue()));
-				// Pose
-				AddPose(SkelIndividual->GetCachedPose(), &individual_obj);
-				// Bones
-				AddSkeletalBoneIndividuals(SkelIndividual->GetBoneIndividuals(), SkelIndividual->GetVirtualBoneIndividuals(),
-					&individual_obj);
-				// Constraints
-				//AddSkeletalConstraintIndividuals(SkelIndividual->GetBoneConstraintIndividuals(), &individual_obj);
-			bson_append_document_end(&arr_obj, &individual_obj);
-
-			arr_idx++;
-			Num++;
-		//}
+	for (int32 SkelIdx = 0; SkelIdx < Layout.NumSkeletal(); ++SkelIdx)
+	{
+		const int32 PoseIdx = Layout.SkeletalPoseIndices[SkelIdx];
+
+		// Skip the skeletal individual if neither the root nor any of its bones moved
+		if (!bWriteAll && !Snapshot->Moved[PoseIdx])
+		{
+			int32 FirstBone;
+			int32 LastBone;
+			Layout.GetBoneRange(SkelIdx, FirstBone, LastBone);
+			bool bAnyBoneMoved = false;
+			for (int32 BoneSlot = FirstBone; BoneSlot < LastBone && !bAnyBoneMoved; ++BoneSlot)
+			{
+				bAnyBoneMoved = Snapshot->Moved[Layout.BonePoseIndices[BoneSlot]];
+			}
+			if (!bAnyBoneMoved)
+			{
+				continue;
+			}
+		}
+
+		bson_t individual_obj;
+		char idx_str[16];
+		const char* idx_key;
+
+		bson_uint32_to_string(arr_idx, &idx_key, idx_str, sizeof idx_str);
+		BSON_APPEND_DOCUMENT_BEGIN(&arr_obj, idx_key, &individual_obj);
+			// Id
+			BSON_APPEND_UTF8(&individual_obj, "id", TCHAR_TO_UTF8(*Layout.Ids[PoseIdx]));
+			// Pose (the root pose is always written, readers expect it with every entry)
+			AddPose(Snapshot->GetPose(PoseIdx), &individual_obj);
+			// Bones
+			AddSkeletalBoneIndividuals(SkelIdx, bWriteAll, &individual_obj);
+		bson_append_document_end(&arr_obj, &individual_obj);
+
+		arr_idx++;
+		Num++;
 	}
 	bson_append_array_end(doc, &arr_obj);
 	return Num;
 }
 
-// Add skeletal bones to the document
-void FSLWorldStateDBWriterAsyncTask::AddSkeletalBoneIndividuals(
-	const TArray<USLBoneIndividual*>& BoneIndividuals,
-	const TArray<USLVirtualBoneIndividual*>& VirtualBoneIndividuals,
-	bson_t* doc)
+// Add skeletal bones (all or only the moved ones) of the given skeletal layout index to the document
+void FSLWorldStateDBWriterAsyncTask::AddSkeletalBoneIndividuals(int32 SkelIdx, bool bWriteAll, bson_t* doc)
 {
 	bson_t bones_arr;
 	bson_t arr_obj;
@@ -271,82 +363,32 @@ void FSLWorldStateDBWriterAsyncTask::AddSkeletalBoneIndividuals(
 	const char* idx_key;
 	uint32_t arr_idx = 0;
 
-	BSON_APPEND_ARRAY_BEGIN(doc, "bones", &bones_arr);
+	const FSLIndividualPoseLayout& Layout = *Snapshot->Layout;
+	int32 FirstBone;
+	int32 LastBone;
+	Layout.GetBoneRange(SkelIdx, FirstBone, LastBone);
 
-	for (const auto& BI : BoneIndividuals)
+	BSON_APPEND_ARRAY_BEGIN(doc, "bones", &bones_arr);
+	for (int32 BoneSlot = FirstBone; BoneSlot < LastBone; ++BoneSlot)
 	{
-		bson_uint32_to_string(arr_idx, &idx_key, idx_str, sizeof idx_str);
-		BSON_APPEND_DOCUMENT_BEGIN(&bones_arr, idx_key, &arr_obj);
-			// Bone index
-			BSON_APPEND_INT32(&arr_obj, "idx", BI->GetBoneIndex());
-			// Bone world pose
-			AddPose(BI->GetCachedPose(), &arr_obj);
-		bson_append_document_end(&bones_arr, &arr_obj);
-		arr_idx++;
-	}
+		const int32 BonePoseIdx = Layout.BonePoseIndices[BoneSlot];
+		if (!bWriteAll && !Snapshot->Moved[BonePoseIdx])
+		{
+			continue;
+		}
 
-	for (const auto& VBI : VirtualBoneIndividuals)
-	{
 		bson_uint32_to_string(arr_idx, &idx_key, idx_str, sizeof idx_str);
 		BSON_APPEND_DOCUMENT_BEGIN(&bones_arr, idx_key, &arr_obj);
 			// Bone index
-			BSON_APPEND_INT32(&arr_obj, "idx", VBI->GetBoneIndex());
+			BSON_APPEND_INT32(&arr_obj, "idx", Layout.BoneIndices[BoneSlot]);
 			// Bone world pose
-			AddPose(VBI->GetCachedPose(), &arr_obj);
+			AddPose(Snapshot->GetPose(BonePoseIdx), &arr_obj);
 		bson_append_document_end(&bones_arr, &arr_obj);
 		arr_idx++;
 	}
-
-
 	bson_append_array_end(doc, &bones_arr);
 }
 
-// Add skeletal bone constraints to the document
-void FSLWorldStateDBWriterAsyncTask::AddSkeletalConstraintIndividuals(const TArray<USLBoneConstraintIndividual*>& ConstraintIndividuals,
-	bson_t* doc)
-{
-}
-
-// Add robot individuals (return the number of individuals added)
-int32 FSLWorldStateDBWriterAsyncTask::AddRobotIndividuals(bson_t* doc)
-{
-	int32 Num = 0;
-	bson_t arr_obj;
-	uint32_t arr_idx = 0;
-
-	BSON_APPEND_ARRAY_BEGIN(doc, "robo_individuals", &arr_obj);
-	for (const auto& RoboIndividual : IndividualManager->GetRobotIndividuals())
-	{
-		//// Check if it was marked as "moved" by the previous iterator function
-		//if (RoboIndividual->HasMovedFlagSet())
-		//{
-		//	RoboIndividual->SetHasMovedFlag(false);
-
-			bson_t individual_obj;
-			char idx_str[16];
-			const char* idx_key;
-
-			bson_uint32_to_string(arr_idx, &idx_key, idx_str, sizeof idx_str);
-			BSON_APPEND_DOCUMENT_BEGIN(&arr_obj, idx_key, &individual_obj);
-				// Id
-				BSON_APPEND_UTF8(&individual_obj, "id", TCHAR_TO_UTF8(*RoboIndividual->GetIdValue()));
-				// Pose
-				AddPose(RoboIndividual->GetCachedPose(), &individual_obj);
-
-				// Links				
-
-				// Joints
-
-			bson_append_document_end(&arr_obj, &individual_obj);
-
-			arr_idx++;
-			Num++;
-		//}
-	}
-	bson_append_array_end(doc, &arr_obj);
-	return Num;
-}
-
 // Add pose document
 void FSLWorldStateDBWriterAsyncTask::AddPose(FTransform Pose, bson_t* doc)
 {
@@ -401,11 +443,124 @@ void FSLWorldStateDBWriterAsyncTask::AddPose(FTransform Pose, bson_t* doc)
 	bson_append_array_end(doc, &child_pose);
 }
 
+// Add the layout version and the packed poses (all or only the moved ones) as binary (return the number of poses added)
+int32 FSLWorldStateDBWriterAsyncTask::AddCompactPoses(bool bWriteAll, bson_t* doc)
+{
+	const FSLIndividualPoseLayout& Layout = *Snapshot->Layout;
+
+	CompactIndexBuffer.Reset();
+	if (!bWriteAll)
+	{
+		// Set bits are iterated in ascending order, the query side relies on it
+		for (TConstSetBitIterator<> MovedItr(Snapshot->Moved); MovedItr; ++MovedItr)
+		{
+			CompactIndexBuffer.Add(static_cast<uint32>(MovedItr.GetIndex()));
+		}
+	}
+
+	const int32 Num = bWriteAll ? Layout.Num() : CompactIndexBuffer.Num();
+	if (Num == 0)
+	{
+		return 0;
+	}
+
+	CompactPoseBuffer.SetNumUninitialized(Num * FSLWorldStateCompactSchema::PoseSize, false);
+	for (int32 Idx = 0; Idx < Num; ++Idx)
+	{
+		FTransform Pose = Snapshot->GetPose(bWriteAll ? Idx : static_cast<int32>(CompactIndexBuffer[Idx]));
+#if SL_WITH_ROS_CONVERSIONS
+		FConversions::UToROS(Pose);
+#endif // SL_WITH_ROS_CONVERSIONS
+		FSLWorldStateCompactSchema::PackPose(Pose, CompactPoseBuffer.GetData() + Idx * FSLWorldStateCompactSchema::PoseSize);
+	}
+
+	BSON_APPEND_INT32(doc, "layout", Layout.Version);
+	BSON_APPEND_BINARY(doc, "poses", BSON_SUBTYPE_BINARY, CompactPoseBuffer.GetData(), CompactPoseBuffer.Num());
+	if (!bWriteAll)
+	{
+		BSON_APPEND_BINARY(doc, "idx", BSON_SUBTYPE_BINARY,
+			reinterpret_cast<const uint8_t*>(CompactIndexBuffer.GetData()), Num * FSLWorldStateCompactSchema::IndexSize);
+	}
+	return Num;
+}
+
+// Upsert the index to id layout of the current snapshot into the meta collection
+bool FSLWorldStateDBWriterAsyncTask::WriteCompactLayout()
+{
+	const FSLIndividualPoseLayout& Layout = *Snapshot->Layout;
+
+	// Every writer upserts the layouts it uses, the selector makes it idempotent
+	bson_t* selector = bson_new();
+	BSON_APPEND_UTF8(selector, "type_id", FSLWorldStateCompactSchema::LayoutTypeId);
+	BSON_APPEND_UTF8(selector, "episode_id", mongoc_collection_get_name(mongo_collection));
+	BSON_APPEND_INT32(selector, "layout", Layout.Version);
+
+	bson_t* layout_doc = bson_copy(selector);
+	char idx_str[16];
+	const char* idx_key;
+
+	// Ids in pose index order
+	bson_t ids_arr;
+	BSON_APPEND_ARRAY_BEGIN(layout_doc, "ids", &ids_arr);
+	for (int32 PoseIdx = 0; PoseIdx < Layout.Num(); ++PoseIdx)
+	{
+		bson_uint32_to_string(PoseIdx, &idx_key, idx_str, sizeof idx_str);
+		BSON_APPEND_UTF8(&ids_arr, idx_key, TCHAR_TO_UTF8(*Layout.Ids[PoseIdx]));
+	}
+	bson_append_array_end(layout_doc, &ids_arr);
+
+	// Skeletal individuals with their bone indices
+	bson_t skel_arr;
+	BSON_APPEND_ARRAY_BEGIN(layout_doc, "skel", &skel_arr);
+	for (int32 SkelIdx = 0; SkelIdx < Layout.NumSkeletal(); ++SkelIdx)
+	{
+		bson_t skel_obj;
+		bson_uint32_to_string(SkelIdx, &idx_key, idx_str, sizeof idx_str);
+		BSON_APPEND_DOCUMENT_BEGIN(&skel_arr, idx_key, &skel_obj);
+			BSON_APPEND_INT32(&skel_obj, "idx", Layout.SkeletalPoseIndices[SkelIdx]);
+
+			int32 FirstBone;
+			int32 LastBone;
+			Layout.GetBoneRange(SkelIdx, FirstBone, LastBone);
+
+			bson_t bones_arr;
+			BSON_APPEND_ARRAY_BEGIN(&skel_obj, "bones", &bones_arr);
+			for (int32 BoneSlot = FirstBone; BoneSlot < LastBone; ++BoneSlot)
+			{
+				bson_t bone_obj;
+				bson_uint32_to_string(BoneSlot - FirstBone, &idx_key, idx_str, sizeof idx_str);
+				BSON_APPEND_DOCUMENT_BEGIN(&bones_arr, idx_key, &bone_obj);
+					BSON_APPEND_INT32(&bone_obj, "idx", Layout.BoneIndices[BoneSlot]);
+					BSON_APPEND_INT32(&bone_obj, "pose_idx", Layout.BonePoseIndices[BoneSlot]);
+				bson_append_document_end(&bones_arr, &bone_obj);
+			}
+			bson_append_array_end(&skel_obj, &bones_arr);
+		bson_append_document_end(&skel_arr, &skel_obj);
+	}
+	bson_append_array_end(layout_doc, &skel_arr);
+
+	bson_t* opts = BCON_NEW("upsert", BCON_BOOL(true));
+	bson_error_t error;
+	bool bRetVal = true;
+	if (!mongoc_collection_replace_one(mongo_meta_collection, selector, layout_doc, opts, NULL, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not write the pose layout %d, err.: %s"),
+			*FString(__func__), __LINE__, Layout.Version, *FString(error.message));
+		bRetVal = false;
+	}
+
+	// Clean up
+	bson_destroy(opts);
+	bson_destroy(layout_doc);
+	bson_destroy(selector);
+	return bRetVal;
+}
+
 // Write the bson doc to the meta_coll
 bool FSLWorldStateDBWriterAsyncTask::UploadDoc(bson_t* doc)
 {
 	bson_error_t error;
-	if (!mongoc_collection_insert_one(mongo_collection, doc, NULL, NULL, &error))
+	if (!mongoc_collection_insert_one(mongo_collection, doc, insert_opts, NULL, &error))
 	{
 		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.: %s"),
 			*FString(__func__), __LINE__, *FString(error.message));
@@ -413,6 +568,32 @@ bool FSLWorldStateDBWriterAsyncTask::UploadDoc(bson_t* doc)
 	}
 	return true;
 }
+
+// Add the bson doc to the bulk operation, flush if the batch is full
+void FSLWorldStateDBWriterAsyncTask::AddToBatch(bson_t* doc)
+{
+	if (bulk == nullptr)
+	{
+		bulk = mongoc_collection_create_bulk_operation_with_opts(mongo_collection, bulk_opts);
+		BatchStartTime = FPlatformTime::Seconds();
+	}
+
+	// The document is copied into the bulk operation
+	bson_error_t error;
+	if (!mongoc_bulk_operation_insert_with_opts(bulk, doc, NULL, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Err.: %s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+		FrameRing->AddFailed(1);
+		return;
+	}
+	NumBatched++;
+
+	if (NumBatched >= BatchSize || FPlatformTime::Seconds() - BatchStartTime >= BatchMaxDelay)
+	{
+		FlushBatch();
+	}
+}
 #endif //SL_WITH_LIBMONGO_C	
 
 
@@ -423,7 +604,17 @@ FSLWorldStateDBHandler::FSLWorldStateDBHandler()
 {
 	bIsFinished = false;
 	bIsInit = false;
-	DBWriterTask = nullptr;
+	IndividualManager = nullptr;
+	bWriteSparse = true;
+	KeyframeInterval = 0.f;
+	LastKeyframeTs = 0.f;
+#if SL_WITH_LIBMONGO_C
+	bMongocInit = false;
+	uri = nullptr;
+	client = nullptr;
+	database = nullptr;
+	collection = nullptr;
+#endif //SL_WITH_LIBMONGO_C
 }
 
 // Dtor
@@ -436,46 +627,85 @@ FSLWorldStateDBHandler::~FSLWorldStateDBHandler()
 }
 
 // Connect to the db and set up the async writer
-bool FSLWorldStateDBHandler::Init(ASLIndividualManager* IndividualManager,
+bool FSLWorldStateDBHandler::Init(ASLIndividualManager* InIndividualManager,
 	const FSLWorldStateLoggerParams& InLoggerParameters,
 	const FSLLoggerLocationParams& InLocationParameters,
 	const FSLLoggerDBServerParams& InDBServerParameters)
 {
+	IndividualManager = InIndividualManager;
+	SparseTolerance.Pose = InLoggerParameters.PoseTolerance;
+	SparseTolerance.BoneLocation = InLoggerParameters.BoneLocationTolerance;
+	SparseTolerance.BoneRotation = InLoggerParameters.BoneRotationTolerance;
+	bWriteSparse = InLoggerParameters.bWriteSparse;
+	KeyframeInterval = InLoggerParameters.KeyframeInterval;
+
 	// Connect to the database
 	if (!Connect(InLocationParameters.TaskId, InLocationParameters.EpisodeId, 
 		InDBServerParameters.Ip, InDBServerParameters.Port,
 		InLocationParameters.bOverwrite))
 	{
 		UE_LOG(LogTemp, Error, TEXT("%s::%d World state writer DB handler could not connect to the database.."), *FString(__FUNCTION__), __LINE__);
+		Disconnect();
 		return false;
 	}
 
 	// Write metadata if needed
 	if (InLoggerParameters.bIncludeMetadata)
 	{
-		WriteMetadata(IndividualManager, InLocationParameters.TaskId + ".meta", InLoggerParameters.bOverwriteMetadata);
+		WriteMetadata(InLocationParameters.TaskId + ".meta", InLoggerParameters.bOverwriteMetadata);
 	}
 
-	// Create the async worker
-	if (DBWriterTask == nullptr)
-	{
-		DBWriterTask = new FAsyncTask<FSLWorldStateDBWriterAsyncTask>();
-	}
-	else
-	{
-		UE_LOG(LogTemp, Warning, TEXT("%s::%d World state async writer should be nullptr here.."),
-			*FString(__FUNCTION__), __LINE__);
-	}
+	// Preallocate the frame queue (at least one free slot for every writer plus the game thread)
+	const int32 NumWorkers = FMath::Max(InLoggerParameters.NumWriterWorkers, 1);
+	FrameRing.Init(FMath::Max(InLoggerParameters.QueueSize, NumWorkers + 2),
+		InLoggerParameters.QueuePolicy, InLoggerParameters.MaxBlockTime);
 
 #if SL_WITH_LIBMONGO_C
-	// Set worker parameters
-	if (!DBWriterTask->GetTask().Init(collection, IndividualManager, InLoggerParameters.PoseTolerance, InLoggerParameters.bWriteSparse))
+	// Every additional writer uses its own connection
+	if (!ConnectWorkers(NumWorkers))
 	{
-		UE_LOG(LogTemp, Error, TEXT("%s::%d World state async writer could not be initialized.."),
+		UE_LOG(LogTemp, Error, TEXT("%s::%d World state writers could not connect to the database.."),
 			*FString(__FUNCTION__), __LINE__);
 		Disconnect();
 		return false;
 	}
+
+	// Create the async workers
+	if (DBWriterTasks.Num() > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d World state async writers should be empty here.."),
+			*FString(__FUNCTION__), __LINE__);
+	}
+	const bool bCompactSchema = InLoggerParameters.PoseSchema == ESLWorldStatePoseSchema::Compact;
+	const FString MetaCollName = InLocationParameters.TaskId + ".meta";
+	for (int32 WorkerIdx = 0; WorkerIdx < NumWorkers; ++WorkerIdx)
+	{
+		mongoc_collection_t* worker_collection = WorkerIdx == 0 ? collection : worker_collections[WorkerIdx - 1];
+		mongoc_collection_t* worker_meta_collection = nullptr;
+		if (bCompactSchema)
+		{
+			// The compact layouts are written by the writers, using their own connection
+			worker_meta_collection = WorkerIdx == 0
+				? mongoc_database_get_collection(database, TCHAR_TO_UTF8(*MetaCollName))
+				: mongoc_client_get_collection(worker_clients[WorkerIdx - 1], mongoc_database_get_name(database), TCHAR_TO_UTF8(*MetaCollName));
+			worker_meta_collections.Add(worker_meta_collection);
+		}
+		FAsyncTask<FSLWorldStateDBWriterAsyncTask>* DBWriterTask = new FAsyncTask<FSLWorldStateDBWriterAsyncTask>();
+		if (!DBWriterTask->GetTask().Init(worker_collection, worker_meta_collection, &FrameRing, InLoggerParameters))
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d World state async writer could not be initialized.."),
+				*FString(__FUNCTION__), __LINE__);
+			delete DBWriterTask;
+			for (auto& PrevDBWriterTask : DBWriterTasks)
+			{
+				delete PrevDBWriterTask;
+			}
+			DBWriterTasks.Empty();
+			Disconnect();
+			return false;
+		}
+		DBWriterTasks.Add(DBWriterTask);
+	}
 #else
 	UE_LOG(LogTemp, Error, TEXT("%s::%d SL_WITH_LIBMONGO_C flag is 0, aborting.."),
 		*FString(__func__), __LINE__);
@@ -486,15 +716,18 @@ bool FSLWorldStateDBHandler::Init(ASLIndividualManager* IndividualManager,
 	return true;
 }
 
-// Delegate first job to the async task
+// Snapshot all the poses and queue them for writing
 void FSLWorldStateDBHandler::FirstWrite(float Timestamp)
 {
 	PrevWriteCallTime = FPlatformTime::Seconds();
-	DBWriterTask->GetTask().SetTimestamp(Timestamp);
-	DBWriterTask->StartBackgroundTask();
+
+	// First write caches every pose, irregardless of the tolerance
+	LastKeyframeTs = Timestamp;
+	EnqueueFrame(Timestamp, FSLIndividualPoseTolerance(), true);
+	StartIdleWriterTasks();
 }
 
-// Delegate job to the async task (true if the previous job was done)
+// Snapshot the poses and queue them for writing (false if a frame was dropped or coalesced)
 bool FSLWorldStateDBHandler::Write(float Timestamp)
 {
 	//double CurrentTime = FPlatformTime::Seconds();
@@ -503,20 +736,20 @@ bool FSLWorldStateDBHandler::Write(float Timestamp)
 	//UE_LOG(LogTemp, Warning, TEXT("%s::%d \t\t Duration since previous call:\t%f (s)"),
 	//	*FString(__func__), __LINE__, DurationSincePrevCall);
 
-	if (DBWriterTask->IsDone())
-	{
-		DBWriterTask->GetTask().SetTimestamp(Timestamp);
-		DBWriterTask->StartBackgroundTask();
-		return true;
-	}
-	else
+	// Periodically write a full keyframe in sparse mode so readers can resync without replaying from the start
+	bool bWriteAll = !bWriteSparse;
+	if (bWriteSparse && KeyframeInterval > 0.f && Timestamp - LastKeyframeTs >= KeyframeInterval)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("%s::%d [%f] Current db write async task is not finished yet, trying again next update call.."), *FString(__func__), __LINE__, Timestamp);
-		return false;
+		LastKeyframeTs = Timestamp;
+		bWriteAll = true;
 	}
+
+	const bool bRetVal = EnqueueFrame(Timestamp, bWriteSparse ? SparseTolerance : FSLIndividualPoseTolerance(), bWriteAll);
+	StartIdleWriterTasks();
+	return bRetVal;
 }
 
-// Disconnect from db, clear task
+// Write the remaining frames, disconnect from db, clear tasks
 void FSLWorldStateDBHandler::Finish()
 {
 	if (bIsFinished)
@@ -524,31 +757,42 @@ void FSLWorldStateDBHandler::Finish()
 		UE_LOG(LogTemp, Log, TEXT("%s::%d World state db handler is already finished.."), *FString(__FUNCTION__), __LINE__);
 		return;
 	}
+
+	// Nothing to write if the init failed (the connection is already released)
+	if (!bIsInit)
+	{
+		Disconnect();
+		bIsFinished = true;
+		return;
+	}
 	
-	// Wait for writer to finish
-	if (DBWriterTask != nullptr)
+	// Wait for the writers to finish
+	for (auto& DBWriterTask : DBWriterTasks)
 	{
-		if (DBWriterTask->IsDone())
+		if (!DBWriterTask->IsDone() && !DBWriterTask->WaitCompletionWithTimeout(0.5f))
 		{
-			delete DBWriterTask;
-			DBWriterTask = nullptr;
-		}
-		else
-		{
-			if (DBWriterTask->WaitCompletionWithTimeout(0.5f))
-			{
-				delete DBWriterTask;
-				DBWriterTask = nullptr;
-			}
-			else
-			{
-				UE_LOG(LogTemp, Error, TEXT("%s::%d Task not completed, and writer was killed.."), *FString(__FUNCTION__), __LINE__);
-				delete DBWriterTask;
-				DBWriterTask = nullptr;
-			}
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d Writer task not completed yet, waiting for it to finish.."), *FString(__FUNCTION__), __LINE__);
+			DBWriterTask->EnsureCompletion();
 		}
 	}
 
+	// Write any remaining frames on the calling thread
+	if (DBWriterTasks.Num() > 0 && FrameRing.HasQueued())
+	{
+		UE_LOG(LogTemp, Log, TEXT("%s::%d Writing %d remaining frames.."), *FString(__FUNCTION__), __LINE__, FrameRing.NumPending());
+		DBWriterTasks[0]->StartSynchronousTask();
+	}
+
+	// Insert the remaining batched documents
+	for (auto& DBWriterTask : DBWriterTasks)
+	{
+		DBWriterTask->GetTask().FlushBatch();
+		delete DBWriterTask;
+	}
+	DBWriterTasks.Empty();
+
+	UE_LOG(LogTemp, Log, TEXT("%s::%d World state writer stats: %s"), *FString(__FUNCTION__), __LINE__, *FrameRing.GetStats().ToString());
+
 	// Finish up handler
 	CreateIndexes();
 	Disconnect();
@@ -557,6 +801,42 @@ void FSLWorldStateDBHandler::Finish()
 	bIsFinished = true;
 }
 
+// Snapshot the poses into the queue (false if a frame was dropped or coalesced)
+bool FSLWorldStateDBHandler::EnqueueFrame(float Timestamp, const FSLIndividualPoseTolerance& Tolerance, bool bWriteAll)
+{
+	bool bMerged = false;
+	const int32 SlotIdx = FrameRing.BeginEnqueue(bMerged, [this]() { StartIdleWriterTasks(); });
+	if (SlotIdx == INDEX_NONE)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d [%f] No free frame slot available, skipping frame.."), *FString(__func__), __LINE__, Timestamp);
+		return false;
+	}
+
+	// When taking over a queued sparse frame, its moved flags are kept so no change is lost
+	FSLWorldStateFrame& Frame = FrameRing.GetFrame(SlotIdx);
+	IndividualManager->CachePosesToSnapshot(Tolerance, Timestamp, Frame.Snapshot, bMerged && bWriteSparse);
+	FrameRing.EndEnqueue(SlotIdx, bWriteAll, bMerged);
+	return !bMerged;
+}
+
+// Start the idle writers (pending batched documents also restart them, so the batch delay is checked every update)
+void FSLWorldStateDBHandler::StartIdleWriterTasks()
+{
+	int32 NumToStart = FrameRing.NumPending();
+	for (auto& DBWriterTask : DBWriterTasks)
+	{
+		if (NumToStart <= 0)
+		{
+			break;
+		}
+		if (DBWriterTask->IsDone())
+		{
+			DBWriterTask->StartBackgroundTask();
+			NumToStart--;
+		}
+	}
+}
+
 // Connect to the db
 bool FSLWorldStateDBHandler::Connect(const FString& DBName, const FString& CollName, const FString& ServerIp,
 		uint16 ServerPort, bool bOverwrite)
@@ -564,6 +844,7 @@ bool FSLWorldStateDBHandler::Connect(const FString& DBName, const FString& CollN
 #if SL_WITH_LIBMONGO_C
 	// Required to initialize libmongoc's internals	
 	mongoc_init();
+	bMongocInit = true;
 
 	// Stores any error that might appear during the connection
 	bson_error_t error;
@@ -640,8 +921,30 @@ bool FSLWorldStateDBHandler::Connect(const FString& DBName, const FString& CollN
 #endif //SL_WITH_LIBMONGO_C
 }
 
+#if SL_WITH_LIBMONGO_C
+// Create a separate connection for every additional writer
+bool FSLWorldStateDBHandler::ConnectWorkers(int32 NumWorkers)
+{
+	const char* db_name = mongoc_database_get_name(database);
+	const char* coll_name = mongoc_collection_get_name(collection);
+	for (int32 WorkerIdx = 1; WorkerIdx < NumWorkers; ++WorkerIdx)
+	{
+		mongoc_client_t* worker_client = mongoc_client_new_from_uri(uri);
+		if (!worker_client)
+		{
+			return false;
+		}
+		mongoc_client_set_appname(worker_client,
+			TCHAR_TO_UTF8(*FString::Printf(TEXT("SL_WorldStateWriter_%s_%d"), UTF8_TO_TCHAR(coll_name), WorkerIdx)));
+		worker_clients.Add(worker_client);
+		worker_collections.Add(mongoc_client_get_collection(worker_client, db_name, coll_name));
+	}
+	return true;
+}
+#endif //SL_WITH_LIBMONGO_C	
+
 // Write metadata (collname + .meta)
-bool FSLWorldStateDBHandler::WriteMetadata(ASLIndividualManager* IndividualManager, const FString& MetaCollName, bool bOverwrite)
+bool FSLWorldStateDBHandler::WriteMetadata(const FString& MetaCollName, bool bOverwrite)
 {
 #if SL_WITH_LIBMONGO_C
 	bson_error_t error;
@@ -690,7 +993,7 @@ bool FSLWorldStateDBHandler::WriteMetadata(ASLIndividualManager* IndividualManag
 	BSON_APPEND_UTF8(meta_doc, "type_id", "individuals");
 
 	// Add individuals data
-	int32 Num = AddIndividualsMetadata(IndividualManager, meta_doc);
+	int32 Num = AddIndividualsMetadata(meta_doc);
 
 	bool RetVal = true;
 	if(Num > 0)
@@ -723,7 +1026,7 @@ bool FSLWorldStateDBHandler::WriteMetadata(ASLIndividualManager* IndividualManag
 }
 
 #if SL_WITH_LIBMONGO_C
-int32 FSLWorldStateDBHandler::AddIndividualsMetadata(ASLIndividualManager* IndividualManager, bson_t* doc)
+int32 FSLWorldStateDBHandler::AddIndividualsMetadata(bson_t* doc)
 {
 	int32 Num = 0;
 	bson_t arr_obj;
@@ -754,27 +1057,51 @@ int32 FSLWorldStateDBHandler::AddIndividualsMetadata(ASLIndividualManager* Indiv
 }
 #endif //SL_WITH_LIBMONGO_C	
 	
-void FSLWorldStateDBHandler::Disconnect() const
+// Disconnect and clean db connection (the handles are reset, safe to call multiple times)
+void FSLWorldStateDBHandler::Disconnect()
 {
 #if SL_WITH_LIBMONGO_C
 	// Release handles and clean up mongoc
-	if (uri)
+	for (mongoc_collection_t* worker_meta_collection : worker_meta_collections)
 	{
-		mongoc_uri_destroy(uri);
+		mongoc_collection_destroy(worker_meta_collection);
 	}
-	if (client)
+	worker_meta_collections.Empty();
+	for (mongoc_collection_t* worker_collection : worker_collections)
 	{
-		mongoc_client_destroy(client);
+		mongoc_collection_destroy(worker_collection);
 	}
-	if (database)
+	worker_collections.Empty();
+	for (mongoc_client_t* worker_client : worker_clients)
 	{
-		mongoc_database_destroy(database);
+		mongoc_client_destroy(worker_client);
 	}
+	worker_clients.Empty();
 	if (collection)
 	{
 		mongoc_collection_destroy(collection);
+		collection = nullptr;
+	}
+	if (database)
+	{
+		mongoc_database_destroy(database);
+		database = nullptr;
+	}
+	if (client)
+	{
+		mongoc_client_destroy(client);
+		client = nullptr;
+	}
+	if (uri)
+	{
+		mongoc_uri_destroy(uri);
+		uri = nullptr;
+	}
+	if (bMongocInit)
+	{
+		mongoc_cleanup();
+		bMongocInit = false;
 	}
-	mongoc_cleanup();
 #endif //SL_WITH_LIBMONGO_C
 }
 
@@ -0,0 +1,200 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Runtime/SLWorldStateFrameRing.h"
+#include "HAL/PlatformProcess.h"
+
+// Ctor
+FSLWorldStateFrameRing::FSLWorldStateFrameRing()
+{
+	Policy = ESLWorldStateQueuePolicy::Block;
+	MaxBlockTime = 0.5f;
+	NextSequence = 0;
+}
+
+// Preallocate the slots and set the full queue policy
+void FSLWorldStateFrameRing::Init(int32 Capacity, ESLWorldStateQueuePolicy InPolicy, float InMaxBlockTime)
+{
+	Slots.Empty();
+	Slots.SetNum(FMath::Max(Capacity, 2));
+	Policy = InPolicy;
+	MaxBlockTime = InMaxBlockTime;
+	NextSequence = 0;
+
+	NumQueued.Reset();
+	NumDropped.Reset();
+	NumFailed.Reset();
+	NumCoalesced.Reset();
+	NumWritten.Reset();
+	NumBlocked.Reset();
+	SerializationLatency.Reset();
+	InsertLatency.Reset();
+}
+
+// Acquire a slot to fill, bOutMerged is true if the slot still holds an older queued frame (INDEX_NONE on failure)
+int32 FSLWorldStateFrameRing::BeginEnqueue(bool& bOutMerged, const TFunction<void()>& OnBlocked)
+{
+	bOutMerged = false;
+
+	int32 SlotIdx = AcquireFree();
+	if (SlotIdx != INDEX_NONE)
+	{
+		return SlotIdx;
+	}
+
+	// Queue is full, wait for the writers to release a slot (failed inserts release their slots as well)
+	if (Policy == ESLWorldStateQueuePolicy::Block)
+	{
+		NumBlocked.Increment();
+		const double StartTime = FPlatformTime::Seconds();
+		bool bWarned = false;
+		while (true)
+		{
+			if (OnBlocked)
+			{
+				OnBlocked();
+			}
+			FPlatformProcess::Sleep(0.0005f);
+			SlotIdx = AcquireFree();
+			if (SlotIdx != INDEX_NONE)
+			{
+				return SlotIdx;
+			}
+			if (!bWarned && FPlatformTime::Seconds() - StartTime > MaxBlockTime)
+			{
+				UE_LOG(LogTemp, Warning, TEXT("%s::%d Frame queue still full after blocking for %f (s), the writers cannot keep up, still waiting.."),
+					*FString(__FUNCTION__), __LINE__, MaxBlockTime);
+				bWarned = true;
+			}
+		}
+	}
+
+	// Take over the oldest (drop) or the newest (coalesce) queued frame, retry if a writer claims it first
+	const bool bTakeOldest = Policy != ESLWorldStateQueuePolicy::Coalesce;
+	for (int32 Try = 0; Try < Slots.Num(); ++Try)
+	{
+		const int32 QueuedIdx = FindQueued(bTakeOldest);
+		if (QueuedIdx == INDEX_NONE)
+		{
+			SlotIdx = AcquireFree();
+			if (SlotIdx != INDEX_NONE)
+			{
+				return SlotIdx;
+			}
+		}
+		else if (TryTransition(QueuedIdx, Queued, Filling))
+		{
+			if (bTakeOldest)
+			{
+				NumDropped.Increment();
+			}
+			else
+			{
+				NumCoalesced.Increment();
+			}
+			bOutMerged = true;
+			return QueuedIdx;
+		}
+	}
+	return INDEX_NONE;
+}
+
+// Publish the filled slot to the writers
+void FSLWorldStateFrameRing::EndEnqueue(int32 SlotIdx, bool bWriteAll, bool bMerged)
+{
+	FSlot& Slot = Slots[SlotIdx];
+	Slot.Frame.bWriteAll = bMerged ? (Slot.Frame.bWriteAll || bWriteAll) : bWriteAll;
+	Slot.Frame.QueuedTime = FPlatformTime::Seconds();
+	FPlatformAtomics::InterlockedExchange(&Slot.Sequence, NextSequence++);
+	NumQueued.Increment();
+
+	// Full barrier, the frame data is visible before the slot is seen as queued
+	FPlatformAtomics::InterlockedExchange(&Slot.State, Queued);
+}
+
+// Claim the oldest queued frame (INDEX_NONE if the queue is empty)
+int32 FSLWorldStateFrameRing::TryDequeue()
+{
+	for (int32 Try = 0; Try < Slots.Num(); ++Try)
+	{
+		const int32 QueuedIdx = FindQueued(true);
+		if (QueuedIdx == INDEX_NONE)
+		{
+			return INDEX_NONE;
+		}
+		if (TryTransition(QueuedIdx, Queued, Writing))
+		{
+			return QueuedIdx;
+		}
+	}
+	return INDEX_NONE;
+}
+
+// Give the slot back after the frame has been written or batched
+void FSLWorldStateFrameRing::Release(int32 SlotIdx)
+{
+	FPlatformAtomics::InterlockedExchange(&Slots[SlotIdx].State, Free);
+}
+
+// Number of frames queued, being written or batched
+int32 FSLWorldStateFrameRing::NumPending() const
+{
+	return NumQueued.GetValue() - NumWritten.GetValue() - NumFailed.GetValue() - NumDropped.GetValue() - NumCoalesced.GetValue();
+}
+
+// Get the current counters and latencies
+FSLWorldStateWriterStats FSLWorldStateFrameRing::GetStats() const
+{
+	FSLWorldStateWriterStats Stats;
+	Stats.NumQueued = NumQueued.GetValue();
+	Stats.NumDropped = NumDropped.GetValue();
+	Stats.NumFailed = NumFailed.GetValue();
+	Stats.NumCoalesced = NumCoalesced.GetValue();
+	Stats.NumWritten = NumWritten.GetValue();
+	Stats.NumBlocked = NumBlocked.GetValue();
+	Stats.NumPending = NumPending();
+	Stats.SerializationP50 = SerializationLatency.GetPercentileMs(0.5f);
+	Stats.SerializationP99 = SerializationLatency.GetPercentileMs(0.99f);
+	Stats.InsertP50 = InsertLatency.GetPercentileMs(0.5f);
+	Stats.InsertP99 = InsertLatency.GetPercentileMs(0.99f);
+	return Stats;
+}
+
+// Atomically change the state of the slot, true on success
+bool FSLWorldStateFrameRing::TryTransition(int32 SlotIdx, ESlotState From, ESlotState To)
+{
+	return FPlatformAtomics::InterlockedCompareExchange(&Slots[SlotIdx].State, To, From) == From;
+}
+
+// Claim any free slot for filling
+int32 FSLWorldStateFrameRing::AcquireFree()
+{
+	for (int32 Idx = 0; Idx < Slots.Num(); ++Idx)
+	{
+		if (Slots[Idx].State == Free && TryTransition(Idx, Free, Filling))
+		{
+			return Idx;
+		}
+	}
+	return INDEX_NONE;
+}
+
+// Find the oldest or newest queued slot
+int32 FSLWorldStateFrameRing::FindQueued(bool bOldest) const
+{
+	int32 FoundIdx = INDEX_NONE;
+	int64 FoundSequence = 0;
+	for (int32 Idx = 0; Idx < Slots.Num(); ++Idx)
+	{
+		if (Slots[Idx].State == Queued)
+		{
+			const int64 Sequence = Slots[Idx].Sequence;
+			if (FoundIdx == INDEX_NONE || (bOldest ? Sequence < FoundSequence : Sequence > FoundSequence))
+			{
+				FoundIdx = Idx;
+				FoundSequence = Sequence;
+			}
+		}
+	}
+	return FoundIdx;
+}
@@ -260,6 +260,7 @@ void ASLWorldStateLogger::FinishImpl(bool bForced)
 
 	// Index and disconnect from database
 	DBHandler->Finish();
+	WriterStats = DBHandler->GetStats();
 	DBHandler.Reset();
 
 	//  Disable tick
@@ -347,5 +348,10 @@ void ASLWorldStateLogger::FirstUpdate()
 // Log individuals which changed state
 void ASLWorldStateLogger::Update()
 {
-	DBHandler->Write(GetWorld()->GetTimeSeconds());
+	if (!DBHandler->Write(GetWorld()->GetTimeSeconds()))
+	{
+		UE_LOG(LogTemp, Verbose, TEXT("%s::%d World state logger (%s) frame queue full at %.2f.."),
+			*FString(__FUNCTION__), __LINE__, *GetName(), GetWorld()->GetTimeSeconds());
+	}
+	WriterStats = DBHandler->GetStats();
 }
@@ -24,6 +24,8 @@ USLVisionLogger::USLVisionLogger() : bIsInit(false), bIsStarted(false), bIsFinis
 	CurrVirtualCameraIdx = INDEX_NONE;
 	CurrTimestamp = -1.f;
 	PrevViewMode = ESLVisionViewMode::NONE;
+	MaskImageFormat = ESLImageFormat::PNG;
+	MaxPendingFrames = 2;
 
 	ViewModes.Add(ESLVisionViewMode::Color);
 	ViewModes.Add(ESLVisionViewMode::Unlit);
@@ -51,6 +53,7 @@ void USLVisionLogger::Init(const FString& InTaskId, const FString& InEpisodeId,
 	if (!bIsInit)
 	{
 		Resolution = Params.Resolution;
+		MaskImageFormat = Params.MaskImageFormat;
 
 		// Save the folder name if the images are going to be stored locally as well
 		if(Params.bIncludeLocally)
@@ -128,7 +131,7 @@ void USLVisionLogger::Init(const FString& InTaskId, const FString& InEpisodeId,
 					// Create the overlap calc object
 					OverlapCalc = NewObject<USLVisionOverlapCalc>(this);
 					// Give control to the overlap calc to pause and start the vision logger
-					OverlapCalc->Init(this, Resolution/Params.OverlapResolutionDivisor, SaveLocallyFolderName);
+					OverlapCalc->Init(this, Resolution/Params.OverlapResolutionDivisor, SaveLocallyFolderName, Params.bBatchOverlaps);
 				}
 			}
 			else
@@ -170,6 +173,11 @@ void USLVisionLogger::Finish(bool bForced)
 {
 	if (!bIsFinished && (bIsInit || bIsStarted))
 	{
+		// Make sure all the frames are written and all the screenshots are stored
+		WritePendingFrames(0);
+		ImageWriter.Flush();
+		ImageWriter.LogStats();
+
 		// Index the entries in the db
 		DBHandler.CreateIndexes();
 
@@ -291,53 +299,35 @@ void USLVisionLogger::ScreenshotCB(int32 SizeX, int32 SizeY, const TArray<FColor
 	// Terminal output with the log progress
 	PrintProgress();
 
-	// Compress image
-	TArray<uint8> CompressedBitmap;
-
 	// If mask mode is currently active, restore the colors and get the entity data
-	if (ViewModes[CurrViewModeIdx] == ESLVisionViewMode::Mask)
+	const bool bMaskViewMode = ViewModes[CurrViewModeIdx] == ESLVisionViewMode::Mask;
+	if (bMaskViewMode)
 	{
 		// Remove const-ness from image (needed for restore the image masks from the rendered values to the original ones)
 		TArray<FColor>& BitmapRef = const_cast<TArray<FColor>&>(Bitmap);
 
 		// Get information from the mask image and restore any rendering artefacts to the original mask colors
 		MaskImgHandler.GetDataAndRestoreImage(BitmapRef, SizeX, SizeY, CurrViewData);
-
-		// Compress the restored bitmap image
-		FImageUtils::CompressImageArray(SizeX, SizeY, BitmapRef, CompressedBitmap);
-	
-		if (OverlapCalc)
-		{
-			// Check if the image should be saved locally as well
-			if (!SaveLocallyFolderName.IsEmpty())
-			{
-				SaveImageLocally(CompressedBitmap);
-			}
-
-			// Cache the image binary
-			CurrViewData.Images.Emplace(FSLVisionImageData(GetViewModeName(ViewModes[CurrViewModeIdx]), CompressedBitmap));
-
-			// Bind the screenshot callback for calculating overlaps
-			OverlapCalc->Start(&CurrViewData, CurrTimestamp, Episode.GetCurrIndex());
-
-			// Wait for next step until the overlaps were calculated
-			return;
-		}
 	}
-	else
+
+	// Compress (and save locally) in the background, the image binary is added to its view when the frame is written
+	TArray<FString> Paths;
+	if (!SaveLocallyFolderName.IsEmpty())
 	{
-		// Compress the original bitmap image
-		FImageUtils::CompressImageArray(SizeX, SizeY, Bitmap, CompressedBitmap);
+		Paths.Add(GetLocalImagePath());
 	}
+	const ESLImageFormat Format = bMaskViewMode ? MaskImageFormat : ESLImageFormat::PNG;
+	auto Result = ImageWriter.AddImage(SizeX, SizeY, TArray<FColor>(Bitmap), Paths, nullptr, true, Format);
+	CurrFrameImages.Emplace(CurrFrameData.Views.Num(), GetViewModeName(ViewModes[CurrViewModeIdx]), Result);
 
-	// Check if the image should be saved locally as well
-	if(!SaveLocallyFolderName.IsEmpty())
+	if (bMaskViewMode && OverlapCalc)
 	{
-		SaveImageLocally(CompressedBitmap);
-	}
+		// Bind the screenshot callback for calculating overlaps
+		OverlapCalc->Start(&CurrViewData, CurrTimestamp, Episode.GetCurrIndex());
 
-	// Cache the image binary
-	CurrViewData.Images.Emplace(FSLVisionImageData(GetViewModeName(ViewModes[CurrViewModeIdx]), CompressedBitmap));
+		// Wait for next step until the overlaps were calculated
+		return;
+	}
 
 	// Go to next frame/camera/view mode
 	if (NextStep())
@@ -403,8 +393,8 @@ bool USLVisionLogger::NextStep()
 		}
 		else
 		{
-			// Write vision frame data to the database
-			DBHandler.WriteFrame(CurrFrameData);
+			// Write vision frame data to the database (once its images are compressed)
+			QueueCurrFrame();
 
 			if (SetupNextEpisodeFrame())
 			{
@@ -934,13 +924,66 @@ void USLVisionLogger::QuitEditor()
 #endif // WITH_EDITOR
 }
 
-// Save the compressed screenshot image locally
-void USLVisionLogger::SaveImageLocally(const TArray<uint8>& CompressedBitmap)
+// Get the local path of the current screenshot image
+FString USLVisionLogger::GetLocalImagePath() const
 {
 	const FString FolderName = VirtualCameras[CurrVirtualCameraIdx]->GetClassName() + "_" + CurrViewModePostfix;
-	FString Path = FPaths::ProjectDir() + "/SemLog/" + SaveLocallyFolderName + "/" + FolderName + "/" + CurrImageFilename + ".png";
+	const ESLImageFormat Format = ViewModes[CurrViewModeIdx] == ESLVisionViewMode::Mask ? MaskImageFormat : ESLImageFormat::PNG;
+	FString Path = FPaths::ProjectDir() + "/SemLog/" + SaveLocallyFolderName + "/" + FolderName + "/" + CurrImageFilename + FSLImageCodec::GetFileExtension(Format);
 	FPaths::RemoveDuplicateSlashes(Path);
-	FFileHelper::SaveArrayToFile(CompressedBitmap, *Path);
+	return Path;
+}
+
+// Queue the current frame, it is written once its images are compressed
+void USLVisionLogger::QueueCurrFrame()
+{
+	FSLVisionPendingFrame& Frame = PendingFrames.AddDefaulted_GetRef();
+	Frame.Data = MoveTemp(CurrFrameData);
+	Frame.Images = MoveTemp(CurrFrameImages);
+	CurrFrameImages.Reset();
+	WritePendingFrames(MaxPendingFrames);
+}
+
+// Write the frames with compressed images in order, block on the oldest frames while more than the given number are pending
+void USLVisionLogger::WritePendingFrames(int32 MaxPending)
+{
+	int32 NumWritten = 0;
+	while (NumWritten < PendingFrames.Num())
+	{
+		FSLVisionPendingFrame& Frame = PendingFrames[NumWritten];
+		const bool bMustWrite = PendingFrames.Num() - NumWritten > MaxPending;
+		bool bImagesDone = true;
+		for (const auto& FrameImage : Frame.Images)
+		{
+			const auto& Result = FrameImage.Get<2>();
+			if (!Result->bDone)
+			{
+				if (!bMustWrite)
+				{
+					bImagesDone = false;
+					break;
+				}
+				ImageWriter.Wait(Result);
+			}
+		}
+		if (!bImagesDone)
+		{
+			break;
+		}
+
+		for (auto& FrameImage : Frame.Images)
+		{
+			const int32 ViewIdx = FrameImage.Get<0>();
+			if (Frame.Data.Views.IsValidIndex(ViewIdx))
+			{
+				const auto& Result = FrameImage.Get<2>();
+				Frame.Data.Views[ViewIdx].Images.Emplace(FSLVisionImageData(FrameImage.Get<1>(), MoveTemp(Result->CompressedBitmap), Result->Format));
+			}
+		}
+		DBHandler.WriteFrame(Frame.Data);
+		NumWritten++;
+	}
+	PendingFrames.RemoveAt(0, NumWritten);
 }
 
 // Output progress to terminal
@@ -0,0 +1,136 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Misc/AutomationTest.h"
+#include "Events/SLContactEventHandler.h"
+#include "Events/SLPouringEvent.h"
+#include "Monitors/SLContactMonitorBox.h"
+#include "Individuals/Type/SLBaseIndividual.h"
+#include "Individuals/Type/SLParticleIndividual.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "HAL/PlatformTime.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace SLContactEventHandlerBenchmark
+{
+	// Particles leaving the source container per second
+	static const float PouringRate = 500.f;
+
+	// Container individual of the actor, the pose is cached from the actor
+	static USLBaseIndividual* CreateContainer(AStaticMeshActor* Actor, const FString& ClassName)
+	{
+		USLBaseIndividual* Individual = NewObject<USLBaseIndividual>(Actor->GetStaticMeshComponent());
+		Individual->Init(false);
+		Individual->SetClassValue(ClassName);
+		Individual->UpdateCachedPose(0.f);
+		return Individual;
+	}
+
+	// Pour the particles from the source into the destination container, every tenth particle bounces in the destination
+	static bool RunBenchmark(FAutomationTestBase& Test, UWorld* World, int32 NumParticles)
+	{
+		// The source container is tilted, the destination container is upright
+		AStaticMeshActor* SourceActor = World->SpawnActor<AStaticMeshActor>(FVector::ZeroVector, FRotator(0.f, 0.f, 90.f));
+		AStaticMeshActor* DestinationActor = World->SpawnActor<AStaticMeshActor>(FVector(0.f, 0.f, -20.f), FRotator::ZeroRotator);
+		if (!Test.TestNotNull(TEXT("Source actor"), SourceActor) || !Test.TestNotNull(TEXT("Destination actor"), DestinationActor))
+		{
+			return false;
+		}
+		USLBaseIndividual* Source = CreateContainer(SourceActor, TEXT("Pitcher"));
+		USLBaseIndividual* Destination = CreateContainer(DestinationActor, TEXT("Bowl"));
+
+		TArray<USLBaseIndividual*> Particles;
+		Particles.Reserve(NumParticles);
+		for (int32 Idx = 0; Idx < NumParticles; ++Idx)
+		{
+			Particles.Add(NewObject<USLParticleIndividual>(DestinationActor->GetStaticMeshComponent()));
+		}
+
+		// The handler only listens to the delegates of the monitor
+		USLContactMonitorBox* Monitor = NewObject<USLContactMonitorBox>(DestinationActor);
+		FSLContactEventHandler Handler;
+		Handler.Init(Monitor);
+		Handler.Start();
+
+		int32 NumContactEvents = 0;
+		TArray<TSharedPtr<FSLPouringEvent>> PouringEvents;
+		Handler.OnSemanticEvent.BindLambda([&NumContactEvents, &PouringEvents](TSharedPtr<ISLEvent> Event)
+		{
+			if (Event->TypeName().Equals(TEXT("Pouring")))
+			{
+				PouringEvents.Add(StaticCastSharedPtr<FSLPouringEvent>(Event));
+			}
+			else
+			{
+				NumContactEvents++;
+			}
+		});
+
+		float LastSourceTime = 0.f;
+		float LastDestinationTime = 0.f;
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 Idx = 0; Idx < NumParticles; ++Idx)
+		{
+			USLBaseIndividual* Particle = Particles[Idx];
+			const float OutTime = 0.1f + Idx / PouringRate;
+
+			Monitor->OnBeginSLContact.Broadcast(FSLContactResult(Source, Particle, OutTime - 0.1f, false));
+			Monitor->OnEndSLContact.Broadcast(Source, Particle, OutTime);
+			LastSourceTime = OutTime - 0.1f;
+
+			Monitor->OnBeginSLContact.Broadcast(FSLContactResult(Destination, Particle, OutTime + 0.3f, false));
+			LastDestinationTime = FMath::Max(LastDestinationTime, OutTime + 0.3f);
+			if (Idx % 10 == 0)
+			{
+				Monitor->OnBeginSLContact.Broadcast(FSLContactResult(Destination, Particle, OutTime + 0.5f, false));
+				LastDestinationTime = FMath::Max(LastDestinationTime, OutTime + 0.5f);
+			}
+			Monitor->OnEndSLContact.Broadcast(Destination, Particle, OutTime + 1.f);
+		}
+		Handler.Finish(LastDestinationTime + 2.f);
+		const double Duration = FPlatformTime::Seconds() - StartTime;
+
+		// A contact per container and particle, the bounces first publish the older contact
+		const int32 NumBounces = FMath::DivideAndRoundUp(NumParticles, 10);
+		Test.TestEqual(TEXT("Contact events"), NumContactEvents, 2 * NumParticles + NumBounces);
+
+		// One pouring event per container role, closed at the last particle contact of the container
+		if (Test.TestEqual(TEXT("Pouring events"), PouringEvents.Num(), 2))
+		{
+			for (const auto& Event : PouringEvents)
+			{
+				const bool bIsSource = Event->PouringEventTypes == USLPouringEventTypes::PouredOut;
+				const TArray<FTransform>& Poses = bIsSource ? Event->PouringPoseForSourceContainer : Event->PouringPoseForDestinationContainer;
+				Test.TestEqual(TEXT("Pouring event end time"), Event->EndTime, bIsSource ? LastSourceTime : LastDestinationTime);
+				Test.TestEqual(TEXT("Pouring event particles"), Event->NumberOfParticles, NumParticles);
+				// The sample is bounded, only the poses with the extreme roll are added to it when finished
+				Test.TestTrue(TEXT("Pouring event pose sample is bounded"), Poses.Num() > 0 && Poses.Num() <= 64 + 2);
+			}
+		}
+
+		Test.AddInfo(FString::Printf(TEXT("%d particles (%d contacts, %d bounces): %.3f ms total, %.3f us per contact"),
+			NumParticles, 2 * NumParticles + NumBounces, NumBounces, Duration * 1000.0,
+			Duration * 1e6 / (2 * NumParticles + NumBounces)));
+
+		SourceActor->Destroy();
+		DestinationActor->Destroy();
+		return true;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSLContactEventHandlerBenchmark, "USemLog.Events.ContactEventHandler.Benchmark",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+// Pour thousands of particles between two containers through the contact and pouring paths of the handler
+bool FSLContactEventHandlerBenchmark::RunTest(const FString& Parameters)
+{
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+	bool bSuccess = SLContactEventHandlerBenchmark::RunBenchmark(*this, World, 2000);
+	bSuccess &= SLContactEventHandlerBenchmark::RunBenchmark(*this, World, 20000);
+	World->DestroyWorld(false);
+	return bSuccess;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,79 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Misc/AutomationTest.h"
+#include "Individuals/SLMaskColorAllocator.h"
+#include "HAL/PlatformTime.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSLMaskColorAllocatorBenchmark, "USemLog.Individuals.MaskColorAllocator.Benchmark",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+// Allocate the masks of a large map (rigid individuals and skeletal bones) next to already existing masks
+bool FSLMaskColorAllocatorBenchmark::RunTest(const FString& Parameters)
+{
+	const int32 MinManhattanDist = 17;
+	const int32 NumExisting = 200;
+	const int32 NumRigid = 4000;
+	const int32 NumSkeletal = 60;
+	const int32 NumBonesPerSkeletal = 100;
+	const int32 NumToAllocate = NumRigid + NumSkeletal * NumBonesPerSkeletal;
+
+	FSLMaskColorAllocator Allocator(MinManhattanDist);
+
+	// Masks already written in the world
+	TArray<FColor> Colors;
+	FRandomStream Stream(7);
+	while (Colors.Num() < NumExisting)
+	{
+		const FColor Color((uint8)Stream.RandRange(0, 255), (uint8)Stream.RandRange(0, 255), (uint8)Stream.RandRange(0, 255));
+		if (Allocator.IsColorAvailable(Color))
+		{
+			Allocator.AddConsumedColor(Color);
+			Colors.Add(Color);
+		}
+	}
+
+	int32 NumFailed = 0;
+	const double StartTime = FPlatformTime::Seconds();
+	for (int32 Idx = 0; Idx < NumToAllocate; ++Idx)
+	{
+		const FColor Color = Allocator.Allocate();
+		if (Color == FColor::Black)
+		{
+			NumFailed++;
+		}
+		else
+		{
+			Colors.Add(Color);
+		}
+	}
+	const double Duration = FPlatformTime::Seconds() - StartTime;
+
+	TestEqual(TEXT("Failed allocations"), NumFailed, 0);
+	TestEqual(TEXT("Consumed colors"), Allocator.Num(), NumExisting + NumToAllocate - NumFailed);
+
+	// Brute force check of the min distance between all the colors
+	int32 NumTooClose = 0;
+	for (int32 Idx = 0; Idx < Colors.Num(); ++Idx)
+	{
+		for (int32 OtherIdx = Idx + 1; OtherIdx < Colors.Num(); ++OtherIdx)
+		{
+			const FColor& C1 = Colors[Idx];
+			const FColor& C2 = Colors[OtherIdx];
+			if (FMath::Abs(C1.R - C2.R) + FMath::Abs(C1.G - C2.G) + FMath::Abs(C1.B - C2.B) <= MinManhattanDist)
+			{
+				NumTooClose++;
+			}
+		}
+	}
+	TestEqual(TEXT("Colors closer than the min distance"), NumTooClose, 0);
+
+	AddInfo(FString::Printf(TEXT("%d allocations (%d rigid, %d bones) next to %d existing masks: %.3f ms total, %.3f us per allocation, %d lattice candidates left"),
+		NumToAllocate, NumRigid, NumSkeletal * NumBonesPerSkeletal, NumExisting, Duration * 1000.0,
+		Duration * 1e6 / NumToAllocate, Allocator.NumRemainingCandidates()));
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,106 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Misc/AutomationTest.h"
+#include "Vision/SLVisionMaskImageHandler.h"
+#include "HAL/PlatformTime.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace SLVisionMaskImageHandlerBenchmark
+{
+	// Rendered color of the entity (the original mask color is offseted like a screenshot would)
+	static FColor GetRenderedColor(int32 EntityIdx)
+	{
+		return FColor(16 + (EntityIdx % 200), 16 + ((EntityIdx / 200) % 200), 64 + (EntityIdx / 40000), 255);
+	}
+
+	// Original mask color of the entity
+	static FColor GetOriginalColor(int32 EntityIdx)
+	{
+		const FColor Rendered = GetRenderedColor(EntityIdx);
+		return FColor(Rendered.R - 1, Rendered.G + 1, Rendered.B, 255);
+	}
+
+	// Fill the image with rectangular entity tiles separated by black lines (returns the number of non black pixels)
+	static int64 CreateMaskImage(int32 Width, int32 Height, int32 NumEntities, TArray<FColor>& OutImage)
+	{
+		const int32 TileSize = 48;
+		const int32 TilesX = FMath::DivideAndRoundUp(Width, TileSize);
+		int64 NumColored = 0;
+		OutImage.SetNumUninitialized(Width * Height);
+		for (int32 Y = 0; Y < Height; ++Y)
+		{
+			for (int32 X = 0; X < Width; ++X)
+			{
+				const bool bBorder = (X % TileSize) == 0 || (Y % TileSize) == 0;
+				const int32 EntityIdx = ((Y / TileSize) * TilesX + (X / TileSize)) % NumEntities;
+				OutImage[Y * Width + X] = bBorder ? FColor::Black : GetRenderedColor(EntityIdx);
+				NumColored += bBorder ? 0 : 1;
+			}
+		}
+		return NumColored;
+	}
+
+	// Time the mask restore kernel on the image size
+	static bool RunBenchmark(FAutomationTestBase& Test, int32 Width, int32 Height, int32 NumEntities, int32 NumIterations)
+	{
+		TMap<FColor, FSLVisionMaskEntityInfo> RenderedColorToEntityInfo;
+		for (int32 EntityIdx = 0; EntityIdx < NumEntities; ++EntityIdx)
+		{
+			RenderedColorToEntityInfo.Emplace(GetRenderedColor(EntityIdx),
+				FSLVisionMaskEntityInfo(TEXT("Entity"), FString::FromInt(EntityIdx), GetOriginalColor(EntityIdx).ToHex()));
+		}
+
+		FSLVisionMaskImageHandler Handler;
+		if (!Test.TestTrue(TEXT("Handler init"), Handler.Init(RenderedColorToEntityInfo, TMap<FColor, FSLVisionMaskSkelInfo>())))
+		{
+			return false;
+		}
+
+		TArray<FColor> SourceImage;
+		const int64 NumColored = CreateMaskImage(Width, Height, NumEntities, SourceImage);
+
+		TArray<FColor> Image;
+		FSLVisionViewData ViewData;
+		double TotalTime = 0.0;
+		for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			// The image is restored in place, start every iteration from the rendered one
+			Image = SourceImage;
+			ViewData.Clear();
+			const double StartTime = FPlatformTime::Seconds();
+			Handler.GetDataAndRestoreImage(Image, Width, Height, ViewData);
+			TotalTime += FPlatformTime::Seconds() - StartTime;
+		}
+
+		// Check the results of the last iteration
+		float TotalPercentage = 0.f;
+		for (const auto& EntityData : ViewData.Entities)
+		{
+			TotalPercentage += EntityData.ImagePercentage;
+		}
+		Test.TestEqual(TEXT("Number of entities"), ViewData.Entities.Num(),
+			FMath::Min(NumEntities, FMath::DivideAndRoundUp(Width, 48) * FMath::DivideAndRoundUp(Height, 48)));
+		Test.TestEqual(TEXT("Entity image percentage"), TotalPercentage, (float)((double)NumColored / ((int64)Width * Height)), 1e-3f);
+		Test.TestEqual(TEXT("Restored pixel"), Image[Width + 1], GetOriginalColor(0));
+
+		const double AvgMs = TotalTime * 1000.0 / NumIterations;
+		Test.AddInfo(FString::Printf(TEXT("%dx%d, %d entities: %.3f ms per image (%.1f MPixel/s)"),
+			Width, Height, NumEntities, AvgMs, ((double)Width * Height / 1e6) / (AvgMs / 1000.0)));
+		return true;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSLVisionMaskImageHandlerBenchmark, "USemLog.Vision.MaskImageHandler.Benchmark",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+
+// Restore synthetic 1080p and 4K mask images
+bool FSLVisionMaskImageHandlerBenchmark::RunTest(const FString& Parameters)
+{
+	bool bSuccess = SLVisionMaskImageHandlerBenchmark::RunBenchmark(*this, 1920, 1080, 512, 20);
+	bSuccess &= SLVisionMaskImageHandlerBenchmark::RunBenchmark(*this, 3840, 2160, 2048, 10);
+	return bSuccess;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
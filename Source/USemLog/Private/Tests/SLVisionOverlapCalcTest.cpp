@@ -0,0 +1,123 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Misc/AutomationTest.h"
+#include "Vision/SLVisionOverlapCalc.h"
+#include "Math/RandomStream.h"
+#include "HAL/PlatformTime.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace SLVisionOverlapCalcTest
+{
+	// Paint the non occluded (white) area of the entity, the area fills its screen rectangle
+	static void PaintEntity(TArray<FColor>& Image, int32 Width, int32 Height, const FIntRect& Rect)
+	{
+		for (int32 Y = FMath::Max(Rect.Min.Y, 0); Y < FMath::Min(Rect.Max.Y, Height); ++Y)
+		{
+			for (int32 X = FMath::Max(Rect.Min.X, 0); X < FMath::Min(Rect.Max.X, Width); ++X)
+			{
+				Image[Y * Width + X] = FColor::White;
+			}
+		}
+	}
+
+	// Random entity rectangles, some of them touch the image edges
+	static void CreateRects(int32 Width, int32 Height, int32 NumEntities, TArray<FIntRect>& OutRects)
+	{
+		FRandomStream Stream(42);
+		for (int32 Idx = 0; Idx < NumEntities; ++Idx)
+		{
+			const int32 SizeX = Stream.RandRange(4, 96);
+			const int32 SizeY = Stream.RandRange(4, 96);
+			const int32 MinX = Idx % 17 == 0 ? 0 : Stream.RandRange(0, Width - SizeX);
+			const int32 MinY = Idx % 23 == 0 ? Height - SizeY : Stream.RandRange(0, Height - SizeY);
+			OutRects.Emplace(MinX, MinY, MinX + SizeX, MinY + SizeY);
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSLVisionOverlapCalcBatchTest, "USemLog.Vision.OverlapCalc.Batching",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+// The batched captures give the same non occluded pixels and clipping as one capture per entity
+bool FSLVisionOverlapCalcBatchTest::RunTest(const FString& Parameters)
+{
+	using namespace SLVisionOverlapCalcTest;
+	const int32 Width = 640;
+	const int32 Height = 360;
+	const int32 NumEntities = 150;
+
+	TArray<FIntRect> Rects;
+	CreateRects(Width, Height, NumEntities, Rects);
+
+	TArray<TArray<int32>> Batches;
+	USLVisionOverlapCalc::GroupNonOverlappingRects(Rects, Batches);
+
+	// Every entity is in exactly one batch, and the rectangles of a batch do not overlap
+	TArray<int32> NumInBatches;
+	NumInBatches.Init(0, NumEntities);
+	for (const auto& Batch : Batches)
+	{
+		for (int32 BatchIdx = 0; BatchIdx < Batch.Num(); ++BatchIdx)
+		{
+			NumInBatches[Batch[BatchIdx]]++;
+			for (int32 OtherBatchIdx = BatchIdx + 1; OtherBatchIdx < Batch.Num(); ++OtherBatchIdx)
+			{
+				TestFalse(TEXT("Rectangles of a batch overlap"), Rects[Batch[BatchIdx]].Intersect(Rects[Batch[OtherBatchIdx]]));
+			}
+		}
+	}
+	for (int32 Idx = 0; Idx < NumEntities; ++Idx)
+	{
+		TestEqual(TEXT("Number of batches of the entity"), NumInBatches[Idx], 1);
+	}
+
+	// Reference, one capture per entity
+	TArray<int64> RefNum;
+	TArray<bool> RefClipped;
+	TArray<FColor> Image;
+	const double RefStartTime = FPlatformTime::Seconds();
+	for (const FIntRect& Rect : Rects)
+	{
+		Image.Init(FColor::Black, Width * Height);
+		PaintEntity(Image, Width, Height, Rect);
+		int64 Num = 0;
+		bool bClipped = false;
+		USLVisionOverlapCalc::CountNonOccludedPixels(Image, Width, Height, FIntRect(0, 0, Width, Height), Num, bClipped);
+		RefNum.Add(Num);
+		RefClipped.Add(bClipped);
+	}
+	const double RefTime = FPlatformTime::Seconds() - RefStartTime;
+
+	// Batched, one capture per batch, every entity only reads its own rectangle
+	const double BatchStartTime = FPlatformTime::Seconds();
+	for (const auto& Batch : Batches)
+	{
+		Image.Init(FColor::Black, Width * Height);
+		for (int32 Idx : Batch)
+		{
+			PaintEntity(Image, Width, Height, Rects[Idx]);
+		}
+		for (int32 Idx : Batch)
+		{
+			int64 Num = 0;
+			bool bClipped = false;
+			USLVisionOverlapCalc::CountNonOccludedPixels(Image, Width, Height, Rects[Idx], Num, bClipped);
+			TestEqual(TEXT("Non occluded pixels"), Num, RefNum[Idx]);
+			TestEqual(TEXT("Clipped"), bClipped, RefClipped[Idx]);
+			TestEqual(TEXT("Non occluded pixels of the rectangle"), Num, (int64)Rects[Idx].Area());
+		}
+	}
+	const double BatchTime = FPlatformTime::Seconds() - BatchStartTime;
+
+	// A partially visible entity
+	TestEqual(TEXT("Occlusion percentage"), USLVisionOverlapCalc::GetOcclusionPercentage(0.25f, 1.f), 0.75f);
+	TestEqual(TEXT("Occlusion percentage without non occluded pixels"), USLVisionOverlapCalc::GetOcclusionPercentage(0.25f, 0.f), 0.f);
+
+	AddInfo(FString::Printf(TEXT("%d entities in %d captures (%.3f ms) instead of %d (%.3f ms)"),
+		NumEntities, Batches.Num(), BatchTime * 1000.0, NumEntities, RefTime * 1000.0));
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,213 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Utils/SLImageCodec.h"
+#include "ImageUtils.h"
+#include "Async/ParallelFor.h"
+
+// RLE file identifier and version
+static const uint32 SL_RLE_MAGIC = 0x4C524C53; // "SLRL"
+static const uint32 SL_RLE_VERSION = 1;
+static const int32 SL_RLE_HEADER_SIZE = 6 * sizeof(int32);
+static const int64 SL_RLE_MAX_PIXELS = 16384 * 16384; // largest texture size, keeps the pixel offsets in int32
+
+// Append the value as a little endian 32 bit integer
+static void AppendUInt32(TArray<uint8>& OutData, uint32 Value)
+{
+	OutData.Add((uint8)(Value & 0xFF));
+	OutData.Add((uint8)((Value >> 8) & 0xFF));
+	OutData.Add((uint8)((Value >> 16) & 0xFF));
+	OutData.Add((uint8)((Value >> 24) & 0xFF));
+}
+
+// Read a little endian 32 bit integer
+static uint32 ReadUInt32(const uint8* Data)
+{
+	return (uint32)Data[0] | ((uint32)Data[1] << 8) | ((uint32)Data[2] << 16) | ((uint32)Data[3] << 24);
+}
+
+// Encode the image in the given format
+bool FSLImageCodec::Encode(ESLImageFormat Format, int32 SizeX, int32 SizeY, const TArray<FColor>& Bitmap, TArray<uint8>& OutData)
+{
+	if (Format == ESLImageFormat::RLE)
+	{
+		return EncodeRLE(SizeX, SizeY, Bitmap, OutData);
+	}
+	FImageUtils::CompressImageArray(SizeX, SizeY, Bitmap, OutData);
+	return OutData.Num() > 0;
+}
+
+// Run-length encode the image, the tiles of rows are encoded in parallel
+bool FSLImageCodec::EncodeRLE(int32 SizeX, int32 SizeY, const TArray<FColor>& Bitmap, TArray<uint8>& OutData, int32 RowsPerTile)
+{
+	if (SizeX <= 0 || SizeY <= 0 || Bitmap.Num() != SizeX * SizeY)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Invalid image size %dx%d for %d pixels.."),
+			*FString(__FUNCTION__), __LINE__, SizeX, SizeY, Bitmap.Num());
+		return false;
+	}
+
+	RowsPerTile = FMath::Clamp(RowsPerTile, 1, SizeY);
+	const int32 NumTiles = FMath::DivideAndRoundUp(SizeY, RowsPerTile);
+	TArray<TArray<uint8>> Tiles;
+	Tiles.SetNum(NumTiles);
+
+	ParallelFor(NumTiles, [&](int32 TileIdx)
+	{
+		const FColor* Pixels = Bitmap.GetData() + (int64)TileIdx * RowsPerTile * SizeX;
+		const int32 NumPixels = FMath::Min(RowsPerTile, SizeY - TileIdx * RowsPerTile) * SizeX;
+		TArray<uint8>& Tile = Tiles[TileIdx];
+		Tile.Reserve(1024);
+
+		int32 PixelIdx = 0;
+		while (PixelIdx < NumPixels)
+		{
+			const FColor RunColor = Pixels[PixelIdx];
+			const int32 RunStart = PixelIdx;
+			while (PixelIdx < NumPixels && Pixels[PixelIdx] == RunColor)
+			{
+				PixelIdx++;
+			}
+
+			Tile.Add(RunColor.B);
+			Tile.Add(RunColor.G);
+			Tile.Add(RunColor.R);
+			Tile.Add(RunColor.A);
+			uint32 RunLength = PixelIdx - RunStart;
+			while (RunLength >= 0x80)
+			{
+				Tile.Add((uint8)((RunLength & 0x7F) | 0x80));
+				RunLength >>= 7;
+			}
+			Tile.Add((uint8)RunLength);
+		}
+	});
+
+	int32 DataSize = 0;
+	for (const auto& Tile : Tiles)
+	{
+		DataSize += Tile.Num();
+	}
+
+	OutData.Reset(SL_RLE_HEADER_SIZE + NumTiles * sizeof(uint32) + DataSize);
+	AppendUInt32(OutData, SL_RLE_MAGIC);
+	AppendUInt32(OutData, SL_RLE_VERSION);
+	AppendUInt32(OutData, SizeX);
+	AppendUInt32(OutData, SizeY);
+	AppendUInt32(OutData, RowsPerTile);
+	AppendUInt32(OutData, NumTiles);
+	uint32 TileEnd = 0;
+	for (const auto& Tile : Tiles)
+	{
+		TileEnd += Tile.Num();
+		AppendUInt32(OutData, TileEnd);
+	}
+	for (const auto& Tile : Tiles)
+	{
+		OutData.Append(Tile);
+	}
+	return true;
+}
+
+// Decode the run-length encoded image
+bool FSLImageCodec::DecodeRLE(const TArray<uint8>& Data, int32& OutSizeX, int32& OutSizeY, TArray<FColor>& OutBitmap)
+{
+	if (Data.Num() < SL_RLE_HEADER_SIZE
+		|| ReadUInt32(Data.GetData()) != SL_RLE_MAGIC
+		|| ReadUInt32(Data.GetData() + 4) != SL_RLE_VERSION)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Data is not a valid run-length encoded image.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	const int32 SizeX = ReadUInt32(Data.GetData() + 8);
+	const int32 SizeY = ReadUInt32(Data.GetData() + 12);
+	const int32 RowsPerTile = ReadUInt32(Data.GetData() + 16);
+	const int32 NumTiles = ReadUInt32(Data.GetData() + 20);
+	const int64 TilesBegin = SL_RLE_HEADER_SIZE + (int64)NumTiles * sizeof(uint32);
+	// The header is not trusted, the image size is checked before allocating the bitmap
+	if (SizeX <= 0 || SizeY <= 0 || (int64)SizeX * SizeY > SL_RLE_MAX_PIXELS
+		|| RowsPerTile <= 0 || NumTiles != FMath::DivideAndRoundUp(SizeY, RowsPerTile) || TilesBegin > Data.Num())
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Invalid run-length image header.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	OutBitmap.SetNumUninitialized(SizeX * SizeY);
+	FThreadSafeCounter NumInvalidTiles;
+	ParallelFor(NumTiles, [&](int32 TileIdx)
+	{
+		const int64 Begin = TilesBegin + (TileIdx > 0 ? ReadUInt32(Data.GetData() + SL_RLE_HEADER_SIZE + (TileIdx - 1) * sizeof(uint32)) : 0);
+		const int64 End = TilesBegin + ReadUInt32(Data.GetData() + SL_RLE_HEADER_SIZE + TileIdx * sizeof(uint32));
+		FColor* Pixels = OutBitmap.GetData() + (int64)TileIdx * RowsPerTile * SizeX;
+		const int32 NumPixels = FMath::Min(RowsPerTile, SizeY - TileIdx * RowsPerTile) * SizeX;
+		if (Begin > End || End > Data.Num())
+		{
+			NumInvalidTiles.Increment();
+			return;
+		}
+
+		int64 ByteIdx = Begin;
+		int32 PixelIdx = 0;
+		while (ByteIdx + 4 < End)
+		{
+			const FColor RunColor(Data[ByteIdx + 2], Data[ByteIdx + 1], Data[ByteIdx], Data[ByteIdx + 3]);
+			ByteIdx += 4;
+			uint32 RunLength = 0;
+			int32 Shift = 0;
+			while (ByteIdx < End && Shift < 32)
+			{
+				const uint8 Byte = Data[ByteIdx++];
+				RunLength |= (uint32)(Byte & 0x7F) << Shift;
+				Shift += 7;
+				if ((Byte & 0x80) == 0)
+				{
+					break;
+				}
+			}
+			if (RunLength > (uint32)(NumPixels - PixelIdx))
+			{
+				break;
+			}
+			for (uint32 Idx = 0; Idx < RunLength; ++Idx)
+			{
+				Pixels[PixelIdx++] = RunColor;
+			}
+		}
+		if (PixelIdx != NumPixels)
+		{
+			NumInvalidTiles.Increment();
+		}
+	});
+
+	if (NumInvalidTiles.GetValue() > 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d %d corrupted tiles in the run-length image.."),
+			*FString(__FUNCTION__), __LINE__, NumInvalidTiles.GetValue());
+		return false;
+	}
+	OutSizeX = SizeX;
+	OutSizeY = SizeY;
+	return true;
+}
+
+// Get the name of the format
+const TCHAR* FSLImageCodec::GetFormatName(ESLImageFormat Format)
+{
+	switch (Format)
+	{
+	case ESLImageFormat::PNG: return TEXT("png");
+	case ESLImageFormat::RLE: return TEXT("slrle");
+	default: return TEXT("unknown");
+	}
+}
+
+// Get the file extension of the format (with the dot)
+const TCHAR* FSLImageCodec::GetFileExtension(ESLImageFormat Format)
+{
+	switch (Format)
+	{
+	case ESLImageFormat::RLE: return TEXT(".slrle");
+	default: return TEXT(".png");
+	}
+}
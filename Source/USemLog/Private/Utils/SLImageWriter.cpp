@@ -0,0 +1,149 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Utils/SLImageWriter.h"
+#include "Misc/FileHelper.h"
+
+/* Image write task */
+// Ctor
+FSLImageWriteTask::FSLImageWriteTask(int32 InSizeX, int32 InSizeY, TArray<FColor>&& InBitmap, const TArray<FString>& InPaths,
+	TFunction<void(TArray<FColor>&)> InPostProcess, bool bInKeepCompressed, ESLImageFormat InFormat,
+	TSharedPtr<FSLImageWriteResult, ESPMode::ThreadSafe> InResult, FSLImageCodecStats* InStats) :
+	SizeX(InSizeX), SizeY(InSizeY), Bitmap(MoveTemp(InBitmap)), Paths(InPaths),
+	PostProcess(MoveTemp(InPostProcess)), bKeepCompressed(bInKeepCompressed), Format(InFormat),
+	Result(InResult), Stats(InStats)
+{
+}
+
+// Post-process, compress and save the image
+void FSLImageWriteTask::DoWork()
+{
+	if (PostProcess)
+	{
+		PostProcess(Bitmap);
+	}
+
+	const double EncodeBegin = FPlatformTime::Seconds();
+	TArray<uint8> CompressedBitmap;
+	FSLImageCodec::Encode(Format, SizeX, SizeY, Bitmap, CompressedBitmap);
+	Stats->Add(Bitmap.Num() * sizeof(FColor), CompressedBitmap.Num(), FPlatformTime::Seconds() - EncodeBegin);
+
+	for (const FString& Path : Paths)
+	{
+		if (!FFileHelper::SaveArrayToFile(CompressedBitmap, *Path))
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Could not save %s.."), *FString(__FUNCTION__), __LINE__, *Path);
+		}
+	}
+
+	if (bKeepCompressed)
+	{
+		Result->CompressedBitmap = MoveTemp(CompressedBitmap);
+	}
+	Result->Format = Format;
+
+	// Release the raw image before the task is deleted on the game thread
+	Bitmap.Empty();
+	Result->bDone = true;
+}
+
+
+/* Image writer */
+// Ctor
+FSLImageWriter::FSLImageWriter(int32 InMaxPendingImages)
+{
+	SetMaxPendingImages(InMaxPendingImages);
+}
+
+// Dtor, waits for the pending images
+FSLImageWriter::~FSLImageWriter()
+{
+	Flush();
+}
+
+// Post-process (optional), compress and save the image on a worker thread (no paths skips saving)
+TSharedPtr<FSLImageWriteResult, ESPMode::ThreadSafe> FSLImageWriter::AddImage(int32 SizeX, int32 SizeY, TArray<FColor>&& Bitmap,
+	const TArray<FString>& Paths, TFunction<void(TArray<FColor>&)> PostProcess, bool bKeepCompressed,
+	ESLImageFormat Format)
+{
+	// Bounded number of raw images in memory, wait for the oldest one if the limit is reached
+	RemoveDoneTasks();
+	if (PendingTasks.Num() >= MaxPendingImages)
+	{
+		const double WaitBegin = FPlatformTime::Seconds();
+		PendingTasks[0]->EnsureCompletion();
+		RemoveDoneTasks();
+		BlockedDuration += FPlatformTime::Seconds() - WaitBegin;
+	}
+
+	TSharedPtr<FSLImageWriteResult, ESPMode::ThreadSafe> Result = MakeShared<FSLImageWriteResult, ESPMode::ThreadSafe>();
+	FAsyncTask<FSLImageWriteTask>* Task = new FAsyncTask<FSLImageWriteTask>(
+		SizeX, SizeY, MoveTemp(Bitmap), Paths, MoveTemp(PostProcess), bKeepCompressed, Format, Result, &FormatStats[(int32)Format]);
+	Task->StartBackgroundTask();
+	PendingTasks.Add(Task);
+	NumImages++;
+	return Result;
+}
+
+// Block until the given image is done (the images are processed in order, the older ones are waited for as well)
+void FSLImageWriter::Wait(const TSharedPtr<FSLImageWriteResult, ESPMode::ThreadSafe>& Result)
+{
+	const double WaitBegin = FPlatformTime::Seconds();
+	for (FAsyncTask<FSLImageWriteTask>* Task : PendingTasks)
+	{
+		if (Result->bDone)
+		{
+			break;
+		}
+		Task->EnsureCompletion();
+	}
+	RemoveDoneTasks();
+	BlockedDuration += FPlatformTime::Seconds() - WaitBegin;
+}
+
+// Block until all the pending images are done
+void FSLImageWriter::Flush()
+{
+	const double WaitBegin = FPlatformTime::Seconds();
+	for (FAsyncTask<FSLImageWriteTask>* Task : PendingTasks)
+	{
+		Task->EnsureCompletion();
+		delete Task;
+	}
+	PendingTasks.Empty();
+	BlockedDuration += FPlatformTime::Seconds() - WaitBegin;
+}
+
+// Log the number of written images, the time the caller was blocked and the per-format size and throughput
+void FSLImageWriter::LogStats() const
+{
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Images=%d, pending=%d, blocked=[%f] seconds..;"),
+		*FString(__FUNCTION__), __LINE__, NumImages, PendingTasks.Num(), BlockedDuration);
+	for (int32 FormatIdx = 0; FormatIdx < (int32)ESLImageFormat::Num; ++FormatIdx)
+	{
+		const FSLImageCodecStats& Stats = FormatStats[FormatIdx];
+		const int64 NumEncoded = Stats.NumImages.GetValue();
+		if (NumEncoded == 0)
+		{
+			continue;
+		}
+		const double RawMB = Stats.RawBytes.GetValue() / (1024.0 * 1024.0);
+		const double EncodedMB = Stats.EncodedBytes.GetValue() / (1024.0 * 1024.0);
+		const double EncodeSeconds = FMath::Max(Stats.EncodeMicroseconds.GetValue() / 1000000.0, SMALL_NUMBER);
+		UE_LOG(LogTemp, Log, TEXT("%s::%d \t %s: images=%lld; raw=%.2fMB; encoded=%.2fMB; ratio=%.2f; throughput=%.2fMB/s (per thread);"),
+			*FString(__FUNCTION__), __LINE__, FSLImageCodec::GetFormatName((ESLImageFormat)FormatIdx),
+			NumEncoded, RawMB, EncodedMB, EncodedMB > 0 ? RawMB / EncodedMB : 0.0, RawMB / EncodeSeconds);
+	}
+}
+
+// Delete the finished tasks from the front of the queue
+void FSLImageWriter::RemoveDoneTasks()
+{
+	int32 NumDone = 0;
+	while (NumDone < PendingTasks.Num() && PendingTasks[NumDone]->IsDone())
+	{
+		delete PendingTasks[NumDone];
+		NumDone++;
+	}
+	PendingTasks.RemoveAt(0, NumDone, false);
+}
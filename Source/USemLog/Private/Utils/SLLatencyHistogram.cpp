@@ -0,0 +1,65 @@
+// Copyright 2017-present, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "Utils/SLLatencyHistogram.h"
+
+// Add a sample in seconds (can be called from any thread)
+void FSLLatencyHistogram::AddSample(double DurationInSeconds)
+{
+	Buckets[GetBucketIdx(DurationInSeconds * 1000000.0)].Increment();
+	NumSamples.Increment();
+}
+
+// Get the approximated percentile (0-1) in milliseconds
+double FSLLatencyHistogram::GetPercentileMs(float Percentile) const
+{
+	const int32 Total = NumSamples.GetValue();
+	if (Total == 0)
+	{
+		return 0.0;
+	}
+
+	const int32 Rank = FMath::Max(1, FMath::CeilToInt(FMath::Clamp(Percentile, 0.f, 1.f) * Total));
+	int32 Cumulated = 0;
+	for (int32 Idx = 0; Idx < NumBuckets; ++Idx)
+	{
+		Cumulated += Buckets[Idx].GetValue();
+		if (Cumulated >= Rank)
+		{
+			return GetBucketValue(Idx) / 1000.0;
+		}
+	}
+	return GetBucketValue(NumBuckets - 1) / 1000.0;
+}
+
+// Remove all samples
+void FSLLatencyHistogram::Reset()
+{
+	for (int32 Idx = 0; Idx < NumBuckets; ++Idx)
+	{
+		Buckets[Idx].Reset();
+	}
+	NumSamples.Reset();
+}
+
+// Get the bucket index of the duration in microseconds
+int32 FSLLatencyHistogram::GetBucketIdx(double DurationInUs)
+{
+	if (DurationInUs < 1.0)
+	{
+		return 0;
+	}
+	const int32 Idx = FMath::FloorToInt(FMath::Log2(static_cast<float>(DurationInUs)) * NumSubBuckets) + 1;
+	return FMath::Clamp(Idx, 1, NumBuckets - 1);
+}
+
+// Get the representative duration (microseconds) of the bucket
+double FSLLatencyHistogram::GetBucketValue(int32 BucketIdx)
+{
+	if (BucketIdx == 0)
+	{
+		return 0.5;
+	}
+	// Geometric middle of the bucket
+	return FMath::Pow(2.f, (BucketIdx - 1 + 0.5f) / NumSubBuckets);
+}
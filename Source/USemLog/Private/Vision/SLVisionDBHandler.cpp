@@ -99,6 +99,10 @@ bool FSLVisionDBHandler::Connect(const FString& DBName, const FString& CollName,
 		return false;
 	}
 
+	// The buckets are dropped with the vis collection (or the logging is skipped if it exists), so only the
+	// files of a run interrupted before its vis collection was created can be found and reused here
+	LoadGridFsHashes();
+
 	// Double check that the server is alive. Ping the "admin" database
 	bson_t* server_ping_cmd;
 	server_ping_cmd = BCON_NEW("ping", BCON_INT32(1));
@@ -128,6 +132,8 @@ bool FSLVisionDBHandler::Connect(const FString& DBName, const FString& CollName,
 void FSLVisionDBHandler::Disconnect() const
 {
 #if SL_WITH_LIBMONGO_C
+	LogGridFsStats();
+
 	// Release handles and clean up mongoc
 	if (uri)
 	{
@@ -290,6 +296,31 @@ void FSLVisionDBHandler::CreateIndexes() const
 	bson_free(idx_skeid_str);
 	bson_free(idx_skecls_str);
 	bson_free(idx_skebcls_str);
+
+	// Index the image content hashes of the gridfs files
+	mongoc_collection_t* files_collection = mongoc_gridfs_get_files(gridfs);
+	bson_t idx_sha1;
+	bson_init(&idx_sha1);
+	BSON_APPEND_INT32(&idx_sha1, "metadata.sha1", 1);
+	char* idx_sha1_str = mongoc_collection_keys_to_index_string(&idx_sha1);
+	bson_t* files_index_command = BCON_NEW("createIndexes",
+		BCON_UTF8(mongoc_collection_get_name(files_collection)),
+		"indexes",
+		"[",
+			"{",
+				"key",
+				BCON_DOCUMENT(&idx_sha1),
+				"name",
+				BCON_UTF8(idx_sha1_str),
+			"}",
+		"]");
+	if (!mongoc_collection_write_command_with_opts(files_collection, files_index_command, NULL/*opts*/, NULL/*reply*/, &error))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Create gridfs indexes err.: %s"),
+			*FString(__func__), __LINE__, *FString(error.message));
+	}
+	bson_destroy(files_index_command);
+	bson_free(idx_sha1_str);
 #endif //SL_WITH_LIBMONGO_C
 }
 
@@ -396,7 +427,7 @@ bool FSLVisionDBHandler::GetEpisodeData(float UpdateRate, const TMap<ASkeletalMe
 }
 
 // Write current frame
-void FSLVisionDBHandler::WriteFrame(const FSLVisionFrameData& Frame) const
+void FSLVisionDBHandler::WriteFrame(const FSLVisionFrameData& Frame)
 {
 #if SL_WITH_LIBMONGO_C
 	// Document holding the frame data in bson format
@@ -525,6 +556,7 @@ void FSLVisionDBHandler::WriteFrame(const FSLVisionFrameData& Frame) const
 				BSON_APPEND_DOCUMENT_BEGIN(&imgs_arr, k_key, &imgs_arr_obj);
 
 				BSON_APPEND_UTF8(&imgs_arr_obj, "type", TCHAR_TO_UTF8(*Img.Type));
+				BSON_APPEND_UTF8(&imgs_arr_obj, "format", TCHAR_TO_UTF8(FSLImageCodec::GetFormatName(Img.Format)));
 				BSON_APPEND_OID(&imgs_arr_obj, "file_id", (const bson_oid_t*)&file_oid);
 
 				bson_append_document_end(&imgs_arr, &imgs_arr_obj);
@@ -804,8 +836,8 @@ bool FSLVisionDBHandler::GetSkeletalEntitiesData(bson_iter_t* doc,
 	return false;
 }
 
-// Save image to gridfs, get the file oid and return true if succeeded
-bool FSLVisionDBHandler::AddToGridFs(const TArray<uint8>& InData, bson_oid_t* out_oid) const
+// Save image to gridfs (or reuse the file of an identical image), get the file oid and return true if succeeded
+bool FSLVisionDBHandler::AddToGridFs(const TArray<uint8>& InData, bson_oid_t* out_oid)
 {
 	mongoc_gridfs_file_t *file;
 	mongoc_gridfs_file_opt_t file_opt = { 0 };
@@ -813,12 +845,20 @@ bool FSLVisionDBHandler::AddToGridFs(const TArray<uint8>& InData, bson_oid_t* ou
 	mongoc_iovec_t iov;
 	bson_error_t error;
 
-	//bson_t* metadata_doc;
-	//metadata_doc = BCON_NEW(
-	//	"type", BCON_UTF8(TCHAR_TO_UTF8(*ImgData.RenderType))
-	//);
-	//file_opt.filename = "no_name";
-	//file_opt.metadata = metadata_doc;
+	// Static cameras produce many identical images, these reference the already stored file
+	FSHAHash Hash;
+	FSHA1::HashBuffer(InData.GetData(), InData.Num(), Hash.Hash);
+	NumGridFsImages++;
+	GridFsImageBytes += InData.Num();
+	if (const bson_oid_t* existing_oid = GridFsHashes.Find(Hash))
+	{
+		bson_oid_copy(existing_oid, out_oid);
+		return true;
+	}
+
+	// Store the content hash with the file
+	bson_t* metadata_doc = BCON_NEW("sha1", BCON_UTF8(TCHAR_TO_UTF8(*Hash.ToString())));
+	file_opt.metadata = metadata_doc;
 
 	// Create new file
 	file = mongoc_gridfs_create_file(gridfs, &file_opt);
@@ -835,6 +875,7 @@ bool FSLVisionDBHandler::AddToGridFs(const TArray<uint8>& InData, bson_oid_t* ou
 			UE_LOG(LogTemp, Warning, TEXT("%s::%d Err.:%s"),
 				*FString(__func__), __LINE__, *FString(error.message));
 		}
+		bson_destroy(metadata_doc);
 		mongoc_gridfs_file_destroy(file);
 		return false;
 	}
@@ -845,6 +886,7 @@ bool FSLVisionDBHandler::AddToGridFs(const TArray<uint8>& InData, bson_oid_t* ou
 		mongoc_gridfs_file_error(file, &error);
 		UE_LOG(LogTemp, Warning, TEXT("%s::%d Err.:%s"),
 			*FString(__func__), __LINE__, *FString(error.message));
+		bson_destroy(metadata_doc);
 		mongoc_gridfs_file_destroy(file);
 		return false;
 	}
@@ -852,14 +894,62 @@ bool FSLVisionDBHandler::AddToGridFs(const TArray<uint8>& InData, bson_oid_t* ou
 	// Set the out oid
 	file_id_val = mongoc_gridfs_file_get_id(file);
 	bson_oid_copy(&file_id_val->value.v_oid, out_oid);
+	GridFsHashes.Add(Hash, *out_oid);
+	NumGridFsFiles++;
+	GridFsFileBytes += InData.Num();
 
 	// Clean up
-	//bson_destroy(metadata_doc);
+	bson_destroy(metadata_doc);
 	mongoc_gridfs_file_destroy(file);
 
 	return true;
 }
 
+// Load the content hashes of the images already stored in the gridfs bucket (orphaned files of an interrupted run)
+void FSLVisionDBHandler::LoadGridFsHashes()
+{
+	GridFsHashes.Empty();
+	bson_t* filter = BCON_NEW("metadata.sha1", "{", "$exists", BCON_BOOL(true), "}");
+	bson_t* opts = BCON_NEW("projection", "{", "metadata", BCON_INT32(1), "}");
+	mongoc_gridfs_file_list_t* file_list = mongoc_gridfs_find_with_opts(gridfs, filter, opts);
+	mongoc_gridfs_file_t* file;
+	while ((file = mongoc_gridfs_file_list_next(file_list)))
+	{
+		bson_iter_t iter;
+		const bson_t* metadata = mongoc_gridfs_file_get_metadata(file);
+		const bson_value_t* file_id_val = mongoc_gridfs_file_get_id(file);
+		if (metadata && file_id_val && file_id_val->value_type == BSON_TYPE_OID
+			&& bson_iter_init_find(&iter, metadata, "sha1") && BSON_ITER_HOLDS_UTF8(&iter))
+		{
+			FSHAHash Hash;
+			Hash.FromString(FString(UTF8_TO_TCHAR(bson_iter_utf8(&iter, NULL))));
+			GridFsHashes.Add(Hash, file_id_val->value.v_oid);
+		}
+		mongoc_gridfs_file_destroy(file);
+	}
+	mongoc_gridfs_file_list_destroy(file_list);
+	bson_destroy(filter);
+	bson_destroy(opts);
+
+	if (GridFsHashes.Num() > 0)
+	{
+		UE_LOG(LogTemp, Log, TEXT("%s::%d Loaded %d stored image hashes.."), *FString(__func__), __LINE__, GridFsHashes.Num());
+	}
+}
+
+// Log the number of written and deduplicated images
+void FSLVisionDBHandler::LogGridFsStats() const
+{
+	if (NumGridFsImages == 0)
+	{
+		return;
+	}
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Images=%d; stored files=%d (%.2f%%); image size=%.2fMB; stored size=%.2fMB (%.2f%%);"),
+		*FString(__func__), __LINE__, NumGridFsImages, NumGridFsFiles, 100.f * NumGridFsFiles / NumGridFsImages,
+		GridFsImageBytes / (1024.0 * 1024.0), GridFsFileBytes / (1024.0 * 1024.0),
+		GridFsImageBytes > 0 ? 100.0 * GridFsFileBytes / GridFsImageBytes : 0.0);
+}
+
 // Write the bson doc containing the vision data to the entry corresponding to the timestamp
 bool FSLVisionDBHandler::WriteToWorldColl_Legacy(bson_t* doc, float Timestamp) const
 {
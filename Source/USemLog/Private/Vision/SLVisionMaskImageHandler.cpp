@@ -2,12 +2,15 @@
 // Author: Andrei Haidu (http://haidu.eu)
 
 #include "Vision/SLVisionMaskImageHandler.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
 
 
 // Ctor
 FSLVisionMaskImageHandler::FSLVisionMaskImageHandler()
 {
 	bIsInit = false;
+	SlotTableBits = 0;
 }
 
 // Load the color to entities mapping
@@ -76,18 +79,43 @@ bool FSLVisionMaskImageHandler::Init()
 		//		*FColor::FromHex(Pair.Value.OrigMaskColor).ToString());
 		//}
 
+		BuildColorSlots();
 		bIsInit = true;
 		return true;
 	}
 	return true;
 }
 
+// Use the given color to entities mapping (e.g. synthetic masks)
+bool FSLVisionMaskImageHandler::Init(const TMap<FColor, FSLVisionMaskEntityInfo>& InRenderedColorToEntityInfo,
+	const TMap<FColor, FSLVisionMaskSkelInfo>& InRenderedColorToSkelInfo)
+{
+	Reset();
+	if (InRenderedColorToEntityInfo.Num() == 0 && InRenderedColorToSkelInfo.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Init failed, no entities given.."), *FString(__func__), __LINE__);
+		return false;
+	}
+	RenderedColorToEntityInfo = InRenderedColorToEntityInfo;
+	RenderedColorToSkelInfo = InRenderedColorToSkelInfo;
+	BuildColorSlots();
+	bIsInit = true;
+	return true;
+}
+
 // Clear init flag and mappings
 void FSLVisionMaskImageHandler::Reset()
 {
 	bIsInit = false;
 	RenderedColorToEntityInfo.Empty();
 	RenderedColorToSkelInfo.Empty();
+	SlotRenderedColors.Empty();
+	SlotOriginalColors.Empty();
+	SlotTableKeys.Empty();
+	SlotTableValues.Empty();
+	SlotTableBits = 0;
+	BandColorsData.Empty();
+	BandTouchedSlots.Empty();
 }
 
 // Restore image (the screenshot image pixel colors are a bit offseted from the supposed mask value) and get the entities from mask image
@@ -95,101 +123,122 @@ void FSLVisionMaskImageHandler::GetDataAndRestoreImage(TArray<FColor>& MaskBitma
 	FSLVisionViewData& OutViewData) const
 {
 	// Used to calculate the percentage of an entity in the image
-	const int64 ImgTotalPixels = ImgWidth * ImgHeight;
-
-	// Index position of the image matrix in rows and columns (used for storing the bounding box of the entities)
-	int32 RowIdx = 0;
-	int32 ColIdx = 0;
-
-	// Store the occurance of every color in the image to its data
-	TMap<FColor, FSLVisionImageColorInfo> TempRenderedColorsData;
+	const int64 ImgTotalPixels = (int64)ImgWidth * ImgHeight;
+	if (ImgTotalPixels <= 0 || MaskBitmapToRestore.Num() < ImgTotalPixels || SlotTableValues.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Invalid image size or the handler is not initialized.."), *FString(__func__), __LINE__);
+		return;
+	}
+	const int32 NumSlots = SlotRenderedColors.Num();
+
+	// The rows are split into bands processed in parallel, every band gathers the color data of its own slots
+	// (the band arrays are kept between the images, they only hold data for the touched slots while processing)
+	const int32 NumBands = FMath::Clamp(FTaskGraphInterface::Get().GetNumWorkerThreads() * 4, 1, ImgHeight);
+	const int32 RowsPerBand = FMath::DivideAndRoundUp(ImgHeight, NumBands);
+	const FSLVisionImageColorInfo EmptyColorData(0, FIntPoint(MAX_int32, MAX_int32), FIntPoint(-1, -1));
+	if (BandColorsData.Num() != NumBands * NumSlots)
+	{
+		BandColorsData.Init(EmptyColorData, NumBands * NumSlots);
+	}
+	BandTouchedSlots.SetNum(NumBands);
 
-	// Array of rendered colors without a semantic match (store in array to avoid smapping the logger everytime the color appears)
-	TSet<FColor> UnknownColors;
+	// Rendered colors without a semantic match (stored to avoid spamming the logger everytime the color appears)
+	TArray<TSet<uint32>> BandUnknownColors;
+	BandUnknownColors.SetNum(NumBands);
 
-	// Restore image colors and create a mapping of all the rendered pixel colors to its data
-	for (auto& PixelColor : MaskBitmapToRestore)
+	uint32* Pixels = reinterpret_cast<uint32*>(MaskBitmapToRestore.GetData());
+	const uint32 PackedBlack = FColor::Black.DWColor();
+	ParallelFor(NumBands, [&](int32 BandIdx)
 	{
-		// Ignore color black (represents semantically unknown areas, normally there should not be any
-		if (PixelColor != FColor::Black)
+		FSLVisionImageColorInfo* ColorsData = BandColorsData.GetData() + BandIdx * NumSlots;
+		TArray<int32>& TouchedSlots = BandTouchedSlots[BandIdx];
+		const int32 FirstRow = BandIdx * RowsPerBand;
+		const int32 LastRow = FMath::Min(FirstRow + RowsPerBand, ImgHeight);
+		for (int32 RowIdx = FirstRow; RowIdx < LastRow; ++RowIdx)
 		{
-			// Check if the color is new
-			if (FSLVisionImageColorInfo* ColorData = TempRenderedColorsData.Find(PixelColor))
+			uint32* Row = Pixels + (int64)RowIdx * ImgWidth;
+			int32 ColIdx = 0;
+			while (ColIdx < ImgWidth)
 			{
-				// Color already stored, update its data
-				(*ColorData).Num++;
-
-				// Update the bounding box in the image
-				if (RowIdx < (*ColorData).MinBB.Y)
+				// Neighbouring pixels mostly share the same color, the slot lookup and the bounding box update are done once per run
+				const uint32 RunColor = Row[ColIdx];
+				const int32 RunStart = ColIdx;
+				while (ColIdx < ImgWidth && Row[ColIdx] == RunColor)
 				{
-					(*ColorData).MinBB.Y = RowIdx;
+					ColIdx++;
 				}
-				if (RowIdx > (*ColorData).MaxBB.Y)
-				{
-					(*ColorData).MaxBB.Y = RowIdx;
-				}
-				if (ColIdx < (*ColorData).MinBB.X)
+
+				// Ignore color black (represents semantically unknown areas, normally there should not be any
+				if (RunColor == PackedBlack)
 				{
-					(*ColorData).MinBB.X = ColIdx;
+					continue;
 				}
-				if (ColIdx > (*ColorData).MaxBB.X)
+
+				const int32 Slot = FindColorSlot(RunColor);
+				if (Slot == INDEX_NONE)
 				{
-					(*ColorData).MaxBB.X = ColIdx;
+					BandUnknownColors[BandIdx].Add(RunColor);
+					continue;
 				}
 
-				// Fix image by changing the rendered color to the original value
-				PixelColor = (*ColorData).OriginalMaskColor;
-			}
-			else
-			{
-				// Cache rendered color, since the pixel color will be restored to the original mask (if found)
-				const FColor RenderedColor = PixelColor;
-
-				// New color, cache its info
-				FSLVisionImageColorInfo ColorInfo(1, FIntPoint(ImgWidth, ImgHeight), FIntPoint(0, 0));
-
-				// Get the original mask color value
-				if (const FSLVisionMaskEntityInfo* EntityInfo = RenderedColorToEntityInfo.Find(RenderedColor))
+				FSLVisionImageColorInfo& ColorData = ColorsData[Slot];
+				if (ColorData.Num == 0)
 				{
-					// Color found as an entity visual mask
-					ColorInfo.OriginalMaskColor = FColor::FromHex((*EntityInfo).OrigMaskColor);
-
-					// Cache the color info in the local map
-					TempRenderedColorsData.Emplace(RenderedColor, ColorInfo);
-
-					// Fix image by changing the rendered color to the original value
-					PixelColor = ColorInfo.OriginalMaskColor;
+					TouchedSlots.Add(Slot);
 				}
-				else if (const FSLVisionMaskSkelInfo* SkelInfo = RenderedColorToSkelInfo.Find(RenderedColor))
-				{
-					// Color found as a skeletal visual mask
-					ColorInfo.OriginalMaskColor = FColor::FromHex((*SkelInfo).OrigMaskColor);
-
-					// Cache the color info in the local map
-					TempRenderedColorsData.Emplace(RenderedColor, ColorInfo);
+				ColorData.Num += ColIdx - RunStart;
+				ColorData.MinBB.X = FMath::Min(ColorData.MinBB.X, RunStart);
+				ColorData.MaxBB.X = FMath::Max(ColorData.MaxBB.X, ColIdx - 1);
+				ColorData.MinBB.Y = FMath::Min(ColorData.MinBB.Y, RowIdx);
+				ColorData.MaxBB.Y = FMath::Max(ColorData.MaxBB.Y, RowIdx);
 
-					// Fix image by changing the rendered color to the original value
-					PixelColor = ColorInfo.OriginalMaskColor;
-				}
-				else if(!UnknownColors.Contains(PixelColor))
+				// Fix image by changing the rendered color to the original value
+				const uint32 OrigColor = SlotOriginalColors[Slot].DWColor();
+				for (int32 PixelIdx = RunStart; PixelIdx < ColIdx; ++PixelIdx)
 				{
-					UnknownColors.Add(PixelColor);
-					UE_LOG(LogTemp, Error, TEXT("%s::%d Rendered color %s - %s has no mapping to any entity.. this should not happen.."),
-						*FString(__func__), __LINE__, *RenderedColor.ToString(), *RenderedColor.ToHex());
+					Row[PixelIdx] = OrigColor;
 				}
 			}
 		}
+	});
 
-		// Update current pixel index position
-		ColIdx++;
-
-		// Check for row change
-		if (ColIdx > ImgWidth - 1)
+	// Merge the touched slots of the bands into the first band, and reset them for the next image
+	for (int32 BandIdx = 1; BandIdx < NumBands; ++BandIdx)
+	{
+		for (const int32 Slot : BandTouchedSlots[BandIdx])
 		{
-			ColIdx = 0;
-			RowIdx++;
+			FSLVisionImageColorInfo& BandColorData = BandColorsData[BandIdx * NumSlots + Slot];
+			FSLVisionImageColorInfo& ColorData = BandColorsData[Slot];
+			if (ColorData.Num == 0)
+			{
+				BandTouchedSlots[0].Add(Slot);
+			}
+			ColorData.Num += BandColorData.Num;
+			ColorData.MinBB = ColorData.MinBB.ComponentMin(BandColorData.MinBB);
+			ColorData.MaxBB = ColorData.MaxBB.ComponentMax(BandColorData.MaxBB);
+			BandColorData = EmptyColorData;
 		}
+		BandTouchedSlots[BandIdx].Reset();
+		BandUnknownColors[0].Append(BandUnknownColors[BandIdx]);
+	}
+
+	for (const uint32 PackedColor : BandUnknownColors[0])
+	{
+		FColor RenderedColor;
+		RenderedColor.DWColor() = PackedColor;
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Rendered color %s - %s has no mapping to any entity.. this should not happen.."),
+			*FString(__func__), __LINE__, *RenderedColor.ToString(), *RenderedColor.ToHex());
+	}
+
+	// Store the occurance of every color in the image to its data
+	TMap<FColor, FSLVisionImageColorInfo> TempRenderedColorsData;
+	TempRenderedColorsData.Reserve(BandTouchedSlots[0].Num());
+	for (const int32 Slot : BandTouchedSlots[0])
+	{
+		TempRenderedColorsData.Emplace(SlotRenderedColors[Slot], BandColorsData[Slot]);
+		BandColorsData[Slot] = EmptyColorData;
 	}
+	BandTouchedSlots[0].Reset();
 
 	// Store skeletal related data in a temp map, this will need an extra processing to calculcate the data as a whole skeleton (from bones)
 	TMap<FString, FSLVisionViewSkelData> TempIdToSkelData;
@@ -254,6 +303,44 @@ void FSLVisionMaskImageHandler::GetDataAndRestoreImage(TArray<FColor>& MaskBitma
 	}
 }
 
+// Build the rendered color to slot lookup table from the entity mappings
+void FSLVisionMaskImageHandler::BuildColorSlots()
+{
+	SlotRenderedColors.Reset();
+	SlotOriginalColors.Reset();
+	for (const auto& Pair : RenderedColorToEntityInfo)
+	{
+		SlotRenderedColors.Add(Pair.Key);
+		SlotOriginalColors.Add(FColor::FromHex(Pair.Value.OrigMaskColor));
+	}
+	for (const auto& Pair : RenderedColorToSkelInfo)
+	{
+		// The entity mapping has priority if the color is used by both
+		if (!RenderedColorToEntityInfo.Contains(Pair.Key))
+		{
+			SlotRenderedColors.Add(Pair.Key);
+			SlotOriginalColors.Add(FColor::FromHex(Pair.Value.OrigMaskColor));
+		}
+	}
+
+	// Keep the table at most half full for short probe sequences
+	const uint32 TableSize = FMath::Max(FMath::RoundUpToPowerOfTwo(SlotRenderedColors.Num() * 2), 16u);
+	SlotTableBits = FMath::FloorLog2(TableSize);
+	SlotTableKeys.Init(0, TableSize);
+	SlotTableValues.Init(INDEX_NONE, TableSize);
+	for (int32 Slot = 0; Slot < SlotRenderedColors.Num(); ++Slot)
+	{
+		const uint32 PackedColor = SlotRenderedColors[Slot].DWColor();
+		uint32 TableIdx = (PackedColor * 0x9E3779B1u) >> (32 - SlotTableBits);
+		while (SlotTableValues[TableIdx] != INDEX_NONE)
+		{
+			TableIdx = (TableIdx + 1) & (TableSize - 1);
+		}
+		SlotTableKeys[TableIdx] = PackedColor;
+		SlotTableValues[TableIdx] = Slot;
+	}
+}
+
 // Restore the color of the pixel to its original mask value (offseted by screenshot rendering artifacts), returns true if restoration happened
 bool FSLVisionMaskImageHandler::RestoreColorValueFromArray(FColor& RenderedPixelColor, const TArray<FColor>& InOriginalMaskColors, uint8 Tolerance) const
 {
@@ -9,6 +9,8 @@
 #include "Materials/Material.h"
 #include "Materials/MaterialInstanceDynamic.h"
 #include "Engine/GameViewportClient.h"
+#include "Camera/PlayerCameraManager.h"
+#include "GameFramework/PlayerController.h"
 #include "HighResScreenshot.h"
 #include "ImageUtils.h"
 #include "Async.h"
@@ -31,6 +33,9 @@ USLVisionOverlapCalc::USLVisionOverlapCalc() : bIsInit(false), bIsStarted(false)
 	CurrPMAClone = nullptr;
 	bSkelArrayActive = false;
 	bSkelBoneActive = false;
+	bBatchEntities = false;
+	bEntityBatchActive = false;
+	EntityBatchIndex = INDEX_NONE;
 }
 
 // Destructor
@@ -39,7 +44,7 @@ USLVisionOverlapCalc::~USLVisionOverlapCalc()
 }
 
 // Give control to the overlap calc to pause and start its parent (vision logger)
-void USLVisionOverlapCalc::Init(USLVisionLogger* InParent, FIntPoint InResolution, const FString& InSaveLocallyPath)
+void USLVisionOverlapCalc::Init(USLVisionLogger* InParent, FIntPoint InResolution, const FString& InSaveLocallyPath, bool bInBatchEntities)
 {
 	if (!bIsInit)
 	{
@@ -48,6 +53,7 @@ void USLVisionOverlapCalc::Init(USLVisionLogger* InParent, FIntPoint InResolutio
 		ViewportClient = GetWorld()->GetGameViewport();
 		Resolution = InResolution;
 		SaveLocallyFolderName = InSaveLocallyPath;
+		bBatchEntities = bInBatchEntities;
 
 		// Load the default mask material
 		// this will be used as a template to create the non-occluding mask materials to add to the clones
@@ -89,13 +95,24 @@ void USLVisionOverlapCalc::Start(FSLVisionViewData* CurrViewData, float Timestam
 		}
 		TotalOverlapCalcNum = Entities->Num() + SkelEntities->Num() + NumBones;
 		
-		if (!SelectFirstItem())
+		if (bBatchEntities && BuildEntityBatches())
 		{
-			UE_LOG(LogTemp, Error, TEXT("%s::%d No items found in the scene.."), *FString(__func__), __LINE__);
-			return;
+			// One screenshot per batch instead of one per entity
+			TotalOverlapCalcNum = EntityBatches.Num() + SkelEntities->Num() + NumBones;
+			EntityBatchIndex = 0;
+			bEntityBatchActive = true;
+			ApplyBatchNonOccludingMaterial();
 		}
+		else
+		{
+			if (!SelectFirstItem())
+			{
+				UE_LOG(LogTemp, Error, TEXT("%s::%d No items found in the scene.."), *FString(__func__), __LINE__);
+				return;
+			}
 
-		ApplyNonOccludingMaterial();
+			ApplyNonOccludingMaterial();
+		}
 
 
 		// Switch callback functions and pause parent
@@ -122,6 +139,12 @@ void USLVisionOverlapCalc::Finish()
 		SkelIndex = INDEX_NONE;
 		
 		bSkelArrayActive = false;
+
+		bEntityBatchActive = false;
+		EntityBatchIndex = INDEX_NONE;
+		EntityBatches.Empty();
+		EntityScreenRects.Empty();
+		EntityClones.Empty();
 		
 		Entities = nullptr;
 		SkelEntities = nullptr;
@@ -160,8 +183,15 @@ void USLVisionOverlapCalc::ScreenshotCB(int32 SizeX, int32 SizeY, const TArray<F
 	// Terminal output with the log progress
 	PrintProgress();
 
-	// Calcuate overlap for the currently selected item
-	CalculateOverlap(Bitmap, SizeX, SizeY);
+	// Calcuate overlap for the currently selected item(s)
+	if (bEntityBatchActive)
+	{
+		CalculateBatchOverlaps(Bitmap, SizeX, SizeY);
+	}
+	else
+	{
+		CalculateOverlap(Bitmap, SizeX, SizeY);
+	}
 
 	// Save the png locally
 	if (!SaveLocallyFolderName.IsEmpty())
@@ -174,6 +204,36 @@ void USLVisionOverlapCalc::ScreenshotCB(int32 SizeX, int32 SizeY, const TArray<F
 		FFileHelper::SaveArrayToFile(CompressedBitmap, *Path);
 	}
 
+	if (bEntityBatchActive)
+	{
+		ReApplyBatchOriginalMaterial();
+
+		// Continue with the next batch, or with the skeletal items
+		EntityBatchIndex++;
+		if (EntityBatches.IsValidIndex(EntityBatchIndex))
+		{
+			CurrOverlapCalcIdx++;
+			ApplyBatchNonOccludingMaterial();
+			RequestScreenshot();
+		}
+		else
+		{
+			bEntityBatchActive = false;
+			EntityBatchIndex = INDEX_NONE;
+			if (SelectFirstSkel())
+			{
+				CurrOverlapCalcIdx++;
+				ApplyNonOccludingMaterial();
+				RequestScreenshot();
+			}
+			else
+			{
+				Finish();
+			}
+		}
+		return;
+	}
+
 	// Re-apply original material before selecting the next item
 	ReApplyOriginalMaterial();
 
@@ -637,6 +697,258 @@ void USLVisionOverlapCalc::CalculateOverlap(const TArray<FColor>& NonOccludedIma
 	}	
 }
 
+// Count the white (non occluded) pixels inside the rectangle, and check if any of them touches the image edge
+void USLVisionOverlapCalc::CountNonOccludedPixels(const TArray<FColor>& NonOccludedImage, int32 ImgWidth, int32 ImgHeight,
+	const FIntRect& Rect, int64& OutNum, bool& bOutIsClipped)
+{
+	OutNum = 0;
+	bOutIsClipped = false;
+
+	const int32 MinX = FMath::Max(Rect.Min.X, 0);
+	const int32 MinY = FMath::Max(Rect.Min.Y, 0);
+	const int32 MaxX = FMath::Min(Rect.Max.X, ImgWidth);
+	const int32 MaxY = FMath::Min(Rect.Max.Y, ImgHeight);
+	if (NonOccludedImage.Num() < ImgWidth * ImgHeight)
+	{
+		return;
+	}
+
+	const FColor* Pixels = NonOccludedImage.GetData();
+	for (int32 Y = MinY; Y < MaxY; ++Y)
+	{
+		const FColor* Row = Pixels + Y * ImgWidth;
+		const bool bEdgeRow = Y == 0 || Y == ImgHeight - 1;
+		for (int32 X = MinX; X < MaxX; ++X)
+		{
+			if (Row[X] == FColor::White)
+			{
+				OutNum++;
+				if (bEdgeRow || X == 0 || X == ImgWidth - 1)
+				{
+					bOutIsClipped = true;
+				}
+			}
+		}
+	}
+}
+
+// Get the occlusion percentage from the visible and the non occluded image percentages
+float USLVisionOverlapCalc::GetOcclusionPercentage(float ImgPerc, float NonOccImgPerc)
+{
+	if (NonOccImgPerc <= 0.f)
+	{
+		return 0.f;
+	}
+	// (non occ image perc - occ image perc / non occ image perc)
+	const float OccPerc = (NonOccImgPerc - ImgPerc) / NonOccImgPerc;
+	return OccPerc < 0.01f ? 0.f : OccPerc;
+}
+
+// Greedily group the rectangles into batches without overlapping rectangles (empty rectangles fit in any batch)
+void USLVisionOverlapCalc::GroupNonOverlappingRects(const TArray<FIntRect>& Rects, TArray<TArray<int32>>& OutBatches)
+{
+	OutBatches.Reset();
+	for (int32 Idx = 0; Idx < Rects.Num(); ++Idx)
+	{
+		const FIntRect& Rect = Rects[Idx];
+
+		// First batch without overlapping rectangles
+		bool bAdded = false;
+		for (TArray<int32>& Batch : OutBatches)
+		{
+			bool bOverlaps = false;
+			for (int32 OtherIdx : Batch)
+			{
+				const FIntRect& Other = Rects[OtherIdx];
+				if (Rect.Min.X < Other.Max.X && Other.Min.X < Rect.Max.X &&
+					Rect.Min.Y < Other.Max.Y && Other.Min.Y < Rect.Max.Y)
+				{
+					bOverlaps = true;
+					break;
+				}
+			}
+			if (!bOverlaps)
+			{
+				Batch.Add(Idx);
+				bAdded = true;
+				break;
+			}
+		}
+		if (!bAdded)
+		{
+			OutBatches.AddDefaulted_GetRef().Add(Idx);
+		}
+	}
+}
+
+/* Batch mode */
+// Group the entities with non overlapping screen bounds, return false if there are no entities
+bool USLVisionOverlapCalc::BuildEntityBatches()
+{
+	EntityBatches.Reset();
+	EntityScreenRects.Reset();
+	EntityClones.Reset();
+	if (!Entities || Entities->Num() == 0)
+	{
+		return false;
+	}
+
+	const FIntRect FullRect(0, 0, Resolution.X, Resolution.Y);
+	for (int32 Idx = 0; Idx < Entities->Num(); ++Idx)
+	{
+		AStaticMeshActor* SMAClone = Parent->GetStaticMeshMaskCloneFromId((*Entities)[Idx].Id);
+		EntityClones.Add(SMAClone);
+		if (!SMAClone)
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Could not find pointer to entity %s - %s, continuing.."),
+				*FString(__func__), __LINE__, *(*Entities)[Idx].Class, *(*Entities)[Idx].Id);
+			EntityScreenRects.Add(FIntRect());
+			continue;
+		}
+
+		// Unprojectable entities get the full image, so they end up alone in their batch
+		FIntRect Rect;
+		if (!GetScreenRect(SMAClone, Rect))
+		{
+			Rect = FullRect;
+		}
+		EntityScreenRects.Add(Rect);
+	}
+	GroupNonOverlappingRects(EntityScreenRects, EntityBatches);
+
+	UE_LOG(LogTemp, Log, TEXT("%s::%d %d entities in %d batches.."),
+		*FString(__func__), __LINE__, Entities->Num(), EntityBatches.Num());
+	return EntityBatches.Num() > 0;
+}
+
+// Get the conservative screen rectangle of the actor bounds in the overlap screenshot (false if it cannot be projected)
+bool USLVisionOverlapCalc::GetScreenRect(AStaticMeshActor* SMA, FIntRect& OutRect) const
+{
+	APlayerController* PC = GetWorld()->GetFirstPlayerController();
+	if (!PC || !PC->PlayerCameraManager || Resolution.X <= 0 || Resolution.Y <= 0)
+	{
+		return false;
+	}
+	const FVector CamLoc = PC->PlayerCameraManager->GetCameraLocation();
+	const FRotator CamRot = PC->PlayerCameraManager->GetCameraRotation();
+	const float TanHalfFOV = FMath::Tan(FMath::DegreesToRadians(PC->PlayerCameraManager->GetFOVAngle() * 0.5f));
+	const float AspectRatio = (float)Resolution.X / Resolution.Y;
+	if (TanHalfFOV <= 0.f)
+	{
+		return false;
+	}
+
+	FVector Origin;
+	FVector Extent;
+	SMA->GetActorBounds(false, Origin, Extent);
+
+	// Project the corners of the bounding box (horizontal fov is kept)
+	FVector2D Min(BIG_NUMBER, BIG_NUMBER);
+	FVector2D Max(-BIG_NUMBER, -BIG_NUMBER);
+	for (int32 Corner = 0; Corner < 8; ++Corner)
+	{
+		const FVector Point = Origin + Extent * FVector(Corner & 1 ? 1.f : -1.f, Corner & 2 ? 1.f : -1.f, Corner & 4 ? 1.f : -1.f);
+		const FVector Local = CamRot.UnrotateVector(Point - CamLoc);
+		if (Local.X < KINDA_SMALL_NUMBER)
+		{
+			// Behind or at the camera
+			return false;
+		}
+		const float ScreenX = (0.5f + 0.5f * Local.Y / (Local.X * TanHalfFOV)) * Resolution.X;
+		const float ScreenY = (0.5f - 0.5f * Local.Z * AspectRatio / (Local.X * TanHalfFOV)) * Resolution.Y;
+		Min.X = FMath::Min(Min.X, ScreenX);
+		Min.Y = FMath::Min(Min.Y, ScreenY);
+		Max.X = FMath::Max(Max.X, ScreenX);
+		Max.Y = FMath::Max(Max.Y, ScreenY);
+	}
+
+	// Add a margin for the rasterization
+	const int32 Margin = 2;
+	OutRect.Min.X = FMath::Clamp(FMath::FloorToInt(Min.X) - Margin, 0, Resolution.X);
+	OutRect.Min.Y = FMath::Clamp(FMath::FloorToInt(Min.Y) - Margin, 0, Resolution.Y);
+	OutRect.Max.X = FMath::Clamp(FMath::CeilToInt(Max.X) + Margin, 0, Resolution.X);
+	OutRect.Max.Y = FMath::Clamp(FMath::CeilToInt(Max.Y) + Margin, 0, Resolution.Y);
+	return OutRect.Min.X < OutRect.Max.X && OutRect.Min.Y < OutRect.Max.Y;
+}
+
+// Apply the non occluding material to all the entities of the current batch
+void USLVisionOverlapCalc::ApplyBatchNonOccludingMaterial()
+{
+	UMaterialInstanceDynamic* NonOccludingDynamicMaskMaterial = UMaterialInstanceDynamic::Create(DefaultNonOccludingMaterial, GetTransientPackage());
+	NonOccludingDynamicMaskMaterial->SetVectorParameterValue(FName("MaskColorParam"), FLinearColor::White);
+
+	// The original materials of the batch are cached in order
+	for (int32 Idx : EntityBatches[EntityBatchIndex])
+	{
+		if (EntityClones[Idx])
+		{
+			if (UStaticMeshComponent* MC = EntityClones[Idx]->GetStaticMeshComponent())
+			{
+				for (int32 MaterialIndex = 0; MaterialIndex < MC->GetNumMaterials(); ++MaterialIndex)
+				{
+					CachedMaterials.Add(MC->GetMaterial(MaterialIndex));
+					MC->SetMaterial(MaterialIndex, NonOccludingDynamicMaskMaterial);
+				}
+			}
+		}
+	}
+}
+
+// Re-apply the original materials to the entities of the current batch
+void USLVisionOverlapCalc::ReApplyBatchOriginalMaterial()
+{
+	int32 CachedIdx = 0;
+	for (int32 Idx : EntityBatches[EntityBatchIndex])
+	{
+		if (EntityClones[Idx])
+		{
+			if (UStaticMeshComponent* MC = EntityClones[Idx]->GetStaticMeshComponent())
+			{
+				for (int32 MaterialIndex = 0; MaterialIndex < MC->GetNumMaterials() && CachedMaterials.IsValidIndex(CachedIdx); ++MaterialIndex)
+				{
+					MC->SetMaterial(MaterialIndex, CachedMaterials[CachedIdx++]);
+				}
+			}
+		}
+	}
+	CachedMaterials.Empty();
+}
+
+// Calculate the overlaps of all the entities of the current batch in a single pass over the image
+void USLVisionOverlapCalc::CalculateBatchOverlaps(const TArray<FColor>& NonOccludedImage, int32 ImgWidth, int32 ImgHeight)
+{
+	const int64 ImgTotalPixels = (int64)ImgWidth * ImgHeight;
+	if (ImgTotalPixels == 0)
+	{
+		return;
+	}
+
+	// Scale the rectangles if the screenshot has a different resolution than requested
+	const float ScaleX = Resolution.X > 0 ? (float)ImgWidth / Resolution.X : 1.f;
+	const float ScaleY = Resolution.Y > 0 ? (float)ImgHeight / Resolution.Y : 1.f;
+
+	// The rectangles of the batch do not overlap, every pixel is visited at most once
+	for (int32 Idx : EntityBatches[EntityBatchIndex])
+	{
+		if (!EntityClones[Idx])
+		{
+			continue;
+		}
+		const FIntRect& Rect = EntityScreenRects[Idx];
+		const FIntRect ImgRect(
+			FMath::FloorToInt(Rect.Min.X * ScaleX), FMath::FloorToInt(Rect.Min.Y * ScaleY),
+			FMath::CeilToInt(Rect.Max.X * ScaleX), FMath::CeilToInt(Rect.Max.Y * ScaleY));
+
+		int64 NumWhitePixels = 0;
+		bool bIsClipped = false;
+		CountNonOccludedPixels(NonOccludedImage, ImgWidth, ImgHeight, ImgRect, NumWhitePixels, bIsClipped);
+
+		FSLVisionViewEntityData& Entity = (*Entities)[Idx];
+		Entity.OcclusionPercentage = GetOcclusionPercentage(Entity.ImagePercentage, (float)NumWhitePixels / ImgTotalPixels);
+		Entity.bIsClipped = bIsClipped;
+	}
+}
+
 // Output progress to terminal
 void USLVisionOverlapCalc::PrintProgress() const
 {
@@ -3,7 +3,149 @@
 
 #include "Viz/SLVizEpisodeManager.h"
 #include "Viz/SLVizEpisodeUtils.h"
+#include "Mongo/SLMongoEpisodeStream.h"
 #include "Components/PoseableMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "HAL/PlatformTime.h"
+
+// Add a new target, the already stored keyframes get the initial pose of the target (returns the target index)
+int32 FSLVizEpisodeData::AddTarget(const FString& TargetId, AActor* Actor, UPoseableMeshComponent* BoneComponent, int32 BoneIndex, const FTransform& InitialPose)
+{
+	const int32 PrevNumTargets = NumTargets();
+	const int32 NumKeys = NumKeyframes();
+	if (NumKeys > 0)
+	{
+		// Re-stride the keyframes, only happens if an individual appears after the first frame
+		TArray<FTransform> NewKeyframePoses;
+		NewKeyframePoses.Reserve(NumKeys * (PrevNumTargets + 1));
+		for (int32 KeyIdx = 0; KeyIdx < NumKeys; ++KeyIdx)
+		{
+			NewKeyframePoses.Append(KeyframePoses.GetData() + KeyIdx * PrevNumTargets, PrevNumTargets);
+			NewKeyframePoses.Add(InitialPose);
+		}
+		KeyframePoses = MoveTemp(NewKeyframePoses);
+	}
+
+	TargetIds.Add(TargetId);
+	TargetIdToIdx.Add(TargetId, PrevNumTargets);
+	TargetFirstFrames.Add(INDEX_NONE);
+	TargetActors.Add(Actor);
+	TargetBoneComponents.Add(BoneComponent);
+	TargetBoneIndices.Add(BoneIndex);
+	return PrevNumTargets;
+}
+
+// Append a frame with the given changes, ChangedPoses holds the state of all targets after the changes (used for the keyframes)
+void FSLVizEpisodeData::AddFrame(float Timestamp, const TArray<TPair<int32, FTransform>>& Changes, const TArray<FTransform>& ChangedPoses)
+{
+	KeyframeInterval = FMath::Max(KeyframeInterval, 1);
+	if (DeltaOffsets.Num() == 0)
+	{
+		DeltaOffsets.Add(0);
+	}
+
+	const int32 FrameIndex = Timestamps.Add(Timestamp);
+	for (const auto& Change : Changes)
+	{
+		if (TargetFirstFrames[Change.Key] == INDEX_NONE)
+		{
+			TargetFirstFrames[Change.Key] = FrameIndex;
+		}
+		DeltaTargets.Add(Change.Key);
+		DeltaPoses.Add(Change.Value);
+	}
+	DeltaOffsets.Add(DeltaTargets.Num());
+
+	if (FrameIndex % KeyframeInterval == 0)
+	{
+		KeyframePoses.Append(ChangedPoses);
+	}
+}
+
+// Reconstruct the full poses of the frame from its keyframe and the following deltas (O(KeyframeInterval))
+void FSLVizEpisodeData::GetFramePoses(int32 FrameIndex, TArray<FTransform>& OutPoses) const
+{
+	const int32 NumPoses = NumTargets();
+	const int32 KeyframeIndex = FrameIndex / KeyframeInterval;
+	OutPoses.SetNumUninitialized(NumPoses, false);
+	FMemory::Memcpy(OutPoses.GetData(), KeyframePoses.GetData() + KeyframeIndex * NumPoses, NumPoses * sizeof(FTransform));
+
+	// The keyframe already includes the changes of its own frame
+	const int32 FirstDelta = DeltaOffsets[KeyframeIndex * KeyframeInterval + 1];
+	const int32 LastDelta = DeltaOffsets[FrameIndex + 1];
+	for (int32 DeltaIdx = FirstDelta; DeltaIdx < LastDelta; ++DeltaIdx)
+	{
+		OutPoses[DeltaTargets[DeltaIdx]] = DeltaPoses[DeltaIdx];
+	}
+}
+
+// Set the first sample frame of every target from the delta arrays (used when the deltas are loaded as a whole)
+void FSLVizEpisodeData::SetTargetFirstFrames()
+{
+	TargetFirstFrames.Init(INDEX_NONE, NumTargets());
+	for (int32 FrameIndex = 0; FrameIndex < NumFrames(); ++FrameIndex)
+	{
+		for (int32 DeltaIdx = DeltaOffsets[FrameIndex]; DeltaIdx < DeltaOffsets[FrameIndex + 1]; ++DeltaIdx)
+		{
+			int32& FirstFrame = TargetFirstFrames[DeltaTargets[DeltaIdx]];
+			if (FirstFrame == INDEX_NONE)
+			{
+				FirstFrame = FrameIndex;
+			}
+		}
+	}
+}
+
+// Get the pose of the target with the given individual id at the given time (false if the target is missing or has no sample until the given time)
+bool FSLVizEpisodeData::GetTargetPoseAt(const FString& TargetId, float Ts, FTransform& OutPose) const
+{
+	const int32* TargetIdxPtr = TargetIdToIdx.Find(TargetId);
+	if (TargetIdxPtr == nullptr || !IsValid() || Ts < Timestamps[0])
+	{
+		return false;
+	}
+	const int32 TargetIdx = *TargetIdxPtr;
+
+	// Before its first sample the target only has its initial world pose, the db has no pose for it
+	const int32 FrameIndex = FSLVizEpisodeUtils::BinarySearchLessEqual(Timestamps, Ts);
+	if (TargetFirstFrames[TargetIdx] == INDEX_NONE || FrameIndex < TargetFirstFrames[TargetIdx])
+	{
+		return false;
+	}
+
+	// Start from the keyframe pose and apply the later changes of the target only
+	const int32 KeyframeIndex = FrameIndex / KeyframeInterval;
+	OutPose = KeyframePoses[KeyframeIndex * NumTargets() + TargetIdx];
+	const int32 FirstDelta = DeltaOffsets[KeyframeIndex * KeyframeInterval + 1];
+	const int32 LastDelta = DeltaOffsets[FrameIndex + 1];
+	for (int32 DeltaIdx = LastDelta - 1; DeltaIdx >= FirstDelta; --DeltaIdx)
+	{
+		if (DeltaTargets[DeltaIdx] == TargetIdx)
+		{
+			OutPose = DeltaPoses[DeltaIdx];
+			break;
+		}
+	}
+	return true;
+}
+
+// Allocated memory of the episode data in bytes
+SIZE_T FSLVizEpisodeData::GetAllocatedSize() const
+{
+	return Id.GetAllocatedSize()
+		+ TaskId.GetAllocatedSize()
+		+ Timestamps.GetAllocatedSize()
+		+ TargetIds.GetAllocatedSize()
+		+ TargetIdToIdx.GetAllocatedSize()
+		+ TargetFirstFrames.GetAllocatedSize()
+		+ TargetActors.GetAllocatedSize()
+		+ TargetBoneComponents.GetAllocatedSize()
+		+ TargetBoneIndices.GetAllocatedSize()
+		+ KeyframePoses.GetAllocatedSize()
+		+ DeltaOffsets.GetAllocatedSize()
+		+ DeltaTargets.GetAllocatedSize()
+		+ DeltaPoses.GetAllocatedSize();
+}
 
 // Sets default values
 ASLVizEpisodeManager::ASLVizEpisodeManager()
@@ -16,12 +158,17 @@ ASLVizEpisodeManager::ASLVizEpisodeManager()
 	bEpisodeLoaded = false;
 	bLoopReplay = false;
 	bReplayRunning = false;
+	bStreamPlay = false;
+	StreamIndividualManager = nullptr;
 
-	EpisodeDefaultUpdateRate = 0.f;
+	ReplayTime = 0.0;
+	ReplayWallTime = 0.0;
+	ReplaySpeed = 1.f;
+	bInterpolateReplay = true;
+	ReplayEndTime = -1.f;
 	ActiveFrameIndex = INDEX_NONE;
 	ReplayFirstFrameIndex = INDEX_NONE;
 	ReplayLastFrameIndex = INDEX_NONE;
-	ReplayStepSize = 1;
 
 #if WITH_EDITORONLY_DATA
 	// Make manager sprite smaller (used to easily find the actor in the world)
@@ -34,12 +181,27 @@ void ASLVizEpisodeManager::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
-	if (!ApplyNextFrameChanges())
+	// The tick is also enabled while streaming
+	if (EpisodeStream.IsValid())
+	{
+		UpdateEpisodeStream();
+	}
+
+	if (!bReplayRunning)
+	{
+		return;
+	}
+
+	// The replay is driven by the wall-clock, independent of the tick rate and the world time dilation
+	const double CurrWallTime = FPlatformTime::Seconds();
+	const double DeltaWallTime = CurrWallTime - ReplayWallTime;
+	ReplayWallTime = CurrWallTime;
+
+	if (!AdvanceReplay(DeltaWallTime * ReplaySpeed))
 	{
 		if (bLoopReplay)
 		{
-			ActiveFrameIndex = ReplayFirstFrameIndex;
-			GotoFrame(ActiveFrameIndex);
+			GotoFrame(ReplayFirstFrameIndex);
 		}
 		else
 		{
@@ -68,11 +230,11 @@ void ASLVizEpisodeManager::ConvertWorld()
 	bWorldSetAsVisualOnly = true;
 }
 
-// Load episode data
-void ASLVizEpisodeManager::LoadEpisode(const FSLVizEpisodeData& InEpisodeData)
+// Load episode data (the data is shared with the cache, not copied)
+void ASLVizEpisodeManager::LoadEpisode(TSharedPtr<const FSLVizEpisodeData, ESPMode::ThreadSafe> InEpisodeData)
 {
 	// Check if the data is valid
-	if (!InEpisodeData.IsValid())
+	if (!InEpisodeData.IsValid() || !InEpisodeData->IsValid())
 	{
 		UE_LOG(LogTemp, Warning, TEXT("%s::%d Episode data is not valid to load.."), *FString(__FUNCTION__), __LINE__);
 		return;
@@ -91,9 +253,6 @@ void ASLVizEpisodeManager::LoadEpisode(const FSLVizEpisodeData& InEpisodeData)
 	// Set the episode data
 	EpisodeData = InEpisodeData;
 
-	// Calculate a default update rate  
-	CalcRealtimeAproxUpdateRateValue(256);
-
 	// Mark the episode loaded flag to true
 	bEpisodeLoaded = true;
 
@@ -101,11 +260,87 @@ void ASLVizEpisodeManager::LoadEpisode(const FSLVizEpisodeData& InEpisodeData)
 	GotoFrame(0);
 }
 
+// Load the episode from the stream, the replay (or the goto) starts as soon as the frames of the start time are streamed
+bool ASLVizEpisodeManager::LoadEpisodeStream(ASLIndividualManager* IndividualManager, const FString& InEpisodeId,
+	TSharedPtr<FSLMongoEpisodeStream, ESPMode::ThreadSafe> InStream, const FSLVizEpisodePlayParams& PlayParams, bool bPlay)
+{
+	if (!bWorldSetAsVisualOnly)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d World is not set as visual only.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+	// Already streaming, only update the replay parameters
+	if (IsEpisodeStreaming(InEpisodeId))
+	{
+		StreamPlayParams = PlayParams;
+		bStreamPlay = bPlay;
+		if (bEpisodeLoaded)
+		{
+			bPlay ? Play(PlayParams) : GotoFrame(PlayParams.StartTime);
+		}
+		return true;
+	}
+
+	if (!InStream.IsValid() || IndividualManager == nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Episode stream is not valid to load.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	// Clear any previous episode (and stream)
+	ClearEpisode();
+
+	EpisodeStream = InStream;
+	StreamedEpisodeData = MakeShared<FSLVizEpisodeData, ESPMode::ThreadSafe>();
+	StreamedEpisodeData->Id = InEpisodeId;
+	StreamedEpisodeData->TaskId = InStream->GetTaskId();
+	StreamIndividualManager = IndividualManager;
+	StreamPlayParams = PlayParams;
+	bStreamPlay = bPlay;
+
+	// The chunks are consumed in tick
+	SetActorTickEnabled(true);
+	return true;
+}
+
+// Check if the episode is currently being streamed
+bool ASLVizEpisodeManager::IsEpisodeStreaming(const FString& InEpisodeId) const
+{
+	return EpisodeStream.IsValid() && StreamedEpisodeData.IsValid() && StreamedEpisodeData->Id.Equals(InEpisodeId);
+}
+
+// Stop streaming, the already loaded frames are kept
+void ASLVizEpisodeManager::CancelEpisodeStream()
+{
+	if (!EpisodeStream.IsValid())
+	{
+		return;
+	}
+
+	// Waits for the worker to finish its current cursor batch
+	EpisodeStream->Cancel();
+	EpisodeStream.Reset();
+	StreamedEpisodeData.Reset();
+	StreamBuildState = FSLVizEpisodeBuildState();
+	StreamIndividualManager = nullptr;
+	if (!bReplayRunning)
+	{
+		SetActorTickEnabled(false);
+	}
+}
+
 // Remove episode data
 void ASLVizEpisodeManager::ClearEpisode()
 {
+	CancelEpisodeStream();
 	StopReplay();
-	EpisodeData.Clear();
+	EpisodeData.Reset();
+	FramePosesBuffer.Empty();
+	ReplayMeshes.Empty();
+	TargetMeshIndices.Empty();
+	ChangedTargets.Empty();
+	ChangedTargetFlags.Empty();
+	InterpolatedTargetFlags.Empty();
 	ActiveFrameIndex = INDEX_NONE;
 	ReplayFirstFrameIndex = INDEX_NONE;
 	ReplayLastFrameIndex = INDEX_NONE;
@@ -129,14 +364,16 @@ bool ASLVizEpisodeManager::GotoFrame(int32 FrameIndex)
 		return false;
 	}
 
-	if(!EpisodeData.FullFrames.IsValidIndex(FrameIndex))
+	if(!EpisodeData->Timestamps.IsValidIndex(FrameIndex))
 	{
 		UE_LOG(LogTemp, Warning, TEXT("%s::%d Frame index is not valid, this should not happen.."), *FString(__FUNCTION__), __LINE__);
 		return false;
 	}
 
 	ActiveFrameIndex = FrameIndex;
-	ApplyPoses(EpisodeData.FullFrames[FrameIndex]);
+	ReplayTime = EpisodeData->Timestamps[FrameIndex];
+	EpisodeData->GetFramePoses(FrameIndex, FramePosesBuffer);
+	ApplyPoses(FramePosesBuffer);
 
 	//UE_LOG(LogTemp, Log, TEXT("%s::%d Applied poses from frame %d.."), *FString(__FUNCTION__), __LINE__, ActiveFrameIndex);
 	return true;
@@ -145,7 +382,12 @@ bool ASLVizEpisodeManager::GotoFrame(int32 FrameIndex)
 // Set visual world as in the given timestamp (binary search for nearest index)
 bool ASLVizEpisodeManager::GotoFrame(float Timestamp)
 {
-	return GotoFrame(FSLVizEpisodeUtils::BinarySearchLessEqual(EpisodeData.Timestamps, Timestamp));
+	if (!bEpisodeLoaded)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d No episode is loaded.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+	return GotoFrame(FSLVizEpisodeUtils::BinarySearchLessEqual(EpisodeData->Timestamps, Timestamp));
 }
 
 // Play episode with the given parameters
@@ -166,17 +408,18 @@ bool ASLVizEpisodeManager::Play(const FSLVizEpisodePlayParams& PlayParams)
 	// Stop any previous replays
 	StopReplay();
 
+	// Set loop, tick rate, speed and interpolation
+	SetReplayParams(PlayParams.bLoop, PlayParams.UpdateRate, PlayParams.PlaybackSpeed, PlayParams.bInterpolate);
+
 	// Set first frame
 	ReplayFirstFrameIndex = PlayParams.StartTime < 0 ? 0 
-		: FSLVizEpisodeUtils::BinarySearchLessEqual(EpisodeData.Timestamps, PlayParams.StartTime);
+		: FSLVizEpisodeUtils::BinarySearchLessEqual(EpisodeData->Timestamps, PlayParams.StartTime);
 
 	// Set last frame
-	ReplayLastFrameIndex = PlayParams.EndTime < 0 ? EpisodeData.Timestamps.Num()
-		: PlayParams.EndTime < PlayParams.StartTime ? EpisodeData.Timestamps.Num() 
-			: FSLVizEpisodeUtils::BinarySearchLessEqual(EpisodeData.Timestamps, PlayParams.EndTime);
-
-	// Should the replay be looped
-	bLoopReplay = PlayParams.bLoop;
+	ReplayEndTime = PlayParams.EndTime < 0 || PlayParams.EndTime < PlayParams.StartTime ? -1.f : PlayParams.EndTime;
+	ReplayLastFrameIndex = PlayParams.EndTime < 0 ? EpisodeData->Timestamps.Num()
+		: PlayParams.EndTime < PlayParams.StartTime ? EpisodeData->Timestamps.Num() 
+			: FSLVizEpisodeUtils::BinarySearchLessEqual(EpisodeData->Timestamps, PlayParams.EndTime);
 
 	// Goto first frame
 	GotoFrame(ReplayFirstFrameIndex);
@@ -204,14 +447,14 @@ bool ASLVizEpisodeManager::PlayEpisode()
 
 	// Set replay flags
 	ReplayFirstFrameIndex = 0;
-	ReplayLastFrameIndex = EpisodeData.Timestamps.Num();
+	ReplayLastFrameIndex = EpisodeData->Timestamps.Num();
+	ReplayEndTime = -1.f;
 
 	// Goto first frame
 	GotoFrame(ReplayFirstFrameIndex);
 
-	// Enable tick with the given update rate
-	SetActorTickEnabled(true);
-	bReplayRunning = true;
+	// Start playing the frames
+	StartReplay();
 
 	return true;
 }
@@ -219,7 +462,12 @@ bool ASLVizEpisodeManager::PlayEpisode()
 // Play given frames
 bool ASLVizEpisodeManager::PlayFrames(int32 FirstFrame, int32 LastFrame)
 {
-	if (FirstFrame < 0 || LastFrame < 0 || FirstFrame > LastFrame || LastFrame > EpisodeData.Timestamps.Num())
+	if (!bEpisodeLoaded)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d No episode is loaded.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+	if (FirstFrame < 0 || LastFrame < 0 || FirstFrame > LastFrame || LastFrame > EpisodeData->Timestamps.Num())
 	{
 		UE_LOG(LogTemp, Error, TEXT("%s::%d FirstFrame=%d and LastFrame=%d are not valid.."), *FString(__FUNCTION__), __LINE__, FirstFrame, LastFrame);
 		return false;
@@ -227,13 +475,13 @@ bool ASLVizEpisodeManager::PlayFrames(int32 FirstFrame, int32 LastFrame)
 	// Set replay flags
 	ReplayFirstFrameIndex = FirstFrame;
 	ReplayLastFrameIndex = LastFrame;
+	ReplayEndTime = LastFrame < EpisodeData->Timestamps.Num() ? EpisodeData->Timestamps[LastFrame] : -1.f;
 
 	// Goto first frame
 	GotoFrame(ReplayFirstFrameIndex);
 
-	// Enable tick with the preconfigured update rate	
-	SetActorTickEnabled(true);
-	bReplayRunning = true;
+	// Start playing the frames with the preconfigured parameters
+	StartReplay();
 
 	return true;
 }
@@ -246,16 +494,25 @@ bool ASLVizEpisodeManager::PlayTimeline(float StartTime, float EndTime)
 		UE_LOG(LogTemp, Error, TEXT("%s::%d StartTime=%f and EndTime=%f are not valid.."), *FString(__FUNCTION__), __LINE__, StartTime, EndTime);
 		return false;
 	}
-	int32 StartFrameIndex = FSLVizEpisodeUtils::BinarySearchLessEqual(EpisodeData.Timestamps, StartTime);
-	int32 EndFrameIndex = FSLVizEpisodeUtils::BinarySearchLessEqual(EpisodeData.Timestamps, EndTime);
+	if (!bEpisodeLoaded)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d No episode is loaded.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+	int32 StartFrameIndex = FSLVizEpisodeUtils::BinarySearchLessEqual(EpisodeData->Timestamps, StartTime);
+	int32 EndFrameIndex = FSLVizEpisodeUtils::BinarySearchLessEqual(EpisodeData->Timestamps, EndTime);
 	return PlayFrames(StartFrameIndex, EndFrameIndex);
 }
 
 // Set replay parameters
-void ASLVizEpisodeManager::SetReplayParams(bool bLoop, float UpdateRate, int32 StepSize)
+void ASLVizEpisodeManager::SetReplayParams(bool bLoop, float UpdateRate, float PlaybackSpeed, bool bInterpolate)
 {
 	bLoopReplay = bLoop;
-	UpdateRate > 0.f ? SetActorTickInterval(UpdateRate) : SetActorTickInterval(EpisodeDefaultUpdateRate);
+	ReplaySpeed = FMath::Max(PlaybackSpeed, 0.01f);
+	bInterpolateReplay = bInterpolate;
+
+	// The replay time is independent of the tick, the interval only limits how often the poses are updated
+	SetActorTickInterval(UpdateRate > 0.f ? UpdateRate : 0.f);
 }
 
 // Set replay to pause or play
@@ -263,17 +520,20 @@ void ASLVizEpisodeManager::SetPauseReplay(bool bPause)
 {
 	if (bReplayRunning == bPause)
 	{
-		SetActorTickEnabled(!bPause);
+		SetActorTickEnabled(!bPause || EpisodeStream.IsValid());
 		bReplayRunning = !bPause;
+
+		// Continue from the paused time
+		ReplayWallTime = FPlatformTime::Seconds();
 	}
 }
 
 // Stop replay, goto first frame
 void ASLVizEpisodeManager::StopReplay()
 {
-	if (bReplayRunning || IsActorTickEnabled())
+	if (bReplayRunning || (IsActorTickEnabled() && !EpisodeStream.IsValid()))
 	{
-		SetActorTickEnabled(false);
+		SetActorTickEnabled(EpisodeStream.IsValid());
 		bReplayRunning = false;
 		GotoFrame(0);
 		ReplayFirstFrameIndex = INDEX_NONE;
@@ -471,99 +731,312 @@ void ASLVizEpisodeManager::StopReplay()
 //	}
 //}
 
-// Apply the next frames changes
-bool ASLVizEpisodeManager::ApplyNextFrameChanges()
+// Start replay
+void ASLVizEpisodeManager::StartReplay()
 {
-	if (ActiveFrameIndex < ReplayLastFrameIndex)
+	// The replay time continues from the active frame
+	ReplayTime = EpisodeData->Timestamps[ActiveFrameIndex];
+	ReplayWallTime = FPlatformTime::Seconds();
+
+	// Enable tick with the given update rate
+	SetActorTickEnabled(true);
+	bReplayRunning = true;
+}
+
+// Apply the full poses of all targets
+void ASLVizEpisodeManager::ApplyPoses(const TArray<FTransform>& Poses)
+{
+	BindReplayTargets();
+	for (int32 TargetIdx = 0; TargetIdx < Poses.Num(); ++TargetIdx)
+	{
+		SetTargetPose(TargetIdx, Poses[TargetIdx]);
+	}
+	ApplyBonePoses();
+}
+
+// Advance the replay time, apply the changed targets and interpolate towards the next frame
+bool ASLVizEpisodeManager::AdvanceReplay(double DeltaTime)
+{
+	BindReplayTargets();
+
+	const TArray<float>& Timestamps = EpisodeData->Timestamps;
+	const int32 LastFrameIndex = FMath::Min(ReplayLastFrameIndex, EpisodeData->NumFrames() - 1);
+
+	// While streaming, the replay waits at the last loaded frame until the next frames arrive
+	const bool bWaitForStream = EpisodeStream.IsValid() && (ReplayEndTime < 0.f || Timestamps.Last() < ReplayEndTime);
+	if (ActiveFrameIndex >= LastFrameIndex && !bWaitForStream)
+	{
+		return false;
+	}
+
+	ReplayTime += DeltaTime;
+	if (bWaitForStream && ReplayTime > Timestamps[LastFrameIndex])
+	{
+		ReplayTime = Timestamps[LastFrameIndex];
+	}
+
+	// Gather the targets changed by the passed frames, only their latest pose is applied
+	int32 FirstDelta;
+	int32 LastDelta;
+	while (ActiveFrameIndex < LastFrameIndex && Timestamps[ActiveFrameIndex + 1] <= ReplayTime)
 	{
 		ActiveFrameIndex++;
-		//if (EpisodeData.CompactFrames.IsValidIndex(ActiveFrameIndex))
-		if (EpisodeData.FullFrames.IsValidIndex(ActiveFrameIndex))
+		EpisodeData->GetDeltaRange(ActiveFrameIndex, FirstDelta, LastDelta);
+		for (int32 DeltaIdx = FirstDelta; DeltaIdx < LastDelta; ++DeltaIdx)
 		{
-			//ApplyPoses(EpisodeData.CompactFrames[ActiveFrameIndex]);
-			ApplyPoses(EpisodeData.FullFrames[ActiveFrameIndex]);
-			return true;
+			const int32 TargetIdx = EpisodeData->DeltaTargets[DeltaIdx];
+			FramePosesBuffer[TargetIdx] = EpisodeData->DeltaPoses[DeltaIdx];
+			if (!ChangedTargetFlags[TargetIdx])
+			{
+				ChangedTargetFlags[TargetIdx] = true;
+				ChangedTargets.Add(TargetIdx);
+			}
 		}
-		else
+	}
+
+	// Interpolate the targets changing in the next frame
+	const int32 NextFrameIndex = ActiveFrameIndex + 1;
+	const bool bInterpolate = bInterpolateReplay && NextFrameIndex <= LastFrameIndex
+		&& Timestamps[NextFrameIndex] > Timestamps[ActiveFrameIndex];
+	if (bInterpolate)
+	{
+		const float Alpha = FMath::Clamp(static_cast<float>((ReplayTime - Timestamps[ActiveFrameIndex])
+			/ (Timestamps[NextFrameIndex] - Timestamps[ActiveFrameIndex])), 0.f, 1.f);
+		EpisodeData->GetDeltaRange(NextFrameIndex, FirstDelta, LastDelta);
+		for (int32 DeltaIdx = FirstDelta; DeltaIdx < LastDelta; ++DeltaIdx)
+		{
+			const int32 TargetIdx = EpisodeData->DeltaTargets[DeltaIdx];
+			FTransform Pose;
+			Pose.Blend(FramePosesBuffer[TargetIdx], EpisodeData->DeltaPoses[DeltaIdx], Alpha);
+			SetTargetPose(TargetIdx, Pose);
+			InterpolatedTargetFlags[TargetIdx] = true;
+		}
+	}
+
+	// Apply the latest pose of the changed targets (if not interpolated)
+	for (const int32 TargetIdx : ChangedTargets)
+	{
+		if (!InterpolatedTargetFlags[TargetIdx])
+		{
+			SetTargetPose(TargetIdx, FramePosesBuffer[TargetIdx]);
+		}
+		ChangedTargetFlags[TargetIdx] = false;
+	}
+	ChangedTargets.Reset();
+
+	if (bInterpolate)
+	{
+		for (int32 DeltaIdx = FirstDelta; DeltaIdx < LastDelta; ++DeltaIdx)
 		{
-			//UE_LOG(LogTemp, Warning, TEXT("%s::%d ActiveFrameIndex=%d (Num=%d) is not valid, this should not happen.."),
-			//	*FString(__FUNCTION__), __LINE__, ActiveFrameIndex, EpisodeData.CompactFrames.Num());
-			UE_LOG(LogTemp, Warning, TEXT("%s::%d ActiveFrameIndex=%d (Num=%d) is not valid, this should not happen.."),
-				*FString(__FUNCTION__), __LINE__, ActiveFrameIndex, EpisodeData.FullFrames.Num());
-			ActiveFrameIndex--;
+			InterpolatedTargetFlags[EpisodeData->DeltaTargets[DeltaIdx]] = false;
 		}
 	}
-	return false;	
+
+	ApplyBonePoses();
+	return true;
 }
 
-// Start replay
-void ASLVizEpisodeManager::StartReplay()
+// Set the pose of the target, bone poses are applied with the next ApplyBonePoses call
+void ASLVizEpisodeManager::SetTargetPose(int32 TargetIdx, const FTransform& Pose)
 {
-	// Enable tick with the given update rate
-	SetActorTickEnabled(true);
-	bReplayRunning = true;}
+	const int32 MeshIdx = TargetMeshIndices[TargetIdx];
+	if (MeshIdx != INDEX_NONE)
+	{
+		// Store the world pose, it is converted to component space once the actors are moved
+		FSLVizReplayPoseableMesh& Mesh = ReplayMeshes[MeshIdx];
+		const int32 BoneIdx = EpisodeData->TargetBoneIndices[TargetIdx];
+		if (Mesh.WorldPoses.IsValidIndex(BoneIdx))
+		{
+			Mesh.WorldPoses[BoneIdx] = Pose;
+			Mesh.bDirty = true;
+		}
+	}
+	else
+	{
+		// todo, static components can be ignored (might make sense to remove them form the episode data)
+		AActor* Actor = EpisodeData->TargetActors[TargetIdx];
+		if (Actor->GetRootComponent()->Mobility != EComponentMobility::Static)
+		{
+			Actor->SetActorTransform(Pose);
+		}
+	}
+}
 
-// Apply frame poses
-void ASLVizEpisodeManager::ApplyPoses(const FSLVizEpisodeFrameData& Frame)
+// Apply the bone world poses of every changed poseable mesh in component space (parent-first)
+void ASLVizEpisodeManager::ApplyBonePoses()
 {
-	for (const auto& ActorPosePair : Frame.ActorPoses)
+	for (FSLVizReplayPoseableMesh& Mesh : ReplayMeshes)
 	{
-		// todo, static components can be ignored (might make sense to remove them form the episode data)
-		if (ActorPosePair.Key->GetRootComponent()->Mobility != EComponentMobility::Static)
+		if (!Mesh.bDirty)
 		{
-			ActorPosePair.Key->SetActorTransform(ActorPosePair.Value);
+			continue;
 		}
+
+		const FTransform ComponentTransform = Mesh.Component->GetComponentTransform();
+		TArray<FTransform>& BoneSpaceTransforms = Mesh.Component->BoneSpaceTransforms;
+		TArray<FTransform>& ComponentSpacePoses = Mesh.ComponentSpacePoses;
+
+		// The parents are always updated before their children, so every bone is visited once; the local
+		// transforms of the unchanged bones are recomputed as well so they keep their world pose if their parents moved
+		for (int32 BoneIdx = 0; BoneIdx < ComponentSpacePoses.Num(); ++BoneIdx)
+		{
+			const int32 ParentIdx = Mesh.ParentIndices[BoneIdx];
+			ComponentSpacePoses[BoneIdx] = Mesh.WorldPoses[BoneIdx].GetRelativeTransform(ComponentTransform);
+			BoneSpaceTransforms[BoneIdx] = ParentIdx == INDEX_NONE ? ComponentSpacePoses[BoneIdx]
+				: ComponentSpacePoses[BoneIdx].GetRelativeTransform(ComponentSpacePoses[ParentIdx]);
+		}
+
+		Mesh.Component->MarkRefreshTransformDirtyIfNeeded();
+		Mesh.bDirty = false;
+	}
+}
+
+// Bind the new targets of the episode data to their poseable mesh replay state
+void ASLVizEpisodeManager::BindReplayTargets()
+{
+	const int32 NumTargets = EpisodeData->NumTargets();
+	if (TargetMeshIndices.Num() == NumTargets)
+	{
+		return;
 	}
 
-	// todo, without this multiple iteration the bones are weirdly offseted
-	for (int32 Idx = 0; Idx < 5; Idx++)
+	// Streamed episodes can add targets after the first frames
+	for (int32 TargetIdx = TargetMeshIndices.Num(); TargetIdx < NumTargets; ++TargetIdx)
 	{
-		for (const auto& PMCBonePosesPair : Frame.BonePoses)
+		int32 MeshIdx = INDEX_NONE;
+		if (UPoseableMeshComponent* PMC = EpisodeData->TargetBoneComponents[TargetIdx])
 		{
-			UPoseableMeshComponent* PMC = PMCBonePosesPair.Key;
-			for (const auto& BoneIndexPosePair : PMCBonePosesPair.Value)
+			MeshIdx = ReplayMeshes.IndexOfByPredicate([PMC](const FSLVizReplayPoseableMesh& Mesh) { return Mesh.Component == PMC; });
+			if (MeshIdx == INDEX_NONE)
 			{
-				const FName BoneName = PMC->GetBoneName(BoneIndexPosePair.Key);
-				PMC->SetBoneTransformByName(BoneName, BoneIndexPosePair.Value, EBoneSpaces::WorldSpace);
+				MeshIdx = AddReplayPoseableMesh(PMC);
 			}
 		}
+		TargetMeshIndices.Add(MeshIdx);
+	}
+	ChangedTargets.Reset();
+	ChangedTargetFlags.Init(false, NumTargets);
+	InterpolatedTargetFlags.Init(false, NumTargets);
+
+	// The new targets are missing from the state of the active frame
+	if (FramePosesBuffer.Num() != NumTargets && EpisodeData->Timestamps.IsValidIndex(ActiveFrameIndex))
+	{
+		EpisodeData->GetFramePoses(ActiveFrameIndex, FramePosesBuffer);
 	}
 }
 
-// Calculate an approximation of the update rate value to coincide with realtime
-void ASLVizEpisodeManager::CalcRealtimeAproxUpdateRateValue(int32 MaxNumSteps)
+// Add the replay state of the poseable mesh (returns its index)
+int32 ASLVizEpisodeManager::AddReplayPoseableMesh(UPoseableMeshComponent* PMC)
 {
-	if (!EpisodeData.IsValid())
+	FSLVizReplayPoseableMesh Mesh;
+	Mesh.Component = PMC;
+
+	if (PMC->SkeletalMesh)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("%s::%d Episode data is not valid, cannot aprox a default update rate"),
-			*FString(__FUNCTION__), __LINE__);
-		EpisodeDefaultUpdateRate = 0.f;
+#if ENGINE_MINOR_VERSION > 26 || ENGINE_MAJOR_VERSION > 4
+		const FReferenceSkeleton& RefSkeleton = PMC->SkeletalMesh->GetRefSkeleton();
+#else
+		const FReferenceSkeleton& RefSkeleton = PMC->SkeletalMesh->RefSkeleton;
+#endif
+		const int32 NumBones = FMath::Min(RefSkeleton.GetNum(), PMC->BoneSpaceTransforms.Num());
+		const FTransform ComponentTransform = PMC->GetComponentTransform();
+		Mesh.ParentIndices.Reserve(NumBones);
+		Mesh.ComponentSpacePoses.Reserve(NumBones);
+		Mesh.WorldPoses.Reserve(NumBones);
+		for (int32 BoneIdx = 0; BoneIdx < NumBones; ++BoneIdx)
+		{
+			const int32 ParentIdx = RefSkeleton.GetParentIndex(BoneIdx);
+			Mesh.ParentIndices.Add(ParentIdx);
+			Mesh.ComponentSpacePoses.Add(ParentIdx == INDEX_NONE ? PMC->BoneSpaceTransforms[BoneIdx]
+				: PMC->BoneSpaceTransforms[BoneIdx] * Mesh.ComponentSpacePoses[ParentIdx]);
+			Mesh.WorldPoses.Add(Mesh.ComponentSpacePoses[BoneIdx] * ComponentTransform);
+		}
 	}
-
-	const int32 NumFrames = EpisodeData.Timestamps.Num();
-	if (MaxNumSteps > NumFrames / 2)
+	else
 	{
-		MaxNumSteps = NumFrames / 2;
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s has no skeletal mesh, its bones are not replayed.."),
+			*FString(__FUNCTION__), __LINE__, *PMC->GetName());
 	}
+	return ReplayMeshes.Add(MoveTemp(Mesh));
+}
 
-	// Make an average value using the MaxNumSteps entries from the first quarter
-	int32 StartFrameIdx = NumFrames / 4;
-	int32 EndFrameIdx = StartFrameIdx + MaxNumSteps;
-	float UpdateRate = 0.f;
-	if (EndFrameIdx > NumFrames)
+// Add the streamed chunks to the episode data, start the replay when enough frames are available
+void ASLVizEpisodeManager::UpdateEpisodeStream()
+{
+	// Bound the work per tick, the remaining chunks are consumed in the next ticks
+	const int32 MaxChunksPerTick = FMath::Max(EpisodeStream->GetParams().MaxChunksPerTick, 1);
+
+	TSharedPtr<FSLMongoEpisodeChunk, ESPMode::ThreadSafe> Chunk;
+	int32 NumChunks = 0;
+	while (NumChunks < MaxChunksPerTick && EpisodeStream->DequeueChunk(Chunk))
 	{
-		EndFrameIdx = NumFrames;
+		if (!FSLVizEpisodeUtils::AddEpisodeChunk(StreamIndividualManager, *Chunk, StreamBuildState, *StreamedEpisodeData))
+		{
+			UE_LOG(LogTemp, Error, TEXT("%s::%d Could not add the streamed chunk to episode %s, streaming aborted.."),
+				*FString(__FUNCTION__), __LINE__, *StreamedEpisodeData->Id);
+			CancelEpisodeStream();
+			return;
+		}
+		NumChunks++;
 	}
 
-	// Start from the first quarter, at the beginning one might have some outliers due to loading time spikes
-	for (int32 Idx = StartFrameIdx; Idx < EndFrameIdx - 1; ++Idx)
+	const bool bStreamFinished = EpisodeStream->IsFinished();
+	if (!bEpisodeLoaded)
 	{
-		UpdateRate += (EpisodeData.Timestamps[Idx + 1] - EpisodeData.Timestamps[Idx]);
+		if (StreamedEpisodeData->IsValid()
+			&& (bStreamFinished || StreamedEpisodeData->Timestamps.Last() >= StreamPlayParams.StartTime))
+		{
+			StartStreamedEpisode();
+		}
 	}
+	else if (ReplayLastFrameIndex != INDEX_NONE && NumChunks > 0)
+	{
+		// Extend the running replay with the new frames
+		ReplayLastFrameIndex = ReplayEndTime < 0.f ? StreamedEpisodeData->NumFrames()
+			: FSLVizEpisodeUtils::BinarySearchLessEqual(StreamedEpisodeData->Timestamps, ReplayEndTime);
+	}
+
+	if (bStreamFinished)
+	{
+		UE_LOG(LogTemp, Log, TEXT("%s::%d Episode %s streamed: frames=%d, first chunk=%f seconds, memory=%.2f MB%s.."),
+			*FString(__FUNCTION__), __LINE__, *StreamedEpisodeData->Id, StreamedEpisodeData->NumFrames(),
+			EpisodeStream->GetFirstChunkLatency(), StreamedEpisodeData->GetAllocatedSize() / (1024.f * 1024.f),
+			EpisodeStream->HasFailed() ? TEXT(" (stream failed)") : TEXT(""));
 
-	EpisodeDefaultUpdateRate = UpdateRate / ((float)(MaxNumSteps - 1));
+		TSharedPtr<FSLVizEpisodeData, ESPMode::ThreadSafe> FinishedEpisodeData = StreamedEpisodeData;
+		const bool bFailed = EpisodeStream->HasFailed();
+		if (!bEpisodeLoaded)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d Not enough frames were streamed to load episode %s.."),
+				*FString(__FUNCTION__), __LINE__, *FinishedEpisodeData->Id);
+		}
+		CancelEpisodeStream();
 
-	UE_LOG(LogTemp, Log, TEXT("%s::%d Default update rate set to %f seconds .."),
-		*FString(__FUNCTION__), __LINE__, EpisodeDefaultUpdateRate);
+		// Failed streams are not complete and should not be reused
+		if (bEpisodeLoaded && !bFailed)
+		{
+			FinishedEpisodeData->DeltaTargets.Shrink();
+			FinishedEpisodeData->DeltaPoses.Shrink();
+			OnEpisodeStreamed.Broadcast(FinishedEpisodeData);
+		}
+	}
 }
 
+// Set the streamed episode as loaded and start the pending replay or goto
+void ASLVizEpisodeManager::StartStreamedEpisode()
+{
+	EpisodeData = StreamedEpisodeData;
+	bEpisodeLoaded = true;
+
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Episode %s loaded with the first %d streamed frames after %f seconds.."),
+		*FString(__FUNCTION__), __LINE__, *StreamedEpisodeData->Id, StreamedEpisodeData->NumFrames(), EpisodeStream->GetFirstChunkLatency());
+
+	if (bStreamPlay)
+	{
+		Play(StreamPlayParams);
+	}
+	else
+	{
+		GotoFrame(StreamPlayParams.StartTime);
+	}
+}
@@ -3,6 +3,7 @@
 
 #include "Viz/SLVizEpisodeUtils.h"
 #include "Viz/SLVizEpisodeManager.h"
+#include "Mongo/SLMongoEpisodeStream.h"
 
 #include "Individuals/SLIndividualManager.h"
 #include "Individuals/SLIndividualComponent.h"
@@ -13,6 +14,12 @@
 #include "Components/PoseableMeshComponent.h"
 #include "EngineUtils.h"
 
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
 // IsA's
 //#include "Components/LightComponentBase.h"
 #include "GameFramework/PlayerController.h"
@@ -21,6 +28,50 @@
 //#include "Landscape.h"
 
 
+/**
+ * Header of the local episode file, followed by the data blocks at 16 byte aligned offsets:
+ * target ids (null terminated utf8) | timestamps | keyframe poses | delta offsets | delta targets | delta poses
+ */
+struct FSLVizEpisodeFileHeader
+{
+	// File identifier and format version
+	uint32 Magic;
+	uint32 Version;
+
+	// Size of a stored pose, the poses are raw transforms and are only valid on the same platform
+	uint32 PoseSize;
+
+	// Number of frames between two keyframes
+	int32 KeyframeInterval;
+
+	// Number of elements in the blocks
+	int32 NumFrames;
+	int32 NumTargets;
+	int32 NumKeyframes;
+	int32 NumDeltas;
+
+	// Byte offset and size of the target ids block
+	uint64 IdsOffset;
+	uint64 IdsSize;
+
+	// Byte offsets of the array blocks
+	uint64 TimestampsOffset;
+	uint64 KeyframePosesOffset;
+	uint64 DeltaOffsetsOffset;
+	uint64 DeltaTargetsOffset;
+	uint64 DeltaPosesOffset;
+
+	// Size of the whole file
+	uint64 FileSize;
+
+	// Content hash of the mongo collection the episode was loaded from (null terminated utf8)
+	ANSICHAR ContentHash[64];
+
+	// 'SLEP'
+	static const uint32 FileMagic = 0x50454C53;
+	static const uint32 FileVersion = 1;
+};
+
 // Set actors as visuals only (disable physics, set as movable, clear attachments)
 void FSLVizEpisodeUtils::SetActorsAsVisualsOnly(UWorld* World)
 {
@@ -76,127 +127,358 @@ void FSLVizEpisodeUtils::AddPoseablMeshComponentsToSkeletalActors(UWorld* World)
 	}
 }
 
-// Build the full replay episode data from the mongo compact form
+// Build the keyframe + delta replay episode data from the mongo compact form
 bool FSLVizEpisodeUtils::BuildEpisodeData(ASLIndividualManager* IndividualManager,
 	const TArray<TPair<float, TMap<FString, FTransform>>>& InMongoEpisodeData,
 	FSLVizEpisodeData& OutVizEpisodeData)
 {
-	double ExecBegin = FPlatformTime::Seconds();
-	/* First frame (FullFrame -  contains all the data) */
-	// Process first frame (contains all individuals -- the rest of the frames contain only individuals that have moved)
-	FSLVizEpisodeFrameData FullFrameData;
+	FSLVizEpisodeBuildState BuildState;
+	return AddEpisodeFrames(InMongoEpisodeData,
+		[&](const FString& Id, int32& OutTargetIdx)
+		{
+			return GetOrAddEpisodeTarget(IndividualManager, Id, BuildState, OutVizEpisodeData, OutTargetIdx);
+		},
+		BuildState, OutVizEpisodeData);
+}
 
-	// Iterate individuals with their poses
-	for (const auto& IndividualPosePair : InMongoEpisodeData[0].Value)
+// Resolve the replay targets of all the individuals (game thread only)
+void FSLVizEpisodeUtils::GetEpisodeTargets(ASLIndividualManager* IndividualManager, TMap<FString, FSLVizEpisodeTarget>& OutTargets)
+{
+	OutTargets.Reserve(IndividualManager->GetIndividuals().Num());
+	for (const auto& Individual : IndividualManager->GetIndividuals())
 	{
-		const FString IndividualId = IndividualPosePair.Key;
-		const FTransform IndividualPose = IndividualPosePair.Value;
+		const FString Id = Individual->GetIdValue();
+		FSLVizEpisodeTarget Target;
+		if (!GetEpisodeTarget(IndividualManager, Id, Target.Actor, Target.BoneComponent, Target.BoneIndex))
+		{
+			continue;
+		}
+		if (Target.Actor)
+		{
+			Target.InitialPose = Target.Actor->GetActorTransform();
+		}
+		else if (Target.BoneComponent)
+		{
+			Target.InitialPose = Target.BoneComponent->GetBoneTransform(Target.BoneIndex);
+		}
+		OutTargets.Add(Id, Target);
+	}
+}
 
-		if (auto Individual = IndividualManager->GetIndividual(IndividualId))
+// Build the episode data with the already resolved targets, the world is not accessed so it can run on worker threads
+bool FSLVizEpisodeUtils::BuildEpisodeData(const TMap<FString, FSLVizEpisodeTarget>& Targets,
+	const TArray<TPair<float, TMap<FString, FTransform>>>& InMongoEpisodeData,
+	FSLVizEpisodeData& OutVizEpisodeData)
+{
+	FSLVizEpisodeBuildState BuildState;
+	return AddEpisodeFrames(InMongoEpisodeData,
+		[&](const FString& Id, int32& OutTargetIdx)
 		{
-			if (Individual->IsA(USLRigidIndividual::StaticClass())
-			|| Individual->IsA(USLSkeletalIndividual::StaticClass())
-			|| Individual->IsA(USLVirtualViewIndividual::StaticClass()))
-			{
-				FullFrameData.ActorPoses.Emplace(Individual->GetParentActor(), IndividualPose);
-			}
-			else if (auto BI = Cast<USLBoneIndividual>(Individual))
+			if (const int32* TargetIdx = BuildState.IdToTarget.Find(Id))
 			{
-				FullFrameData.BonePoses.FindOrAdd(BI->GetPoseableMeshComponent()).Add(BI->GetBoneIndex(), IndividualPose);
+				OutTargetIdx = *TargetIdx;
+				return true;
 			}
-			else if (auto VBI = Cast<USLVirtualBoneIndividual>(Individual))
+			const FSLVizEpisodeTarget* Target = Targets.Find(Id);
+			if (Target == nullptr)
 			{
-				FullFrameData.BonePoses.FindOrAdd(VBI->GetPoseableMeshComponent()).Add(VBI->GetBoneIndex(), IndividualPose);
+				UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not find individual with id=%s, this should not happen, aborting.."),
+					*FString(__FUNCTION__), __LINE__, *Id);
+				return false;
 			}
-		}
-		else
+			OutTargetIdx = AddEpisodeTarget(Id, *Target, BuildState, OutVizEpisodeData);
+			return true;
+		},
+		BuildState, OutVizEpisodeData);
+}
+
+// Append the frames of the streamed chunk to the episode data (returns true if no errors occured)
+bool FSLVizEpisodeUtils::AddEpisodeChunk(ASLIndividualManager* IndividualManager,
+	const FSLMongoEpisodeChunk& InChunk, FSLVizEpisodeBuildState& BuildState,
+	FSLVizEpisodeData& OutVizEpisodeData)
+{
+	if (InChunk.FirstNewIdIdx != BuildState.StreamIdxToTarget.Num())
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d The chunk ids are not in sync with the previous chunks, this should not happen.."),
+			*FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	// The ids are resolved only once, the frames reference them by index
+	for (const FString& Id : InChunk.NewIds)
+	{
+		int32 TargetIdx;
+		if (!GetOrAddEpisodeTarget(IndividualManager, Id, BuildState, OutVizEpisodeData, TargetIdx))
 		{
-			UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not find individual with id=%s, this should not happen, aborting.."),
-				*FString(__FUNCTION__), __LINE__, *IndividualPosePair.Key);
 			return false;
 		}
+		BuildState.StreamIdxToTarget.Add(TargetIdx);
+	}
+
+	for (int32 FrameIndex = 0; FrameIndex < InChunk.NumFrames(); ++FrameIndex)
+	{
+		int32 FirstPose;
+		int32 LastPose;
+		InChunk.GetPoseRange(FrameIndex, FirstPose, LastPose);
+		for (int32 PoseIdx = FirstPose; PoseIdx < LastPose; ++PoseIdx)
+		{
+			const int32 TargetIdx = BuildState.StreamIdxToTarget[InChunk.IdIndices[PoseIdx]];
+			if (TargetIdx != INDEX_NONE)
+			{
+				BuildState.FrameChanges.Emplace(TargetIdx, InChunk.Poses[PoseIdx]);
+			}
+		}
+		AddEpisodeFrame(InChunk.Timestamps[FrameIndex], BuildState, OutVizEpisodeData);
 	}
-	// Add the timestamp
-	//OutVizEpisodeData.Timestamps[0] = InMongoEpisodeData[0].Key;
-	OutVizEpisodeData.Timestamps.Emplace(InMongoEpisodeData[0].Key);
+	return true;
+}
 
-	double FirstFrameDuration = FPlatformTime::Seconds() - ExecBegin;
+// Get the path of the local episode file
+FString FSLVizEpisodeUtils::GetEpisodeFilePath(const FString& TaskId, const FString& EpisodeId)
+{
+	return FPaths::ProjectDir() + "/SL/" + TaskId + "/Episodes/" + EpisodeId + ".slep";
+}
 
-	// Add the individuals poses
-	//OutVizEpisodeData.Frames[0] = FullFrameData;
-	OutVizEpisodeData.FullFrames.Emplace(FullFrameData);
-	OutVizEpisodeData.CompactFrames.Emplace(FullFrameData);
+// Write the episode data to the local episode file, tagged with the content hash of its mongo collection
+bool FSLVizEpisodeUtils::WriteEpisodeFile(const FString& Path, const FString& ContentHash, const FSLVizEpisodeData& InVizEpisodeData)
+{
+	if (!InVizEpisodeData.IsValid() || InVizEpisodeData.TargetIds.Num() != InVizEpisodeData.NumTargets())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d The episode data is not valid, cannot write %s.."), *FString(__FUNCTION__), __LINE__, *Path);
+		return false;
+	}
+	double ExecBegin = FPlatformTime::Seconds();
 
-	/* Process the following frames */
-	// Update full frame with the new transform values
-	// Create compact frame holding only the changes fromt he previous frame
-	for (int32 FrameIndex = 1; FrameIndex < InMongoEpisodeData.Num(); ++FrameIndex)
+	TArray<ANSICHAR> IdChars;
+	for (const FString& Id : InVizEpisodeData.TargetIds)
 	{
-		if (FrameIndex % 250 == 0) { UE_LOG(LogTemp, Log, TEXT(" processing frame %d / %d .."),  FrameIndex, InMongoEpisodeData.Num()); }
+		FTCHARToUTF8 Utf8Id(*Id);
+		IdChars.Append(Utf8Id.Get(), Utf8Id.Length());
+		IdChars.Add('\0');
+	}
 
-		// TODO will emplace make a copy, or one needs to make one here ?
-		//FSLVizEpisodeFrameData PrevFrameCopy = FullFrameData;
-		FSLVizEpisodeFrameData CompactFrameData;
+	FSLVizEpisodeFileHeader Header;
+	FMemory::Memzero(Header);
+	Header.Magic = FSLVizEpisodeFileHeader::FileMagic;
+	Header.Version = FSLVizEpisodeFileHeader::FileVersion;
+	Header.PoseSize = sizeof(FTransform);
+	Header.KeyframeInterval = InVizEpisodeData.KeyframeInterval;
+	Header.NumFrames = InVizEpisodeData.NumFrames();
+	Header.NumTargets = InVizEpisodeData.NumTargets();
+	Header.NumKeyframes = InVizEpisodeData.NumKeyframes();
+	Header.NumDeltas = InVizEpisodeData.DeltaTargets.Num();
+	FTCHARToUTF8 Utf8Hash(*ContentHash);
+	FMemory::Memcpy(Header.ContentHash, Utf8Hash.Get(), FMath::Min<int32>(Utf8Hash.Length(), sizeof(Header.ContentHash) - 1));
+
+	// Aligned blocks allow the arrays to be copied directly from the mapped file
+	uint64 Offset = Align(sizeof(Header), 16);
+	Header.IdsOffset = Offset;
+	Header.IdsSize = IdChars.Num();
+	Offset = Align(Offset + Header.IdsSize, 16);
+	Header.TimestampsOffset = Offset;
+	Offset = Align(Offset + InVizEpisodeData.Timestamps.Num() * sizeof(float), 16);
+	Header.KeyframePosesOffset = Offset;
+	Offset = Align(Offset + InVizEpisodeData.KeyframePoses.Num() * sizeof(FTransform), 16);
+	Header.DeltaOffsetsOffset = Offset;
+	Offset = Align(Offset + InVizEpisodeData.DeltaOffsets.Num() * sizeof(int32), 16);
+	Header.DeltaTargetsOffset = Offset;
+	Offset = Align(Offset + InVizEpisodeData.DeltaTargets.Num() * sizeof(int32), 16);
+	Header.DeltaPosesOffset = Offset;
+	Header.FileSize = Offset + InVizEpisodeData.DeltaPoses.Num() * sizeof(FTransform);
+
+	// Write to a temporary file first, an interrupted write never leaves a broken episode file behind
+	const FString TmpPath = Path + TEXT(".tmp");
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(Path), true);
+	FArchive* Writer = IFileManager::Get().CreateFileWriter(*TmpPath);
+	if (Writer == nullptr)
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not create %s.."), *FString(__FUNCTION__), __LINE__, *TmpPath);
+		return false;
+	}
 
-		// Iterate individuals with their poses
-		for (const auto& IndividualPosePair : InMongoEpisodeData[FrameIndex].Value)
+	auto WriteBlock = [Writer](uint64 BlockOffset, const void* Data, int64 Size)
+	{
+		uint8 Padding[16] = { 0 };
+		Writer->Serialize(Padding, BlockOffset - Writer->Tell());
+		Writer->Serialize(const_cast<void*>(Data), Size);
+	};
+	WriteBlock(0, &Header, sizeof(Header));
+	WriteBlock(Header.IdsOffset, IdChars.GetData(), IdChars.Num());
+	WriteBlock(Header.TimestampsOffset, InVizEpisodeData.Timestamps.GetData(), InVizEpisodeData.Timestamps.Num() * sizeof(float));
+	WriteBlock(Header.KeyframePosesOffset, InVizEpisodeData.KeyframePoses.GetData(), InVizEpisodeData.KeyframePoses.Num() * sizeof(FTransform));
+	WriteBlock(Header.DeltaOffsetsOffset, InVizEpisodeData.DeltaOffsets.GetData(), InVizEpisodeData.DeltaOffsets.Num() * sizeof(int32));
+	WriteBlock(Header.DeltaTargetsOffset, InVizEpisodeData.DeltaTargets.GetData(), InVizEpisodeData.DeltaTargets.Num() * sizeof(int32));
+	WriteBlock(Header.DeltaPosesOffset, InVizEpisodeData.DeltaPoses.GetData(), InVizEpisodeData.DeltaPoses.Num() * sizeof(FTransform));
+
+	Writer->Close();
+	const bool bWritten = !Writer->IsError();
+	delete Writer;
+
+	if (!bWritten || !IFileManager::Get().Move(*Path, *TmpPath, true))
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not write %s.."), *FString(__FUNCTION__), __LINE__, *Path);
+		IFileManager::Get().Delete(*TmpPath);
+		return false;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Duration: write(%s, %.2f MB)=[%f] seconds..;"),
+		*FString(__func__), __LINE__, *Path, Header.FileSize / (1024.f * 1024.f), FPlatformTime::Seconds() - ExecBegin);
+	return true;
+}
+
+// Read the episode data from the memory mapped local episode file (false if missing, invalid or stale, an empty content hash skips the staleness check)
+bool FSLVizEpisodeUtils::ReadEpisodeFile(ASLIndividualManager* IndividualManager, const FString& Path, const FString& ContentHash,
+	FSLVizEpisodeData& OutVizEpisodeData)
+{
+	if (!FPaths::FileExists(Path))
+	{
+		return false;
+	}
+	double ExecBegin = FPlatformTime::Seconds();
+
+	// Map the file, fall back to reading it if the platform does not support mapped files
+	TUniquePtr<IMappedFileHandle> MappedFile(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Path));
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	if (MappedFile.IsValid() && MappedFile->GetFileSize() > 0)
+	{
+		MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+	}
+
+	TArray<uint8> FileBytes;
+	const uint8* FileData = nullptr;
+	uint64 FileSize = 0;
+	if (MappedRegion.IsValid())
+	{
+		FileData = MappedRegion->GetMappedPtr();
+		FileSize = MappedRegion->GetMappedSize();
+	}
+	else if (FFileHelper::LoadFileToArray(FileBytes, *Path))
+	{
+		FileData = FileBytes.GetData();
+		FileSize = FileBytes.Num();
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not open %s.."), *FString(__FUNCTION__), __LINE__, *Path);
+		return false;
+	}
+
+	FSLVizEpisodeFileHeader Header;
+	if (FileSize < sizeof(Header))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not a valid episode file.."), *FString(__FUNCTION__), __LINE__, *Path);
+		return false;
+	}
+	FMemory::Memcpy(&Header, FileData, sizeof(Header));
+	Header.ContentHash[sizeof(Header.ContentHash) - 1] = '\0';
+
+	if (Header.Magic != FSLVizEpisodeFileHeader::FileMagic
+		|| Header.Version != FSLVizEpisodeFileHeader::FileVersion
+		|| Header.PoseSize != sizeof(FTransform)
+		|| Header.FileSize != FileSize)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not a valid episode file or has a different version.."), *FString(__FUNCTION__), __LINE__, *Path);
+		return false;
+	}
+
+	const FString FileContentHash = UTF8_TO_TCHAR(Header.ContentHash);
+	if (ContentHash.IsEmpty())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d No content hash given, %s is used without checking if it is stale.."),
+			*FString(__FUNCTION__), __LINE__, *Path);
+	}
+	else if (!FileContentHash.Equals(ContentHash.Left(sizeof(Header.ContentHash) - 1)))
+	{
+		UE_LOG(LogTemp, Log, TEXT("%s::%d %s is stale (hash %s != %s).."),
+			*FString(__FUNCTION__), __LINE__, *Path, *FileContentHash, *ContentHash);
+		return false;
+	}
+
+	// Make sure every block is within the file
+	auto IsBlockInFile = [FileSize](uint64 Offset, uint64 Size) { return Offset <= FileSize && Size <= FileSize - Offset; };
+	if (Header.KeyframeInterval < 1 || Header.NumFrames < 0 || Header.NumTargets < 0 || Header.NumDeltas < 0
+		|| Header.NumKeyframes != (Header.NumFrames + Header.KeyframeInterval - 1) / Header.KeyframeInterval
+		|| !IsBlockInFile(Header.IdsOffset, Header.IdsSize)
+		|| !IsBlockInFile(Header.TimestampsOffset, (uint64)Header.NumFrames * sizeof(float))
+		|| !IsBlockInFile(Header.KeyframePosesOffset, (uint64)Header.NumKeyframes * Header.NumTargets * sizeof(FTransform))
+		|| !IsBlockInFile(Header.DeltaOffsetsOffset, ((uint64)Header.NumFrames + 1) * sizeof(int32))
+		|| !IsBlockInFile(Header.DeltaTargetsOffset, (uint64)Header.NumDeltas * sizeof(int32))
+		|| !IsBlockInFile(Header.DeltaPosesOffset, (uint64)Header.NumDeltas * sizeof(FTransform)))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s has invalid blocks.."), *FString(__FUNCTION__), __LINE__, *Path);
+		return false;
+	}
+
+	// The ids are resolved to the actors and bones of the current world
+	OutVizEpisodeData.Clear();
+	OutVizEpisodeData.KeyframeInterval = Header.KeyframeInterval;
+	const ANSICHAR* IdChars = reinterpret_cast<const ANSICHAR*>(FileData + Header.IdsOffset);
+	const ANSICHAR* IdCharsEnd = IdChars + Header.IdsSize;
+	for (int32 TargetIdx = 0; TargetIdx < Header.NumTargets; ++TargetIdx)
+	{
+		const ANSICHAR* IdEnd = IdChars;
+		while (IdEnd < IdCharsEnd && *IdEnd != '\0')
 		{
-			const FString IndividualId = IndividualPosePair.Key;
-			const FTransform IndividualPose = IndividualPosePair.Value;
-			if (auto Individual = IndividualManager->GetIndividual(IndividualId))
-			{
-				if (Individual->IsA(USLRigidIndividual::StaticClass())
-					|| Individual->IsA(USLSkeletalIndividual::StaticClass())
-					|| Individual->IsA(USLVirtualViewIndividual::StaticClass()))
-				{
-					// Update the full frame with the new value
-					//if (auto FoundActorPose = FullFrameData.ActorPoses.Find(RI->GetParentActor())){(*FoundActorPose) = IndividualPose;}
-					FullFrameData.ActorPoses.FindChecked(Individual->GetParentActor()) = IndividualPose;
-					// Add as new data to the compact frame
-					CompactFrameData.ActorPoses.Emplace(Individual->GetParentActor(), IndividualPose);
-
-					if (IndividualId.Equals("6HI1inL7OUKmqNXGXI81YA"))
-					{
-						UE_LOG(LogTemp, Log, TEXT("%s::%d Pose=%s;"), *FString(__FUNCTION__), __LINE__, *IndividualPose.ToString());
-					}
-				}
-				else if (auto BI = Cast<USLBoneIndividual>(Individual))
-				{
-					FullFrameData.BonePoses.FindOrAdd(BI->GetPoseableMeshComponent()).Add(BI->GetBoneIndex(), IndividualPose);
-					CompactFrameData.BonePoses.FindOrAdd(BI->GetPoseableMeshComponent()).Add(BI->GetBoneIndex(), IndividualPose);
-				}
-				else if (auto VBI = Cast<USLVirtualBoneIndividual>(Individual))
-				{
-					FullFrameData.BonePoses.FindOrAdd(VBI->GetPoseableMeshComponent()).Add(VBI->GetBoneIndex(), IndividualPose);
-					CompactFrameData.BonePoses.FindOrAdd(VBI->GetPoseableMeshComponent()).Add(VBI->GetBoneIndex(), IndividualPose);
-				}
-			}
-			else
-			{
-				UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not find individual with id=%s, this should not happen, aborting.."),
-					*FString(__FUNCTION__), __LINE__, *IndividualId);
-				return false;
-			}
+			++IdEnd;
+		}
+		if (IdEnd == IdCharsEnd)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d %s has invalid target ids.."), *FString(__FUNCTION__), __LINE__, *Path);
+			OutVizEpisodeData.Clear();
+			return false;
 		}
+		const FString Id = UTF8_TO_TCHAR(IdChars);
+		IdChars = IdEnd + 1;
 
-		// Add the timestamp
-		//OutVizEpisodeData.Timestamps[FrameIndex] = InMongoEpisodeData[FrameIndex].Key;
-		OutVizEpisodeData.Timestamps.Emplace(InMongoEpisodeData[FrameIndex].Key);
+		AActor* Actor;
+		UPoseableMeshComponent* BoneComponent;
+		int32 BoneIndex;
+		if (!GetEpisodeTarget(IndividualManager, Id, Actor, BoneComponent, BoneIndex) || (Actor == nullptr && BoneComponent == nullptr))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not find the target individual with id=%s of %s in the world.."),
+				*FString(__FUNCTION__), __LINE__, *Id, *Path);
+			OutVizEpisodeData.Clear();
+			return false;
+		}
+		OutVizEpisodeData.AddTarget(Id, Actor, BoneComponent, BoneIndex, FTransform::Identity);
+	}
 
-		// Add the individuals poses
-		//OutFullEpisodeData.Frames[FrameIndex] = FullFrameData;
-		OutVizEpisodeData.FullFrames.Emplace(FullFrameData);
-		OutVizEpisodeData.CompactFrames.Emplace(CompactFrameData);
+	// Bulk copy the blocks, only the touched pages of the mapped file are read from disk
+	auto CopyBlock = [FileData](auto& OutArray, uint64 Offset, int32 Num)
+	{
+		OutArray.SetNumUninitialized(Num);
+		FMemory::Memcpy(OutArray.GetData(), FileData + Offset, Num * OutArray.GetTypeSize());
+	};
+	CopyBlock(OutVizEpisodeData.Timestamps, Header.TimestampsOffset, Header.NumFrames);
+	CopyBlock(OutVizEpisodeData.KeyframePoses, Header.KeyframePosesOffset, Header.NumKeyframes * Header.NumTargets);
+	CopyBlock(OutVizEpisodeData.DeltaOffsets, Header.DeltaOffsetsOffset, Header.NumFrames + 1);
+	CopyBlock(OutVizEpisodeData.DeltaTargets, Header.DeltaTargetsOffset, Header.NumDeltas);
+	CopyBlock(OutVizEpisodeData.DeltaPoses, Header.DeltaPosesOffset, Header.NumDeltas);
+
+	// Indices out of range would otherwise only show up during the replay
+	bool bIndicesValid = OutVizEpisodeData.DeltaOffsets[0] == 0 && OutVizEpisodeData.DeltaOffsets.Last() == Header.NumDeltas;
+	for (int32 FrameIndex = 0; bIndicesValid && FrameIndex < Header.NumFrames; ++FrameIndex)
+	{
+		bIndicesValid = OutVizEpisodeData.DeltaOffsets[FrameIndex] <= OutVizEpisodeData.DeltaOffsets[FrameIndex + 1];
 	}
-	
-	double FollowingFramesDuration = FPlatformTime::Seconds() - ExecBegin - FirstFrameDuration;
-	UE_LOG(LogTemp, Log, TEXT("%s::%d Durations: first frame=[%f], following frames(num=%d)=[%f], total=[%f] seconds..;"),
-		*FString(__func__), __LINE__, FirstFrameDuration, OutVizEpisodeData.Timestamps.Num(),
-		FollowingFramesDuration, FPlatformTime::Seconds() - ExecBegin);
+	for (int32 DeltaIdx = 0; bIndicesValid && DeltaIdx < Header.NumDeltas; ++DeltaIdx)
+	{
+		bIndicesValid = OutVizEpisodeData.DeltaTargets[DeltaIdx] >= 0 && OutVizEpisodeData.DeltaTargets[DeltaIdx] < Header.NumTargets;
+	}
+	if (!bIndicesValid || !OutVizEpisodeData.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s has invalid episode data.."), *FString(__FUNCTION__), __LINE__, *Path);
+		OutVizEpisodeData.Clear();
+		return false;
+	}
+	OutVizEpisodeData.SetTargetFirstFrames();
+
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Duration: %s(%s, targets=%d, frames=%d, deltas=%d)=[%f] seconds, memory=[%.2f] MB..;"),
+		*FString(__func__), __LINE__, MappedRegion.IsValid() ? TEXT("mapped") : TEXT("read"), *Path, Header.NumTargets,
+		Header.NumFrames, Header.NumDeltas, FPlatformTime::Seconds() - ExecBegin, OutVizEpisodeData.GetAllocatedSize() / (1024.f * 1024.f));
 	return true;
 }
 
-
 // Executes a binary search for element Item in array Array using the <= operator (from ProfilerCommon::FBinaryFindIndex)
 int32 FSLVizEpisodeUtils::BinarySearchLessEqual(const TArray<float>& Array, float Value)
 {
@@ -245,6 +527,139 @@ bool FSLVizEpisodeUtils::IsSpecialCaseActor(AActor* Actor)
 }
 
 /* Private helpers */
+// Append the mongo frames to the episode data, the target index of every individual id is given by the callback (false on errors)
+bool FSLVizEpisodeUtils::AddEpisodeFrames(const TArray<TPair<float, TMap<FString, FTransform>>>& InMongoEpisodeData,
+	TFunctionRef<bool(const FString&, int32&)> GetTargetIdx, FSLVizEpisodeBuildState& BuildState,
+	FSLVizEpisodeData& OutVizEpisodeData)
+{
+	double ExecBegin = FPlatformTime::Seconds();
+	if (InMongoEpisodeData.Num() == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d The episode data is empty.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	const int32 NumFrames = InMongoEpisodeData.Num();
+	for (int32 FrameIndex = 0; FrameIndex < NumFrames; ++FrameIndex)
+	{
+		if (FrameIndex % 250 == 0) { UE_LOG(LogTemp, Log, TEXT(" processing frame %d / %d .."),  FrameIndex, NumFrames); }
+
+		for (const auto& IndividualPosePair : InMongoEpisodeData[FrameIndex].Value)
+		{
+			int32 TargetIdx;
+			if (!GetTargetIdx(IndividualPosePair.Key, TargetIdx))
+			{
+				return false;
+			}
+			if (TargetIdx != INDEX_NONE)
+			{
+				BuildState.FrameChanges.Emplace(TargetIdx, IndividualPosePair.Value);
+			}
+		}
+		AddEpisodeFrame(InMongoEpisodeData[FrameIndex].Key, BuildState, OutVizEpisodeData);
+	}
+
+	// Release the slack of the delta arrays
+	OutVizEpisodeData.DeltaTargets.Shrink();
+	OutVizEpisodeData.DeltaPoses.Shrink();
+
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Duration: total(targets=%d, frames=%d, keyframes=%d, deltas=%d)=[%f] seconds, memory=[%.2f] MB..;"),
+		*FString(__func__), __LINE__, OutVizEpisodeData.NumTargets(), NumFrames, OutVizEpisodeData.NumKeyframes(),
+		OutVizEpisodeData.DeltaTargets.Num(), FPlatformTime::Seconds() - ExecBegin,
+		OutVizEpisodeData.GetAllocatedSize() / (1024.f * 1024.f));
+	return true;
+}
+
+// Add the resolved target to the episode data (returns the target index, INDEX_NONE for the ignored individual types)
+int32 FSLVizEpisodeUtils::AddEpisodeTarget(const FString& Id, const FSLVizEpisodeTarget& Target,
+	FSLVizEpisodeBuildState& BuildState, FSLVizEpisodeData& OutVizEpisodeData)
+{
+	// Targets start from their current world pose
+	int32 TargetIdx = INDEX_NONE;
+	if (Target.Actor || Target.BoneComponent)
+	{
+		TargetIdx = OutVizEpisodeData.AddTarget(Id, Target.Actor, Target.BoneComponent, Target.BoneIndex, Target.InitialPose);
+		BuildState.CurrPoses.Add(Target.InitialPose);
+	}
+	BuildState.IdToTarget.Add(Id, TargetIdx);
+	return TargetIdx;
+}
+
+// Get the pose target of the individual, unknown individuals are added as new targets (false if the individual does not exist)
+bool FSLVizEpisodeUtils::GetOrAddEpisodeTarget(ASLIndividualManager* IndividualManager, const FString& Id,
+	FSLVizEpisodeBuildState& BuildState, FSLVizEpisodeData& OutVizEpisodeData, int32& OutTargetIdx)
+{
+	if (const int32* TargetIdx = BuildState.IdToTarget.Find(Id))
+	{
+		OutTargetIdx = *TargetIdx;
+		return true;
+	}
+
+	FSLVizEpisodeTarget Target;
+	if (!GetEpisodeTarget(IndividualManager, Id, Target.Actor, Target.BoneComponent, Target.BoneIndex))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not find individual with id=%s, this should not happen, aborting.."),
+			*FString(__FUNCTION__), __LINE__, *Id);
+		return false;
+	}
+	if (Target.Actor)
+	{
+		Target.InitialPose = Target.Actor->GetActorTransform();
+	}
+	else if (Target.BoneComponent)
+	{
+		Target.InitialPose = Target.BoneComponent->GetBoneTransform(Target.BoneIndex);
+	}
+	OutTargetIdx = AddEpisodeTarget(Id, Target, BuildState, OutVizEpisodeData);
+	return true;
+}
+
+// Get the actor or the poseable mesh bone moved by the individual (false if the individual does not exist, both are nullptr for the ignored types)
+bool FSLVizEpisodeUtils::GetEpisodeTarget(ASLIndividualManager* IndividualManager, const FString& Id,
+	AActor*& OutActor, UPoseableMeshComponent*& OutBoneComponent, int32& OutBoneIndex)
+{
+	OutActor = nullptr;
+	OutBoneComponent = nullptr;
+	OutBoneIndex = INDEX_NONE;
+
+	auto Individual = IndividualManager->GetIndividual(Id);
+	if (Individual == nullptr)
+	{
+		return false;
+	}
+
+	if (Individual->IsA(USLRigidIndividual::StaticClass())
+		|| Individual->IsA(USLSkeletalIndividual::StaticClass())
+		|| Individual->IsA(USLVirtualViewIndividual::StaticClass()))
+	{
+		OutActor = Individual->GetParentActor();
+	}
+	else if (auto BI = Cast<USLBoneIndividual>(Individual))
+	{
+		OutBoneComponent = BI->GetPoseableMeshComponent();
+		OutBoneIndex = BI->GetBoneIndex();
+	}
+	else if (auto VBI = Cast<USLVirtualBoneIndividual>(Individual))
+	{
+		OutBoneComponent = VBI->GetPoseableMeshComponent();
+		OutBoneIndex = VBI->GetBoneIndex();
+	}
+	return true;
+}
+
+// Append the frame with the changes gathered in the build state
+void FSLVizEpisodeUtils::AddEpisodeFrame(float Timestamp, FSLVizEpisodeBuildState& BuildState, FSLVizEpisodeData& OutVizEpisodeData)
+{
+	// Sorted changes keep the target access in order during the replay
+	BuildState.FrameChanges.Sort([](const TPair<int32, FTransform>& A, const TPair<int32, FTransform>& B) { return A.Key < B.Key; });
+	for (const auto& Change : BuildState.FrameChanges)
+	{
+		BuildState.CurrPoses[Change.Key] = Change.Value;
+	}
+	OutVizEpisodeData.AddFrame(Timestamp, BuildState.FrameChanges, BuildState.CurrPoses);
+	BuildState.FrameChanges.Reset();
+}
+
 // Remove actor components that are not required in the 'visual only' world (e.g. controllers)
 void FSLVizEpisodeUtils::RemoveUnnecessaryComponents(AActor* Actor)
 {
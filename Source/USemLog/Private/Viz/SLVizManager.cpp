@@ -862,7 +862,7 @@ bool ASLVizManager::IsWorldConvertedToVisualizationMode() const
 }
 
 // Cache the episode data
-bool ASLVizManager::CacheEpisodeData(const FString& Id, const TArray<TPair<float, TMap<FString, FTransform>>>& InMongoEpisodeData)
+bool ASLVizManager::CacheEpisodeData(const FString& TaskId, const FString& Id, const TArray<TPair<float, TMap<FString, FTransform>>>& InMongoEpisodeData)
 {
 	if (!bIsInit)
 	{
@@ -881,11 +881,16 @@ bool ASLVizManager::CacheEpisodeData(const FString& Id, const TArray<TPair<float
 	}
 
 	// Create and reserve episode data with the array size
-	FSLVizEpisodeData VizEpisodeData(InMongoEpisodeData.Num());
-	VizEpisodeData.Id = Id;
-	if (FSLVizEpisodeUtils::BuildEpisodeData(IndividualManager, InMongoEpisodeData, VizEpisodeData))
+	TSharedPtr<FSLVizEpisodeData, ESPMode::ThreadSafe> VizEpisodeData = MakeShared<FSLVizEpisodeData, ESPMode::ThreadSafe>(InMongoEpisodeData.Num());
+	VizEpisodeData->Id = Id;
+	VizEpisodeData->TaskId = TaskId;
+	if (FSLVizEpisodeUtils::BuildEpisodeData(IndividualManager, InMongoEpisodeData, *VizEpisodeData))
 	{
 		CachedEpisodeData.Add(Id, VizEpisodeData);
+		UE_LOG(LogTemp, Log, TEXT("%s::%d %s cached episode %s (frames=%d, keyframes=%d, deltas=%d): %.2f MB, total cache (%d episodes): %.2f MB.."),
+			*FString(__FUNCTION__), __LINE__, *GetName(), *Id, VizEpisodeData->NumFrames(), VizEpisodeData->NumKeyframes(),
+			VizEpisodeData->DeltaTargets.Num(), VizEpisodeData->GetAllocatedSize() / (1024.f * 1024.f),
+			CachedEpisodeData.Num(), GetCachedEpisodesDataSize() / (1024.f * 1024.f));
 		return true;
 	}
 	else
@@ -895,6 +900,127 @@ bool ASLVizManager::CacheEpisodeData(const FString& Id, const TArray<TPair<float
 	}
 }
 
+// Cache the already built episode data (e.g. built on a worker thread)
+bool ASLVizManager::CacheEpisodeData(TSharedPtr<FSLVizEpisodeData, ESPMode::ThreadSafe> VizEpisodeData)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return false;
+	}
+	if (!VizEpisodeData.IsValid() || !VizEpisodeData->IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s the episode data is not valid.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return false;
+	}
+	if (IsEpisodeCached(VizEpisodeData->Id))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s the episode data is already cached.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return true;
+	}
+
+	CachedEpisodeData.Add(VizEpisodeData->Id, VizEpisodeData);
+	UE_LOG(LogTemp, Log, TEXT("%s::%d %s cached episode %s (frames=%d, keyframes=%d, deltas=%d): %.2f MB, total cache (%d episodes): %.2f MB.."),
+		*FString(__FUNCTION__), __LINE__, *GetName(), *VizEpisodeData->Id, VizEpisodeData->NumFrames(), VizEpisodeData->NumKeyframes(),
+		VizEpisodeData->DeltaTargets.Num(), VizEpisodeData->GetAllocatedSize() / (1024.f * 1024.f),
+		CachedEpisodeData.Num(), GetCachedEpisodesDataSize() / (1024.f * 1024.f));
+	return true;
+}
+
+// Resolve the replay targets of all the individuals, used for building episode data on worker threads
+bool ASLVizManager::GetEpisodeTargets(TMap<FString, FSLVizEpisodeTarget>& OutTargets) const
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return false;
+	}
+	FSLVizEpisodeUtils::GetEpisodeTargets(IndividualManager, OutTargets);
+	return true;
+}
+
+// Get the allocated memory (bytes) of the cached episode (0 if not cached)
+SIZE_T ASLVizManager::GetCachedEpisodeDataSize(const FString& Id) const
+{
+	if (const auto* VizEpisodeData = CachedEpisodeData.Find(Id))
+	{
+		return (*VizEpisodeData)->GetAllocatedSize();
+	}
+	return 0;
+}
+
+// Get the allocated memory (bytes) of all the cached episodes
+SIZE_T ASLVizManager::GetCachedEpisodesDataSize() const
+{
+	SIZE_T Size = 0;
+	for (const auto& IdDataPair : CachedEpisodeData)
+	{
+		Size += IdDataPair.Value->GetAllocatedSize();
+	}
+	return Size;
+}
+
+// Log the allocated memory of every cached episode
+void ASLVizManager::LogCachedEpisodesDataSize() const
+{
+	for (const auto& IdDataPair : CachedEpisodeData)
+	{
+		UE_LOG(LogTemp, Log, TEXT("%s::%d \t %s: frames=%d, targets=%d, keyframes=%d, deltas=%d, memory=%.2f MB;"),
+			*FString(__FUNCTION__), __LINE__, *IdDataPair.Key, IdDataPair.Value->NumFrames(), IdDataPair.Value->NumTargets(),
+			IdDataPair.Value->NumKeyframes(), IdDataPair.Value->DeltaTargets.Num(), IdDataPair.Value->GetAllocatedSize() / (1024.f * 1024.f));
+	}
+	UE_LOG(LogTemp, Log, TEXT("%s::%d %s total cache (%d episodes): %.2f MB.."),
+		*FString(__FUNCTION__), __LINE__, *GetName(), CachedEpisodeData.Num(), GetCachedEpisodesDataSize() / (1024.f * 1024.f));
+}
+
+// Cache the episode from its local episode file (false if there is no valid file, an empty content hash skips the staleness check)
+bool ASLVizManager::CacheEpisodeFile(const FString& TaskId, const FString& Id, const FString& ContentHash)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return false;
+	}
+	if (IsEpisodeCached(Id))
+	{
+		return true;
+	}
+
+	TSharedPtr<FSLVizEpisodeData, ESPMode::ThreadSafe> VizEpisodeData = MakeShared<FSLVizEpisodeData, ESPMode::ThreadSafe>();
+	if (FSLVizEpisodeUtils::ReadEpisodeFile(IndividualManager, FSLVizEpisodeUtils::GetEpisodeFilePath(TaskId, Id), ContentHash, *VizEpisodeData))
+	{
+		VizEpisodeData->Id = Id;
+		VizEpisodeData->TaskId = TaskId;
+		CachedEpisodeData.Add(Id, VizEpisodeData);
+		UE_LOG(LogTemp, Log, TEXT("%s::%d %s cached episode %s from file (frames=%d): %.2f MB, total cache (%d episodes): %.2f MB.."),
+			*FString(__FUNCTION__), __LINE__, *GetName(), *Id, VizEpisodeData->NumFrames(), VizEpisodeData->GetAllocatedSize() / (1024.f * 1024.f),
+			CachedEpisodeData.Num(), GetCachedEpisodesDataSize() / (1024.f * 1024.f));
+		return true;
+	}
+	return false;
+}
+
+// Write the cached episode to its local episode file (if the episode is still streaming the file is written once it is cached)
+bool ASLVizManager::SaveEpisodeFile(const FString& TaskId, const FString& Id, const FString& ContentHash)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return false;
+	}
+	if (IsEpisodeCached(Id))
+	{
+		return FSLVizEpisodeUtils::WriteEpisodeFile(FSLVizEpisodeUtils::GetEpisodeFilePath(TaskId, Id), ContentHash, *CachedEpisodeData[Id]);
+	}
+	if (IsEpisodeStreaming(Id))
+	{
+		PendingEpisodeFiles.Add(Id, TPair<FString, FString>(TaskId, ContentHash));
+		return true;
+	}
+	UE_LOG(LogTemp, Warning, TEXT("%s::%d %s episode (%s) is not cached.."), *FString(__FUNCTION__), __LINE__, *GetName(), *Id);
+	return false;
+}
+
 // Load cached episode data
 bool ASLVizManager::LoadCachedEpisodeData(const FString& Id)
 {
@@ -960,6 +1086,34 @@ bool ASLVizManager::GotoCachedEpisodeFrame(const FString& Id, float Ts)
 	return EpisodeManager->GotoFrame(Ts);
 }
 
+// Load the episode from the stream, the replay (or goto) starts with the first streamed frames, the episode is cached once fully streamed
+bool ASLVizManager::LoadEpisodeStream(const FString& Id, TSharedPtr<FSLMongoEpisodeStream, ESPMode::ThreadSafe> Stream,
+	const FSLVizEpisodePlayParams& Params, bool bPlay)
+{
+	if (!bIsInit)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return false;
+	}
+	if (!EpisodeManager->IsWorldConverted())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s cannot load episode data because the world is not set as visual only.."), *FString(__FUNCTION__), __LINE__, *GetName());
+		return false;
+	}
+
+	if (!EpisodeManager->OnEpisodeStreamed.IsBoundToObject(this))
+	{
+		EpisodeManager->OnEpisodeStreamed.AddUObject(this, &ASLVizManager::OnEpisodeStreamed);
+	}
+	return EpisodeManager->LoadEpisodeStream(IndividualManager, Id, Stream, Params, bPlay);
+}
+
+// Check if the episode is currently being streamed
+bool ASLVizManager::IsEpisodeStreaming(const FString& Id) const
+{
+	return bIsInit && EpisodeManager->IsEpisodeStreaming(Id);
+}
+
 // Change the data into an episode format and load it to the episode replay manager
 void ASLVizManager::LoadEpisodeData(const TArray<TPair<float, TMap<FString, FTransform>>>& InMongoEpisodeData)
 {
@@ -981,8 +1135,8 @@ void ASLVizManager::LoadEpisodeData(const TArray<TPair<float, TMap<FString, FTra
 
 
 	// Create and reserve episode data with the array size
-	FSLVizEpisodeData VizEpisodeData(InMongoEpisodeData.Num());
-	if (FSLVizEpisodeUtils::BuildEpisodeData(IndividualManager, InMongoEpisodeData, VizEpisodeData))
+	TSharedPtr<FSLVizEpisodeData, ESPMode::ThreadSafe> VizEpisodeData = MakeShared<FSLVizEpisodeData, ESPMode::ThreadSafe>(InMongoEpisodeData.Num());
+	if (FSLVizEpisodeUtils::BuildEpisodeData(IndividualManager, InMongoEpisodeData, *VizEpisodeData))
 	{
 		EpisodeManager->LoadEpisode(VizEpisodeData);
 	}
@@ -1018,7 +1172,7 @@ bool ASLVizManager::PlayEpisode(FSLVizEpisodePlayParams PlayParams)
 		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
 		return false;
 	}
-	EpisodeManager->SetReplayParams(PlayParams.bLoop, PlayParams.UpdateRate, PlayParams.StepSize);
+	EpisodeManager->SetReplayParams(PlayParams.bLoop, PlayParams.UpdateRate, PlayParams.PlaybackSpeed, PlayParams.bInterpolate);
 	if (PlayParams.StartTime < 0.f && PlayParams.EndTime < 0.f)
 	{
 		return EpisodeManager->PlayEpisode();
@@ -1037,7 +1191,7 @@ bool ASLVizManager::PlayEpisodeTimeline(float StartTime, float EndTime, FSLVizEp
 		UE_LOG(LogTemp, Warning, TEXT("%s::%d %s is not initialized, call init first.."), *FString(__FUNCTION__), __LINE__, *GetName());
 		return false;
 	}
-	EpisodeManager->SetReplayParams(PlayParams.bLoop, PlayParams.UpdateRate, PlayParams.StepSize);
+	EpisodeManager->SetReplayParams(PlayParams.bLoop, PlayParams.UpdateRate, PlayParams.PlaybackSpeed, PlayParams.bInterpolate);
 	return EpisodeManager->PlayTimeline(StartTime, EndTime);
 }
 
@@ -1227,6 +1381,25 @@ bool ASLVizManager::SetEpisodeManager()
 	return true;
 }
 
+// Cache the fully streamed episode
+void ASLVizManager::OnEpisodeStreamed(TSharedPtr<FSLVizEpisodeData, ESPMode::ThreadSafe> VizEpisodeData)
+{
+	if (!IsEpisodeCached(VizEpisodeData->Id))
+	{
+		CachedEpisodeData.Add(VizEpisodeData->Id, VizEpisodeData);
+		UE_LOG(LogTemp, Log, TEXT("%s::%d %s cached streamed episode %s (frames=%d): %.2f MB, total cache (%d episodes): %.2f MB.."),
+			*FString(__FUNCTION__), __LINE__, *GetName(), *VizEpisodeData->Id, VizEpisodeData->NumFrames(),
+			VizEpisodeData->GetAllocatedSize() / (1024.f * 1024.f), CachedEpisodeData.Num(), GetCachedEpisodesDataSize() / (1024.f * 1024.f));
+	}
+
+	TPair<FString, FString> TaskIdContentHash;
+	if (PendingEpisodeFiles.RemoveAndCopyValue(VizEpisodeData->Id, TaskIdContentHash))
+	{
+		FSLVizEpisodeUtils::WriteEpisodeFile(FSLVizEpisodeUtils::GetEpisodeFilePath(TaskIdContentHash.Key, VizEpisodeData->Id),
+			TaskIdContentHash.Value, *VizEpisodeData);
+	}
+}
+
 // Get the vizualization camera director from the world (or spawn a new one)
 bool ASLVizManager::SetCameraDirector()
 {
@@ -5,7 +5,240 @@
 #include "Knowrob/SLKnowrobManager.h"
 #include "Mongo/SLMongoQueryManager.h"
 #include "Viz/SLVizManager.h"
+#include "Viz/SLVizEpisodeUtils.h"
+#include "HAL/PlatformTime.h"
 
+// Ctor
+FSLVizQEpisodePrefetch::FSLVizQEpisodePrefetch(ASLVizManager* InVizManager, ASLMongoQueryManager* InMongoQueryManager,
+	const FString& InTask, SIZE_T InMemoryBudget, bool bInUseEpisodeFiles) :
+	VizManager(InVizManager),
+	MongoQueryManager(InMongoQueryManager),
+	Task(InTask),
+	bUseEpisodeFiles(bInUseEpisodeFiles),
+	MemoryBudget(InMemoryBudget)
+{
+}
+
+// Add an episode to prefetch
+void FSLVizQEpisodePrefetch::AddEpisode(const FString& Episode)
+{
+	if (bUseEpisodeFiles)
+	{
+		PendingHashes.Add(Episode);
+	}
+	else
+	{
+		PendingFetches.Emplace(Episode, FString());
+	}
+	NumTotal++;
+}
+
+// Start the prefetch (false if it could not be started)
+bool FSLVizQEpisodePrefetch::Start()
+{
+	if (!VizManager.IsValid() || !MongoQueryManager.IsValid())
+	{
+		return false;
+	}
+	MaxRunning = MongoQueryManager->GetNumQueryWorkers();
+	if (MaxRunning == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d The mongo query workers are not connected.."), *FString(__FUNCTION__), __LINE__);
+		return false;
+	}
+
+	// The workers only read the resolved targets, the world is not accessed outside of the game thread
+	TSharedPtr<TMap<FString, FSLVizEpisodeTarget>, ESPMode::ThreadSafe> ResolvedTargets = MakeShared<TMap<FString, FSLVizEpisodeTarget>, ESPMode::ThreadSafe>();
+	if (!VizManager->GetEpisodeTargets(*ResolvedTargets))
+	{
+		return false;
+	}
+	Targets = ResolvedTargets;
+
+	UsedMemory = VizManager->GetCachedEpisodesDataSize();
+	StartTime = FPlatformTime::Seconds();
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Prefetching %d episodes of %s with %d workers (budget=%.2f MB, used=%.2f MB).."),
+		*FString(__FUNCTION__), __LINE__, NumTotal, *Task, MaxRunning, MemoryBudget / (1024.f * 1024.f), UsedMemory / (1024.f * 1024.f));
+	StartNextJobs();
+	return true;
+}
+
+// Start the next jobs as long as there are free workers and the memory budget allows it
+void FSLVizQEpisodePrefetch::StartNextJobs()
+{
+	while (NumRunning < MaxRunning && PendingFetches.Num() > 0)
+	{
+		// Run a single fetch until the size of an episode is known
+		if (NumFetched == 0 && NumFetching > 0)
+		{
+			break;
+		}
+
+		// The peak memory of a fetch (mongo data and built episode) is estimated with the largest ones so far
+		const SIZE_T PeakEstimate = LargestTransferSize + LargestEpisodeSize;
+		if (UsedMemory + (NumFetching + 1) * PeakEstimate > MemoryBudget)
+		{
+			if (NumFetching == 0)
+			{
+				UE_LOG(LogTemp, Warning, TEXT("%s::%d The memory budget (%.2f MB) is reached, skipping the remaining %d episodes.."),
+					*FString(__FUNCTION__), __LINE__, MemoryBudget / (1024.f * 1024.f), PendingFetches.Num() + PendingHashes.Num());
+				NumSkipped += PendingFetches.Num() + PendingHashes.Num();
+				PendingFetches.Empty();
+				PendingHashes.Empty();
+			}
+			break;
+		}
+
+		const TPair<FString, FString> EpisodeContentHash = PendingFetches[0];
+		PendingFetches.RemoveAt(0);
+		StartFetchJob(EpisodeContentHash.Key, EpisodeContentHash.Value);
+	}
+
+	// The remaining workers compute the content hashes
+	while (NumRunning < MaxRunning && PendingHashes.Num() > 0)
+	{
+		const FString Episode = PendingHashes[0];
+		PendingHashes.RemoveAt(0);
+		StartHashJob(Episode);
+	}
+
+	if (NumRunning == 0 && PendingFetches.Num() == 0 && PendingHashes.Num() == 0)
+	{
+		UE_LOG(LogTemp, Log, TEXT("%s::%d Prefetch of %s done in %f seconds: cached=%d, failed=%d, skipped=%d (of %d), memory=%.2f MB.."),
+			*FString(__FUNCTION__), __LINE__, *Task, FPlatformTime::Seconds() - StartTime, NumCached, NumFailed, NumSkipped, NumTotal,
+			UsedMemory / (1024.f * 1024.f));
+	}
+}
+
+// Compute the content hash of the episode on a worker
+void FSLVizQEpisodePrefetch::StartHashJob(const FString& Episode)
+{
+	NumRunning++;
+	MongoQueryManager->QueryAsync<FString>(Task, Episode,
+		[](const FSLMongoQueryDBHandler& Handler) { return Handler.GetContentHash(); },
+		[Prefetch = AsShared(), Episode](const FString& ContentHash)
+		{
+			Prefetch->OnEpisodeHashed(Episode, ContentHash);
+		});
+}
+
+// Fetch and build the episode on a worker
+void FSLVizQEpisodePrefetch::StartFetchJob(const FString& Episode, const FString& ContentHash)
+{
+	NumRunning++;
+	NumFetching++;
+	TSharedPtr<const TMap<FString, FSLVizEpisodeTarget>, ESPMode::ThreadSafe> WorkerTargets = Targets;
+	MongoQueryManager->QueryAsync<FSLVizQEpisodePrefetchResult>(Task, Episode,
+		[WorkerTargets, Task = Task, Episode](const FSLMongoQueryDBHandler& Handler)
+		{
+			// Fetch and build on the worker, only the compact episode data is returned
+			FSLVizQEpisodePrefetchResult Result;
+			const TArray<TPair<float, TMap<FString, FTransform>>> MongoEpisodeData = Handler.GetEpisodeData();
+			Result.TransferSize = MongoEpisodeData.GetAllocatedSize();
+			for (const auto& Frame : MongoEpisodeData)
+			{
+				Result.TransferSize += Frame.Value.GetAllocatedSize();
+				for (const auto& IdPosePair : Frame.Value)
+				{
+					Result.TransferSize += IdPosePair.Key.GetAllocatedSize();
+				}
+			}
+
+			TSharedPtr<FSLVizEpisodeData, ESPMode::ThreadSafe> VizEpisodeData = MakeShared<FSLVizEpisodeData, ESPMode::ThreadSafe>(MongoEpisodeData.Num());
+			VizEpisodeData->Id = Episode;
+			VizEpisodeData->TaskId = Task;
+			if (FSLVizEpisodeUtils::BuildEpisodeData(*WorkerTargets, MongoEpisodeData, *VizEpisodeData))
+			{
+				Result.VizEpisodeData = VizEpisodeData;
+			}
+			return Result;
+		},
+		[Prefetch = AsShared(), Episode, ContentHash](const FSLVizQEpisodePrefetchResult& Result)
+		{
+			Prefetch->OnEpisodeBuilt(Episode, ContentHash, Result);
+		});
+}
+
+// Load the episode from its local file if it is up to date, otherwise queue its fetch (game thread)
+void FSLVizQEpisodePrefetch::OnEpisodeHashed(const FString& Episode, const FString& ContentHash)
+{
+	NumRunning--;
+	if (!CheckManagers())
+	{
+		return;
+	}
+
+	// An empty hash (failed or cancelled query) never matches a file, the episode is fetched instead
+	if (!ContentHash.IsEmpty() && VizManager->CacheEpisodeFile(Task, Episode, ContentHash))
+	{
+		UsedMemory += VizManager->GetCachedEpisodeDataSize(Episode);
+		OnEpisodeDone(Episode, true);
+		return;
+	}
+	PendingFetches.Emplace(Episode, ContentHash);
+	StartNextJobs();
+}
+
+// Publish the built episode (game thread)
+void FSLVizQEpisodePrefetch::OnEpisodeBuilt(const FString& Episode, const FString& ContentHash, const FSLVizQEpisodePrefetchResult& Result)
+{
+	NumRunning--;
+	NumFetching--;
+	NumFetched++;
+	if (!CheckManagers())
+	{
+		return;
+	}
+
+	LargestTransferSize = FMath::Max(LargestTransferSize, Result.TransferSize);
+	if (Result.VizEpisodeData.IsValid() && VizManager->CacheEpisodeData(Result.VizEpisodeData))
+	{
+		const SIZE_T EpisodeSize = Result.VizEpisodeData->GetAllocatedSize();
+		UsedMemory += EpisodeSize;
+		LargestEpisodeSize = FMath::Max(LargestEpisodeSize, EpisodeSize);
+		if (!ContentHash.IsEmpty())
+		{
+			VizManager->SaveEpisodeFile(Task, Episode, ContentHash);
+		}
+		OnEpisodeDone(Episode, true);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("%s::%d Could not cache episode %s::%s .."), *FString(__FUNCTION__), __LINE__, *Task, *Episode);
+		OnEpisodeDone(Episode, false);
+	}
+}
+
+// Count the finished episode and continue with the next jobs (game thread)
+void FSLVizQEpisodePrefetch::OnEpisodeDone(const FString& Episode, bool bCached)
+{
+	if (bCached)
+	{
+		NumCached++;
+	}
+	else
+	{
+		NumFailed++;
+	}
+	UE_LOG(LogTemp, Log, TEXT("%s::%d Prefetch progress %d/%d (%s::%s) after %f seconds, memory=%.2f MB.."),
+		*FString(__FUNCTION__), __LINE__, NumCached + NumFailed, NumTotal, *Task, *Episode,
+		FPlatformTime::Seconds() - StartTime, UsedMemory / (1024.f * 1024.f));
+	StartNextJobs();
+}
+
+// Check if the managers are still valid, abort the prefetch otherwise
+bool FSLVizQEpisodePrefetch::CheckManagers()
+{
+	if (VizManager.IsValid() && MongoQueryManager.IsValid())
+	{
+		return true;
+	}
+	UE_LOG(LogTemp, Warning, TEXT("%s::%d The managers are not valid anymore, prefetch of %s aborted.."),
+		*FString(__FUNCTION__), __LINE__, *Task);
+	PendingHashes.Empty();
+	PendingFetches.Empty();
+	return false;
+}
 
 // Virtual implementation of the execute function
 void USLVizQCacheEpisodes::ExecuteImpl(ASLKnowrobManager* KRManager)
@@ -13,19 +246,53 @@ void USLVizQCacheEpisodes::ExecuteImpl(ASLKnowrobManager* KRManager)
 	ASLVizManager* VizManager = KRManager->GetVizManager();
 	ASLMongoQueryManager* MongoQueryManager = KRManager->GetMongoQueryManager();
 
+	if (bParallelPrefetch)
+	{
+		// The content hashes are computed on the workers as well
+		TSharedRef<FSLVizQEpisodePrefetch, ESPMode::ThreadSafe> Prefetch = MakeShared<FSLVizQEpisodePrefetch, ESPMode::ThreadSafe>(
+			VizManager, MongoQueryManager, Task, SIZE_T(PrefetchMemoryBudgetMB) * 1024 * 1024, bUseEpisodeFiles);
+		for (const auto Episode : Episodes)
+		{
+			if (!VizManager->IsEpisodeCached(Episode))
+			{
+				Prefetch->AddEpisode(Episode);
+			}
+		}
+
+		// The prefetch keeps itself alive with the pending callbacks
+		if (Prefetch->Start())
+		{
+			return;
+		}
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not start the parallel prefetch, loading the episodes one by one.."),
+			*FString(__FUNCTION__), __LINE__);
+	}
+
 	for (const auto Episode : Episodes)
 	{
+		// Skip mongo if the local episode file is up to date (without a connection the file is used as it is)
+		FString ContentHash;
+		if (bUseEpisodeFiles && !VizManager->IsEpisodeCached(Episode))
+		{
+			ContentHash = MongoQueryManager->IsConnected() ? MongoQueryManager->GetEpisodeContentHash(Task, Episode) : FString();
+			VizManager->CacheEpisodeFile(Task, Episode, ContentHash);
+		}
+
 		if (!VizManager->IsEpisodeCached(Episode))
 		{
 			UE_LOG(LogTemp, Log, TEXT("%s::%d Collecting episode %s::%s .."),
 				*FString(__FUNCTION__), __LINE__, *Task, *Episode);
 
 			auto EpisodeData = MongoQueryManager->GetEpisodeData(Task, Episode);
-			if (!VizManager->CacheEpisodeData(Episode, EpisodeData))
+			if (!VizManager->CacheEpisodeData(Task, Episode, EpisodeData))
 			{
 				UE_LOG(LogTemp, Error, TEXT("%s::%d Could not cache episode %s::%s, execution aborted .."),
 					*FString(__FUNCTION__), __LINE__, *Task, *Episode);
 			}
+			else if (bUseEpisodeFiles && !ContentHash.IsEmpty())
+			{
+				VizManager->SaveEpisodeFile(Task, Episode, ContentHash);
+			}
 		}
 	}
 }
@@ -171,6 +171,16 @@ void USLVizQMarkerArray::ExecuteImpl(ASLKnowrobManager* KRManager)
 		return;
 	}
 
+	// Query the non skeletal trajectories of all individuals at once
+	FSLMongoTrajectories Trajectories;
+	const bool bBatchTrajectories = MeshType != ESLVizQMarkerArrayMeshType::SkeletalMesh
+		&& Type != ESLVizQMarkerArrayType::Pose && EndTime > 0 && EndTime > StartTime;
+	if (bBatchTrajectories)
+	{
+		Trajectories = MongoQueryManager->GetIndividualTrajectories(Task, Episode, Individuals,
+			StartTime, EndTime, DeltaT);
+	}
+
 	int32 ViewIdx = 0;
 	for (const auto& MarkerId : MarkerIds)
 	{
@@ -247,10 +257,16 @@ void USLVizQMarkerArray::ExecuteImpl(ASLKnowrobManager* KRManager)
 				Poses.Add(MongoQueryManager->GetIndividualPoseAt(Task, Episode, Individual,
 					StartTime));
 			}
-			else if (EndTime > 0 && EndTime > StartTime)
+			else if (bBatchTrajectories)
 			{
-				Poses = MongoQueryManager->GetIndividualTrajectory(Task, Episode, Individual,
-					StartTime, EndTime, DeltaT);
+				const int32 TrajIdx = Trajectories.Ids.IndexOfByKey(Individual);
+				Poses = TrajIdx != INDEX_NONE ? Trajectories.GetTrajectory(TrajIdx) : TArray<FTransform>();
+
+				// Individuals without samples in the window keep their pose from the start time
+				if (Poses.Num() == 0)
+				{
+					Poses.Add(MongoQueryManager->GetIndividualPoseAt(Individual, StartTime));
+				}
 			}
 			else
 			{
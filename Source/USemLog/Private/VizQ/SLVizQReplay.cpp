@@ -4,6 +4,7 @@
 #include "VizQ/SLVizQReplay.h"
 #include "Knowrob/SLKnowrobManager.h"
 #include "Mongo/SLMongoQueryManager.h"
+#include "Mongo/SLMongoEpisodeStream.h"
 #include "Viz/SLVizManager.h"
 
 #if WITH_EDITOR
@@ -50,18 +51,63 @@ void USLVizQReplay::ExecuteImpl(ASLKnowrobManager* KRManager)
 	ASLVizManager* VizManager = KRManager->GetVizManager();
 	ASLMongoQueryManager* MongoQueryManager = KRManager->GetMongoQueryManager();
 
+	FSLVizEpisodePlayParams Params;
+	Params.StartTime = StartTime;
+	Params.EndTime = EndTime;
+	Params.bLoop = bLoop;
+	Params.UpdateRate = UpdateRate;
+	Params.PlaybackSpeed = PlaybackSpeed;
+	Params.bInterpolate = bInterpolate;
+
+	// Stream the episode, the replay starts with the first frames and the episode is cached once fully loaded
+	if (VizManager->IsEpisodeStreaming(Episode))
+	{
+		VizManager->LoadEpisodeStream(Episode, nullptr, Params, Type == ESLVizQReplayType::Replay);
+		return;
+	}
+
+	// Skip mongo if the local episode file is up to date (without a connection the file is used as it is)
+	FString ContentHash;
+	if (bUseEpisodeFile && !VizManager->IsEpisodeCached(Episode))
+	{
+		ContentHash = MongoQueryManager->IsConnected() ? MongoQueryManager->GetEpisodeContentHash(Task, Episode) : FString();
+		VizManager->CacheEpisodeFile(Task, Episode, ContentHash);
+	}
+
+	if (bStreamEpisode && !VizManager->IsEpisodeCached(Episode))
+	{
+		UE_LOG(LogTemp, Log, TEXT("%s::%d Streaming episode %s::%s .."),
+			*FString(__FUNCTION__), __LINE__, *Task, *Episode);
+		FSLMongoEpisodeStreamParams StreamParams;
+		auto Stream = MongoQueryManager->StartEpisodeStream(Task, Episode, StreamParams);
+		if (Stream.IsValid() && VizManager->LoadEpisodeStream(Episode, Stream, Params, Type == ESLVizQReplayType::Replay))
+		{
+			if (bUseEpisodeFile && !ContentHash.IsEmpty())
+			{
+				VizManager->SaveEpisodeFile(Task, Episode, ContentHash);
+			}
+			return;
+		}
+		UE_LOG(LogTemp, Warning, TEXT("%s::%d Could not stream episode %s::%s, loading it as a whole .."),
+			*FString(__FUNCTION__), __LINE__, *Task, *Episode);
+	}
+
 	// Retrieve and cache episode
 	if (!VizManager->IsEpisodeCached(Episode))
 	{
 		UE_LOG(LogTemp, Log, TEXT("%s::%d Collecting episode %s::%s .."),
 			*FString(__FUNCTION__), __LINE__, *Task, *Episode);
 		auto EpisodeData = MongoQueryManager->GetEpisodeData(Task, Episode);
-		if (!VizManager->CacheEpisodeData(Episode, EpisodeData))
+		if (!VizManager->CacheEpisodeData(Task, Episode, EpisodeData))
 		{
 			UE_LOG(LogTemp, Error, TEXT("%s::%d Could not cache episode %s::%s, execution aborted .."),
 				*FString(__FUNCTION__), __LINE__, *Task, *Episode);
 			return;
 		}
+		if (bUseEpisodeFile && !ContentHash.IsEmpty())
+		{
+			VizManager->SaveEpisodeFile(Task, Episode, ContentHash);
+		}
 	}
 
 	// Execute task
@@ -71,12 +117,6 @@ void USLVizQReplay::ExecuteImpl(ASLKnowrobManager* KRManager)
 	}
 	else if (Type == ESLVizQReplayType::Replay)
 	{
-		FSLVizEpisodePlayParams Params;
-		Params.StartTime = StartTime;
-		Params.EndTime = EndTime;
-		Params.bLoop = bLoop;
-		Params.UpdateRate = UpdateRate;
-		Params.StepSize = StepSize;
 		VizManager->ReplayCachedEpisode(Episode, Params);
 	}
 }